@@ -0,0 +1,122 @@
+/** @file benchmark_bvn.cpp
+ * @author Mark J. Olah (mjo\@cs.unm DOT edu)
+ * @date 2017-2019
+ * @brief Speed and accuracy map of the bivariate normal cdf methods over the (h, k, rho) domain.
+ *
+ * Points are sampled in regions of |rho| and max(|h|,|k|).  For each region and method the maximum absolute error
+ * against an extended precision quadrature reference, and the mean time per call, are reported.  The regions
+ * used by bvn_cdf_select_method are taken from this table.
+ *
+ * Usage: benchmark_bvn [points_per_region=200] [repeats=20] [seed=1]
+ */
+#include "PriorHessian/mvn_cdf.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include <boost/math/constants/constants.hpp>
+#include <boost/math/quadrature/gauss_kronrod.hpp>
+
+using namespace prior_hessian;
+
+namespace {
+
+/* P(X < h, Y < k) = int_{-inf}^h phi(x) Phi((k-rx)/sqrt(1-r^2)) dx in extended precision.
+ * For |r| near 1 the inner cdf is a steep step at x = k/r, so the quadrature is split around it.
+ */
+long double reference_bvn_cdf(double h, double k, double r)
+{
+    using boost::math::quadrature::gauss_kronrod;
+    if(h==-INFINITY || k==-INFINITY) return 0;
+    long double s = std::sqrt((1.0L-r)*(1.0L+r));
+    const long double sqrt2 = std::sqrt(2.0L);
+    const long double inv_sqrt2pi = 1/std::sqrt(2*boost::math::constants::pi<long double>());
+    auto f = [&](long double x) {
+        return std::exp(-x*x/2)*inv_sqrt2pi * 0.5L*std::erfc(-(k-r*x)/(s*sqrt2));
+    };
+    long double lo = -40;
+    long double hi = std::min(static_cast<long double>(h), 40.0L);
+    if(hi <= lo) return 0;
+    std::vector<long double> pts = {lo};
+    if(r != 0) {
+        long double x0 = k/r;
+        for(long double d: {-16*s, -4*s, -s, 0.0L, s, 4*s, 16*s})
+            if(x0+d > pts.back() && x0+d < hi) pts.push_back(x0+d);
+    }
+    pts.push_back(hi);
+    long double tot = 0;
+    for(size_t i=0; i+1<pts.size(); i++) tot += gauss_kronrod<long double,61>::integrate(f, pts[i], pts[i+1], 8, 1E-17L);
+    return tot;
+}
+
+double gauss_legendre_bvn_cdf(double h, double k, double r)
+{
+    double out;
+    bvn_cdf_batch(1, &h, &k, &r, &out);
+    return out;
+}
+
+struct Method {
+    const char *name;
+    std::function<double(double,double,double)> f;
+};
+
+} /* namespace */
+
+int main(int argc, char **argv)
+{
+    int Npoints = argc>1 ? std::atoi(argv[1]) : 200;
+    int Nrepeats = argc>2 ? std::atoi(argv[2]) : 20;
+    unsigned long seed = argc>3 ? std::strtoul(argv[3],nullptr,10) : 1;
+    if(Npoints<1 || Nrepeats<1) {
+        std::fprintf(stderr, "Usage: %s [points_per_region=200] [repeats=20] [seed=1]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<Method> methods = {
+        {"owen", [](double h, double k, double r) { return owen_b_integral(h,k,r); }},
+        {"donnelly", [](double h, double k, double r) { return donnelly_bvn_integral(-h,-k,r); }},
+        {"donnelly_orig", [](double h, double k, double r) { return donnelly_bvn_integral_orig(-h,-k,r); }},
+        {"gauss_legendre", gauss_legendre_bvn_cdf},
+        {"auto(1e-14)", [](double h, double k, double r) { return bvn_cdf_integral(h,k,r); }},
+        {"auto(1e-8)", [](double h, double k, double r) { return bvn_cdf_integral(h,k,r,1E-8); }}
+    };
+    const std::vector<double> rho_bins = {0, 0.5, 0.8, 0.925, 0.99, 0.9999, 1};
+    const std::vector<double> z_bins = {0, 1, 3, 5, 8, 38};
+
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> unif;
+    std::printf("%-16s %-10s %-16s %12s %12s\n", "|rho|", "max|h,k|", "method", "max_abs_err", "ns/call");
+    for(size_t ri=0; ri+1<rho_bins.size(); ri++) for(size_t zi=0; zi+1<z_bins.size(); zi++) {
+        std::vector<double> H(Npoints), K(Npoints), R(Npoints);
+        std::vector<long double> ref(Npoints);
+        for(int n=0; n<Npoints; n++) {
+            //One coordinate has magnitude m in the z bin, the other is uniform in [-m,m]
+            double m = z_bins[zi] + (z_bins[zi+1]-z_bins[zi])*unif(rng);
+            H[n] = unif(rng)<.5 ? -m : m;
+            K[n] = m*(2*unif(rng)-1);
+            if(unif(rng)<.5) std::swap(H[n],K[n]);
+            R[n] = rho_bins[ri] + (rho_bins[ri+1]-rho_bins[ri])*unif(rng);
+            if(unif(rng)<.5) R[n] = -R[n];
+            ref[n] = reference_bvn_cdf(H[n],K[n],R[n]);
+        }
+        for(auto &method: methods) {
+            double max_err = 0;
+            for(int n=0; n<Npoints; n++) {
+                double err = std::fabs(static_cast<double>(method.f(H[n],K[n],R[n]) - ref[n]));
+                if(!(err <= max_err)) max_err = err; //NaN propagates
+            }
+            volatile double sink = 0;
+            auto start = std::chrono::steady_clock::now();
+            for(int rep=0; rep<Nrepeats; rep++) for(int n=0; n<Npoints; n++) sink = sink + method.f(H[n],K[n],R[n]);
+            std::chrono::duration<double,std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            std::printf("[%-6g,%6g) [%g,%g) %-16s %12.3e %12.1f\n", rho_bins[ri], rho_bins[ri+1], z_bins[zi], z_bins[zi+1],
+                        method.name, max_err, elapsed.count()/(Nrepeats*Npoints));
+        }
+    }
+    return 0;
+}
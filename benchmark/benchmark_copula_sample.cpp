@@ -0,0 +1,84 @@
+/** @file benchmark_copula_sample.cpp
+ * @author Mark J. Olah (mjo\@cs.unm DOT edu)
+ * @date 2017-2019
+ * @brief Sampling throughput of AMH copulas and copula distributions against independent marginal sampling.
+ *
+ * Positive theta uses the frailty sampler, and negative theta the conditional inversion sampler.
+ *
+ * Usage: benchmark_copula_sample [num_samples=100000] [seed=1]
+ */
+#include "PriorHessian/AMHCopula.h"
+#include "PriorHessian/CopulaDist.h"
+#include "PriorHessian/TruncatedNormalDist.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+
+using namespace prior_hessian;
+
+namespace {
+
+using RngT = std::mt19937_64;
+
+/* Mean time per sample in ns */
+double time_per_sample(IdxT num_samples, const std::function<double()> &f)
+{
+    volatile double sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    sink = sink + f();
+    std::chrono::duration<double,std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count()/num_samples;
+}
+
+template<int Ndim>
+void benchmark_amh_copula(IdxT N, RngT &rng, double theta)
+{
+    AMHCopula<Ndim> copula(theta);
+    double single = time_per_sample(N, [&]() { 
+        double s=0; 
+        for(IdxT n=0; n<N; n++) s += copula.sample(rng)(0); 
+        return s; 
+    });
+    double batch = time_per_sample(N, [&]() { return arma::accu(copula.sample(rng,N)); });
+    std::printf("AMHCopula<%d> theta=%-5g %12.1f %12.1f\n", Ndim, theta, single, batch);
+}
+
+} /* namespace */
+
+int main(int argc, char **argv)
+{
+    IdxT N = argc>1 ? std::strtoul(argv[1],nullptr,10) : 100000;
+    unsigned long seed = argc>2 ? std::strtoul(argv[2],nullptr,10) : 1;
+    if(N<1) {
+        std::fprintf(stderr, "Usage: %s [num_samples=100000] [seed=1]\n", argv[0]);
+        return 1;
+    }
+    RngT rng(seed);
+    std::printf("%-26s %12s %12s\n", "sampler", "ns/sample", "ns/batched");
+
+    TruncatedNormalDist marginal;
+    double marginal_time = time_per_sample(N, [&]() {
+        double s=0;
+        for(IdxT n=0; n<N; n++) s += marginal.sample(rng) + marginal.sample(rng);
+        return s;
+    });
+    std::printf("%-26s %12.1f %12s\n", "2 x TruncatedNormalDist", marginal_time, "-");
+
+    for(double theta: {-0.5, 0.5}) benchmark_amh_copula<2>(N,rng,theta);
+    for(double theta: {-0.2, 0.5}) benchmark_amh_copula<4>(N,rng,theta);
+
+    for(double theta: {-0.5, 0.5}) {
+        CopulaDist<AMHCopula,TruncatedNormalDist,TruncatedNormalDist> dist(AMHCopula<2>(theta), marginal, marginal);
+        double single = time_per_sample(N, [&]() { 
+            double s=0; 
+            for(IdxT n=0; n<N; n++) s += dist.sample(rng)(0); 
+            return s; 
+        });
+        double batch = time_per_sample(N, [&]() { return arma::accu(dist.sample(rng,N)); });
+        std::printf("CopulaDist<2> theta=%-5g %12.1f %12.1f\n", theta, single, batch);
+    }
+    return 0;
+}
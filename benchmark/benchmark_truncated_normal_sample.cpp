@@ -0,0 +1,101 @@
+/** @file benchmark_truncated_normal_sample.cpp
+ * @author Mark J. Olah (mjo\@cs.unm DOT edu)
+ * @date 2017-2019
+ * @brief Throughput and tail accuracy of truncated normal sampling by inversion and by region-selected rejection.
+ *
+ * For each truncation region the generic TruncatedDist inversion, icdf(uniform), is compared with TruncatedNormalDist::sample,
+ * which uses the rejection samplers of sample_truncated_unit_normal.  Accuracy is reported as the error of the sample mean
+ * in units of its standard error, against the exact truncated mean.  The last regions are far tails, and compare the
+ * plain cdf inversion with sample_truncated_unit_normal directly.
+ *
+ * Usage: benchmark_truncated_normal_sample [num_samples=1000000] [seed=1]
+ */
+#include "PriorHessian/TruncatedNormalDist.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace prior_hessian;
+
+namespace {
+
+using RngT = std::mt19937_64;
+
+/* Exact mean of the unit normal truncated to [a,b].  Probabilities are computed in the tail that avoids cancellation. */
+double truncated_unit_normal_mean(double a, double b)
+{
+    auto phi = [](double x) { return std::isinf(x) ? 0 : std::exp(-.5*x*x)/constants::sqrt2pi; };
+    double Z = a >= 0 ? .5*(std::erfc(a/constants::sqrt2) - std::erfc(b/constants::sqrt2)) :
+                        .5*(std::erfc(-b/constants::sqrt2) - std::erfc(-a/constants::sqrt2));
+    return (phi(a)-phi(b))/Z;
+}
+
+struct Result {
+    double ns_per_sample;
+    double mean_error; // (sample mean - exact mean)/standard error
+    double out_of_bounds; // Fraction of samples that were not finite or not in [a,b]
+};
+
+Result run(IdxT N, double a, double b, const std::function<double()> &sample)
+{
+    double s = 0, s2 = 0;
+    IdxT bad = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(IdxT n=0; n<N; n++) {
+        double x = sample();
+        if(!(a <= x && x <= b)) { bad++; continue; }
+        s += x;
+        s2 += x*x;
+    }
+    std::chrono::duration<double,std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    IdxT Ngood = N - bad;
+    double mean = s/Ngood;
+    double se = std::sqrt(std::max(s2/Ngood - mean*mean, 0.)/Ngood);
+    return {elapsed.count()/N, (mean - truncated_unit_normal_mean(a,b))/se, static_cast<double>(bad)/N};
+}
+
+void print(const char *method, double a, double b, const Result &r)
+{
+    std::printf("[%5g,%5g] %-12s %10.1f %12.2f %12.3g\n", a, b, method, r.ns_per_sample, r.mean_error, r.out_of_bounds);
+}
+
+} /* namespace */
+
+int main(int argc, char **argv)
+{
+    IdxT N = argc>1 ? std::strtoul(argv[1],nullptr,10) : 1000000;
+    unsigned long seed = argc>2 ? std::strtoul(argv[2],nullptr,10) : 1;
+    if(N<2) {
+        std::fprintf(stderr, "Usage: %s [num_samples=1000000] [seed=1]\n", argv[0]);
+        return 1;
+    }
+    RngT rng(seed);
+    std::uniform_real_distribution<double> uniform;
+    std::printf("%-13s %-12s %10s %12s %12s\n", "region", "method", "ns/sample", "mean_err/se", "frac_bad");
+
+    const std::vector<std::pair<double,double>> regions = {
+        {-1,1}, {-0.1,0.2}, {0,INFINITY}, {-INFINITY,0.3}, {1,2}, {3,INFINITY}, {4,4.5}, {5.5,INFINITY}, {-INFINITY,-5.5}};
+    for(auto &ab: regions) {
+        double a = ab.first, b = ab.second;
+        TruncatedNormalDist dist(NormalDist(0,1), a, b);
+        print("icdf", a, b, run(N, a, b, [&]() { return dist.icdf(uniform(rng)); }));
+        print("rejection", a, b, run(N, a, b, [&]() { return dist.sample(rng); }));
+    }
+
+    /* Far tails.  The plain inversion, icdf(cdf(a) + u*(cdf(b)-cdf(a))), fails once cdf(a) rounds to 1. */
+    NormalDist unit;
+    const std::vector<std::pair<double,double>> far_regions = {{7,INFINITY}, {9,10}, {20,INFINITY}, {38,39}};
+    for(auto &ab: far_regions) {
+        double a = ab.first, b = ab.second;
+        double pa = unit.cdf(a), pb = unit.cdf(b);
+        print("icdf", a, b, run(N, a, b, [&]() { return unit.icdf(pa + uniform(rng)*(pb-pa)); }));
+        print("rejection", a, b, run(N, a, b, [&]() { return sample_truncated_unit_normal(a,b,rng); }));
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+/** @file benchmark_univariate_batch.cpp
+ * @author Mark J. Olah (mjo\@cs.unm DOT edu)
+ * @date 2017-2019
+ * @brief Throughput of the array forms of llh, rllh and grad_grad2_accumulate against the scalar methods.
+ *
+ * Each univariate distribution is timed on its own, and then as the components of a CompositeDist, where the batched
+ * methods over the columns of a matrix are compared with evaluation column by column.  CompositeDist wraps each component
+ * in its bounds adaptor, e.g., TruncatedDist, so the CompositeDist llh times include the truncation constant.
+ *
+ * Usage: benchmark_univariate_batch [num_points=1000000] [seed=1]
+ */
+#include "PriorHessian/CompositeDist.h"
+#include "PriorHessian/NormalDist.h"
+#include "PriorHessian/GammaDist.h"
+#include "PriorHessian/ParetoDist.h"
+#include "PriorHessian/SymmetricBetaDist.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+using namespace prior_hessian;
+
+namespace {
+
+using RngT = std::mt19937_64;
+
+/* Mean time per point in ns */
+double time_per_point(IdxT num_points, const std::function<double()> &f)
+{
+    volatile double sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    sink = sink + f();
+    std::chrono::duration<double,std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count()/num_points;
+}
+
+void print(const char *name, const char *method, double scalar, double array)
+{
+    std::printf("%-20s %-12s %12.2f %12.2f %10.2f\n", name, method, scalar, array, scalar/array);
+}
+
+template<class Dist>
+void benchmark_dist(const char *name, const Dist &dist, IdxT N, RngT &rng)
+{
+    std::vector<double> x(N), out(N), g(N), g2(N);
+    for(IdxT n=0; n<N; n++) x[n] = dist.sample(rng);
+    double scalar = time_per_point(N, [&]() {
+        for(IdxT n=0; n<N; n++) out[n] = dist.llh(x[n]);
+        return out[N-1];
+    });
+    double array = time_per_point(N, [&]() {
+        dist.llh(N, x.data(), out.data());
+        return out[N-1];
+    });
+    print(name, "llh", scalar, array);
+    scalar = time_per_point(N, [&]() {
+        for(IdxT n=0; n<N; n++) out[n] = dist.rllh(x[n]);
+        return out[N-1];
+    });
+    array = time_per_point(N, [&]() {
+        dist.rllh(N, x.data(), out.data());
+        return out[N-1];
+    });
+    print(name, "rllh", scalar, array);
+    scalar = time_per_point(N, [&]() {
+        for(IdxT n=0; n<N; n++) dist.grad_grad2_accumulate(x[n], g[n], g2[n]);
+        return g[N-1];
+    });
+    array = time_per_point(N, [&]() {
+        dist.grad_grad2_accumulate(N, x.data(), g.data(), g2.data());
+        return g[N-1];
+    });
+    print(name, "grad_grad2", scalar, array);
+}
+
+} /* namespace */
+
+int main(int argc, char **argv)
+{
+    IdxT N = argc>1 ? std::strtoul(argv[1],nullptr,10) : 1000000;
+    unsigned long seed = argc>2 ? std::strtoul(argv[2],nullptr,10) : 1;
+    if(N<1) {
+        std::fprintf(stderr, "Usage: %s [num_points=1000000] [seed=1]\n", argv[0]);
+        return 1;
+    }
+    RngT rng(seed);
+    std::printf("%-20s %-12s %12s %12s %10s\n", "dist", "method", "ns/scalar", "ns/array", "speedup");
+
+    NormalDist normal(1,2);
+    GammaDist gamma(2,3.5);
+    ParetoDist pareto(0.5,1.7);
+    SymmetricBetaDist beta(2.5);
+    benchmark_dist("NormalDist", normal, N, rng);
+    benchmark_dist("GammaDist", gamma, N, rng);
+    benchmark_dist("ParetoDist", pareto, N, rng);
+    benchmark_dist("SymmetricBetaDist", beta, N, rng);
+
+    /* Times are per column.  The scalar column is evaluation column by column. */
+    CompositeDist composite(normal, gamma, pareto, beta);
+    MatT theta = composite.sample(rng, N);
+    double scalar = time_per_point(N, [&]() {
+        double s=0;
+        for(IdxT n=0; n<N; n++) s += composite.llh(VecT(theta.colptr(n), composite.num_dim(), false, true));
+        return s;
+    });
+    double batch = time_per_point(N, [&]() { return arma::accu(composite.llh(theta)); });
+    print("CompositeDist", "llh", scalar, batch);
+    scalar = time_per_point(N, [&]() {
+        double s=0;
+        for(IdxT n=0; n<N; n++) s += composite.rllh(VecT(theta.colptr(n), composite.num_dim(), false, true));
+        return s;
+    });
+    batch = time_per_point(N, [&]() { return arma::accu(composite.rllh(theta)); });
+    print("CompositeDist", "rllh", scalar, batch);
+    MatT grad = composite.make_zero_grad(N);
+    MatT grad2 = composite.make_zero_grad(N);
+    scalar = time_per_point(N, [&]() {
+        IdxT Ndim = composite.num_dim();
+        for(IdxT n=0; n<N; n++) {
+            const VecT t(theta.colptr(n), Ndim, false, true);
+            VecT g(grad.colptr(n), Ndim, false, true);
+            VecT g2(grad2.colptr(n), Ndim, false, true);
+            composite.grad_grad2_accumulate(t, g, g2);
+        }
+        return grad(0,N-1);
+    });
+    batch = time_per_point(N, [&]() {
+        composite.grad_grad2_accumulate(theta, grad, grad2);
+        return grad(0,N-1);
+    });
+    print("CompositeDist", "grad_grad2", scalar, batch);
+    return 0;
+}
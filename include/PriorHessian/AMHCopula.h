@@ -7,6 +7,7 @@
 #ifndef PRIOR_HESSIAN_AMHCOPULA_H
 #define PRIOR_HESSIAN_AMHCOPULA_H
 #include <limits>
+#include <random>
 
 #include "PriorHessian/PriorHessianError.h"
 #include "PriorHessian/ArchimedeanCopula.h"
@@ -71,6 +72,8 @@ public:
     NdimVecT grad2(const Vec &u) const;
     template<class Vec>
     NdimMatT hess(const Vec &u) const;
+    template<class Vec, class Vec2>
+    NdimVecT hessvec(const Vec &u, const Vec2 &v) const;
 
     template<class Vec, class Vec2>
     void rllh_grad_accumulate(const Vec &u, double &rllh, Vec2 &grad) const;
@@ -84,9 +87,24 @@ public:
     static void rllh_dtheta_accumulate(double theta, const Vec &u, double &rllh, double &dtheta);
     template<class Vec>
     static void rllh_d2theta_accumulate(double theta, const Vec &u, double &rllh, double &dtheta, double &d2theta);
-
+    /* Fused rllh, grad, upper triangular hess, theta derivatives, and the mixed derivatives d2/dtheta du(i). 
+     * Used by CopulaDist for the parameter derivatives. */
+    template<class Vec, class Vec2, class Mat>
+    void rllh_grad_hess_dtheta_accumulate(const Vec &u, double &rllh, Vec2 &grad, Mat &hess, 
+                                          double &dtheta, double &d2theta, Vec2 &grad_dtheta) const;
+
+    /** Sample from the copula.
+     * For theta >= 0 the generator is the Laplace transform of V ~ Geometric(1-theta) on {1,2,...}, so the
+     * Marshall-Olkin frailty construction applies: u(i) = gen(E(i)/V) with E(i) ~ Exp(1) independent.  For
+     * theta < 0 each coordinate is drawn in turn by inversion of its distribution conditional on the previous
+     * coordinates, in closed form for the second coordinate and by bisection thereafter.  For Ndim > 2 and
+     * theta < 0 the AMH family is only a valid copula for theta close enough to 0.
+     */
     template<class RngT>
     NdimVecT sample(RngT &rng) const;
+    /* Batched sampling.  Samples are the columns. */
+    template<class RngT>
+    MatT sample(RngT &rng, IdxT num_samples) const;
     
     /* Public numerical methods */
     double gen(double t) const;
@@ -100,52 +118,50 @@ private:
         double z;
         double prod_d1_igen;
     };
+    /* Terms of the log-density and its derivatives.  See compute_rllh_terms(). */
+    struct RllhTerms {
+        double rllh;
+        double z;
+        double h1;    // h'(z)
+        double h2;    // h''(z)
+        double z_h1;  // z*h'(z)
+        double z2_h2; // z^2*h''(z)
+        NdimVecT W;   // 1-theta+theta*u(i)
+        NdimVecT g;   // dlog(z)/du(i)
+    };
+    /* Terms of the theta derivatives.  See compute_theta_terms(). */
+    struct ThetaTerms {
+        double s1;  // sum((u(i)-1)/W(i))
+        double s2;  // sum(((u(i)-1)/W(i))^2)
+        double dz;  // dz/dtheta
+        double d2z; // d2z/dtheta2
+    };
 
     double _theta;
 
-    /* Core coputational methods:
-     * Organized into static methods for the generator and inverse-generator constants
-     * for computing the rllh and derivatives vs u and vs theta.
-     * 
-     * This organization keeps terms with common subexpressions together, and
-     * concentrates all of the computational code into a small set of methods.
-     *
-     * Each method returns a struct from ArchimedeanCopula with the relevent scalars for
-     * computing the rllh, and first and second derivatives.
-     * 
-     */
-    template<class Vec>
-    static double igen_sum(double theta, const Vec &u);
     template<class Vec>
-    static double compute_z(double theta, const Vec &u);
-    template<class Vec>
-    static PDFTerms compute_pdf_terms(double theta, const Vec &u);
-    static double ddim_gen_z(double theta, double z); // z=theta*exp(-t)
-    
-    template<class Vec>
-    static D_GenTerms compute_d_gen_terms(double theta, const Vec &u);
+    static RllhTerms compute_rllh_terms(double theta, const Vec &u);
+    static double hess_diag_term(double theta, double ui, const RllhTerms &terms, IdxT i);
     template<class Vec>
-    static D2_GenTerms compute_d2_gen_terms(double theta, const Vec &u);
-    template<class Vec>
-    static D_GenTerms compute_d_gen_terms_only(double theta, const Vec &u); //Ignore rllh terms
-    template<class Vec>
-    static D2_GenTerms compute_d2_gen_terms_only(double theta, const Vec &u); //Ignore rllh terms
+    static ThetaTerms compute_theta_terms(double theta, const Vec &u, const RllhTerms &terms);
+    static double dtheta_term(double theta, const RllhTerms &terms, const ThetaTerms &tterms);
+    static double d2theta_term(double theta, const RllhTerms &terms, const ThetaTerms &tterms);
 
-    static D_IGenTerms compute_d_igen_terms(double theta, double ui);
-    static D2_IGenTerms compute_d2_igen_terms(double theta, double ui);
+    template<class RngT>
+    static double open_uniform(RngT &rng);
+    template<class IterT, class RngT>
+    void sample_frailty(IterT u, RngT &rng) const;
+    template<class IterT, class RngT>
+    void sample_conditional(IterT u, RngT &rng) const;
 
-    /* Computation of deriviatives with respect to theta */ 
+    /* Core coputational methods */
     template<class Vec>
-    static DTheta_GenTerms compute_dtheta_gen_terms(double theta, const Vec &u);
-    template<class Vec>
-    static D2Theta_GenTerms compute_d2theta_gen_terms(double theta, const Vec &u);
-
+    static double igen_sum(double theta, const Vec &u);
     template<class Vec>
-    static DTheta_IGenTerms compute_dtheta_igen_terms(double theta, const Vec &u);
+    static double compute_z(double theta, const Vec &u);
     template<class Vec>
-    static D2Theta_IGenTerms compute_d2theta_igen_terms(double theta, const Vec &u);
-    
-
+    static PDFTerms compute_pdf_terms(double theta, const Vec &u);
+    static double ddim_gen_z(double theta, double z); // z=theta*exp(-t)
 };
 
 /* Templated static member variable definitions */
@@ -193,25 +209,39 @@ template<int Ndim>
 template<class Vec>
 double AMHCopula<Ndim>::cdf(const Vec &u) const  
 { 
-    auto terms = compute_cdf_terms(theta(),u);
-    return terms.prod_d1_igen * ddim_gen_z(terms.z);
+    //gen(igen_sum(u)) = (1-theta)/(prod(W(i)/u(i)) - theta)
+    double one_m_theta = 1-_theta;
+    double p = 1;
+    for(IdxT i=0; i<Ndim; i++) p *= (one_m_theta + _theta*u(i))/u(i);
+    return one_m_theta / (p - _theta);
 }
 
 template<int Ndim>
 template<class Vec>
 double AMHCopula<Ndim>::pdf(const Vec &u) const
 { 
-    auto terms = compute_pdf_terms(theta(),u);
-    return terms.prod_d1_igen * ddim_gen_z(terms.z);
+    return exp(rllh(u));
 }
 
 template<int Ndim>
 template<class Vec>
 double AMHCopula<Ndim>::llh(const Vec &u) const
 { 
-    double L = log(fabs(ddim_gen(igen_sum(u))));  //Use fabs instead of pow(-1,Ndim).  Should be faster.
-    for(IdxT k=0;k<Ndim;k++) L += log(-d1_igen(u(k)));
-    return L;
+    return rllh(u);
+}
+
+template<int Ndim>
+template<class Vec>
+double AMHCopula<Ndim>::rllh(const Vec &u) const
+{ 
+    return compute_rllh_terms(theta(),u).rllh;
+}
+
+/* The copula density is normalized */
+template<int Ndim>
+double AMHCopula<Ndim>::rllh_const() const
+{ 
+    return 0;
 }
 
 template<int Ndim>
@@ -219,12 +249,9 @@ template<class Vec>
 typename AMHCopula<Ndim>::NdimVecT 
 AMHCopula<Ndim>::grad(const Vec &u) const
 {
-    NdimVecT grad2;
-    auto gterms = compute_d_gen_terms_only(theta(),u);
-    for(int i=0; i<Ndim; i++) {
-        auto igterms = compute_d_igen_terms(theta(),u(i));
-        grad(i) += igterms.d1_igen_ui * gterms.eta_n_np1_t + igterms.ieta_21_ui;
-    }
+    NdimVecT grad(arma::fill::zeros);
+    double rllh = 0;
+    rllh_grad_accumulate(u,rllh,grad);
     return grad;
 }
 
@@ -233,12 +260,10 @@ template<class Vec>
 typename AMHCopula<Ndim>::NdimVecT 
 AMHCopula<Ndim>::grad2(const Vec &u) const
 {
-    NdimVecT grad2;
-    auto gterms = compute_d2_gen_terms_only(theta(),u);
-    for(int i=0; i<Ndim; i++) {
-        auto igterms = compute_d2_igen_terms_only(theta(),u(i));
-        grad2(i) = square(igterms.d1_igen_ui)*gterms.xi_n_t + igterms.d2_igen_ui*gterms.eta_n_np1_t + igterms.ixi_1_ui;
-    }
+    NdimVecT grad(arma::fill::zeros);
+    NdimVecT grad2(arma::fill::zeros);
+    double rllh = 0;
+    rllh_grad_grad2_accumulate(u,rllh,grad,grad2);
     return grad2;
 }
 
@@ -247,18 +272,62 @@ template<class Vec>
 typename AMHCopula<Ndim>::NdimMatT 
 AMHCopula<Ndim>::hess(const Vec &u) const
 {
-    NdimMatT hess;
-    auto gterms = compute_d2_gen_terms_only(theta(),u);
-    NdimVecT  d1_igen_u;
-    for(int i=0; i<Ndim; i++) {
-        auto igterms = compute_d2_igen_terms_only(theta(),u(i));
-        hess(i,i) = square(igterms.d1_igen_ui)*gterms.xi_n_t + igterms.d2_igen_ui*gterms.eta_n_np1_t + igterms.ixi_1_ui;
-        d1_igen_u(i) = igterms.d1_igen_ui;
-        for(int j=0; j<i; j++) hess(j,i) = d1_igen_u(i)*d1_igen_u(j)*gterms.xi_n_t;
-    }
+    NdimVecT grad(arma::fill::zeros);
+    NdimMatT hess(arma::fill::zeros);
+    double rllh = 0;
+    rllh_grad_hess_accumulate(u,rllh,grad,hess);
     return arma::symmatu(hess);
 }
 
+/* The hessian is diagonal plus the rank-one term (z^2*h''(z) + z*h'(z)) * g * g^T, so H*v is O(Ndim) */
+template<int Ndim>
+template<class Vec, class Vec2>
+typename AMHCopula<Ndim>::NdimVecT 
+AMHCopula<Ndim>::hessvec(const Vec &u, const Vec2 &v) const
+{
+    auto terms = compute_rllh_terms(theta(),u);
+    double g_dot_v = arma::dot(terms.g,v);
+    NdimVecT hv;
+    for(IdxT i=0; i<Ndim; i++) hv(i) = hess_diag_term(theta(),u(i),terms,i)*v(i);
+    hv += ((terms.z2_h2+terms.z_h1)*g_dot_v)*terms.g;
+    return hv;
+}
+
+template<int Ndim>
+template<class Vec, class Vec2>
+void AMHCopula<Ndim>::rllh_grad_accumulate(const Vec &u, double &rllh, Vec2 &grad) const
+{
+    auto terms = compute_rllh_terms(theta(),u);
+    rllh += terms.rllh;
+    for(IdxT i=0; i<Ndim; i++) grad(i) += -2*_theta/terms.W(i) + terms.z_h1*terms.g(i);
+}
+
+template<int Ndim>
+template<class Vec, class Vec2>
+void AMHCopula<Ndim>::rllh_grad_grad2_accumulate(const Vec &u, double &rllh, Vec2 &grad, Vec2 &grad2) const
+{
+    auto terms = compute_rllh_terms(theta(),u);
+    rllh += terms.rllh;
+    for(IdxT i=0; i<Ndim; i++) {
+        grad(i) += -2*_theta/terms.W(i) + terms.z_h1*terms.g(i);
+        grad2(i) += (terms.z2_h2+terms.z_h1)*square(terms.g(i)) + hess_diag_term(theta(),u(i),terms,i);
+    }
+}
+
+/* Only the upper triangle of hess is accumulated */
+template<int Ndim>
+template<class Vec, class Vec2, class Mat>
+void AMHCopula<Ndim>::rllh_grad_hess_accumulate(const Vec &u, double &rllh, Vec2 &grad, Mat &hess) const
+{
+    auto terms = compute_rllh_terms(theta(),u);
+    rllh += terms.rllh;
+    double c = terms.z2_h2+terms.z_h1;
+    for(IdxT j=0; j<Ndim; j++) {
+        grad(j) += -2*_theta/terms.W(j) + terms.z_h1*terms.g(j);
+        for(IdxT i=0; i<j; i++) hess(i,j) += c*terms.g(i)*terms.g(j);
+        hess(j,j) += c*square(terms.g(j)) + hess_diag_term(theta(),u(j),terms,j);
+    }
+}
 
 /*Public Non-Static computational methods */
 template<int Ndim>
@@ -334,268 +403,228 @@ AMHCopula<Ndim>::compute_pdf_terms(double theta, const Vec &u)
     return terms;
 }
 
-// template<int Ndim>
-// template<class Vec>
-// typename AMHCopula<Ndim>::D_GenTerms 
-// AMHCopula<Ndim>::compute_d_gen_terms(double theta, const Vec &u)
-// {
-//     D_GenTerms terms;
-//     double z = compute_z(theta,u); // z(\theta,t) = \theta*\exp{-\sum_{i=1}^n \igen(u_i)}
-//     double ep_nm1_z = eulerian_polynomial<Ndim-1>(z);
-//     terms.log_dn_gen_t = log(fabs((theta-1)/theta * (z/pow(1-z,Ndim+1)) * ep_nm1_z));
-//     terms.eta_n_np1_t = eulerian_polynomial<Ndim>(z) / ((z-1)*ep_nm1_z);
-//     return terms;
-// }
-// 
-// /*
-//  * Do not computer rllh terms.  Derivitive calculations only
-//  * 
-//  */
-// template<int Ndim>
-// template<class Vec>
-// typename AMHCopula<Ndim>::D_GenTerms 
-// void AMHCopula<Ndim>::compute_d_gen_terms_only(double theta, const Vec &u)
-// {
-//     D_GenTerms terms;
-//     double z = compute_z(theta,u); // z(\theta,t) = \theta*\exp{-\sum_{i=1}^n \igen(u_i)}
-//     double ep_nm1_z = eulerian_polynomial<Ndim-1>(z);
-//     terms.log_dn_gen_t = NAN; //Do not compute
-//     terms.eta_n_np1_t = eulerian_polynomial<Ndim>(z) / ((z-1)*ep_nm1_z);
-//     return terms;
-// }
-// 
-// template<int Ndim>
-// template<class Vec>
-// typename AMHCopula<Ndim>::D2_GenTerms 
-// void AMHCopula<Ndim>::compute_d2_gen_terms(double theta, const Vec &u)
-// {
-//     D2_GenTerms terms;
-//     double z = compute_z(theta,u); // z(\theta,t) = \theta*\exp{-\sum_{i=1}^n \igen(u_i)}
-//     double ep_nm1_z = eulerian_polynomial<Ndim-1>(z);
-//     terms.log_dn_gen_t = log(fabs((theta-1)/theta * (z/pow(1-z,Ndim+1)) * ep_nm1_z));
-//     terms.eta_n_np1_t = eulerian_polynomial<Ndim>(z) / ((z-1)*ep_nm1_z);
-//     terms.xi_n_t = eulerian_polynomial<Ndim+1>(z) /(square(z-1)*ep_nm1_z) - square(eta_n_np1_t);
-//     return terms;
-// }
-// 
-// /*
-//  * Do not computer rllh terms.  Derivitive calculations only
-//  * 
-//  */
-// template<int Ndim>
-// template<class Vec>
-// typename AMHCopula<Ndim>::D2_GenTerms 
-// void AMHCopula<Ndim>::compute_d2_gen_terms_only(double theta, const Vec &u)
-// {
-//     D2_GenTerms terms;
-//     double z = compute_z(theta,u); // z(\theta,t) = \theta*\exp{-\sum_{i=1}^n \igen(u_i)}
-//     double ep_nm1_z = eulerian_polynomial<Ndim-1>(z);
-//     terms.log_dn_gen_t = NAN;  //Do not compute
-//     terms.eta_n_np1_t = eulerian_polynomial<Ndim>(z) / ((z-1)*ep_nm1_z);
-//     terms.xi_n_t = eulerian_polynomial<Ndim+1>(z) /(square(z-1)*ep_nm1_z) - square(eta_n_np1_t);
-//     return terms;
-// }
-// 
-// template<int Ndim>
-// typename AMHCopula<Ndim>::D_IGenTerms 
-// void AMHCopula<Ndim>::compute_d_igen_terms(double theta, double ui)
-// {
-//     D_IGenTerms terms;
-//     double W = theta*ui - theta + 1;
-//     terms.d1_igen_ui =  (theta-1) / (ui*W);
-//     terms.ieta_21_ui = -2*theta/W + terms.d1_igen_ui;
-//     return terms
-// }
-// 
-// template<int Ndim>
-// typename AMHCopula<Ndim>::D2_IGenTerms 
-// void AMHCopula<Ndim>::compute_d2_igen_terms(double theta, double ui)
-// {
-//     D2_IGenTerms terms;
-//     double W = theta*ui - theta + 1;
-//     double ui_inv = 1/ui;
-//     double W_inv = 1/W;
-//     double Wui_inv = ui_inv*W_inv;
-//     terms.d1_igen_ui =  (theta-1)*Wui_inv;
-//     terms.d2_igen_ui =  (theta*u+W)*Wui_inv * terms.d1_igen_ui
-//     terms.ixi_1_ui = square(theta*W_inv) + square(ui_inv);
-//     terms.ieta_21_ui = -2*theta*W_inv + terms.d1_igen_ui;
-//     return terms
-// }
-// 
-// /*
-//  * Compute only terms needed for second derivative.
-//  * 
-//  */
-// template<int Ndim>
-// typename AMHCopula<Ndim>::D2_IGenTerms 
-// void AMHCopula<Ndim>::compute_d2_igen_terms_only(double theta, double ui)
-// {
-//     D2_IGenTerms terms;
-//     double W = theta*ui - theta + 1;
-//     double ui_inv = 1/ui;
-//     double W_inv = 1/W;
-//     terms.d1_igen_ui =  (theta-1)*ui_inv*W_inv;
-//     terms.d2_igen_ui =  (theta*u+W)*ui_inv*W_inv * terms.d1_igen_ui
-//     terms.ixi_1_ui = square(theta*W_inv) + square(ui_inv);
-//     terms.ieta_21_ui = NAN; //Do not compute.  Needed for grad1 only.
-//     return terms
-// }
-// 
-// 
-// template<int Ndim>
-// template<class Vec, class Vec2>
-// void AMHCopula<Ndim>::rllh_grad_accumulate(const Vec &u, double &rllh, Vec2 &grad) const
-// {
-//     auto gterms = compute_d_gen_terms(theta(),u);
-//     rllh += gterms.log_dn_gen_t;
-//     for(int i=0; i<Ndim; i++) {
-//         auto igterms = compute_d_igen_terms(theta(),u(i));
-//         rllh += log(-igterms.d1_igen_ui);
-//         grad(i) += igterms.d1_igen_ui * gterms.eta_n_np1_t + igterms.ieta_21_ui;
-//     }
-// }
-// 
-// template<int Ndim>
-// template<class Vec, class Vec2>
-// void AMHCopula<Ndim>::rllh_grad_grad2_accumulate(const Vec &u, double &rllh, Vec2 &grad, Vec2 &grad2) const
-// {
-//     auto gterms = compute_d2_gen_terms(theta(),u);
-//     rllh += gterms.log_dn_gen_t;
-//     for(int i=0; i<Ndim; i++) {
-//         auto igterms = compute_d2_igen_terms(theta(),u(i));
-//         rllh += log(-igterms.d1_igen_ui);
-//         grad(i) += igterms.d1_igen_ui * gterms.eta_n_np1_t + igterms.ieta_21_ui;
-//         grad2(i) += square(igterms.d1_igen_ui)*gterms.xi_n_t + igterms.d2_igen_ui*gterms.eta_n_np1_t + igterms.ixi_1_ui;
-//     }
-// }
-// 
-// template<int Ndim>
-// template<class Vec, class Vec2, class Mat>
-// void AMHCopula<Ndim>::rllh_grad_hess_accumulate(const Vec &u, double &rllh, Vec2 &grad, Mat &hess) const
-// {
-//     auto gterms = compute_d2_gen_terms(theta(),u);
-//     rllh += gterms.log_dn_gen_t;
-//     NdimVecT  d1_igen_u;
-//     for(int i=0; i<Ndim; i++) {
-//         auto igterms = compute_d2_igen_terms(theta(),u(i));
-//         rllh += log(-igterms.d1_igen_ui);
-//         grad(i) += igterms.d1_igen_ui * gterms.eta_n_np1_t + igterms.ieta_21_ui;
-//         hess(i,i) += square(igterms.d1_igen_ui)*gterms.xi_n_t + igterms.d2_igen_ui*gterms.eta_n_np1_t + igterms.ixi_1_ui;
-//         d1_igen_u(i) = igterms.d1_igen_ui;
-//         for(int j=0; j<i; j++) hess(j,i) += d1_igen_u(i)*d1_igen_u(j)*gterms.xi_n_t;
-//     }
-// }
-// 
-// template<int Ndim>
-// template<class Vec>
-// typename AMHCopula<Ndim>::DTheta_GenTerms 
-// void AMHCopula<Ndim>::compute_dtheta_gen_terms(double theta, const Vec &u)
-// {
-//     DTheta_GenTerms terms;
-//     double theta_m_1 = theta-1;
-//     double theta_inv = 1/theta;
-//     double z = compute_z(theta,u); // z(\theta,t) = \theta*\exp{-\sum_{i=1}^n \igen(u_i)}
-//     double ep_nm1_z = eulerian_polynomial<Ndim-1>(z);
-//     double eta_n_np1_t = eulerian_polynomial<Ndim>(z) / ((z-1)*ep_nm1_z);
-//     terms.log_dn_gen_t = log(fabs(theta_m_1*theta_inv*(z/pow(1-z,Ndim+1))*ep_nm1_z));
-//     terms.eta_0n_1n_t = theta_inv * (eta_n_np1_t + 1/theta_m_1);
-//     return terms;
-// }
-// 
-// template<int Ndim>
-// template<class Vec>
-// typename AMHCopula<Ndim>::DTheta_IGenTerms 
-// AMHCopula<Ndim>::compute_dtheta_igen_terms(double theta, const Vec &u)
-// {
-//     DTheta_IGenTerms terms; //Initialized to 0 in constructor
-//     double theta_m_1 = theta-1;
-//     for(int i=0; i<Ndim; i++) {
-//         double ui = u(i);
-//         double W = theta*ui - theta_m_1;  // W(theta, u(i)) = W*u(i) - theta + 1
-//         double d1_igen_ui =  theta_m_1/(ui*W); // (d/dt) \widetilde{\phi}(u_i)
-//         double d10_igen_ui = (u_i-1)/W; // (d/dtheta) \widetilde{\phi}(u_i)
-//         double ieta_01_11_ui = square(W)/d1_igen_ui; // \widetilde{\eta}_{(0,1)}^{(1,1)}(u_i)
-//         assert(d1_igen_ui >= 0);
-//         terms.sum_log_d1_igen_u += log(-d1_igen_ui);        
-//         terms.sum_d10_igen_u += d10_igen_ui;
-//         terms.sum_ieta_01_11_u += ieta_01_11_ui;
-//     }
-//     return terms;
-// }
-// 
-// template<int Ndim>
-// template<class Vec>
-// typename AMHCopula<Ndim>::D2Theta_GenTerms 
-// void AMHCopula<Ndim>::compute_d2theta_gen_terms(double theta, const Vec &u)
-// {
-//     D2Theta_GenTerms terms;
-//     double theta_m_1 = theta-1;
-//     double theta_inv = 1/theta;
-//     double z = compute_z(theta,u); // z(\theta,t) = \theta*\exp{-\sum_{i=1}^n \igen(u_i)}
-//     double ep_nm1_z = eulerian_polynomial<Ndim-1>(z);
-//     double eta_n_np1_t = eulerian_polynomial<Ndim>(z) / ((z-1)*ep_nm1_z);
-//     double xi_n_t = eulerian_polynomial<Ndim+1>(z) /(square(z-1)*ep_nm1_z) - square(eta_n_np1_t);
-//     terms.log_dn_gen_t = log(fabs(theta_m_1*theta_inv*(z/pow(1-z,Ndim+1))*ep_nm1_z));
-//     terms.eta_0n_1n_t = theta_inv * (eta_n_np1_t + 1/theta_m_1);
-//     terms.xi_0n_t = square(theta_inv) * ((1-2*theta)/square(theta_m_1) - eta_n_np1_t + xi_n_t)
-//     return terms;
-// }
-// 
-// template<int Ndim>
-// template<class Vec>
-// typename AMHCopula<Ndim>::D2Theta_IGenTerms 
-// AMHCopula<Ndim>::compute_d2theta_igen_terms(double theta, const Vec &u)
-// {
-//     D2Theta_IGenTerms terms; //Initialized to 0 in constructor
-//     double theta_m_1 = theta-1;
-//     for(int i=0; i<Ndim; i++) {
-//         double ui = u(i);
-//         double W = theta*ui - theta_m_1;  // W(theta, u(i)) = W*u(i) - theta + 1
-//         double ui_inv = 1/ui;
-//         double W_inv = 1/W;
-//         double d1_igen_ui =  theta_m_1*ui_inv*W_inv; // (d/dt) \widetilde{\phi}(u_i)
-//         double d10_igen_ui = (u_i-1)*W_inv; // (d/dtheta) \widetilde{\phi}(u_i)
-//         double ieta_01_11_ui = square(W)/d1_igen_ui; // \widetilde{\eta}_{(0,1)}^{(1,1)}(u_i)
-//         double d20_igen_ui = -square(d_10_igen_ui); // (d^2/dtheta^2) \widetilde{\phi}(u_i)
-//         double ixi_01_ui = (ui-2*W)/d1_igen_ui; // \widetilde{\xi}_{(0,1)}(u_i)
-//         assert(d1_igen_ui >= 0);
-//         terms.sum_log_d1_igen_u += log(-d1_igen_ui);        
-//         terms.sum_d10_igen_u += d10_igen_ui;
-//         terms.sum_ieta_01_11_u += ieta_01_11_ui;
-//         terms.sum_d20_igen_u += d20_igen_ui;
-//         terms.sum_ixi_01_u += ixi_01_ui;
-//     }
-//     return terms;
-// }
-// 
-// template<int Ndim>
-// template<class Vec>
-// void AMHCopula<Ndim>::rllh_dtheta_accumulate(double theta, const Vec &u, double &rllh, double &dtheta)
-// {
-//     auto gterms = compute_dtheta_gen_terms(theta,u);
-//     auto igterms = compute_dtheta_igen_terms(theta,u);
-//     rllh += gterms.log_dn_gen_t + igterms.sum_log_d1_igen_u;
-//     dtheta += gterms.eta_0n_1n_t*igterms.sum_d10_iget_t + igterms.sum_ieta_01_11_u;
-// }
-// 
-// template<int Ndim>
-// template<class Vec>
-// void AMHCopula<Ndim>::rllh_d2theta_accumulate(double theta, const Vec &u, double &rllh, double &dtheta, double &d2theta)
-// {
-//     auto gterms = compute_d2theta_gen_terms(theta,u);
-//     auto igterms = compute_d2theta_igen_terms(theta,u);
-//     rllh += gterms.log_dn_gen_t + igterms.sum_log_d1_igen_u;
-//     dtheta += gterms.eta_0n_1n_t*igterms.sum_d10_iget_t + igterms.sum_ieta_01_11_u;
-//     d2theta += gterms.eta_0n_1n_t*igterms.sum_d20_igen_t + gterms.xi_0_n_t*igterms.sum_d10_igen_t + igterms.sum_ixi_0_1_u;
-// }
+/* With W(i) = 1-theta+theta*u(i) and z = theta*prod(u(i)/W(i)) = theta*exp(-igen_sum(u)), the log-density is
+ *      rllh(u) = (Ndim+1)*log(1-theta) - 2*sum(log(W(i))) + h(z),
+ *      h(z) = log(A_Ndim(z)) - (Ndim+1)*log(1-z),
+ * where A_Ndim = polylog::eulerian_polynomial<Ndim-1>, so that polylog<-Ndim>(z) = z*A_Ndim(z)/(1-z)^(Ndim+1).
+ * With g(i) = (1-theta)/(u(i)*W(i)), dz/du(i) = z*g(i), giving
+ *      grad(i) = -2*theta/W(i) + z*h'(z)*g(i)
+ *      hess(i,j) = (z^2*h''(z) + z*h'(z))*g(i)*g(j) + delta(i,j)*(2*(theta/W(i))^2 - z*h'(z)*g(i)*(1/u(i)+theta/W(i)))
+ * This form is smooth through theta=0, where the copula is the independence copula.
+ */
+template<int Ndim>
+template<class Vec>
+typename AMHCopula<Ndim>::RllhTerms 
+AMHCopula<Ndim>::compute_rllh_terms(double theta, const Vec &u)
+{
+    RllhTerms terms;
+    double one_m_theta = 1-theta;
+    double z = theta;
+    double sum_log_W = 0;
+    for(IdxT i=0; i<Ndim; i++) {
+        terms.W(i) = one_m_theta + theta*u(i);
+        terms.g(i) = one_m_theta/(u(i)*terms.W(i));
+        z *= u(i)/terms.W(i);
+        sum_log_W += log(terms.W(i));
+    }
+    double a0, a1, a2;
+    polylog::eulerian_polynomial_derivatives<Ndim-1>(z,a0,a1,a2);
+    double one_m_z = 1-z;
+    if(theta>0) {
+        //As theta->1 and u->1, z->1 and 1-z cancels.  Since W(i)/u(i) = 1+(1-theta)*(1-u(i))/u(i), log(z) is
+        //accurate from log1p terms, and 1-z = -expm1(log(z)) keeps full relative precision.
+        double log_z = std::log1p(-one_m_theta);
+        for(IdxT i=0; i<Ndim; i++) log_z -= std::log1p(one_m_theta*(1-u(i))/u(i));
+        one_m_z = -std::expm1(log_z);
+    }
+    double r1 = a1/a0;
+    terms.rllh = (Ndim+1)*(log(one_m_theta) - log(one_m_z)) - 2*sum_log_W + log(a0);
+    terms.z = z;
+    terms.h1 = r1 + (Ndim+1)/one_m_z;
+    terms.h2 = a2/a0 - square(r1) + (Ndim+1)/square(one_m_z);
+    terms.z_h1 = z*terms.h1;
+    terms.z2_h2 = square(z)*terms.h2;
+    return terms;
+}
+
+/* Diagonal-only part of the hessian */
+template<int Ndim>
+double AMHCopula<Ndim>::hess_diag_term(double theta, double ui, const RllhTerms &terms, IdxT i)
+{
+    double theta_W = theta/terms.W(i);
+    return 2*square(theta_W) - terms.z_h1*terms.g(i)*(1/ui + theta_W);
+}
+
+/* Since dW(i)/dtheta = u(i)-1, with p = z/theta = prod(u(i)/W(i)),
+ *      dz/dtheta = p*(1-theta*s1)
+ *      d2z/dtheta2 = p*(theta*(s1^2+s2) - 2*s1),
+ * which, like the rllh terms, are smooth through theta=0.
+ */
+template<int Ndim>
+template<class Vec>
+typename AMHCopula<Ndim>::ThetaTerms 
+AMHCopula<Ndim>::compute_theta_terms(double theta, const Vec &u, const RllhTerms &terms)
+{
+    ThetaTerms tterms;
+    tterms.s1 = 0;
+    tterms.s2 = 0;
+    double p = 1;
+    for(IdxT i=0; i<Ndim; i++) {
+        double v = (u(i)-1)/terms.W(i);
+        tterms.s1 += v;
+        tterms.s2 += square(v);
+        p *= u(i)/terms.W(i);
+    }
+    tterms.dz = p*(1-theta*tterms.s1);
+    tterms.d2z = p*(theta*(square(tterms.s1)+tterms.s2) - 2*tterms.s1);
+    return tterms;
+}
+
+/* d/dtheta rllh = -(Ndim+1)/(1-theta) - 2*s1 + h'(z)*dz/dtheta */
+template<int Ndim>
+double AMHCopula<Ndim>::dtheta_term(double theta, const RllhTerms &terms, const ThetaTerms &tterms)
+{
+    return -(Ndim+1)/(1-theta) - 2*tterms.s1 + terms.h1*tterms.dz;
+}
+
+/* d2/dtheta2 rllh = -(Ndim+1)/(1-theta)^2 + 2*s2 + h''(z)*(dz/dtheta)^2 + h'(z)*d2z/dtheta2 */
+template<int Ndim>
+double AMHCopula<Ndim>::d2theta_term(double theta, const RllhTerms &terms, const ThetaTerms &tterms)
+{
+    return -(Ndim+1)/square(1-theta) + 2*tterms.s2 + terms.h2*square(tterms.dz) + terms.h1*tterms.d2z;
+}
+
+template<int Ndim>
+template<class Vec>
+void AMHCopula<Ndim>::rllh_dtheta_accumulate(double theta, const Vec &u, double &rllh, double &dtheta)
+{
+    auto terms = compute_rllh_terms(theta,u);
+    auto tterms = compute_theta_terms(theta,u,terms);
+    rllh += terms.rllh;
+    dtheta += dtheta_term(theta,terms,tterms);
+}
+
+template<int Ndim>
+template<class Vec>
+void AMHCopula<Ndim>::rllh_d2theta_accumulate(double theta, const Vec &u, double &rllh, double &dtheta, double &d2theta)
+{
+    auto terms = compute_rllh_terms(theta,u);
+    auto tterms = compute_theta_terms(theta,u,terms);
+    rllh += terms.rllh;
+    dtheta += dtheta_term(theta,terms,tterms);
+    d2theta += d2theta_term(theta,terms,tterms);
+}
+
+/* With dg(i)/dtheta = -1/W(i)^2, differentiating grad(i) gives
+ *      d2/dtheta du(i) rllh = -2/W(i)^2 + dz/dtheta*(h'(z) + z*h''(z))*g(i) - z*h'(z)/W(i)^2
+ */
+template<int Ndim>
+template<class Vec, class Vec2, class Mat>
+void AMHCopula<Ndim>::rllh_grad_hess_dtheta_accumulate(const Vec &u, double &rllh, Vec2 &grad, Mat &hess, 
+                                                        double &dtheta, double &d2theta, Vec2 &grad_dtheta) const
+{
+    auto terms = compute_rllh_terms(theta(),u);
+    auto tterms = compute_theta_terms(theta(),u,terms);
+    rllh += terms.rllh;
+    double c = terms.z2_h2+terms.z_h1;
+    double c_theta = tterms.dz*(terms.h1 + terms.z*terms.h2);
+    for(IdxT j=0; j<Ndim; j++) {
+        double W_inv2 = 1/square(terms.W(j));
+        grad(j) += -2*_theta/terms.W(j) + terms.z_h1*terms.g(j);
+        for(IdxT i=0; i<j; i++) hess(i,j) += c*terms.g(i)*terms.g(j);
+        hess(j,j) += c*square(terms.g(j)) + hess_diag_term(theta(),u(j),terms,j);
+        grad_dtheta(j) += -(2+terms.z_h1)*W_inv2 + c_theta*terms.g(j);
+    }
+    dtheta += dtheta_term(theta(),terms,tterms);
+    d2theta += d2theta_term(theta(),terms,tterms);
+}
 
 template<int Ndim>
 template<class RngT>
 typename AMHCopula<Ndim>::NdimVecT 
-AMHCopula<Ndim>::sample(RngT &) const
+AMHCopula<Ndim>::sample(RngT &rng) const
+{
+    NdimVecT u;
+    if(_theta >= 0) sample_frailty(u.begin(),rng);
+    else sample_conditional(u.begin(),rng);
+    return u;
+}
+
+template<int Ndim>
+template<class RngT>
+MatT AMHCopula<Ndim>::sample(RngT &rng, IdxT num_samples) const
 {
-    return {};
+    MatT u(Ndim,num_samples);
+    if(_theta >= 0) for(IdxT n=0; n<num_samples; n++) sample_frailty(u.begin_col(n),rng);
+    else for(IdxT n=0; n<num_samples; n++) sample_conditional(u.begin_col(n),rng);
+    return u;
+}
+
+/* Uniform on the open interval (0,1), so that samples are never exactly on the boundary */
+template<int Ndim>
+template<class RngT>
+double AMHCopula<Ndim>::open_uniform(RngT &rng)
+{
+    std::uniform_real_distribution<double> uniform;
+    double u;
+    do { u = uniform(rng); } while(u==0);
+    return u;
+}
+
+/* V = 1 + floor(log(U)/log(theta)) is Geometric(1-theta).  gen(E/V) = (1-theta)/(expm1(E/V) + 1-theta) is
+ * evaluated with expm1 to keep precision for theta near 1.
+ */
+template<int Ndim>
+template<class IterT, class RngT>
+void AMHCopula<Ndim>::sample_frailty(IterT u, RngT &rng) const
+{
+    double one_m_theta = 1-_theta;
+    double V = 1;
+    if(_theta > 0) V += std::floor(log(open_uniform(rng))/log(_theta));
+    for(IdxT i=0; i<Ndim; i++) {
+        double E = -log(open_uniform(rng));
+        *u++ = one_m_theta / (std::expm1(E/V) + one_m_theta);
+    }
+}
+
+/* With s = sum_{i<k} igen(u(i)), the conditional cdf of u(k) given u(0..k-1) is 
+ * gen^{(k)}(s+igen(u(k)))/gen^{(k)}(s).  Writing gen^{(k)} in terms of polylog<-k>(z), with z = theta*exp(-s) and
+ * r = exp(-igen(u(k))), the conditional cdf is
+ *      F(r) = r*((1-z)/(1-z*r))^(k+1) * A_k(z*r)/A_k(z),
+ * where A_k is the Eulerian polynomial with A_k(0)=1.  F(r)=w is solved for r, then u(k) = gen(-log(r)).
+ */
+template<int Ndim>
+template<class IterT, class RngT>
+void AMHCopula<Ndim>::sample_conditional(IterT u, RngT &rng) const
+{
+    const int max_iter = 64;
+    double one_m_theta = 1-_theta;
+    double u0 = open_uniform(rng);
+    *u++ = u0;
+    double z = _theta*u0/(one_m_theta+_theta*u0);
+    for(IdxT k=1; k<Ndim; k++) {
+        double w = open_uniform(rng);
+        double r;
+        if(k==1) {
+            //Quadratic in sqrt(r), in the form that is stable as z->0
+            double a = 1-z;
+            r = square(2*sqrt(w)/(a + sqrt(a*a + 4*w*z)));
+        } else {
+            //A_k(x) = eulerian_polynomial<k-1>(x), with k only known at run time
+            auto eulerian = [&](double x) { return polylog::eulerian_polynomial<Ndim-1>(k-1,x); };
+            double A_z = eulerian(z);
+            double lb = 0, ub = 1;
+            for(int n=0; n<max_iter && ub-lb > std::numeric_limits<double>::epsilon(); n++) {
+                double mid = .5*(lb+ub);
+                if(mid*std::pow((1-z)/(1-z*mid),k+1)*eulerian(z*mid)/A_z < w) lb = mid;
+                else ub = mid;
+            }
+            r = .5*(lb+ub);
+        }
+        double uk = one_m_theta*r/(1-_theta*r);
+        *u++ = uk;
+        z *= uk/(one_m_theta+_theta*uk);
+    }
 }
 
 
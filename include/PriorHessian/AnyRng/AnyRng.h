@@ -8,16 +8,35 @@
  * type-erased container for use in passing a generic random number generator in code that cannot be
  * templated (e.g., virtual function calls, or in combination with other type-erasure methods).
  * 
+ * Each operator() call on an AnyRng is a virtual call.  For code that draws many numbers, generate_block fills an
+ * array with a single virtual call, and BufferedRng wraps an AnyRng as a generator that reads from such a block.
  */
 #ifndef _ANY_RNG_ANYRNG_H
 #define _ANY_RNG_ANYRNG_H
 #include <typeinfo>
 #include <memory>
 #include <type_traits>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
 
 namespace any_rng
 {
 
+namespace detail {
+    template<class... Ts> struct make_void { using type = void; };
+
+    /* A generator can be rewound if its state can be saved by copying and it can discard numbers */
+    template<class RngT, class=void> 
+    struct is_rewindable : std::false_type {};
+    
+    template<class RngT> 
+    struct is_rewindable<RngT, typename make_void<decltype(std::declval<RngT&>().discard(0ULL))>::type>
+        : std::integral_constant<bool, std::is_copy_constructible<RngT>::value && std::is_copy_assignable<RngT>::value> {};
+} /* namespace any_rng::detail */
+
 /** Generic, type-erased container for a random number generator.
  * 
  * Stores a reference to rng.  This is by design.  This will become invalid 
@@ -41,7 +60,16 @@ public:
     ResultT max() const { return handle->max(); }
     void seed(ResultT seed=0) { handle->seed(seed); }
     ResultT operator()() { return handle->generate(); }
+    /* Fill out[0..n-1] with the next n numbers, exactly as n calls to operator() would */
+    void generate_block(ResultT *out, std::size_t n) { handle->generate_block(out,n); }
     void discard( ResultT z) { return handle->discard(z); }
+    /* Save a copy of the generator state, and later restore it and discard n numbers.  Used by BufferedRng to
+     * return unused buffered numbers.  Only generators that are copy-assignable and have discard can be rewound; for
+     * others can_rewind() is false, mark() does nothing, and rewind_to_mark() throws std::logic_error.
+     */
+    bool can_rewind() const { return handle->can_rewind(); }
+    void mark() { handle->mark(); }
+    void rewind_to_mark(unsigned long long n) { handle->rewind_to_mark(n); }
     
 private:
     class RngHandle
@@ -53,7 +81,11 @@ private:
         virtual ResultT max() const = 0;        
         virtual void seed(ResultT seed) = 0;
         virtual ResultT generate() = 0;
+        virtual void generate_block(ResultT *out, std::size_t n) = 0;
         virtual void discard( ResultT z) = 0;
+        virtual bool can_rewind() const = 0;
+        virtual void mark() = 0;
+        virtual void rewind_to_mark(unsigned long long n) = 0;
     };
     
     template<class RngT>
@@ -65,14 +97,108 @@ private:
         ResultT max() const override { return rng.max(); }        
         void seed(ResultT seed) override { rng.seed(seed); }
         ResultT generate() override { return rng(); }
+        void generate_block(ResultT *out, std::size_t n) override 
+        { 
+            //Generate into a local chunk first.  Writes through out could alias the generator state, which would
+            //force the compiler to reload the state on every draw.
+            constexpr std::size_t chunk = 64;
+            ResultT local[chunk];
+            while(n>0) {
+                std::size_t m = n<chunk ? n : chunk;
+                for(std::size_t i=0; i<m; i++) local[i] = rng();
+                std::copy(local, local+m, out);
+                out += m;
+                n -= m;
+            }
+        }
         void discard( ResultT z) override { rng.discard(z); }
+        bool can_rewind() const override { return Rewindable::value; }
+        void mark() override { mark(Rewindable{}); }
+        void rewind_to_mark(unsigned long long n) override { rewind_to_mark(n,Rewindable{}); }
     private:
+        using Rewindable = detail::is_rewindable<RngT>;
         RngT &rng;
+        std::unique_ptr<RngT> marked; //State saved by mark()
+        
+        void mark(std::true_type)
+        {
+            if(marked) *marked = rng;
+            else marked.reset(new RngT(rng));
+        }
+        void mark(std::false_type) { }
+        void rewind_to_mark(unsigned long long n, std::true_type)
+        {
+            if(!marked) throw std::logic_error("AnyRng::rewind_to_mark called without a mark.");
+            rng = *marked;
+            rng.discard(n);
+        }
+        void rewind_to_mark(unsigned long long, std::false_type)
+        { throw std::logic_error("AnyRng::rewind_to_mark: generator is not copy-assignable with discard."); }
     };
     
     std::unique_ptr<RngHandle> handle;
 };
 
+/** Buffered view of an AnyRng, refilled BlockSize numbers at a time with AnyRng::generate_block.
+ * 
+ * Drawing a number is an array read rather than a virtual call.  Just as important, min() and max() are constexpr.
+ * The std distributions use them to scale each draw, and with the run-time min() and max() of AnyRng that costs
+ * virtual calls and, in std::generate_canonical, a log on every draw.  This requires the source to produce the full
+ * range of ResultT, as std::mt19937_64 does; use is_full_range to check.
+ * 
+ * The BufferedRng draws ahead from the underlying generator, but the numbers drawn through it are the same sequence the
+ * AnyRng would have produced.  With exact_position (the default) and a generator that AnyRng::can_rewind, it also
+ * returns the unused numbers in its buffer on destruction: each refill saves the generator state with AnyRng::mark,
+ * and the destructor restores it and discards the numbers used from the last block.  So, the underlying generator is
+ * left at exactly the position it would have after drawing the same numbers directly.  Saving the state copies the
+ * generator once per block, e.g., 2.5kB for std::mt19937_64.  Callers that do not need the exact end position can
+ * pass exact_position=false to skip the copies; the generator is then left at the end of the last block.
+ * 
+ * Stores a reference to the AnyRng, which must outlive it.
+ */
+template<class ResultT, std::size_t BlockSize=256>
+class BufferedRng
+{
+public:
+    static_assert(std::is_unsigned<ResultT>::value, "BufferedRng requires an unsigned result type.");
+    static_assert(BlockSize>0, "BlockSize must be positive.");
+    using result_type = ResultT;
+    static constexpr ResultT min() { return 0; }
+    static constexpr ResultT max() { return std::numeric_limits<ResultT>::max(); }
+    static bool is_full_range(const AnyRng<ResultT> &rng) { return rng.min()==min() && rng.max()==max(); }
+
+    explicit BufferedRng(AnyRng<ResultT> &rng_, bool exact_position=true) 
+        : rng(rng_), rewind(exact_position && rng_.can_rewind()), pos(BlockSize)
+    { 
+        if(!is_full_range(rng)) throw std::invalid_argument("BufferedRng requires a generator with the full range of its result_type.");
+    }
+    BufferedRng(const BufferedRng&) = delete; //Copies would repeat the same buffered numbers
+    BufferedRng& operator=(const BufferedRng&) = delete;
+    ~BufferedRng() { if(rewind && pos<BlockSize) rng.rewind_to_mark(pos); }
+    
+    /* True if the unused numbers are returned to the generator on destruction */
+    bool returns_unused() const { return rewind; }
+
+    ResultT operator()() 
+    { 
+        if(pos==BlockSize) refill();
+        return buffer[pos++]; 
+    }
+    
+private:
+    AnyRng<ResultT> &rng;
+    bool rewind; //Mark each block and rewind on destruction
+    std::size_t pos;
+    std::array<ResultT,BlockSize> buffer;
+    
+    void refill()
+    {
+        if(rewind) rng.mark();
+        rng.generate_block(buffer.data(),BlockSize);
+        pos = 0;
+    }
+};
+
 } /* namespace any_rng */
 
 #endif /* _ANY_RNG_ANYRNG_H */
@@ -6,10 +6,102 @@
 #ifndef PRIOR_HESSIAN_BASEDIST_H
 #define PRIOR_HESSIAN_BASEDIST_H
 
+#include <algorithm>
+#include <cmath>
+
+#include "PriorHessian/util.h"
+
 namespace prior_hessian {
     
 class BaseDist
-{ };
+{ 
+protected:
+    /** Central finite-difference gradient and hessian of func(dist) with respect to the parameters of dist.
+     * Used by the truncation adaptors for the log of the truncated probability mass when a closed form is not
+     * available.  It is a function of the parameters only, so it need only be computed once per parameter setting.
+     * Steps are scaled by max(1,|param|), and are relative to the parameter's magnitude only if needed to stay within
+     * param_lbound() and param_ubound(), so that parameters near 0 do not get steps lost in roundoff.
+     */
+    template<class Dist, class Func>
+    static void param_grad_hess_finite_difference(const Dist &dist, Func &&func, 
+                                                  typename Dist::NparamsVecT &grad, typename Dist::NparamsMatT &hess);
+    /** Central finite-difference hessian with respect to the parameters of dist, from a closed-form gradient
+     * grad_func(dist).  The result is symmetrized.  Steps are as for param_grad_hess_finite_difference.
+     */
+    template<class Dist, class Func>
+    static void param_hess_finite_difference(const Dist &dist, Func &&grad_func, typename Dist::NparamsMatT &hess);
+    static constexpr double param_finite_difference_step = 1.0e-4;
+private:
+    template<class Dist>
+    static typename Dist::NparamsVecT param_finite_difference_steps(const Dist &dist);
+};
+
+template<class Dist>
+typename Dist::NparamsVecT BaseDist::param_finite_difference_steps(const Dist &dist)
+{
+    typename Dist::NparamsVecT p0 = dist.params();
+    typename Dist::NparamsVecT step;
+    for(IdxT i=0; i<Dist::num_params(); i++) {
+        step(i) = param_finite_difference_step * std::max(1.0, std::fabs(p0(i)));
+        if(!(p0(i)-step(i) > dist.param_lbound()(i) && p0(i)+step(i) < dist.param_ubound()(i))) 
+            step(i) = param_finite_difference_step * std::fabs(p0(i));
+    }
+    return step;
+}
+
+template<class Dist, class Func>
+void BaseDist::param_grad_hess_finite_difference(const Dist &dist, Func &&func, 
+                                                 typename Dist::NparamsVecT &grad, typename Dist::NparamsMatT &hess)
+{
+    using NparamsVecT = typename Dist::NparamsVecT;
+    constexpr IdxT Nparams = Dist::num_params();
+    const NparamsVecT p0 = dist.params();
+    const NparamsVecT step = param_finite_difference_steps(dist);
+    Dist d(dist);
+    auto eval = [&](IdxT i, double di, IdxT j, double dj) {
+        NparamsVecT p = p0;
+        p(i) += di*step(i);
+        p(j) += dj*step(j);
+        d.set_params(p);
+        return func(static_cast<const Dist&>(d));
+    };
+    double f0 = func(dist);
+    for(IdxT i=0; i<Nparams; i++) {
+        double fp = eval(i,1,i,0);
+        double fm = eval(i,-1,i,0);
+        grad(i) = (fp-fm)/(2*step(i));
+        hess(i,i) = (fp-2*f0+fm)/square(step(i));
+        for(IdxT j=0; j<i; j++) {
+            double fpp = eval(i,1,j,1);
+            double fpm = eval(i,1,j,-1);
+            double fmp = eval(i,-1,j,1);
+            double fmm = eval(i,-1,j,-1);
+            hess(i,j) = hess(j,i) = (fpp-fpm-fmp+fmm)/(4*step(i)*step(j));
+        }
+    }
+}
+
+template<class Dist, class Func>
+void BaseDist::param_hess_finite_difference(const Dist &dist, Func &&grad_func, typename Dist::NparamsMatT &hess)
+{
+    using NparamsVecT = typename Dist::NparamsVecT;
+    using NparamsMatT = typename Dist::NparamsMatT;
+    const NparamsVecT p0 = dist.params();
+    const NparamsVecT step = param_finite_difference_steps(dist);
+    Dist d(dist);
+    NparamsMatT h;
+    for(IdxT i=0; i<Dist::num_params(); i++) {
+        NparamsVecT p = p0;
+        p(i) += step(i);
+        d.set_params(p);
+        NparamsVecT gp = grad_func(static_cast<const Dist&>(d));
+        p(i) = p0(i) - step(i);
+        d.set_params(p);
+        NparamsVecT gm = grad_func(static_cast<const Dist&>(d));
+        h.col(i) = (gp-gm)/(2*step(i));
+    }
+    hess = .5*(h + h.t());
+}
 
 } /* namespace prior_hessian */
 #endif /* PRIOR_HESSIAN_BASEDIST_H */
@@ -0,0 +1,60 @@
+/** @file BatchThreadPool.h
+ * @author Mark J. Olah (mjo\@cs.unm DOT edu)
+ * @date 2019
+ * @brief BatchThreadPool class declaration
+ *
+ */
+#ifndef PRIOR_HESSIAN_BATCHTHREADPOOL_H
+#define PRIOR_HESSIAN_BATCHTHREADPOOL_H
+
+#include<vector>
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<functional>
+#include<cstdint>
+
+#include "PriorHessian/util.h"
+
+namespace prior_hessian {
+
+/** @brief Persistent worker threads for parallel batched evaluation in CompositeDist.
+ *
+ * run(nthreads,task) calls task(t) for each t in [0,nthreads), with t=0 in the calling thread and the others in pooled
+ * worker threads, and returns once all calls are done.  Workers are created on first use, grown as needed, and wait
+ * between runs, so batched calls do not pay for thread creation.  task must not throw.
+ *
+ * One run executes at a time.  A run requested while another is in progress, from another thread or from within a
+ * task, calls task(t) for each t serially in the calling thread instead of waiting, so it cannot deadlock.
+ */
+class BatchThreadPool
+{
+public:
+    static BatchThreadPool& instance(); /* Process-wide pool used by CompositeDist */
+
+    BatchThreadPool() = default;
+    BatchThreadPool(const BatchThreadPool &) = delete;
+    BatchThreadPool& operator=(const BatchThreadPool &) = delete;
+    ~BatchThreadPool();
+
+    IdxT num_workers() const;
+    void run(IdxT nthreads, const std::function<void(IdxT)> &task);
+
+private:
+    void worker_loop(IdxT t, std::uint64_t generation);
+
+    std::vector<std::thread> workers;
+    std::mutex run_mutex; //Held by the calling thread for the duration of a run
+    mutable std::mutex mutex; //Protects the members below
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    const std::function<void(IdxT)> *task = nullptr;
+    IdxT task_nthreads = 0;
+    IdxT num_pending = 0;
+    std::uint64_t generation = 0; //Incremented to start each run
+    bool stopping = false;
+};
+
+} /* namespace prior_hessian */
+
+#endif /* PRIOR_HESSIAN_BATCHTHREADPOOL_H */
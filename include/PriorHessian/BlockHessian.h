@@ -0,0 +1,69 @@
+/** @file BlockHessian.h
+ * @author Mark J. Olah (mjo\@cs.unm DOT edu)
+ * @date 2019
+ * @brief BlockHessian class declaration
+ *
+ */
+#ifndef PRIOR_HESSIAN_BLOCKHESSIAN_H
+#define PRIOR_HESSIAN_BLOCKHESSIAN_H
+
+#include<vector>
+
+#include<armadillo>
+
+#include "PriorHessian/util.h"
+#include "PriorHessian/PriorHessianError.h"
+
+namespace prior_hessian {
+
+/** @brief A block-diagonal Hessian, stored as a dense block for each component of a CompositeDist.
+ *
+ * The hessian of a CompositeDist is block-diagonal by construction, as the components are independent.  Storing only the
+ * blocks means solve, logdet, and inverse cost O(sum b_i^3) instead of O(N^3) for N=sum b_i.
+ *
+ * Like CompositeDist::hess, accumulation only fills the upper triangle of each block.  All other methods treat
+ * the blocks as symmetric matrices, so to_dense() and to_sp_mat() return the full symmetric matrix.
+ */
+class BlockHessian
+{
+public:
+    BlockHessian() = default;
+    /** @brief Construct a zero-valued hessian with the given block sizes */
+    explicit BlockHessian(const UVecT &block_sizes);
+
+    IdxT num_dim() const { return _num_dim; }
+    IdxT num_blocks() const { return _blocks.size(); }
+    const UVecT& block_sizes() const { return _block_sizes; }
+    const UVecT& block_offsets() const { return _block_offsets; }
+    IdxT block_size(IdxT i) const { return _block_sizes(i); }
+    IdxT block_offset(IdxT i) const { return _block_offsets(i); }
+    MatT& block(IdxT i) { return _blocks[i]; }
+    const MatT& block(IdxT i) const { return _blocks[i]; }
+
+    void zeros();
+
+    MatT to_dense() const;
+    arma::sp_mat to_sp_mat() const;
+
+    /** Solve H*x = b, one block at a time */
+    VecT solve(const VecT &b) const;
+    /** Returns log(abs(det(H))), and the sign of the determinant in sign */
+    double logdet(double &sign) const;
+    BlockHessian inverse() const;
+
+    bool operator==(const BlockHessian &o) const;
+    bool operator!=(const BlockHessian &o) const { return !this->operator==(o); }
+
+private:
+    IdxT _num_dim = 0;
+    UVecT _block_sizes;
+    UVecT _block_offsets;
+    std::vector<MatT> _blocks;
+
+    void check_size(const VecT &b) const;
+};
+
+std::ostream& operator<<(std::ostream &out, const BlockHessian &hess);
+
+} /* namespace prior_hessian */
+#endif /* PRIOR_HESSIAN_BLOCKHESSIAN_H */
@@ -8,11 +8,16 @@
 #ifndef PRIOR_HESSIAN_COMPOSITEDIST_H
 #define PRIOR_HESSIAN_COMPOSITEDIST_H
 
+#include<algorithm>
 #include<utility>
 #include<memory>
 #include<unordered_map>
 #include<unordered_set>
 #include<sstream>
+#include<thread>
+#include<atomic>
+#include<exception>
+#include<functional>
 
 #include<armadillo>
 
@@ -22,11 +27,16 @@
 #include "PriorHessian/UnivariateDist.h"
 #include "PriorHessian/MultivariateDist.h"
 #include "PriorHessian/BoundsAdaptedDist.h"
+#include "PriorHessian/BlockHessian.h"
+#include "PriorHessian/BatchThreadPool.h"
 
 #include "PriorHessian/AnyRng/AnyRng.h"
+#include "PriorHessian/rng/philox.h"
 
 namespace prior_hessian {
 
+template<class... Ts> class StaticCompositeDist;
+
 /** @brief A probability distribution made of independent component distributions composing groups of 1 or more variables.
  * 
  * CompositeDist is a world unto itself.
@@ -53,6 +63,13 @@ namespace prior_hessian {
  *   template< class RngT > double sample(RngT &rng) const;
  * }
  * 
+ * Univariate components may also have array methods, which are used for batched evaluation over the columns of a matrix:
+ *   void llh(IdxT N, const double *x, double *out) const;
+ *   void rllh(IdxT N, const double *x, double *out) const;
+ *   void grad(IdxT N, const double *x, double *out) const;
+ *   void grad2(IdxT N, const double *x, double *out) const;
+ *   void grad_grad2_accumulate(IdxT N, const double *x, double *g, double *g2) const;
+ * 
  * dim_variables and param_names are lazily computed.  If they are not accessed, they are not created.
  * 
  */
@@ -65,11 +82,14 @@ public:
     
 public:
     using AnyRngT = any_rng::AnyRng<std::size_t>;
+    /* Bulk sampling draws through this buffered adaptor when the generator has the full 64-bit range */
+    using BufferedRngT = any_rng::BufferedRng<std::size_t>;
     
     CompositeDist();
     
     /** @brief Construct from a variadic list of subclasses of UnivariateDist's or MulitvariateDist's */
-    template<class... Ts, meta::ConstructableIfAllAreNotTupleAndAreNotT<CompositeDist, Ts...> = true>
+    template<class... Ts, meta::ConstructableIfAllAreNotTupleAndAreNotT<CompositeDist, Ts...> = true,
+                          meta::ConstructableIfNoneInstantiatedFromT<StaticCompositeDist, Ts...> = true>
     explicit CompositeDist(Ts&&... dists)
         : handle{ std::make_unique<DistTuple<ComponentDistT<Ts>...>>(make_component_dist(std::forward<Ts>(dists))...) }
     { initialize_from_handle(); }
@@ -85,11 +105,16 @@ public:
     explicit CompositeDist(const std::tuple<Ts...>& dist_tuple)
         : handle{ std::make_unique<DistTuple<ComponentDistT<Ts>...>>(make_component_dist_tuple(dist_tuple)) }
     { initialize_from_handle(); }
+
+    /** @brief Construct a type-erased copy of a StaticCompositeDist.  Defined in StaticCompositeDist.h */
+    template<class... Ts>
+    explicit CompositeDist(const StaticCompositeDist<Ts...> &static_dist);
     
     void initialize() { clear(); } /** @brief Initialize to the empty state. */
     void initialize(const std::tuple<>&) { clear(); } /** @brief Initialize of an empty lvalue tuple produces the empty state. */
     void initialize(std::tuple<>&&) { clear(); } /** @brief Initialize of an empty rvalue tuple produces the empty state. */
-    template<class... Ts, typename=meta::EnableIfAllAreNotTupleT<Ts...>>
+    template<class... Ts, typename=meta::EnableIfAllAreNotTupleT<Ts...>,
+                          meta::ConstructableIfNoneInstantiatedFromT<StaticCompositeDist, Ts...> = true>
     void initialize(Ts&&... dists)
     {
         handle = std::make_unique<DistTuple<ComponentDistT<Ts>...>>(make_component_dist(std::forward<Ts>(dists))...);
@@ -110,6 +135,10 @@ public:
         initialize_from_handle();
     }
 
+    /** @brief Initialize from a StaticCompositeDist.  Defined in StaticCompositeDist.h */
+    template<class... Ts>
+    void initialize(const StaticCompositeDist<Ts...> &static_dist);
+
     
     CompositeDist(const CompositeDist &);
     CompositeDist& operator=(const CompositeDist &);     
@@ -222,10 +251,242 @@ public:
     
     /* Returns hessian as an upper triangular matrix */
     void grad_hess_accumulate(const VecT &theta, VecT &grad, MatT &hess) const { return handle->grad_hess_accumulate(theta,grad,hess); }
+    /* Fused rllh, grad, and upper triangular hess.  Components that can share work between the three, e.g., CopulaDist
+     * evaluating each marginal once, do so.
+     */
+    void rllh_grad_hess_accumulate(const VecT &theta, double &rllh, VecT &grad, MatT &hess) const 
+    { return handle->rllh_grad_hess_accumulate(theta,rllh,grad,hess); }
+    /* Workspace methods write into caller-owned buffers instead of returning newly allocated values.
+     * Buffers are zeroed, and resized only if their size is wrong, so once a buffer has been used in one call
+     * further calls do no heap allocation.
+     */
+    void grad(const VecT &theta, VecT &grad) const
+    {
+        grad.zeros(num_dim());
+        handle->grad_accumulate(theta,grad);
+    }
+
+    void grad2(const VecT &theta, VecT &grad2) const
+    {
+        grad2.zeros(num_dim());
+        handle->grad2_accumulate(theta,grad2);
+    }
+
+    /* Computes hessian as an upper triangular matrix */
+    void hess(const VecT &theta, MatT &hess) const
+    {
+        hess.zeros(num_dim(),num_dim());
+        handle->hess_accumulate(theta,hess);
+    }
+
+    void grad_grad2(const VecT &theta, VecT &grad, VecT &grad2) const
+    {
+        grad.zeros(num_dim());
+        grad2.zeros(num_dim());
+        handle->grad_grad2_accumulate(theta,grad,grad2);
+    }
+
+    /* Computes hessian as an upper triangular matrix */
+    void grad_hess(const VecT &theta, VecT &grad, MatT &hess) const
+    {
+        grad.zeros(num_dim());
+        hess.zeros(num_dim(),num_dim());
+        handle->grad_hess_accumulate(theta,grad,hess);
+    }
+
     //Convenience methods for the lazy.
     VecT make_zero_grad() const { return {num_dim(),arma::fill::zeros}; }
     MatT make_zero_hess() const { return {num_dim(),num_dim(),arma::fill::zeros}; }
-    
+
+    /* Block-diagonal hessian, with one dense upper-triangular block per component.
+     * Avoids the O(num_dim^2) storage and O(num_dim^3) factorization costs of the dense hessian.
+     */
+    BlockHessian block_hess(const VecT &theta) const
+    {
+        BlockHessian h = make_zero_block_hess();
+        handle->hess_accumulate(theta,h);
+        return h;
+    }
+    void hess_accumulate(const VecT &theta, BlockHessian &hess) const 
+    { 
+        check_block_hess(hess);
+        handle->hess_accumulate(theta,hess); 
+    }
+    void grad_hess_accumulate(const VecT &theta, VecT &grad, BlockHessian &hess) const 
+    { 
+        check_block_hess(hess);
+        handle->grad_hess_accumulate(theta,grad,hess); 
+    }
+    BlockHessian make_zero_block_hess() const { return BlockHessian{num_dim_components()}; }
+
+    /* Hessian-vector products.  Accumulates hess(theta)*v into out, one component block at a time, without forming
+     * the num_dim X num_dim hessian.  Cost is O(num_dim) for univariate components and at most O(b^2) for a multivariate
+     * component with b dimensions.  Unlike hess(), the product uses the full symmetric hessian.
+     */
+    void hessvec_accumulate(const VecT &theta, const VecT &v, VecT &out) const { handle->hessvec_accumulate(theta,v,out); }
+    VecT hessvec(const VecT &theta, const VecT &v) const
+    {
+        VecT hv(num_dim(), arma::fill::zeros);
+        handle->hessvec_accumulate(theta,v,hv);
+        return hv;
+    }
+
+    /* Derivatives of llh(theta) with respect to the parameters, in params() order.
+     * The components have disjoint parameters, so the parameter hessian is block-diagonal with a num_params X num_params
+     * block per component.  As with hess(), only the upper triangle is filled.
+     */
+    void param_grad_accumulate(const VecT &theta, VecT &pgrad) const { handle->param_grad_accumulate(theta,pgrad); }
+    void param_grad_hess_accumulate(const VecT &theta, VecT &pgrad, MatT &phess) const 
+    { handle->param_grad_hess_accumulate(theta,pgrad,phess); }
+    VecT param_grad(const VecT &theta) const
+    {
+        VecT g(num_params(), arma::fill::zeros);
+        handle->param_grad_accumulate(theta,g);
+        return g;
+    }
+
+    /* Returns parameter hessian as an upper triangular matrix */
+    MatT param_hess(const VecT &theta) const
+    {
+        VecT g(num_params(), arma::fill::zeros);
+        MatT h(num_params(), num_params(), arma::fill::zeros);
+        handle->param_grad_hess_accumulate(theta,g,h);
+        return h;
+    }
+
+    /* Batched evaluation over the columns of a matrix of points theta (size: num_dim X N).
+     * The DistTuple is entered only once per chunk of columns, and the loop over columns is done inside the statically typed tuple,
+     * so the per-point cost is only that of the component distribution computations.
+     * 
+     * If num_threads()>1, chunks of batch_chunk_size columns are evaluated in parallel.  Each column is computed independently
+     * by the same code path, so results are bit-identical for any number of threads.
+     */
+    VecT llh(const MatT &theta) const
+    {
+        VecT llh(theta.n_cols);
+        check_batch(theta);
+        initialize_llh_constants(theta);
+        for_each_batch_chunk(theta.n_cols, [&](IdxT b, IdxT e){ handle->llh(theta,llh,b,e); });
+        return llh;
+    }
+
+    VecT rllh(const MatT &theta) const
+    {
+        VecT rllh(theta.n_cols);
+        check_batch(theta);
+        for_each_batch_chunk(theta.n_cols, [&](IdxT b, IdxT e){ handle->rllh(theta,rllh,b,e); });
+        return rllh;
+    }
+
+    MatT grad(const MatT &theta) const
+    {
+        MatT g(num_dim(), theta.n_cols, arma::fill::zeros);
+        grad_accumulate(theta,g);
+        return g;
+    }
+
+    MatT grad2(const MatT &theta) const
+    {
+        MatT g2(num_dim(), theta.n_cols, arma::fill::zeros);
+        grad2_accumulate(theta,g2);
+        return g2;
+    }
+
+    /* Returns a cube of upper triangular hessians, one slice per column of theta */
+    CubeT hess(const MatT &theta) const
+    {
+        CubeT h(num_dim(), num_dim(), theta.n_cols, arma::fill::zeros);
+        hess_accumulate(theta,h);
+        return h;
+    }
+
+    /* Batched accumulate methods.  Outputs are preallocated by the caller and must be sized to match theta. */
+    void grad_accumulate(const MatT &theta, MatT &grad) const
+    { 
+        check_batch(theta,grad);
+        for_each_batch_chunk(theta.n_cols, [&](IdxT b, IdxT e){ handle->grad_accumulate(theta,grad,b,e); });
+    }
+
+    void grad2_accumulate(const MatT &theta, MatT &grad2) const
+    { 
+        check_batch(theta,grad2);
+        for_each_batch_chunk(theta.n_cols, [&](IdxT b, IdxT e){ handle->grad2_accumulate(theta,grad2,b,e); });
+    }
+
+    void hess_accumulate(const MatT &theta, CubeT &hess) const
+    { 
+        check_batch(theta,hess);
+        for_each_batch_chunk(theta.n_cols, [&](IdxT b, IdxT e){ handle->hess_accumulate(theta,hess,b,e); });
+    }
+
+    void grad_grad2_accumulate(const MatT &theta, MatT &grad, MatT &grad2) const
+    { 
+        check_batch(theta,grad);
+        check_batch(theta,grad2);
+        for_each_batch_chunk(theta.n_cols, [&](IdxT b, IdxT e){ handle->grad_grad2_accumulate(theta,grad,grad2,b,e); });
+    }
+
+    void grad_hess_accumulate(const MatT &theta, MatT &grad, CubeT &hess) const
+    { 
+        check_batch(theta,grad);
+        check_batch(theta,hess);
+        for_each_batch_chunk(theta.n_cols, [&](IdxT b, IdxT e){ handle->grad_hess_accumulate(theta,grad,hess,b,e); });
+    }
+
+    /* Batched workspace methods.  As with the single point versions the outputs are zeroed and resized only if necessary. */
+    void grad(const MatT &theta, MatT &grad) const
+    {
+        grad.zeros(num_dim(),theta.n_cols);
+        grad_accumulate(theta,grad);
+    }
+
+    void grad2(const MatT &theta, MatT &grad2) const
+    {
+        grad2.zeros(num_dim(),theta.n_cols);
+        grad2_accumulate(theta,grad2);
+    }
+
+    void hess(const MatT &theta, CubeT &hess) const
+    {
+        hess.zeros(num_dim(),num_dim(),theta.n_cols);
+        hess_accumulate(theta,hess);
+    }
+
+    /* Batched parameter derivatives.  Outputs have a column (or slice) of size num_params for each column of theta. */
+    MatT param_grad(const MatT &theta) const
+    {
+        MatT g(num_params(), theta.n_cols, arma::fill::zeros);
+        param_grad_accumulate(theta,g);
+        return g;
+    }
+
+    /* Returns a cube of upper triangular parameter hessians, one slice per column of theta */
+    CubeT param_hess(const MatT &theta) const
+    {
+        MatT g(num_params(), theta.n_cols, arma::fill::zeros);
+        CubeT h(num_params(), num_params(), theta.n_cols, arma::fill::zeros);
+        param_grad_hess_accumulate(theta,g,h);
+        return h;
+    }
+
+    void param_grad_accumulate(const MatT &theta, MatT &pgrad) const
+    { 
+        check_param_batch(theta,pgrad);
+        initialize_param_constants(theta);
+        for_each_batch_chunk(theta.n_cols, [&](IdxT b, IdxT e){ handle->param_grad_accumulate(theta,pgrad,b,e); });
+    }
+
+    void param_grad_hess_accumulate(const MatT &theta, MatT &pgrad, CubeT &phess) const
+    { 
+        check_param_batch(theta,pgrad);
+        check_param_batch(theta,phess);
+        initialize_param_constants(theta);
+        for_each_batch_chunk(theta.n_cols, [&](IdxT b, IdxT e){ handle->param_grad_hess_accumulate(theta,pgrad,phess,b,e); });
+    }
+
+    MatT make_zero_grad(IdxT N) const { return {num_dim(),N,arma::fill::zeros}; }
+    CubeT make_zero_hess(IdxT N) const { return {num_dim(),num_dim(),N,arma::fill::zeros}; }
+
     VecT sample(AnyRngT &rng) const { return handle->sample(rng); }
     VecT sample(AnyRngT &&rng) const { return handle->sample(rng); }
     MatT sample(AnyRngT &rng, IdxT num_samples) const { return handle->sample(rng,num_samples); }
@@ -245,9 +506,40 @@ public:
         return handle->sample(anyrng,num_samples); 
     }
 
+    /* Parallel sampling from counter-based streams.  Columns are generated in chunks of batch_chunk_size, and chunk c
+     * draws from its own substream, rng::philox4x64(seed,0,c).  The result depends only on seed and num_samples, so it
+     * is bit-identical for any nthreads.  nthreads=0 uses std::thread::hardware_concurrency().
+     */
+    MatT sample(IdxT num_samples, std::uint64_t seed, IdxT nthreads) const;
+
     /* Per-component values for debugging and plotting purposes */
     VecT llh_components(const VecT &u) const { return handle->llh_components(u); }
     VecT rllh_components(const VecT &u) const { return handle->rllh_components(u); }
+    /* Batched per-component values.  Returns a matrix of size num_components X N */
+    MatT llh_components(const MatT &theta) const
+    {
+        MatT llh(num_components(),theta.n_cols);
+        check_batch(theta);
+        initialize_llh_constants(theta);
+        for_each_batch_chunk(theta.n_cols, [&](IdxT b, IdxT e){ handle->llh_components(theta,llh,b,e); });
+        return llh;
+    }
+
+    MatT rllh_components(const MatT &theta) const
+    {
+        MatT rllh(num_components(),theta.n_cols);
+        check_batch(theta);
+        for_each_batch_chunk(theta.n_cols, [&](IdxT b, IdxT e){ handle->rllh_components(theta,rllh,b,e); });
+        return rllh;
+    }
+
+    /* Threading for batched evaluation.
+     * num_threads=1 (default) evaluates serially in the calling thread.  num_threads=0 uses std::thread::hardware_concurrency().
+     */
+    IdxT num_threads() const { return _num_threads; }
+    void set_num_threads(IdxT n) { _num_threads = n>0 ? n : std::max(IdxT{1}, static_cast<IdxT>(std::thread::hardware_concurrency())); }
+    /* Columns per work unit.  Fixed (independent of num_threads) so the partition of work is deterministic. */
+    static constexpr IdxT batch_chunk_size = 256;
 
 private:
     
@@ -289,10 +581,28 @@ private:
         virtual void hess_accumulate(const VecT &u, MatT &hess) const = 0;
         virtual void grad_grad2_accumulate(const VecT &u, VecT &grad, VecT &grad2) const = 0;
         virtual void grad_hess_accumulate(const VecT &u, VecT &grad, MatT &hess) const = 0;
+        virtual void rllh_grad_hess_accumulate(const VecT &u, double &rllh, VecT &grad, MatT &hess) const = 0;
+        virtual void hess_accumulate(const VecT &u, BlockHessian &hess) const = 0;
+        virtual void grad_hess_accumulate(const VecT &u, VecT &grad, BlockHessian &hess) const = 0;
+        virtual void hessvec_accumulate(const VecT &u, const VecT &v, VecT &out) const = 0;
+        virtual void param_grad_accumulate(const VecT &u, VecT &pgrad) const = 0;
+        virtual void param_grad_hess_accumulate(const VecT &u, VecT &pgrad, MatT &phess) const = 0;
         virtual VecT sample(AnyRngT &rng) const = 0;
         virtual MatT sample(AnyRngT &rng, IdxT nSamples) const = 0;
         virtual VecT llh_components(const VecT &u) const = 0;
         virtual VecT rllh_components(const VecT &u) const = 0;
+        /* Batched evaluation over columns [begin,end) of u.  Outputs are preallocated with a column (or slice) for each column of u. */
+        virtual void llh(const MatT &u, VecT &llh, IdxT begin, IdxT end) const = 0;
+        virtual void rllh(const MatT &u, VecT &rllh, IdxT begin, IdxT end) const = 0;
+        virtual void grad_accumulate(const MatT &u, MatT &grad, IdxT begin, IdxT end) const = 0;
+        virtual void grad2_accumulate(const MatT &u, MatT &grad2, IdxT begin, IdxT end) const = 0;
+        virtual void hess_accumulate(const MatT &u, CubeT &hess, IdxT begin, IdxT end) const = 0;
+        virtual void grad_grad2_accumulate(const MatT &u, MatT &grad, MatT &grad2, IdxT begin, IdxT end) const = 0;
+        virtual void grad_hess_accumulate(const MatT &u, MatT &grad, CubeT &hess, IdxT begin, IdxT end) const = 0;
+        virtual void param_grad_accumulate(const MatT &u, MatT &pgrad, IdxT begin, IdxT end) const = 0;
+        virtual void param_grad_hess_accumulate(const MatT &u, MatT &pgrad, CubeT &phess, IdxT begin, IdxT end) const = 0;
+        virtual void llh_components(const MatT &u, MatT &llh, IdxT begin, IdxT end) const = 0;
+        virtual void rllh_components(const MatT &u, MatT &rllh, IdxT begin, IdxT end) const = 0;
     }; /* class DistTupleHandle */
     
     template<class... Ts>
@@ -410,6 +720,13 @@ private:
         void hess_accumulate(const VecT &u, MatT &h) const override { hess_accumulate(u,h,IndexT()); }
         void grad_grad2_accumulate(const VecT &u, VecT &g, VecT &g2) const override { grad_grad2_accumulate(u,g,g2,IndexT()); }
         void grad_hess_accumulate(const VecT &u, VecT &g, MatT &h) const override { grad_hess_accumulate(u,g,h,IndexT()); }
+        void rllh_grad_hess_accumulate(const VecT &u, double &rllh, VecT &g, MatT &h) const override 
+        { rllh_grad_hess_accumulate(u,rllh,g,h,IndexT()); }
+        void hess_accumulate(const VecT &u, BlockHessian &h) const override { hess_accumulate(u,h,IndexT()); }
+        void grad_hess_accumulate(const VecT &u, VecT &g, BlockHessian &h) const override { grad_hess_accumulate(u,g,h,IndexT()); }
+        void hessvec_accumulate(const VecT &u, const VecT &v, VecT &out) const override { hessvec_accumulate(u,v,out,IndexT()); }
+        void param_grad_accumulate(const VecT &u, VecT &g) const override { param_grad_accumulate(u,g,IndexT()); }
+        void param_grad_hess_accumulate(const VecT &u, VecT &g, MatT &h) const override { param_grad_hess_accumulate(u,g,h,IndexT()); }
         
         VecT sample(AnyRngT &rng) const override
         {
@@ -421,13 +738,87 @@ private:
         MatT sample(AnyRngT &rng, IdxT nSamples) const override
         {
             MatT s(_num_dim,nSamples);
-            sample(rng, s.begin(), nSamples, IndexT());
+            sample_bulk(rng, s, IndexT());
             return s;
         }
         
         VecT llh_components(const VecT &theta) const override { return llh_components(theta.begin(), IndexT());}
         VecT rllh_components(const VecT &theta) const override { return rllh_components(theta.begin(), IndexT());}
 
+        /* Batched methods.  Columns are wrapped as non-owning VecT's so the per-column work is allocation free.
+         * Only columns [begin,end) are touched, so disjoint column ranges can be evaluated concurrently.
+         * The llh, grad, and grad2 methods evaluate one component at a time over all columns, which lets univariate
+         * components use their vectorized array methods.  Components are summed in the same order as the scalar methods.
+         */
+        void llh(const MatT &u, VecT &out, IdxT begin, IdxT end) const override 
+        { 
+            for(IdxT n=begin; n<end; n++) out(n) = 0;
+            llh_accumulate_batch(u,out,begin,end,IndexT());
+        }
+        
+        void rllh(const MatT &u, VecT &out, IdxT begin, IdxT end) const override 
+        { 
+            for(IdxT n=begin; n<end; n++) out(n) = 0;
+            rllh_accumulate_batch(u,out,begin,end,IndexT());
+        }
+        
+        void grad_accumulate(const MatT &u, MatT &g, IdxT begin, IdxT end) const override 
+        { grad_accumulate_batch(u,g,begin,end,IndexT()); }
+        
+        void grad2_accumulate(const MatT &u, MatT &g2, IdxT begin, IdxT end) const override 
+        { grad2_accumulate_batch(u,g2,begin,end,IndexT()); }
+        
+        void hess_accumulate(const MatT &u, CubeT &h, IdxT begin, IdxT end) const override 
+        { 
+            for(IdxT n=begin; n<end; n++) {
+                const VecT un(const_cast<double*>(u.colptr(n)), _num_dim, false, true);
+                MatT hn(h.slice_memptr(n), _num_dim, _num_dim, false, true);
+                hess_accumulate(un,hn,IndexT());
+            }
+        }
+        
+        void grad_grad2_accumulate(const MatT &u, MatT &g, MatT &g2, IdxT begin, IdxT end) const override 
+        { grad_grad2_accumulate_batch(u,g,g2,begin,end,IndexT()); }
+        
+        void grad_hess_accumulate(const MatT &u, MatT &g, CubeT &h, IdxT begin, IdxT end) const override 
+        { 
+            for(IdxT n=begin; n<end; n++) {
+                const VecT un(const_cast<double*>(u.colptr(n)), _num_dim, false, true);
+                VecT gn(g.colptr(n), _num_dim, false, true);
+                MatT hn(h.slice_memptr(n), _num_dim, _num_dim, false, true);
+                grad_hess_accumulate(un,gn,hn,IndexT());
+            }
+        }
+
+        void param_grad_accumulate(const MatT &u, MatT &g, IdxT begin, IdxT end) const override 
+        { 
+            for(IdxT n=begin; n<end; n++) {
+                const VecT un(const_cast<double*>(u.colptr(n)), _num_dim, false, true);
+                VecT gn(g.colptr(n), _num_params, false, true);
+                param_grad_accumulate(un,gn,IndexT());
+            }
+        }
+
+        void param_grad_hess_accumulate(const MatT &u, MatT &g, CubeT &h, IdxT begin, IdxT end) const override 
+        { 
+            for(IdxT n=begin; n<end; n++) {
+                const VecT un(const_cast<double*>(u.colptr(n)), _num_dim, false, true);
+                VecT gn(g.colptr(n), _num_params, false, true);
+                MatT hn(h.slice_memptr(n), _num_params, _num_params, false, true);
+                param_grad_hess_accumulate(un,gn,hn,IndexT());
+            }
+        }
+        
+        void llh_components(const MatT &u, MatT &out, IdxT begin, IdxT end) const override 
+        { 
+            for(IdxT n=begin; n<end; n++) append_llh_components(u.colptr(n), out.colptr(n), IndexT());
+        }
+        
+        void rllh_components(const MatT &u, MatT &out, IdxT begin, IdxT end) const override 
+        { 
+            for(IdxT n=begin; n<end; n++) append_rllh_components(u.colptr(n), out.colptr(n), IndexT());
+        }
+
     private:
         /* Data members */
         std::tuple<Ts...> dists;
@@ -547,15 +938,109 @@ private:
             meta::call_in_order( {(std::get<I>(dists).grad_hess_accumulate_idx(u,g,h,k),0)...} );
         }
 
+        template<std::size_t... I> 
+        void rllh_grad_hess_accumulate(const VecT &u, double &rllh, VecT &g, MatT &h,std::index_sequence<I...>) const
+        {
+            IdxT k=0;
+            meta::call_in_order( {(std::get<I>(dists).rllh_grad_hess_accumulate_idx(u,rllh,g,h,k),0)...} );
+        }
+
+        template<std::size_t... I> 
+        void llh_accumulate_batch(const MatT &u, VecT &out, IdxT begin, IdxT end, std::index_sequence<I...>) const
+        {
+            IdxT k=0;
+            meta::call_in_order( {(std::get<I>(dists).llh_accumulate_batch(u,out,begin,end,k),0)...} );
+        }
+
+        template<std::size_t... I> 
+        void rllh_accumulate_batch(const MatT &u, VecT &out, IdxT begin, IdxT end, std::index_sequence<I...>) const
+        {
+            IdxT k=0;
+            meta::call_in_order( {(std::get<I>(dists).rllh_accumulate_batch(u,out,begin,end,k),0)...} );
+        }
+
+        template<std::size_t... I> 
+        void grad_accumulate_batch(const MatT &u, MatT &g, IdxT begin, IdxT end, std::index_sequence<I...>) const
+        {
+            IdxT k=0;
+            meta::call_in_order( {(std::get<I>(dists).grad_accumulate_batch(u,g,begin,end,k),0)...} );
+        }
+
+        template<std::size_t... I> 
+        void grad2_accumulate_batch(const MatT &u, MatT &g2, IdxT begin, IdxT end, std::index_sequence<I...>) const
+        {
+            IdxT k=0;
+            meta::call_in_order( {(std::get<I>(dists).grad2_accumulate_batch(u,g2,begin,end,k),0)...} );
+        }
+
+        template<std::size_t... I> 
+        void grad_grad2_accumulate_batch(const MatT &u, MatT &g, MatT &g2, IdxT begin, IdxT end, std::index_sequence<I...>) const
+        {
+            IdxT k=0;
+            meta::call_in_order( {(std::get<I>(dists).grad_grad2_accumulate_batch(u,g,g2,begin,end,k),0)...} );
+        }
+
+        template<std::size_t... I> 
+        void hess_accumulate(const VecT &u, BlockHessian &h, std::index_sequence<I...>) const 
+        {
+            IdxT k=0;
+            meta::call_in_order( {(std::get<I>(dists).hess_accumulate_block(u,h.block(I),k),0)...} );
+        }
+
+        template<std::size_t... I> 
+        void grad_hess_accumulate(const VecT &u, VecT &g, BlockHessian &h,std::index_sequence<I...>) const
+        {
+            IdxT k=0;
+            meta::call_in_order( {(std::get<I>(dists).grad_hess_accumulate_block(u,g,h.block(I),k),0)...} );
+        }
+
+        template<std::size_t... I> 
+        void hessvec_accumulate(const VecT &u, const VecT &v, VecT &out, std::index_sequence<I...>) const
+        {
+            IdxT k=0;
+            meta::call_in_order( {(std::get<I>(dists).hessvec_accumulate_idx(u,v,out,k),0)...} );
+        }
+
+        /* Parameter derivatives track both the dimension index k and the parameter index p */
+        template<std::size_t... I> 
+        void param_grad_accumulate(const VecT &u, VecT &g, std::index_sequence<I...>) const
+        {
+            IdxT k=0;
+            IdxT p=0;
+            meta::call_in_order( {(std::get<I>(dists).param_grad_accumulate_idx(u,g,k,p),0)...} );
+        }
+
+        template<std::size_t... I> 
+        void param_grad_hess_accumulate(const VecT &u, VecT &g, MatT &h, std::index_sequence<I...>) const
+        {
+            IdxT k=0;
+            IdxT p=0;
+            meta::call_in_order( {(std::get<I>(dists).param_grad_hess_accumulate_idx(u,g,h,k,p),0)...} );
+        }
+
         template<class IterT, std::size_t... I> 
         void sample(AnyRngT &rng, IterT s, std::index_sequence<I...>) const
         { meta::call_in_order( {(std::get<I>(dists).append_sample(rng,s),0)...} ); }
 
-        template<class IterT, std::size_t... I> 
-        void sample(AnyRngT &rng, IterT s, IdxT nSamples, std::index_sequence<I...>) const
+        /* Each component fills its rows for all samples, so components with bulk samplers amortize their setup.
+         * Components draw through a BufferedRngT when possible, rather than making a virtual call for every number.
+         */
+        template<std::size_t... I> 
+        void sample_bulk(AnyRngT &rng, MatT &s, std::index_sequence<I...> idx) const
         {     
-            for(IdxT n=0; n<nSamples; n++) 
-                meta::call_in_order( {(std::get<I>(dists).append_sample(rng,s),0)...} );
+            if(BufferedRngT::is_full_range(rng)) {
+                BufferedRngT buffered_rng(rng);
+                sample_bulk_from(buffered_rng,s,idx);
+            } else {
+                sample_bulk_from(rng,s,idx);
+            }
+        }
+
+        template<class RngT, std::size_t... I> 
+        void sample_bulk_from(RngT &rng, MatT &s, std::index_sequence<I...>) const
+        {     
+            IdxT k=0;
+            meta::call_in_order( {(std::get<I>(dists).append_samples(rng,s,k),0)...} );
         }
         
         template<class IterT, std::size_t... I> 
@@ -565,6 +1050,14 @@ private:
         template<class IterT, std::size_t... I> 
         VecT rllh_components(IterT theta, std::index_sequence<I...>) const
         { return {std::get<I>(dists).rllh_from_iter(theta)...}; }
+
+        template<class IterT, class OutIterT, std::size_t... I> 
+        void append_llh_components(IterT theta, OutIterT out, std::index_sequence<I...>) const
+        { meta::call_in_order( {(*out++ = std::get<I>(dists).llh_from_iter(theta),0)...} ); }
+        
+        template<class IterT, class OutIterT, std::size_t... I> 
+        void append_rllh_components(IterT theta, OutIterT out, std::index_sequence<I...>) const
+        { meta::call_in_order( {(*out++ = std::get<I>(dists).rllh_from_iter(theta),0)...} ); }
     }; /* class DistTuple */
     
     class EmptyDistTuple : public DistTupleHandle
@@ -614,11 +1107,29 @@ private:
         void hess_accumulate(const VecT&, MatT&) const override { throw RuntimeTypeError("Empty dist cannot be evaluated."); }
         void grad_grad2_accumulate(const VecT&, VecT&, VecT&) const override { throw RuntimeTypeError("Empty dist cannot be evaluated."); }
         void grad_hess_accumulate(const VecT&, VecT&, MatT&) const override { throw RuntimeTypeError("Empty dist cannot be evaluated."); }
+        void rllh_grad_hess_accumulate(const VecT&, double&, VecT&, MatT&) const override { throw RuntimeTypeError("Empty dist cannot be evaluated."); }
+        void hess_accumulate(const VecT&, BlockHessian&) const override { throw RuntimeTypeError("Empty dist cannot be evaluated."); }
+        void grad_hess_accumulate(const VecT&, VecT&, BlockHessian&) const override { throw RuntimeTypeError("Empty dist cannot be evaluated."); }
+        void hessvec_accumulate(const VecT&, const VecT&, VecT&) const override { throw RuntimeTypeError("Empty dist cannot be evaluated."); }
+        void param_grad_accumulate(const VecT&, VecT&) const override { throw RuntimeTypeError("Empty dist cannot be evaluated."); }
+        void param_grad_hess_accumulate(const VecT&, VecT&, MatT&) const override { throw RuntimeTypeError("Empty dist cannot be evaluated."); }
         VecT sample(AnyRngT&) const override { throw RuntimeTypeError("Empty dist cannot be evaluated."); }
         MatT sample(AnyRngT&, IdxT) const override { throw RuntimeTypeError("Empty dist cannot be evaluated."); }
 
         VecT llh_components(const VecT&) const override { throw RuntimeTypeError("Empty dist cannot be evaluated."); }
         VecT rllh_components(const VecT&) const override { throw RuntimeTypeError("Empty dist cannot be evaluated."); }
+
+        void llh(const MatT&, VecT&, IdxT, IdxT) const override { throw RuntimeTypeError("Empty dist cannot be evaluated."); }
+        void rllh(const MatT&, VecT&, IdxT, IdxT) const override { throw RuntimeTypeError("Empty dist cannot be evaluated."); }
+        void grad_accumulate(const MatT&, MatT&, IdxT, IdxT) const override { throw RuntimeTypeError("Empty dist cannot be evaluated."); }
+        void grad2_accumulate(const MatT&, MatT&, IdxT, IdxT) const override { throw RuntimeTypeError("Empty dist cannot be evaluated."); }
+        void hess_accumulate(const MatT&, CubeT&, IdxT, IdxT) const override { throw RuntimeTypeError("Empty dist cannot be evaluated."); }
+        void grad_grad2_accumulate(const MatT&, MatT&, MatT&, IdxT, IdxT) const override { throw RuntimeTypeError("Empty dist cannot be evaluated."); }
+        void grad_hess_accumulate(const MatT&, MatT&, CubeT&, IdxT, IdxT) const override { throw RuntimeTypeError("Empty dist cannot be evaluated."); }
+        void param_grad_accumulate(const MatT&, MatT&, IdxT, IdxT) const override { throw RuntimeTypeError("Empty dist cannot be evaluated."); }
+        void param_grad_hess_accumulate(const MatT&, MatT&, CubeT&, IdxT, IdxT) const override { throw RuntimeTypeError("Empty dist cannot be evaluated."); }
+        void llh_components(const MatT&, MatT&, IdxT, IdxT) const override { throw RuntimeTypeError("Empty dist cannot be evaluated."); }
+        void rllh_components(const MatT&, MatT&, IdxT, IdxT) const override { throw RuntimeTypeError("Empty dist cannot be evaluated."); }
     }; /* class EmptyDistTuple */
 public:
     /* Adaptor for UnivariateDists */
@@ -687,8 +1198,168 @@ public:
             k++;
         }
 
+        void rllh_grad_hess_accumulate_idx(const VecT &u, double &rllh, VecT &g, MatT &h, IdxT &k) const 
+        { 
+            rllh += this->rllh(u(k));
+            this->grad_grad2_accumulate(u(k),g(k),h(k,k));
+            k++;
+        }
+
+        /* Block versions accumulate into the component's own 1x1 block h of a BlockHessian */
+        void hess_accumulate_block(const VecT &u, MatT &h, IdxT &k) const 
+        { 
+            h(0,0) += this->grad2(u(k));
+            k++;
+        }
+
+        void grad_hess_accumulate_block(const VecT &u, VecT &g, MatT &h, IdxT &k) const 
+        { 
+            this->grad_grad2_accumulate(u(k),g(k),h(0,0));
+            k++;
+        }
+
+        void hessvec_accumulate_idx(const VecT &u, const VecT &v, VecT &out, IdxT &k) const 
+        { 
+            out(k) += this->grad2(u(k))*v(k);
+            k++;
+        }
+
+        void param_grad_accumulate_idx(const VecT &u, VecT &g, IdxT &k, IdxT &p) const 
+        { 
+            IdxT Np = Dist::num_params();
+            g.subvec(p,p+Np-1) += this->param_grad(u(k));
+            k++;
+            p+=Np;
+        }
+
+        void param_grad_hess_accumulate_idx(const VecT &u, VecT &g, MatT &h, IdxT &k, IdxT &p) const 
+        { 
+            IdxT Np = Dist::num_params();
+            typename Dist::NparamsVecT G(arma::fill::zeros);
+            typename Dist::NparamsMatT H(arma::fill::zeros);
+            this->param_grad_hess_accumulate(u(k),G,H);
+            g.subvec(p,p+Np-1) += G;
+            for(IdxT j=0; j<Np; j++) for(IdxT i=0; i<=j; i++) h(p+i,p+j) += H(i,j);
+            k++;
+            p+=Np;
+        }
+
+        /* Batched versions over columns [begin,end) of u.  Row k is gathered into contiguous chunks, which are evaluated
+         * with the array methods of Dist if it has them, e.g., NormalDist::llh(N,x,out).
+         */
+        void llh_accumulate_batch(const MatT &u, VecT &out, IdxT begin, IdxT end, IdxT &k) const
+        {
+            for_each_row_chunk(u,begin,end,k,[&](IdxT b, IdxT N, const double *x) {
+                double v[batch_chunk_size];
+                llh_array(N,x,v,0);
+                for(IdxT i=0; i<N; i++) out(b+i) += v[i];
+            });
+            k++;
+        }
+
+        void rllh_accumulate_batch(const MatT &u, VecT &out, IdxT begin, IdxT end, IdxT &k) const
+        {
+            for_each_row_chunk(u,begin,end,k,[&](IdxT b, IdxT N, const double *x) {
+                double v[batch_chunk_size];
+                rllh_array(N,x,v,0);
+                for(IdxT i=0; i<N; i++) out(b+i) += v[i];
+            });
+            k++;
+        }
+
+        void grad_accumulate_batch(const MatT &u, MatT &g, IdxT begin, IdxT end, IdxT &k) const
+        {
+            for_each_row_chunk(u,begin,end,k,[&](IdxT b, IdxT N, const double *x) {
+                double v[batch_chunk_size];
+                grad_array(N,x,v,0);
+                for(IdxT i=0; i<N; i++) g(k,b+i) += v[i];
+            });
+            k++;
+        }
+
+        void grad2_accumulate_batch(const MatT &u, MatT &g2, IdxT begin, IdxT end, IdxT &k) const
+        {
+            for_each_row_chunk(u,begin,end,k,[&](IdxT b, IdxT N, const double *x) {
+                double v[batch_chunk_size];
+                grad2_array(N,x,v,0);
+                for(IdxT i=0; i<N; i++) g2(k,b+i) += v[i];
+            });
+            k++;
+        }
+
+        void grad_grad2_accumulate_batch(const MatT &u, MatT &g, MatT &g2, IdxT begin, IdxT end, IdxT &k) const
+        {
+            for_each_row_chunk(u,begin,end,k,[&](IdxT b, IdxT N, const double *x) {
+                double v[batch_chunk_size] = {};
+                double v2[batch_chunk_size] = {};
+                grad_grad2_accumulate_array(N,x,v,v2,0);
+                for(IdxT i=0; i<N; i++) {
+                    g(k,b+i) += v[i];
+                    g2(k,b+i) += v2[i];
+                }
+            });
+            k++;
+        }
+
         template<class RngT, class IterT> 
         void append_sample(RngT &rng, IterT &iter) const { *iter++ = this->sample(rng); }
+
+        template<class RngT> 
+        void append_samples(RngT &rng, MatT &s, IdxT &k) const
+        { 
+            for(IdxT n=0; n<s.n_cols; n++) s(k,n) = this->sample(rng);
+            k++;
+        }
+    private:
+        template<class Func>
+        static void for_each_row_chunk(const MatT &u, IdxT begin, IdxT end, IdxT k, Func &&func)
+        {
+            double x[batch_chunk_size];
+            for(IdxT b=begin; b<end; b+=batch_chunk_size) {
+                IdxT N = std::min(batch_chunk_size, end-b);
+                for(IdxT i=0; i<N; i++) x[i] = u(k,b+i);
+                func(b,N,x);
+            }
+        }
+
+        /* Use the array methods of Dist if it has them.  The bounds adaptors that redefine llh, e.g., TruncatedDist, also
+         * define its array form over that of the underlying distribution.
+         */
+        template<class D=Dist>
+        auto llh_array(IdxT N, const double *x, double *out, int) const -> decltype(std::declval<const D&>().llh(N,x,out))
+        { return D::llh(N,x,out); }
+
+        void llh_array(IdxT N, const double *x, double *out, long) const
+        { for(IdxT i=0; i<N; i++) out[i] = this->llh(x[i]); }
+
+        template<class D=Dist>
+        auto rllh_array(IdxT N, const double *x, double *out, int) const -> decltype(std::declval<const D&>().rllh(N,x,out))
+        { return D::rllh(N,x,out); }
+
+        void rllh_array(IdxT N, const double *x, double *out, long) const
+        { for(IdxT i=0; i<N; i++) out[i] = this->rllh(x[i]); }
+
+        template<class D=Dist>
+        auto grad_array(IdxT N, const double *x, double *out, int) const -> decltype(std::declval<const D&>().grad(N,x,out))
+        { return D::grad(N,x,out); }
+
+        void grad_array(IdxT N, const double *x, double *out, long) const
+        { for(IdxT i=0; i<N; i++) out[i] = this->grad(x[i]); }
+
+        template<class D=Dist>
+        auto grad2_array(IdxT N, const double *x, double *out, int) const -> decltype(std::declval<const D&>().grad2(N,x,out))
+        { return D::grad2(N,x,out); }
+
+        void grad2_array(IdxT N, const double *x, double *out, long) const
+        { for(IdxT i=0; i<N; i++) out[i] = this->grad2(x[i]); }
+
+        template<class D=Dist>
+        auto grad_grad2_accumulate_array(IdxT N, const double *x, double *g, double *g2, int) const 
+            -> decltype(std::declval<const D&>().grad_grad2_accumulate(N,x,g,g2))
+        { return D::grad_grad2_accumulate(N,x,g,g2); }
+
+        void grad_grad2_accumulate_array(IdxT N, const double *x, double *g, double *g2, long) const
+        { for(IdxT i=0; i<N; i++) this->grad_grad2_accumulate(x[i],g[i],g2[i]); }
     };
 
      /* Adaptor for MultivariateDists */
@@ -823,15 +1494,186 @@ public:
             k+=N;
         }
 
+        void rllh_grad_hess_accumulate_idx(const VecT &u, double &rllh, VecT &g, MatT &h, IdxT &k) const 
+        { 
+            IdxT N = Dist::num_dim();
+            typename Dist::NdimVecT U = u.subvec(k,k+N-1);
+            typename Dist::NdimVecT G(arma::fill::zeros);
+            typename Dist::NdimMatT H(arma::fill::zeros);
+            rllh_grad_hess(U,rllh,G,H,0);
+            g.subvec(k,k+N-1) += G;
+            for(IdxT j=0; j<N; j++) for(IdxT i=0; i<=j; i++) h(k+i,k+j) += H(i,j);
+            k+=N;
+        }
+
+        /* Block versions accumulate into the upper triangle of the component's own NxN block h of a BlockHessian */
+        void hess_accumulate_block(const VecT &u, MatT &h, IdxT &k) const 
+        { 
+            IdxT N = Dist::num_dim();
+            auto H = this->hess(u.subvec(k,k+N-1));
+            for(IdxT j=0; j<N; j++) for(IdxT i=0; i<=j; i++) h(i,j) += H(i,j);
+            k+=N;
+        }
+
+        void grad_hess_accumulate_block(const VecT &u, VecT &g, MatT &h, IdxT &k) const 
+        { 
+            IdxT N = Dist::num_dim();
+            auto U = u.subvec(k,k+N-1);
+            g.subvec(k,k+N-1) += this->grad(U);
+            auto H = this->hess(U);
+            for(IdxT j=0; j<N; j++) for(IdxT i=0; i<=j; i++) h(i,j) += H(i,j);
+            k+=N;
+        }
+
+        /* Uses Dist::hessvec, which can exploit structure in the hessian, e.g., -sigma_inv*v for MultivariateNormalDist */
+        void hessvec_accumulate_idx(const VecT &u, const VecT &v, VecT &out, IdxT &k) const 
+        { 
+            IdxT N = Dist::num_dim();
+            out.subvec(k,k+N-1) += this->hessvec(u.subvec(k,k+N-1), v.subvec(k,k+N-1));
+            k+=N;
+        }
+
+        void param_grad_accumulate_idx(const VecT &u, VecT &g, IdxT &k, IdxT &p) const 
+        { 
+            IdxT N = Dist::num_dim();
+            IdxT Np = Dist::num_params();
+            g.subvec(p,p+Np-1) += this->param_grad(u.subvec(k,k+N-1));
+            k+=N;
+            p+=Np;
+        }
+
+        void param_grad_hess_accumulate_idx(const VecT &u, VecT &g, MatT &h, IdxT &k, IdxT &p) const 
+        { 
+            IdxT N = Dist::num_dim();
+            IdxT Np = Dist::num_params();
+            typename Dist::NparamsVecT G;
+            typename Dist::NparamsMatT H;
+            G.zeros(Np);
+            H.zeros(Np,Np);
+            this->param_grad_hess_accumulate(u.subvec(k,k+N-1),G,H);
+            g.subvec(p,p+Np-1) += G;
+            for(IdxT j=0; j<Np; j++) for(IdxT i=0; i<=j; i++) h(p+i,p+j) += H(i,j);
+            k+=N;
+            p+=Np;
+        }
+
+        /* Batched versions over columns [begin,end) of u, evaluated column by column */
+        void llh_accumulate_batch(const MatT &u, VecT &out, IdxT begin, IdxT end, IdxT &k) const
+        {
+            for(IdxT n=begin; n<end; n++) {
+                const double *v = u.colptr(n)+k;
+                out(n) += llh_from_iter(v);
+            }
+            k+=Dist::num_dim();
+        }
+
+        void rllh_accumulate_batch(const MatT &u, VecT &out, IdxT begin, IdxT end, IdxT &k) const
+        {
+            for(IdxT n=begin; n<end; n++) {
+                const double *v = u.colptr(n)+k;
+                out(n) += rllh_from_iter(v);
+            }
+            k+=Dist::num_dim();
+        }
+
+        void grad_accumulate_batch(const MatT &u, MatT &g, IdxT begin, IdxT end, IdxT &k) const
+        {
+            for(IdxT n=begin; n<end; n++) {
+                const VecT un(const_cast<double*>(u.colptr(n)), u.n_rows, false, true);
+                VecT gn(g.colptr(n), g.n_rows, false, true);
+                IdxT kn = k;
+                grad_accumulate_idx(un,gn,kn);
+            }
+            k+=Dist::num_dim();
+        }
+
+        void grad2_accumulate_batch(const MatT &u, MatT &g2, IdxT begin, IdxT end, IdxT &k) const
+        {
+            for(IdxT n=begin; n<end; n++) {
+                const VecT un(const_cast<double*>(u.colptr(n)), u.n_rows, false, true);
+                VecT g2n(g2.colptr(n), g2.n_rows, false, true);
+                IdxT kn = k;
+                grad2_accumulate_idx(un,g2n,kn);
+            }
+            k+=Dist::num_dim();
+        }
+
+        void grad_grad2_accumulate_batch(const MatT &u, MatT &g, MatT &g2, IdxT begin, IdxT end, IdxT &k) const
+        {
+            for(IdxT n=begin; n<end; n++) {
+                const VecT un(const_cast<double*>(u.colptr(n)), u.n_rows, false, true);
+                VecT gn(g.colptr(n), g.n_rows, false, true);
+                VecT g2n(g2.colptr(n), g2.n_rows, false, true);
+                IdxT kn = k;
+                grad_grad2_accumulate_idx(un,gn,g2n,kn);
+            }
+            k+=Dist::num_dim();
+        }
+
         template<class RngT, class IterT> 
         void append_sample(RngT &rng, IterT &v) const
         { v = std::copy_n(this->sample(rng).begin(), Dist::num_dim(), v); }
+
+        template<class RngT> 
+        void append_samples(RngT &rng, MatT &s, IdxT &k) const
+        { 
+            IdxT N = Dist::num_dim();
+            s.rows(k,k+N-1) = sample_bulk(rng, s.n_cols, 0);
+            k+=N;
+        }
+    private:
+        /* Use the fused rllh_grad_hess_accumulate of Dist if it has one.  H is upper triangular. */
+        template<class D=Dist>
+        auto rllh_grad_hess(const typename D::NdimVecT &U, double &rllh, typename D::NdimVecT &G, typename D::NdimMatT &H, int) const
+            -> decltype(std::declval<const D&>().rllh_grad_hess_accumulate(U,rllh,G,H))
+        { return D::rllh_grad_hess_accumulate(U,rllh,G,H); }
+
+        void rllh_grad_hess(const typename Dist::NdimVecT &U, double &rllh, typename Dist::NdimVecT &G, typename Dist::NdimMatT &H, long) const
+        { 
+            rllh += this->rllh(U);
+            G += this->grad(U);
+            H += this->hess(U);
+        }
+
+        /* Use the bulk sampler of Dist if it has one */
+        template<class RngT, class D=Dist>
+        auto sample_bulk(RngT &rng, IdxT nSamples, int) const -> decltype(std::declval<const D&>().sample(rng,nSamples))
+        { return D::sample(rng,nSamples); }
+
+        template<class RngT>
+        MatT sample_bulk(RngT &rng, IdxT nSamples, long) const
+        { 
+            MatT s(Dist::num_dim(),nSamples);
+            for(IdxT n=0; n<nSamples; n++) s.col(n) = this->sample(rng);
+            return s;
+        }
     };
 
     
 private:    
 
     void initialize_from_handle(); //Called on every new handle initialization
+
+    /* Size checks for batched evaluation. */
+    void check_batch(const MatT &theta) const;
+    void check_batch(const MatT &theta, const MatT &out) const;
+    void check_batch(const MatT &theta, const CubeT &out) const;
+    void check_block_hess(const BlockHessian &hess) const;
+    void check_param_batch(const MatT &theta, const MatT &out) const;
+    void check_param_batch(const MatT &theta, const CubeT &out) const;
+
+    /* Lazily computed constants of the component dists, e.g., llh normalizing constants and truncation derivatives,
+     * are not safe to initialize concurrently.  Before a parallel batch they are initialized in the calling thread by
+     * a single-point evaluation at the first column.
+     */
+    bool batch_is_parallel(IdxT N) const { return _num_threads > 1 && N > batch_chunk_size; }
+    void initialize_llh_constants(const MatT &theta) const;
+    void initialize_param_constants(const MatT &theta) const;
+
+    template<class Func>
+    void for_each_batch_chunk(IdxT N, Func &&func) const { for_each_batch_chunk(N, _num_threads, std::forward<Func>(func)); }
+    template<class Func>
+    void for_each_batch_chunk(IdxT N, IdxT max_threads, Func &&func) const;
     
     static std::string generate_var_name() 
     {
@@ -903,6 +1745,8 @@ private:
     mutable bool component_names_initialized;
     mutable bool dim_variables_initialized;
     mutable bool param_names_initialized;
+
+    IdxT _num_threads = 1;
     
     void initialize_component_names() const;
     void initialize_dim_variables() const;
@@ -976,6 +1820,36 @@ void CompositeDist::set_param_names(StringVec &&names)
     param_names_initialized = true;
 }
 
+/* Calls func(begin,end) over consecutive chunks of batch_chunk_size columns.
+ * Chunks are handed out dynamically to the calling thread and the persistent workers of BatchThreadPool, which all
+ * start together.  Callers must initialize lazily computed constants first (see initialize_llh_constants).
+ * Exceptions from workers are re-thrown in the calling thread.
+ */
+template<class Func>
+void CompositeDist::for_each_batch_chunk(IdxT N, IdxT max_threads, Func &&func) const
+{
+    IdxT nchunks = (N + batch_chunk_size - 1) / batch_chunk_size;
+    IdxT nthreads = std::min(max_threads, nchunks);
+    if(nthreads <= 1) {
+        func(0,N);
+        return;
+    }
+    std::atomic<IdxT> next_chunk{0};
+    std::vector<std::exception_ptr> errors(nthreads);
+    std::function<void(IdxT)> worker = [&](IdxT t) {
+        try {
+            for(IdxT c = next_chunk++; c < nchunks; c = next_chunk++) {
+                IdxT begin = c*batch_chunk_size;
+                func(begin, std::min(begin+batch_chunk_size, N));
+            }
+        } catch(...) {
+            errors[t] = std::current_exception();
+        }
+    };
+    BatchThreadPool::instance().run(nthreads, worker);
+    for(auto &err: errors) if(err) std::rethrow_exception(err);
+}
+
 std::ostream& operator<<(std::ostream &out, const CompositeDist &dist);
 
 /* Protected methods */
@@ -6,6 +6,8 @@
 #ifndef PRIOR_HESSIAN_COPULADIST_H
 #define PRIOR_HESSIAN_COPULADIST_H
 
+#include <array>
+
 #include "PriorHessian/util.h"
 #include "PriorHessian/Meta.h"
 #include "PriorHessian/UnivariateDist.h"
@@ -32,16 +34,18 @@ public:
     using NdimMatT = arma::Mat<double>::fixed<_num_dim,_num_dim>;
 #if PRIOR_HESSIAN_META_HAS_CONSTEXPR
     using NparamsVecT = arma::Col<double>::fixed<_num_params>; //Use fixed sized type
+    using NparamsMatT = arma::Mat<double>::fixed<_num_params,_num_params>;
     static constexpr IdxT num_params() {return _num_params;}
 #else
     using NparamsVecT = arma::Col<double>;  //Use variable sized type
+    using NparamsMatT = arma::Mat<double>;
     static IdxT num_params() {return _num_params;}
 #endif
     using MarginalDistTupleT = std::tuple<MarginalDistTs...>;    
     using CopulaT = CopulaTemplate<_num_dim>;
     
     template<size_t I>
-    using MarginalDistT = std::tuple_element<I,MarginalDistTupleT>;
+    using MarginalDistT = std::tuple_element_t<I,MarginalDistTupleT>;
     
     static constexpr IdxT num_components() { return _num_dim; }
     static constexpr IdxT num_dim() { return _num_dim; }
@@ -95,14 +99,28 @@ public:
     template<class Vec> NdimVecT grad(const Vec &x) const;
     template<class Vec> NdimVecT grad2(const Vec &x) const;
     template<class Vec> NdimMatT hess(const Vec &x) const;
+    template<class Vec, class Vec2> NdimVecT hessvec(const Vec &x, const Vec2 &v) const;
+
+    /* Derivatives of llh with respect to the parameters, in params() order: [copula theta, marginal params...].
+     * Marginals must provide cdf_param_grad_hess, the parameter derivatives of their cdf.
+     */
+    template<class Vec> NparamsVecT param_grad(const Vec &x) const;
+    template<class Vec> NparamsMatT param_hess(const Vec &x) const;
+    template<class Vec, class Vec2, class Mat> void param_grad_hess_accumulate(const Vec &x, Vec2 &g, Mat &h) const;
     
     template<class Vec,class Vec2>
     void grad_grad2_accumulate(const Vec &x, Vec2 &g, Vec2 &g2) const;
     template<class Vec,class Vec2,class Mat>
     void grad_hess_accumulate(const Vec &x, Vec2 &g, Mat &hess) const;
+    /* Fused rllh, grad, and upper triangular hess.  The marginals and the copula are each evaluated once. */
+    template<class Vec,class Vec2,class Mat>
+    void rllh_grad_hess_accumulate(const Vec &x, double &rllh, Vec2 &g, Mat &hess) const;
     
     template<class RngT>
     NdimVecT sample(RngT &rng) const;
+    /* Batched sampling.  Samples are the columns. */
+    template<class RngT>
+    MatT sample(RngT &rng, IdxT num_samples) const;
 
      /* Specialized iterator-based adaptor methods for efficient use by CompositeDist::ComponentDistAdaptor */    
     template<class IterT>
@@ -132,7 +150,7 @@ private:
     template<std::size_t... I>
     static StringVecT marginal_param_names(std::index_sequence<I...>);
     template<std::size_t... I>
-    static NdimVecT marginal_num_params(std::index_sequence<I...>);
+    static UVecT marginal_num_params(std::index_sequence<I...>);
     template<class IterT, std::size_t... I>
     static bool check_marginal_params(IterT &params_it, std::index_sequence<I...>);
     
@@ -141,20 +159,48 @@ private:
     template<std::size_t... I>
     NdimVecT marginal_ubound(std::index_sequence<I...>) const ;
     template<class Iter, std::size_t... I>
-    void set_marginal_bounds(Iter &lb_it, Iter &ub_it, std::index_sequence<I...>) const;
+    void set_marginal_bounds(Iter lb_it, Iter ub_it, std::index_sequence<I...>);
     template<class Iter, std::size_t... I>
-    void set_marginal_lbound(Iter &lb_it, std::index_sequence<I...>) const;
+    void set_marginal_lbound(Iter lb_it, std::index_sequence<I...>);
     template<class Iter, std::size_t... I>
-    void set_marginal_ubound(Iter &ub_it, std::index_sequence<I...>) const;
+    void set_marginal_ubound(Iter ub_it, std::index_sequence<I...>);
     template<class Iter, std::size_t... I>
     void append_marginal_params(Iter &it, std::index_sequence<I...>) const;
     template<class Iter,std::size_t... I>
-    void set_marginal_params(Iter &it, std::index_sequence<I...>) const;
+    void set_marginal_params(Iter &it, std::index_sequence<I...>);
     
     
+    /* Marginal values at x needed by the log-density and its derivatives */
+    struct MarginalTerms {
+        NdimVecT cdf;
+        NdimVecT pdf;
+        NdimVecT rllh;
+        NdimVecT grad;
+        NdimVecT grad2;
+    };
+    template<class Vec>
+    MarginalTerms compute_marginal_terms(const Vec &x) const;
+    template<class InIter, std::size_t... I>
+    void compute_marginal_terms(InIter in_it, MarginalTerms &terms, std::index_sequence<I...>) const;
+    template<class Dist>
+    static void compute_marginal_terms_idx(const Dist &dist, double x, MarginalTerms &terms, IdxT i);
+
+    /* Parameter derivatives of each marginal llh and cdf.  Marginal i has parameters [offset[i],offset[i+1]). */
+    using OffsetArrayT = std::array<IdxT,_num_dim+1>;
+    template<class InIter, class Vec2, std::size_t... I>
+    void accumulate_marginal_param_terms(InIter in_it, const NdimVecT &c_grad, Vec2 &g, NparamsVecT &du, 
+                                         NparamsMatT &H, OffsetArrayT &offset, std::index_sequence<I...>) const;
+    template<class Dist, class Vec2>
+    static void accumulate_marginal_param_terms_idx(const Dist &dist, double x, double c_grad, Vec2 &g, NparamsVecT &du, 
+                                                    NparamsMatT &H, OffsetArrayT &offset, IdxT i);
+
     template<class InIter,class OutIter, std::size_t... I>
     void compute_marginal_cdf(InIter in_it, OutIter out_it, std::index_sequence<I...>) const;
     template<class InIter,class OutIter, std::size_t... I>
+    void compute_marginal_llh(InIter in_it, OutIter out_it, std::index_sequence<I...>) const;
+    template<class InIter,class OutIter, std::size_t... I>
+    void compute_marginal_rllh(InIter in_it, OutIter out_it, std::index_sequence<I...>) const;
+    template<class InIter,class OutIter, std::size_t... I>
     void compute_marginal_pdf(InIter in_it, OutIter out_it, std::index_sequence<I...>) const;
     template<class InIter,class OutIter, std::size_t... I>
     void compute_marginal_icdf(InIter in_it, OutIter out_it, std::index_sequence<I...>) const;
@@ -338,6 +384,7 @@ CopulaDist<CopulaTemplate,MarginalDistTs...>::params() const
 {
     NparamsVecT p;
     auto it = p.begin();
+    *it++ = copula.theta();
     append_marginal_params(it,IndexT{});
     return p;
 }
@@ -367,7 +414,7 @@ template<template <int> class CopulaTemplate, class... MarginalDistTs>
 template<class IterT>
 bool CopulaDist<CopulaTemplate,MarginalDistTs...>::check_params_iter(IterT &params_it)
 {
-    return check_params_iter(params_it) && marginal_check_params(params_it,IndexT{});
+    return CopulaT::check_params_iter(params_it) && check_marginal_params(params_it,IndexT{});
 }
 
 template<template <int> class CopulaTemplate, class... MarginalDistTs>
@@ -375,7 +422,7 @@ template<class IterT>
 void CopulaDist<CopulaTemplate,MarginalDistTs...>::set_params_iter(IterT &params_it)
 {
     copula.set_theta(*params_it++);
-    marginal_set_params(params_it,IndexT{});
+    set_marginal_params(params_it,IndexT{});
 }
 
 /* public computational member functions */
@@ -422,16 +469,21 @@ double CopulaDist<CopulaTemplate,MarginalDistTs...>::rllh(const Vec &x) const
     return copula.rllh(marginal_cdf) + arma::sum(marginal_rllh);
 }
 
+/* With u(i) = F(i)(x(i)), f(i) the marginal pdfs, and m(i) the marginal rllh,
+ *      d/dx(i) rllh = dc/du(i)*f(i) + m'(i)
+ *      d2/dx(i)dx(j) rllh = d2c/du(i)du(j)*f(i)*f(j) + delta(i,j)*(dc/du(i)*f(i)*m'(i) + m''(i)),
+ * where c is the copula rllh, using f'(i) = f(i)*m'(i).
+ */
 template<template <int> class CopulaTemplate, class... MarginalDistTs>
 template<class Vec> 
 typename CopulaDist<CopulaTemplate,MarginalDistTs...>::NdimVecT 
 CopulaDist<CopulaTemplate,MarginalDistTs...>::grad(const Vec &x) const
 {
-    NdimVecT marginal_cdf;
-    compute_marginal_cdf(x.begin(),marginal_cdf.begin(),IndexT{});
-    NdimVecT marginal_grad;
-    compute_marginal_grad(x.begin(),marginal_grad.begin(),IndexT{});
-    return copula.grad(marginal_cdf) + marginal_grad;
+    auto m = compute_marginal_terms(x);
+    double c_rllh = 0;
+    NdimVecT c_grad(arma::fill::zeros);
+    copula.rllh_grad_accumulate(m.cdf,c_rllh,c_grad);
+    return c_grad % m.pdf + m.grad;
 }
 
 template<template <int> class CopulaTemplate, class... MarginalDistTs>
@@ -439,11 +491,12 @@ template<class Vec>
 typename CopulaDist<CopulaTemplate,MarginalDistTs...>::NdimVecT 
 CopulaDist<CopulaTemplate,MarginalDistTs...>::grad2(const Vec &x) const
 {
-    NdimVecT marginal_cdf;
-    compute_marginal_cdf(x.begin(),marginal_cdf.begin(),IndexT{});
-    NdimVecT marginal_grad2;
-    compute_marginal_grad2(x.begin(),marginal_grad2.begin(),IndexT{});
-    return copula.grad2(marginal_cdf) + marginal_grad2;
+    auto m = compute_marginal_terms(x);
+    double c_rllh = 0;
+    NdimVecT c_grad(arma::fill::zeros);
+    NdimVecT c_grad2(arma::fill::zeros);
+    copula.rllh_grad_grad2_accumulate(m.cdf,c_rllh,c_grad,c_grad2);
+    return c_grad2 % arma::square(m.pdf) + c_grad % m.pdf % m.grad + m.grad2;
 }
 
 template<template <int> class CopulaTemplate, class... MarginalDistTs>
@@ -451,46 +504,125 @@ template<class Vec>
 typename CopulaDist<CopulaTemplate,MarginalDistTs...>::NdimMatT 
 CopulaDist<CopulaTemplate,MarginalDistTs...>::hess(const Vec &x) const
 {
-    NdimVecT marginal_cdf;
-    compute_marginal_cdf(x.begin(),marginal_cdf.begin(),IndexT{});
-    NdimVecT marginal_grad2;
-    compute_marginal_grad2(x.begin(),marginal_grad2.begin(),IndexT{});
-    auto H = copula.hess(marginal_cdf);
-    H.diag() += marginal_grad2;
-    return H;
+    double rllh = 0;
+    NdimVecT g(arma::fill::zeros);
+    NdimMatT H(arma::fill::zeros);
+    rllh_grad_hess_accumulate(x,rllh,g,H);
+    return arma::symmatu(H);
 }
 
+template<template <int> class CopulaTemplate, class... MarginalDistTs>
+template<class Vec, class Vec2> 
+typename CopulaDist<CopulaTemplate,MarginalDistTs...>::NdimVecT 
+CopulaDist<CopulaTemplate,MarginalDistTs...>::hessvec(const Vec &x, const Vec2 &v) const
+{
+    auto m = compute_marginal_terms(x);
+    double c_rllh = 0;
+    NdimVecT c_grad(arma::fill::zeros);
+    copula.rllh_grad_accumulate(m.cdf,c_rllh,c_grad);
+    NdimVecT fv = m.pdf % v;
+    return m.pdf % copula.hessvec(m.cdf,fv) + (c_grad % m.pdf % m.grad + m.grad2) % v;
+}
 
 template<template <int> class CopulaTemplate, class... MarginalDistTs>
 template<class Vec,class Vec2>
 void CopulaDist<CopulaTemplate,MarginalDistTs...>::grad_grad2_accumulate(const Vec &x, Vec2 &g, Vec2 &g2) const
 {
-    NdimVecT marginal_cdf;
-    compute_marginal_cdf(x.begin(),marginal_cdf.begin(),IndexT{});
-    NdimVecT marginal_grad;
-    compute_marginal_grad(x.begin(),marginal_grad.begin(),IndexT{});
-    NdimVecT marginal_grad2;
-    compute_marginal_grad2(x.begin(),marginal_grad2.begin(),IndexT{});
-    g += copula.grad(marginal_cdf) + marginal_grad;
-    g2 += copula.grad2(marginal_cdf) + marginal_grad2;
+    auto m = compute_marginal_terms(x);
+    double c_rllh = 0;
+    NdimVecT c_grad(arma::fill::zeros);
+    NdimVecT c_grad2(arma::fill::zeros);
+    copula.rllh_grad_grad2_accumulate(m.cdf,c_rllh,c_grad,c_grad2);
+    g += c_grad % m.pdf + m.grad;
+    g2 += c_grad2 % arma::square(m.pdf) + c_grad % m.pdf % m.grad + m.grad2;
 }
 
-
 template<template <int> class CopulaTemplate, class... MarginalDistTs>
 template<class Vec,class Vec2,class Mat>
 void CopulaDist<CopulaTemplate,MarginalDistTs...>::grad_hess_accumulate(const Vec &x, Vec2 &g, Mat &hess) const
 {
-    NdimVecT marginal_cdf;
-    compute_marginal_cdf(x.begin(),marginal_cdf.begin(),IndexT{});
-    NdimVecT marginal_grad;
-    compute_marginal_grad(x.begin(),marginal_grad.begin(),IndexT{});
-    NdimVecT marginal_grad2;
-    compute_marginal_grad2(x.begin(),marginal_grad2.begin(),IndexT{});
+    double rllh = 0;
+    NdimMatT H(arma::fill::zeros);
+    rllh_grad_hess_accumulate(x,rllh,g,H);
+    hess += arma::symmatu(H);
+}
+
+template<template <int> class CopulaTemplate, class... MarginalDistTs>
+template<class Vec,class Vec2,class Mat>
+void CopulaDist<CopulaTemplate,MarginalDistTs...>::rllh_grad_hess_accumulate(const Vec &x, double &rllh, Vec2 &g, Mat &hess) const
+{
+    auto m = compute_marginal_terms(x);
+    double c_rllh = 0;
+    NdimVecT c_grad(arma::fill::zeros);
+    NdimMatT c_hess(arma::fill::zeros);
+    copula.rllh_grad_hess_accumulate(m.cdf,c_rllh,c_grad,c_hess); //Upper triangle
+    rllh += c_rllh + arma::sum(m.rllh);
+    for(IdxT j=0; j<num_dim(); j++) {
+        g(j) += c_grad(j)*m.pdf(j) + m.grad(j);
+        for(IdxT i=0; i<j; i++) hess(i,j) += c_hess(i,j)*m.pdf(i)*m.pdf(j);
+        hess(j,j) += c_hess(j,j)*square(m.pdf(j)) + c_grad(j)*m.pdf(j)*m.grad(j) + m.grad2(j);
+    }
+}
 
-    g += copula.grad(marginal_cdf) + marginal_grad;
-    auto H = copula.hess(marginal_cdf);
-    H.diag() += marginal_grad2;
-    hess += H;
+template<template <int> class CopulaTemplate, class... MarginalDistTs>
+template<class Vec> 
+typename CopulaDist<CopulaTemplate,MarginalDistTs...>::NparamsVecT 
+CopulaDist<CopulaTemplate,MarginalDistTs...>::param_grad(const Vec &x) const
+{
+    NparamsVecT g;
+    NparamsMatT h;
+    g.zeros(num_params());
+    h.zeros(num_params(),num_params());
+    param_grad_hess_accumulate(x,g,h);
+    return g;
+}
+
+template<template <int> class CopulaTemplate, class... MarginalDistTs>
+template<class Vec> 
+typename CopulaDist<CopulaTemplate,MarginalDistTs...>::NparamsMatT 
+CopulaDist<CopulaTemplate,MarginalDistTs...>::param_hess(const Vec &x) const
+{
+    NparamsVecT g;
+    NparamsMatT h;
+    g.zeros(num_params());
+    h.zeros(num_params(),num_params());
+    param_grad_hess_accumulate(x,g,h);
+    return h;
+}
+
+/* With theta the copula parameter, phi(i) the parameters of marginal i, u(i) = F(i)(x(i);phi(i)), c the copula rllh, 
+ * and m(i) the marginal llh,
+ *      d/dtheta llh = dc/dtheta
+ *      d/dphi(i) llh = dc/du(i)*du(i)/dphi(i) + dm(i)/dphi(i)
+ *      d2/dtheta2 llh = d2c/dtheta2
+ *      d2/dtheta dphi(i) llh = d2c/dtheta du(i)*du(i)/dphi(i)
+ *      d2/dphi(i) dphi(j) llh = d2c/du(i)du(j)*du(i)/dphi(i)*du(j)/dphi(j)^T 
+ *                                  + delta(i,j)*(dc/du(i)*d2u(i)/dphi(i)^2 + d2m(i)/dphi(i)^2).
+ */
+template<template <int> class CopulaTemplate, class... MarginalDistTs>
+template<class Vec, class Vec2, class Mat>
+void CopulaDist<CopulaTemplate,MarginalDistTs...>::param_grad_hess_accumulate(const Vec &x, Vec2 &g, Mat &h) const
+{
+    NdimVecT u;
+    compute_marginal_cdf(x.begin(),u.begin(),IndexT{});
+    double c_rllh = 0, c_dtheta = 0, c_d2theta = 0;
+    NdimVecT c_grad(arma::fill::zeros);
+    NdimVecT c_grad_dtheta(arma::fill::zeros);
+    NdimMatT c_hess(arma::fill::zeros);
+    copula.rllh_grad_hess_dtheta_accumulate(u,c_rllh,c_grad,c_hess,c_dtheta,c_d2theta,c_grad_dtheta);
+    NparamsVecT du; //du(p) = du(i)/dphi(p) for the marginal i of parameter p
+    NparamsMatT H; //Upper triangular
+    du.zeros(num_params());
+    H.zeros(num_params(),num_params());
+    OffsetArrayT offset;
+    accumulate_marginal_param_terms(x.begin(),c_grad,g,du,H,offset,IndexT{});
+    g(0) += c_dtheta;
+    H(0,0) += c_d2theta;
+    for(IdxT j=0; j<num_dim(); j++) for(IdxT b=offset[j]; b<offset[j+1]; b++) {
+        H(0,b) += c_grad_dtheta(j)*du(b);
+        for(IdxT i=0; i<=j; i++) for(IdxT a=offset[i]; a<offset[i+1]; a++) H(a,b) += c_hess(i,j)*du(a)*du(b);
+    }
+    h += arma::symmatu(H);
 }
 
 template<template <int> class CopulaTemplate, class... MarginalDistTs>
@@ -503,6 +635,15 @@ CopulaDist<CopulaTemplate,MarginalDistTs...>::sample(RngT &rng) const
     return u;
 }
 
+template<template <int> class CopulaTemplate, class... MarginalDistTs>
+template<class RngT>
+MatT CopulaDist<CopulaTemplate,MarginalDistTs...>::sample(RngT &rng, IdxT num_samples) const
+{
+    MatT u = copula.sample(rng,num_samples);
+    for(IdxT n=0; n<num_samples; n++) compute_marginal_icdf(u.begin_col(n),u.begin_col(n),IndexT{});
+    return u;
+}
+
 /* public static member functions */
 template<template <int> class CopulaTemplate, class... MarginalDistTs>
 const StringVecT& 
@@ -594,7 +735,7 @@ template<std::size_t... I>
 bool
 CopulaDist<CopulaTemplate,MarginalDistTs...>::initialize_global_lbound(std::index_sequence<I...>)
 {
-//     _global_lbound = {MarginalDistT<I>::global_lbound()...};
+    _global_lbound = {MarginalDistT<I>::global_lbound()...};
     return true;    
 }
 
@@ -603,7 +744,7 @@ template<std::size_t... I>
 bool
 CopulaDist<CopulaTemplate,MarginalDistTs...>::initialize_global_ubound(std::index_sequence<I...>)
 {
-//     _global_ubound = {MarginalDistT<I>::global_ubound()...};
+    _global_ubound = {MarginalDistT<I>::global_ubound()...};
     return true;    
 }
 
@@ -614,14 +755,13 @@ CopulaDist<CopulaTemplate,MarginalDistTs...>::marginal_param_names(std::index_se
 {
     StringVecT names;
     names.reserve(num_params());    
-    auto iter = names.begin();
-    meta::call_in_order({(iter = std::copy_n(MarginalDistT<I>::param_names().begin(),MarginalDistT<I>::num_params_static(),iter), 0)... });
+    meta::call_in_order({(names.insert(names.end(),MarginalDistT<I>::param_names().begin(),MarginalDistT<I>::param_names().end()), 0)... });
     return names;
 }
 
 template<template <int> class CopulaTemplate, class... MarginalDistTs>
 template<std::size_t... I>
-typename CopulaDist<CopulaTemplate,MarginalDistTs...>::NdimVecT
+UVecT
 CopulaDist<CopulaTemplate,MarginalDistTs...>::marginal_num_params(std::index_sequence<I...>)
 {
     return { MarginalDistT<I>::num_params()... };
@@ -653,21 +793,21 @@ CopulaDist<CopulaTemplate,MarginalDistTs...>::marginal_ubound(std::index_sequenc
 
 template<template <int> class CopulaTemplate, class... MarginalDistTs>
 template<class Iter, std::size_t... I>
-void CopulaDist<CopulaTemplate,MarginalDistTs...>::set_marginal_bounds(Iter &lb_it,Iter &ub_it, std::index_sequence<I...>) const
+void CopulaDist<CopulaTemplate,MarginalDistTs...>::set_marginal_bounds(Iter lb_it, Iter ub_it, std::index_sequence<I...>)
 {
     meta::call_in_order({(std::get<I>(marginals).set_bounds(*lb_it++,*ub_it++),0)...});
 }
 
 template<template <int> class CopulaTemplate, class... MarginalDistTs>
 template<class Iter, std::size_t... I>
-void CopulaDist<CopulaTemplate,MarginalDistTs...>::set_marginal_lbound(Iter &lb_it, std::index_sequence<I...>) const
+void CopulaDist<CopulaTemplate,MarginalDistTs...>::set_marginal_lbound(Iter lb_it, std::index_sequence<I...>)
 {
     meta::call_in_order({(std::get<I>(marginals).set_lbound(*lb_it++),0)...});
 }
 
 template<template <int> class CopulaTemplate, class... MarginalDistTs>
 template<class Iter, std::size_t... I>
-void CopulaDist<CopulaTemplate,MarginalDistTs...>::set_marginal_ubound(Iter &ub_it, std::index_sequence<I...>) const
+void CopulaDist<CopulaTemplate,MarginalDistTs...>::set_marginal_ubound(Iter ub_it, std::index_sequence<I...>)
 {
     meta::call_in_order({(std::get<I>(marginals).set_ubound(*ub_it++),0)...});
 }
@@ -676,12 +816,12 @@ template<template <int> class CopulaTemplate, class... MarginalDistTs>
 template<class Iter, std::size_t... I>
 void CopulaDist<CopulaTemplate,MarginalDistTs...>::append_marginal_params(Iter &it, std::index_sequence<I...>) const
 {
-    meta::call_in_order({(std::get<I>(marginals).append_params_iter(it),0)...});
+    meta::call_in_order({(it = std::copy_n(std::get<I>(marginals).params().begin(),MarginalDistT<I>::num_params(),it),0)...});
 }
 
 template<template <int> class CopulaTemplate, class... MarginalDistTs>
 template<class Iter, std::size_t... I>
-void CopulaDist<CopulaTemplate,MarginalDistTs...>::set_marginal_params(Iter &it, std::index_sequence<I...>) const
+void CopulaDist<CopulaTemplate,MarginalDistTs...>::set_marginal_params(Iter &it, std::index_sequence<I...>)
 {
     meta::call_in_order({(std::get<I>(marginals).set_params_iter(it),0)...});    
 }
@@ -700,6 +840,78 @@ void CopulaDist<CopulaTemplate,MarginalDistTs...>::compute_marginal_cdf(InIter i
     meta::call_in_order({(*out_it++ = std::get<I>(marginals).cdf(*in_it++),0)...});
 }
 
+template<template <int> class CopulaTemplate, class... MarginalDistTs>
+template<class InIter,class OutIter,std::size_t... I>
+void CopulaDist<CopulaTemplate,MarginalDistTs...>::compute_marginal_llh(InIter in_it, OutIter out_it, std::index_sequence<I...>) const
+{
+    meta::call_in_order({(*out_it++ = std::get<I>(marginals).llh(*in_it++),0)...});
+}
+
+template<template <int> class CopulaTemplate, class... MarginalDistTs>
+template<class InIter,class OutIter,std::size_t... I>
+void CopulaDist<CopulaTemplate,MarginalDistTs...>::compute_marginal_rllh(InIter in_it, OutIter out_it, std::index_sequence<I...>) const
+{
+    meta::call_in_order({(*out_it++ = std::get<I>(marginals).rllh(*in_it++),0)...});
+}
+
+template<template <int> class CopulaTemplate, class... MarginalDistTs>
+template<class Vec>
+typename CopulaDist<CopulaTemplate,MarginalDistTs...>::MarginalTerms
+CopulaDist<CopulaTemplate,MarginalDistTs...>::compute_marginal_terms(const Vec &x) const
+{
+    MarginalTerms terms;
+    compute_marginal_terms(x.begin(),terms,IndexT{});
+    return terms;
+}
+
+template<template <int> class CopulaTemplate, class... MarginalDistTs>
+template<class InIter, std::size_t... I>
+void CopulaDist<CopulaTemplate,MarginalDistTs...>::compute_marginal_terms(InIter in_it, MarginalTerms &terms, std::index_sequence<I...>) const
+{
+    meta::call_in_order({(compute_marginal_terms_idx(std::get<I>(marginals),*in_it++,terms,I),0)...});
+}
+
+template<template <int> class CopulaTemplate, class... MarginalDistTs>
+template<class Dist>
+void CopulaDist<CopulaTemplate,MarginalDistTs...>::compute_marginal_terms_idx(const Dist &dist, double x, MarginalTerms &terms, IdxT i)
+{
+    terms.cdf(i) = dist.cdf(x);
+    terms.pdf(i) = dist.pdf(x);
+    terms.rllh(i) = dist.rllh(x);
+    terms.grad(i) = 0;
+    terms.grad2(i) = 0;
+    dist.grad_grad2_accumulate(x,terms.grad(i),terms.grad2(i));
+}
+
+template<template <int> class CopulaTemplate, class... MarginalDistTs>
+template<class InIter, class Vec2, std::size_t... I>
+void CopulaDist<CopulaTemplate,MarginalDistTs...>::accumulate_marginal_param_terms(InIter in_it, const NdimVecT &c_grad, 
+        Vec2 &g, NparamsVecT &du, NparamsMatT &H, OffsetArrayT &offset, std::index_sequence<I...>) const
+{
+    offset[0] = CopulaT::num_params();
+    meta::call_in_order({(accumulate_marginal_param_terms_idx(std::get<I>(marginals),*in_it++,c_grad(I),g,du,H,offset,I),0)...});
+}
+
+/* Accumulates the marginal i terms of g, and the diagonal block of H, and records du(i)/dphi(i) in du */
+template<template <int> class CopulaTemplate, class... MarginalDistTs>
+template<class Dist, class Vec2>
+void CopulaDist<CopulaTemplate,MarginalDistTs...>::accumulate_marginal_param_terms_idx(const Dist &dist, double x, double c_grad, 
+        Vec2 &g, NparamsVecT &du, NparamsMatT &H, OffsetArrayT &offset, IdxT i)
+{
+    constexpr IdxT Np = Dist::num_params();
+    IdxT k = offset[i];
+    offset[i+1] = k+Np;
+    typename Dist::NparamsVecT m_grad(arma::fill::zeros), u_grad;
+    typename Dist::NparamsMatT m_hess(arma::fill::zeros), u_hess;
+    dist.param_grad_hess_accumulate(x,m_grad,m_hess);
+    dist.cdf_param_grad_hess(x,u_grad,u_hess);
+    for(IdxT b=0; b<Np; b++) {
+        du(k+b) = u_grad(b);
+        g(k+b) += c_grad*u_grad(b) + m_grad(b);
+        for(IdxT a=0; a<=b; a++) H(k+a,k+b) += c_grad*u_hess(a,b) + m_hess(a,b);
+    }
+}
+
 template<template <int> class CopulaTemplate, class... MarginalDistTs>
 template<class InIter,class OutIter,std::size_t... I>
 void CopulaDist<CopulaTemplate,MarginalDistTs...>::compute_marginal_pdf(InIter in_it, OutIter out_it, std::index_sequence<I...>) const
@@ -2,38 +2,140 @@
  * @author Mark J. Olah (mjo\@cs.unm DOT edu)
  * @date 2017-2019
  * @brief EulerianPolynomial computation.
+ *
+ * The Eulerian coefficients are generated at compile time for any degree, and evaluated with Estrin's scheme.
  */
 
 #ifndef PRIOR_HESSIAN_EULERIAN_POLYNOMIAL_H
 #define PRIOR_HESSIAN_EULERIAN_POLYNOMIAL_H
 
-#include<armadillo>
+#include <cstddef>
 
+#include "PriorHessian/Meta.h"
 
 namespace prior_hessian {
+namespace polylog {
 
-    
-template<long N, long M>
-struct eulerian_number 
-    : integral_constant<long, (N-M)*eulerian_number<N-1,M-1>{} + (M+1)*eulerian_number<N-1,M>{}> {};
-template<long M> 
-struct eulerian_number<0,M> : integral_constant<long,M==0> {};
+/* Polynomial coefficients in increasing order.  A plain array so it can be filled in by C++14 constexpr functions. */
+template<std::size_t N>
+struct PolyCoefficients
+{
+    static_assert(N>0, "Polynomial must have at least one coefficient.");
+    double c[N];
+    static constexpr std::size_t size() { return N; }
+    constexpr double operator[](std::size_t i) const { return c[i]; }
+};
+
+/* Coefficients of eulerian_polynomial<n>, i.e., the Eulerian numbers <n+1,k> for k=0..n, from the recurrence
+ *      <m,k> = (k+1)*<m-1,k> + (m-k)*<m-1,k-1>.
+ * The coefficients sum to (n+1)!, so doubles hold them, with at most rounding error, for n<170.
+ */
+template<int n>
+PRIOR_HESSIAN_META_CONSTEXPR
+PolyCoefficients<n+1> make_eulerian_coefficients()
+{
+    static_assert(n>=0 && n<170, "Eulerian polynomial degree must be in [0,170).");
+    PolyCoefficients<n+1> A{};
+    A.c[0] = 1;
+    for(int m=2; m<=n+1; m++) for(int k=m-1; k>=0; k--) A.c[k] = (k+1)*A.c[k] + (k>0 ? (m-k)*A.c[k-1] : 0);
+    return A;
+}
 
+template<std::size_t N>
+PRIOR_HESSIAN_META_CONSTEXPR
+PolyCoefficients<(N>1 ? N-1 : 1)> polynomial_derivative(const PolyCoefficients<N> &p)
+{
+    PolyCoefficients<(N>1 ? N-1 : 1)> d{};
+    for(std::size_t i=1; i<N; i++) d.c[i-1] = i*p.c[i];
+    return d;
+}
 
-namespace detail
+/* Estrin's scheme.  Each level combines adjacent pairs, b(i) = b(2i) + x*b(2i+1), and then squares x.  The pairs within
+ * a level are independent, so unlike Horner's method the evaluation is not one long chain of dependent multiply-adds,
+ * and the inner loop can be vectorized.  For fixed N the compiler fully unrolls it.
+ */
+template<std::size_t N>
+inline double estrin(const PolyCoefficients<N> &p, double x)
 {
-    template<long N, long... I>
-    VecT eulerian_polynomial()
-    {
-        return {eulerian_number<N,I>{},...};
+    double b[N];
+    for(std::size_t i=0; i<N; i++) b[i] = p.c[i];
+    for(std::size_t m=N; m>1; m=(m+1)/2) {
+        for(std::size_t i=0; i<m/2; i++) b[i] = b[2*i] + x*b[2*i+1];
+        if(m%2) b[m/2] = b[m-1];
+        x *= x;
     }
+    return b[0];
+}
+
+/* Compile time coefficients of eulerian_polynomial<n> and its first two derivatives */
+template<int n>
+struct EulerianPolynomial
+{
+    static_assert(PRIOR_HESSIAN_META_HAS_CONSTEXPR, "EulerianPolynomial requires constexpr support.");
+    using CoefficientsT = PolyCoefficients<n+1>;
+    using D1CoefficientsT = PolyCoefficients<(n>0 ? n : 1)>;
+    using D2CoefficientsT = PolyCoefficients<(n>1 ? n-1 : 1)>;
+    static constexpr CoefficientsT coefficients = make_eulerian_coefficients<n>();
+    static constexpr D1CoefficientsT d1_coefficients = polynomial_derivative(coefficients);
+    static constexpr D2CoefficientsT d2_coefficients = polynomial_derivative(d1_coefficients);
+};
+
+template<int n> constexpr typename EulerianPolynomial<n>::CoefficientsT EulerianPolynomial<n>::coefficients;
+template<int n> constexpr typename EulerianPolynomial<n>::D1CoefficientsT EulerianPolynomial<n>::d1_coefficients;
+template<int n> constexpr typename EulerianPolynomial<n>::D2CoefficientsT EulerianPolynomial<n>::d2_coefficients;
+
+/* Eulerian polynomial of degree n: 1, 1+z, 1+4z+z^2, 1+11z+11z^2+z^3, ... */
+template<int n> 
+double eulerian_polynomial(double z)
+{ return estrin(EulerianPolynomial<n>::coefficients, z); }
+
+/* All Eulerian polynomials of degree 0..n, for evaluation with a degree only known at run time */
+template<int n>
+struct EulerianTable
+{
+    static_assert(n>=0 && n<170, "Eulerian polynomial degree must be in [0,170).");
+    double c[n+1][n+1]; //Row m holds the coefficients of eulerian_polynomial<m>, padded with zeros
+};
+
+template<int n>
+PRIOR_HESSIAN_META_CONSTEXPR
+EulerianTable<n> make_eulerian_table()
+{
+    EulerianTable<n> T{};
+    T.c[0][0] = 1;
+    for(int m=1; m<=n; m++) for(int k=0; k<=m; k++) 
+        T.c[m][k] = (k<m ? (k+1)*T.c[m-1][k] : 0) + (k>0 ? (m+1-k)*T.c[m-1][k-1] : 0);
+    return T;
+}
+
+template<int n>
+struct EulerianPolynomialTable
+{
+    static_assert(PRIOR_HESSIAN_META_HAS_CONSTEXPR, "EulerianPolynomialTable requires constexpr support.");
+    static constexpr EulerianTable<n> table = make_eulerian_table<n>();
+};
+
+template<int n> constexpr EulerianTable<n> EulerianPolynomialTable<n>::table;
+
+/* Eulerian polynomial of degree m<=max_n, where m is only known at run time */
+template<int max_n> 
+double eulerian_polynomial(int m, double z)
+{
+    const double *A = EulerianPolynomialTable<max_n>::table.c[m];
+    double s = 0;
+    for(int k=m; k>=0; k--) s = s*z + A[k];
+    return s;
 }
 
-template<long N>
-VecT eulerian_polynomial()
+/* Value, first, and second derivatives of eulerian_polynomial<n> at z */
+template<int n> 
+void eulerian_polynomial_derivatives(double z, double &p, double &d1, double &d2)
 {
-    return detail::eulerian_polynomial<N,std::make_integer_sequence<long,N>>();
+    p = estrin(EulerianPolynomial<n>::coefficients, z);
+    d1 = n>=1 ? estrin(EulerianPolynomial<n>::d1_coefficients, z) : 0;
+    d2 = n>=2 ? estrin(EulerianPolynomial<n>::d2_coefficients, z) : 0;
 }
-    
+
+} /* namespace prior_hessian::polylog */
 } /* namespace prior_hessian */
 #endif /* PRIOR_HESSIAN_EULERIAN_POLYNOMIAL_H */
@@ -24,6 +24,7 @@ class GammaDist : public UnivariateDist
     static constexpr IdxT _num_params = 2;
 public:
     using NparamsVecT = arma::Col<double>::fixed<_num_params>;
+    using NparamsMatT = arma::Mat<double>::fixed<_num_params,_num_params>;
 
     /* Static member functions */
     static constexpr IdxT num_params() { return _num_params; }
@@ -63,12 +64,31 @@ public:
         
     double cdf(double x) const;
     double icdf(double u) const;
+    /* Survival function 1-cdf(x), its inverse, and the log-space cdf functions, all accurate far into the tails */
+    double sf(double x) const;
+    double isf(double u) const;
+    double logcdf(double x) const;
+    double logsf(double x) const;
+    double log_cdf_diff(double a, double b) const { return log_cdf_difference(*this,a,b); } /* log(cdf(b)-cdf(a)) */
+    /* Gradient and hessian of log_cdf_diff(a,b) with respect to the parameters, for the truncation adaptors */
+    void log_cdf_diff_param_grad_hess(double a, double b, NparamsVecT &grad, NparamsMatT &hess) const;
     double pdf(double x) const;
     double llh(double x) const;
     double rllh(double x) const;
     double grad(double x) const;
     double grad2(double x) const;
     void grad_grad2_accumulate(double x, double &g, double &g2) const;
+    /* Array forms over the N points x, for batched evaluation.  These are vectorized (see univariate_batch.cpp). */
+    void llh(IdxT N, const double *x, double *out) const;
+    void rllh(IdxT N, const double *x, double *out) const;
+    void grad(IdxT N, const double *x, double *out) const;
+    void grad2(IdxT N, const double *x, double *out) const;
+    void grad_grad2_accumulate(IdxT N, const double *x, double *g, double *g2) const;
+
+    /* Derivatives of llh with respect to the parameters, in params() order */
+    NparamsVecT param_grad(double x) const;
+    NparamsMatT param_hess(double x) const;
+    void param_grad_hess_accumulate(double x, NparamsVecT &g, NparamsMatT &h) const;
     
     template<class RngT>
     double sample(RngT &rng) const;
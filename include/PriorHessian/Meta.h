@@ -181,6 +181,10 @@ namespace meta {
     using ConstructableIfIsTemplateForAllT = std::enable_if_t< conjunction< 
         is_template_of<ClassTemplate,std::remove_reference_t<Ts>> ... >::value, bool>;
 
+    template<template <typename...> class ClassTemplate, class... Ts> 
+    using ConstructableIfNoneInstantiatedFromT = std::enable_if_t< !disjunction< 
+        is_template_of<ClassTemplate,std::decay_t<Ts>> ... >::value, bool>;
+
     template<class SuperClass, class T> 
     using ConstructableIfIsSuperClassT = std::enable_if_t< 
         std::is_base_of<std::remove_reference_t<SuperClass>,std::remove_reference_t<T>>::value, bool>;
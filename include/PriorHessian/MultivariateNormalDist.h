@@ -23,6 +23,7 @@ public:
     using NdimVecT = arma::Col<double>::fixed<Ndim>;
     using NdimMatT = arma::Mat<double>::fixed<Ndim,Ndim>;
     using NparamsVecT = arma::Col<double>::fixed<_num_params>;
+    using NparamsMatT = arma::Mat<double>::fixed<_num_params,_num_params>;
     
     static constexpr IdxT num_params() {return _num_params;}
     static constexpr IdxT num_dim() {return Ndim;}
@@ -72,17 +73,39 @@ public:
     NdimVecT mode() const { return mu(); }
     
     template<class Vec> double cdf(Vec x) const;
+    /* Batched cdf of each column of x [Ndim x N] */
+    VecT cdf(const MatT &x) const;
+    /* Probability of the rectangle [lbound,ubound], in a single integration.  Entries may be infinite. */
+    template<class Vec,class Vec2> double rectangle_probability(const Vec &lbound, const Vec2 &ubound) const;
+    /* log of rectangle_probability.  Small probabilities are integrated to a relative tolerance, and do not underflow:
+     * a rectangle limited in a single dimension is computed exactly in log space, and others far in the tails are
+     * integrated in log-scaled form (see genz::log_mvn_integral). */
+    template<class Vec,class Vec2> double log_rectangle_probability(const Vec &lbound, const Vec2 &ubound) const;
+    /* Gradient of log_rectangle_probability with respect to the parameters, in params() order.
+     * The mu derivatives are integrals over the faces of the rectangle, and by Plackett's identity the sigma derivatives
+     * are integrals over its faces of codimension 2, so only normal integrals of Ndim-1 and Ndim-2 dimensions are needed.
+     * These are exact for Ndim<=3 and lattice integrals otherwise. */
+    template<class Vec,class Vec2> NparamsVecT log_rectangle_probability_param_grad(const Vec &lbound, const Vec2 &ubound) const;
     template<class Vec> double pdf(const Vec &x) const;
     template<class Vec> double llh(const Vec &x) const;
     template<class Vec> double rllh(const Vec &x) const;
     template<class Vec> NdimVecT grad(const Vec &x) const;
     template<class Vec> NdimVecT grad2(const Vec &x) const;
     template<class Vec> NdimMatT hess(const Vec &x) const;
+    template<class Vec,class Vec2> NdimVecT hessvec(const Vec &x, const Vec2 &v) const;
     
     template<class Vec,class Vec2>
     void grad_grad2_accumulate(const Vec &x, Vec2 &g, Vec2 &g2) const;
     template<class Vec,class Vec2,class Mat>
     void grad_hess_accumulate(const Vec &x, Vec2 &g, Mat &hess) const;
+
+    /* Derivatives of llh with respect to the parameters, in params() order.  
+     * Each sigma parameter is an upper-triangular element, which sets both sigma(r,c) and sigma(c,r).
+     */
+    template<class Vec> NparamsVecT param_grad(const Vec &x) const;
+    template<class Vec> NparamsMatT param_hess(const Vec &x) const;
+    template<class Vec,class Vec2,class Mat>
+    void param_grad_hess_accumulate(const Vec &x, Vec2 &g, Mat &h) const;
     
     template<class RngT>
     NdimVecT sample(RngT &rng) const;
@@ -129,6 +152,14 @@ private:
     mutable bool llh_const_initialized;
     void initialize_llh_const() const;
     static double compute_llh_const(const NdimMatT &sigma);
+
+    /* log of the integral over [a,b] of a zero-mean normal with covariance S, in any number of dimensions.
+     * Trivariate rectangles use tvn_rectangle_probability unless the probability is too small for its absolute accuracy.
+     */
+    static double log_rectangle_integral(const VecT &a, const VecT &b, const MatT &S);
+    static constexpr double tvn_rectangle_min_probability = 1E-6;
+    /* log of the integral of the pdf of x-mu over the face of [a,b] where x(idx)-mu(idx) = s */
+    double log_face_integral(const VecT &a, const VecT &b, const arma::uvec &idx, const VecT &s) const;
 };
 
 namespace helpers 
@@ -488,7 +519,147 @@ template<>
 template<class Vec>
 double MultivariateNormalDist<2>::cdf(Vec x) const
 {
-    return owen_bvn_cdf((x-mu()).eval(), sigma());
+    return bvn_cdf((x-mu()).eval(), sigma());
+}
+
+template<>
+template<class Vec>
+double MultivariateNormalDist<3>::cdf(Vec x) const
+{
+    return tvn_cdf((x-mu()).eval(), sigma());
+}
+
+template<IdxT Ndim>
+template<class Vec, class Vec2>
+double MultivariateNormalDist<Ndim>::rectangle_probability(const Vec &lbound, const Vec2 &ubound) const
+{
+    VecT a = lbound-mu();
+    VecT b = ubound-mu();
+    if(Ndim == 3) {
+        double p = tvn_rectangle_probability(a, b, sigma());
+        if(p > tvn_rectangle_min_probability) return p;
+    }
+    double error;
+    int inform;
+    return genz::mvn_integral_genz(a, b, sigma(), error, inform);
+}
+
+template<IdxT Ndim>
+template<class Vec, class Vec2>
+double MultivariateNormalDist<Ndim>::log_rectangle_probability(const Vec &lbound, const Vec2 &ubound) const
+{
+    return log_rectangle_integral(lbound-mu(), ubound-mu(), sigma());
+}
+
+/* With Z the rectangle probability and F(i,s) the integral over the face x(i)-mu(i)=s, increasing mu(i) adds mass
+ * through the lower face and removes it through the upper face, so
+ *      dZ/dmu(i) = F(i,a(i)) - F(i,b(i)).
+ * Differentiating again, with F(i,j,s,t) the integral over the face of codimension 2,
+ *      d2Z/dmu(i)dmu(j) = sum over the corners of +-F(i,j,s,t),  i!=j
+ *      d2Z/dmu(i)^2 = [s*F(i,s)]_{b(i)}^{a(i)}/sigma(i,i) - sum_{k!=i} sigma(k,i)/sigma(i,i)*d2Z/dmu(i)dmu(k),
+ * as the conditional mean of x(k) on the face x(i)=s moves by -sigma(k,i)/sigma(i,i) with mu(i).  Plackett's identity
+ * gives the sigma derivatives as dZ/dsigma(i,j) = d2Z/dmu(i)dmu(j) for the symmetric off-diagonal parameters, and
+ * dZ/dsigma(i,i) = d2Z/dmu(i)^2/2.  Each face integral is divided by Z in log space, so small Z does not underflow.
+ */
+template<IdxT Ndim>
+template<class Vec, class Vec2>
+typename MultivariateNormalDist<Ndim>::NparamsVecT 
+MultivariateNormalDist<Ndim>::log_rectangle_probability_param_grad(const Vec &lbound, const Vec2 &ubound) const
+{
+    const VecT a = lbound-mu();
+    const VecT b = ubound-mu();
+    const NdimMatT &S = sigma();
+    double log_Z = log_rectangle_integral(a, b, S);
+    NdimVecT d1(arma::fill::zeros);
+    NdimVecT t(arma::fill::zeros); // [s*F(i,s)]_{b(i)}^{a(i)}/sigma(i,i)
+    NdimMatT d2(arma::fill::zeros);
+    for(IdxT i=0; i<Ndim; i++) for(IdxT si=0; si<2; si++) {
+        double s = si ? b(i) : a(i);
+        if(!std::isfinite(s)) continue;
+        double f = (si ? -1 : 1) * exp(log_face_integral(a, b, arma::uvec{i}, VecT{s}) - log_Z);
+        d1(i) += f;
+        t(i) += f*s/S(i,i);
+    }
+    for(IdxT j=1; j<Ndim; j++) for(IdxT i=0; i<j; i++) {
+        for(IdxT si=0; si<2; si++) for(IdxT sj=0; sj<2; sj++) {
+            VecT s = {si ? b(i) : a(i), sj ? b(j) : a(j)};
+            if(!s.is_finite()) continue;
+            d2(i,j) += ((si==sj) ? 1 : -1) * exp(log_face_integral(a, b, arma::uvec{i,j}, s) - log_Z);
+        }
+        d2(j,i) = d2(i,j);
+    }
+    for(IdxT i=0; i<Ndim; i++) {
+        d2(i,i) = t(i);
+        for(IdxT k=0; k<Ndim; k++) if(k != i) d2(i,i) -= S(k,i)/S(i,i)*d2(i,k);
+    }
+    NparamsVecT g;
+    g.head(Ndim) = d1;
+    IdxT q = Ndim;
+    for(IdxT c=0; c<Ndim; c++) for(IdxT r=0; r<=c; r++) g(q++) = (r==c) ? .5*d2(r,r) : d2(r,c);
+    return g;
+}
+
+template<IdxT Ndim>
+double MultivariateNormalDist<Ndim>::log_rectangle_integral(const VecT &a, const VecT &b, const MatT &S)
+{
+    if(a.n_elem == 0) return 0;
+    if(a.n_elem == 3) {
+        double p = tvn_rectangle_probability(a, b, S);
+        if(p > tvn_rectangle_min_probability) return log(p);
+    }
+    double error;
+    int inform;
+    genz::MVNIntegralOptions opts;
+    double log_p = genz::log_mvn_integral_genz(a, b, S, error, inform, opts);
+    if(log_p < log(100*opts.abseps)) { //Refine small probabilities to the relative tolerance
+        opts.abseps = 0;
+        log_p = genz::log_mvn_integral_genz(a, b, S, error, inform, opts);
+    }
+    return log_p;
+}
+
+/* The pdf of x(idx) at s times the probability of the rest of the rectangle under the conditional distribution */
+template<IdxT Ndim>
+double MultivariateNormalDist<Ndim>::log_face_integral(const VecT &a, const VecT &b, const arma::uvec &idx, 
+                                                       const VecT &s) const
+{
+    const NdimMatT &S = sigma();
+    MatT S_face = S.submat(idx,idx);
+    MatT S_face_inv = arma::inv_sympd(S_face);
+    double log_pdf = -.5*(arma::dot(s,S_face_inv*s) + log(arma::det(S_face)) + idx.n_elem*constants::log2pi);
+    arma::uvec rest(Ndim-idx.n_elem);
+    for(IdxT i=0, n=0; i<Ndim; i++) if(!arma::any(idx==i)) rest(n++) = i;
+    if(rest.is_empty()) return log_pdf;
+    MatT B = S.submat(rest,idx)*S_face_inv;
+    VecT m = B*s;
+    MatT S_cond = S.submat(rest,rest) - B*S.submat(idx,rest);
+    return log_pdf + log_rectangle_integral(a.elem(rest)-m, b.elem(rest)-m, S_cond);
+}
+
+template<IdxT Ndim>
+VecT MultivariateNormalDist<Ndim>::cdf(const MatT &x) const
+{
+    if(x.n_rows != Ndim) {
+        std::ostringstream msg;
+        msg<<"cdf: Got x with "<<x.n_rows<<" rows.  Expected Ndim:"<<Ndim;
+        throw ParameterSizeError(msg.str());
+    }
+    VecT out(x.n_cols);
+    for(IdxT n=0; n<x.n_cols; n++) out(n) = cdf(x.col(n));
+    return out;
+}
+
+template<>
+inline
+VecT MultivariateNormalDist<2>::cdf(const MatT &x) const
+{
+    if(x.n_rows != 2) {
+        std::ostringstream msg;
+        msg<<"cdf: Got x with "<<x.n_rows<<" rows.  Expected Ndim:2";
+        throw ParameterSizeError(msg.str());
+    }
+    MatT z = x.each_col() - mu();
+    return owen_bvn_cdf_batch(z, sigma());
 }
 
 template<IdxT Ndim>
@@ -539,6 +710,14 @@ MultivariateNormalDist<Ndim>::hess(const Vec &) const
 {
     return -sigma_inv();
 }
+
+template<IdxT Ndim>
+template<class Vec,class Vec2>
+typename MultivariateNormalDist<Ndim>::NdimVecT 
+MultivariateNormalDist<Ndim>::hessvec(const Vec &, const Vec2 &v) const
+{
+    return -sigma_inv()*v;
+}
     
 template<IdxT Ndim>
 template<class Vec,class Vec2> //Allow different vector types for flexibility between fixed and non-fixed
@@ -556,6 +735,70 @@ void MultivariateNormalDist<Ndim>::grad_hess_accumulate(const Vec &x, Vec2 &g, M
     hess += -sigma_inv();
 }
     
+/* With a = sigma_inv*(x-mu), d(llh)/d(mu) = a and d(llh)/d(sigma) = (a*a' - sigma_inv)/2.
+ * For sigma directions A and B, d2(llh)/dA dB = tr(sigma_inv*A*sigma_inv*B)/2 - a'*A*sigma_inv*B*a.
+ */
+template<IdxT Ndim>
+template<class Vec>
+typename MultivariateNormalDist<Ndim>::NparamsVecT 
+MultivariateNormalDist<Ndim>::param_grad(const Vec &x) const
+{
+    const NdimMatT &P = sigma_inv();
+    NdimVecT a = P*(x-mu());
+    NparamsVecT g;
+    g.head(Ndim) = a;
+    IdxT q = Ndim;
+    for(IdxT c=0; c<Ndim; c++) for(IdxT r=0; r<=c; r++) {
+        double m = .5*(a(r)*a(c) - P(r,c));
+        g(q++) = (r==c) ? m : 2*m;
+    }
+    return g;
+}
+
+template<IdxT Ndim>
+template<class Vec>
+typename MultivariateNormalDist<Ndim>::NparamsMatT 
+MultivariateNormalDist<Ndim>::param_hess(const Vec &x) const
+{
+    NparamsVecT g(arma::fill::zeros);
+    NparamsMatT h(arma::fill::zeros);
+    param_grad_hess_accumulate(x,g,h);
+    return h;
+}
+
+template<IdxT Ndim>
+template<class Vec,class Vec2,class Mat>
+void MultivariateNormalDist<Ndim>::param_grad_hess_accumulate(const Vec &x, Vec2 &g, Mat &h) const
+{
+    const NdimMatT &P = sigma_inv();
+    NdimVecT a = P*(x-mu());
+    for(IdxT j=0; j<Ndim; j++) {
+        g(j) += a(j);
+        for(IdxT i=0; i<Ndim; i++) h(i,j) -= P(i,j);
+    }
+    //The direction for sigma parameter (r,c) is e_r*e_c' + e_c*e_r', or just e_r*e_r' on the diagonal.
+    auto sigma_sigma_term = [&](IdxT r, IdxT c, IdxT r2, IdxT c2) { return P(c,r2)*(.5*P(c2,r) - a(r)*a(c2)); };
+    IdxT q = Ndim;
+    for(IdxT c=0; c<Ndim; c++) for(IdxT r=0; r<=c; r++, q++) {
+        double m = .5*(a(r)*a(c) - P(r,c));
+        g(q) += (r==c) ? m : 2*m;
+        for(IdxT i=0; i<Ndim; i++) { //mu-sigma terms: d(a)/d(sigma_rc)
+            double v = (r==c) ? -P(i,r)*a(r) : -(P(i,r)*a(c) + P(i,c)*a(r));
+            h(i,q) += v;
+            h(q,i) += v;
+        }
+        IdxT q2 = Ndim;
+        for(IdxT c2=0; c2<=c; c2++) for(IdxT r2=0; r2<=c2 && q2<=q; r2++, q2++) {
+            double v = sigma_sigma_term(r,c,r2,c2);
+            if(r!=c) v += sigma_sigma_term(c,r,r2,c2);
+            if(r2!=c2) v += sigma_sigma_term(r,c,c2,r2);
+            if(r!=c && r2!=c2) v += sigma_sigma_term(c,r,c2,r2);
+            h(q,q2) += v;
+            if(q2!=q) h(q2,q) += v;
+        }
+    }
+}
+
 template<IdxT Ndim>
 template<class RngT>
 typename MultivariateNormalDist<Ndim>::NdimVecT 
@@ -574,7 +817,7 @@ double MultivariateNormalDist<Ndim>::compute_llh_const(const NdimMatT &sigma)
     double logdet_sigma;
     arma::log_det(logdet_sigma, sign, sigma);
     if(sign<0) throw ParameterValueError("Log determinant is negative.  Sigma is not positive definite.");
-    return .5*(logdet_sigma + Ndim*constants::log2pi);
+    return -.5*(logdet_sigma + Ndim*constants::log2pi);
 }
 
 template<IdxT Ndim>
@@ -23,6 +23,7 @@ class NormalDist : public UnivariateDist
     static constexpr IdxT _num_params = 2;
 public:
     using NparamsVecT = arma::Col<double>::fixed<_num_params>;
+    using NparamsMatT = arma::Mat<double>::fixed<_num_params,_num_params>;
 
     /* Static member functions */
     static constexpr IdxT num_params() { return _num_params; }
@@ -64,15 +65,40 @@ public:
     
     double cdf(double x) const;
     double icdf(double u) const;
+    /* Survival function 1-cdf(x), its inverse, and the log-space cdf functions, all accurate far into the tails */
+    double sf(double x) const;
+    double isf(double u) const;
+    double logcdf(double x) const;
+    double logsf(double x) const;
+    double log_cdf_diff(double a, double b) const; /* log(cdf(b)-cdf(a)) */
+    /* Gradient and hessian of log_cdf_diff(a,b) with respect to the parameters, for the truncation adaptors */
+    void log_cdf_diff_param_grad_hess(double a, double b, NparamsVecT &grad, NparamsMatT &hess) const;
+    /* Inverses of logcdf and logsf, for quantiles whose probability underflows as a double */
+    double ilogcdf(double log_u) const;
+    double ilogsf(double log_u) const;
     double pdf(double x) const;
     double llh(double x) const;
     double rllh(double x) const;
     double grad(double x) const;
     double grad2(double x) const;
     void grad_grad2_accumulate(double x, double &g, double &g2) const;
+    /* Array forms over the N points x, for batched evaluation.  These are vectorized (see univariate_batch.cpp). */
+    void llh(IdxT N, const double *x, double *out) const;
+    void rllh(IdxT N, const double *x, double *out) const;
+    void grad(IdxT N, const double *x, double *out) const;
+    void grad2(IdxT N, const double *x, double *out) const;
+    void grad_grad2_accumulate(IdxT N, const double *x, double *g, double *g2) const;
+
+    /* Derivatives of llh with respect to the parameters, in params() order */
+    NparamsVecT param_grad(double x) const;
+    NparamsMatT param_hess(double x) const;
+    void param_grad_hess_accumulate(double x, NparamsVecT &g, NparamsMatT &h) const;
     
     template<class RngT>
     double sample(RngT &rng) const;
+    /* Sample truncated to [a,b].  Used by TruncatedDist<NormalDist> in place of inversion. */
+    template<class RngT>
+    double sample_truncated(double a, double b, RngT &rng) const;
 
      /* Specialized iterator-based adapter methods for efficient use by CompositeDist::ComponentDistAdaptor */
     template<class IterT>
@@ -184,6 +210,35 @@ void NormalDist::grad_grad2_accumulate(double x, double &g, double &g2) const
     g2 += -sigma_inv2;
 }
 
+inline
+NormalDist::NparamsVecT NormalDist::param_grad(double x) const
+{
+    double z = (x - _mu)*_sigma_inv;
+    return {z*_sigma_inv, (z*z-1)*_sigma_inv};
+}
+
+inline
+NormalDist::NparamsMatT NormalDist::param_hess(double x) const
+{
+    NparamsVecT g(arma::fill::zeros);
+    NparamsMatT h(arma::fill::zeros);
+    param_grad_hess_accumulate(x,g,h);
+    return h;
+}
+
+inline
+void NormalDist::param_grad_hess_accumulate(double x, NparamsVecT &g, NparamsMatT &h) const
+{
+    double z = (x - _mu)*_sigma_inv;
+    double sigma_inv2 = square(_sigma_inv);
+    g(0) += z*_sigma_inv;  // d/dmu
+    g(1) += (z*z-1)*_sigma_inv; // d/dsigma
+    h(0,0) += -sigma_inv2;
+    h(0,1) += -2*z*sigma_inv2;
+    h(1,0) += -2*z*sigma_inv2;
+    h(1,1) += (1-3*z*z)*sigma_inv2;
+}
+
 template<class RngT>
 double NormalDist::sample(RngT &rng) const
 {
@@ -192,6 +247,64 @@ double NormalDist::sample(RngT &rng) const
 }
  
  
+/** Sample a unit normal truncated to [a,b], for a < b with infinite limits allowed.
+ *
+ * Uses the rejection samplers of Robert (1995), selected by truncation region.  Intervals with b <= 0 are mirrored
+ * to a >= 0.  Intervals containing 0 use a normal proposal if b-a >= sqrt(2*pi), and otherwise a uniform proposal.
+ * Tail intervals, 0 <= a < b, choose among half-normal, uniform, and Robert's exponential proposal with
+ * rate (a+sqrt(a^2+4))/2.  Each acceptance probability is Z=P(a<=X<=b) times a factor with a closed form, so the
+ * proposal with the largest factor is chosen without computing Z.  No cdf or inverse cdf is evaluated, and the
+ * accuracy does not degrade in the tails, where inversion loses precision as the cdf rounds to 1.
+ */
+template<class RngT>
+double sample_truncated_unit_normal(double a, double b, RngT &rng)
+{
+    if(b <= 0) return -sample_truncated_unit_normal(-b,-a,rng);
+    std::uniform_real_distribution<double> uniform;
+    if(a < 0) {
+        if(b-a >= constants::sqrt2pi) {
+            std::normal_distribution<double> normal;
+            for(;;) {
+                double x = normal(rng);
+                if(a <= x && x <= b) return x;
+            }
+        }
+        for(;;) {
+            double x = a + (b-a)*uniform(rng);
+            if(uniform(rng) <= exp(-.5*x*x)) return x;
+        }
+    }
+    //Log of acceptance probability divided by Z, for each proposal
+    double alpha = .5*(a + sqrt(a*a+4));
+    double log_acc_half_normal = log(2.);
+    double log_acc_uniform = .5*constants::log2pi + .5*a*a - log(b-a);
+    double log_acc_exp = .5*constants::log2pi + log(alpha) + alpha*(a-.5*alpha);
+    if(log_acc_half_normal >= log_acc_uniform && log_acc_half_normal >= log_acc_exp) {
+        std::normal_distribution<double> normal;
+        for(;;) {
+            double x = fabs(normal(rng));
+            if(a <= x && x <= b) return x;
+        }
+    } else if(log_acc_uniform >= log_acc_exp) {
+        for(;;) {
+            double x = a + (b-a)*uniform(rng);
+            if(uniform(rng) <= exp(-.5*(x-a)*(x+a))) return x;
+        }
+    } else {
+        for(;;) {
+            double x = a - log1p(-uniform(rng))/alpha;
+            if(x <= b && uniform(rng) <= exp(-.5*square(x-alpha))) return x;
+        }
+    }
+}
+
+template<class RngT>
+double NormalDist::sample_truncated(double a, double b, RngT &rng) const
+{
+    double x = mu() + sigma()*sample_truncated_unit_normal((a-mu())/sigma(), (b-mu())/sigma(), rng);
+    return std::min(std::max(x,a),b); //Rounding in the rescaling can step just outside [a,b]
+}
+
 /* Protected methods */
 template<class IterT>
 bool NormalDist::check_params_iter(IterT &params)
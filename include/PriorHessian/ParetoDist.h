@@ -22,6 +22,7 @@ class ParetoDist : public UnivariateDist
     static constexpr IdxT _num_params = 2;
 public:
     using NparamsVecT = arma::Col<double>::fixed<_num_params>;
+    using NparamsMatT = arma::Mat<double>::fixed<_num_params,_num_params>;
     static constexpr IdxT num_params() { return _num_params; }
     static constexpr double global_lbound() { return 0; }
     static constexpr double ubound() { return INFINITY; }
@@ -65,12 +66,31 @@ public:
     
     double cdf(double x) const;
     double icdf(double u) const;
+    /* Survival function 1-cdf(x), its inverse, and the log-space cdf functions, all accurate far into the tails */
+    double sf(double x) const;
+    double isf(double u) const;
+    double logcdf(double x) const;
+    double logsf(double x) const;
+    double log_cdf_diff(double a, double b) const { return log_cdf_difference(*this,a,b); } /* log(cdf(b)-cdf(a)) */
+    /* Gradient and hessian of log_cdf_diff(a,b) with respect to the parameters, for the truncation adaptors */
+    void log_cdf_diff_param_grad_hess(double a, double b, NparamsVecT &grad, NparamsMatT &hess) const;
     double pdf(double x) const;
     double llh(double x) const;
     double rllh(double x) const;
     double grad(double x) const;
     double grad2(double x) const;
     void grad_grad2_accumulate(double x, double &g, double &g2) const;
+    /* Array forms over the N points x, for batched evaluation.  These are vectorized (see univariate_batch.cpp). */
+    void llh(IdxT N, const double *x, double *out) const;
+    void rllh(IdxT N, const double *x, double *out) const;
+    void grad(IdxT N, const double *x, double *out) const;
+    void grad2(IdxT N, const double *x, double *out) const;
+    void grad_grad2_accumulate(IdxT N, const double *x, double *g, double *g2) const;
+
+    /* Derivatives of llh with respect to the parameters, in params() order */
+    NparamsVecT param_grad(double x) const;
+    NparamsMatT param_hess(double x) const;
+    void param_grad_hess_accumulate(double x, NparamsVecT &g, NparamsMatT &h) const;
     
     template<class RngT>
     double sample(RngT &rng) const;
@@ -154,7 +174,7 @@ bool ParetoDist::check_lbound(double min)
 inline
 double ParetoDist::cdf(double x) const
 {
-    return 1-pow(lbound()/x, alpha());
+    return -expm1(logsf(x));
 }
 
 inline
@@ -163,6 +183,30 @@ double ParetoDist::icdf(double u) const
     return lbound() / pow(1-u,1/alpha());
 }
 
+inline
+double ParetoDist::sf(double x) const
+{
+    return exp(logsf(x));
+}
+
+inline
+double ParetoDist::isf(double u) const
+{
+    return lbound() / pow(u,1/alpha());
+}
+
+inline
+double ParetoDist::logcdf(double x) const
+{
+    return log1mexp(logsf(x));
+}
+
+inline
+double ParetoDist::logsf(double x) const
+{
+    return alpha()*log(lbound()/x);
+}
+
 inline
 double ParetoDist::pdf(double x) const
 {
@@ -196,6 +240,34 @@ void ParetoDist::grad_grad2_accumulate(double x, double &g, double &g2) const
     g2 += ap1ox*x_inv;  // (alpha+1)/x^2
 }
 
+inline
+ParetoDist::NparamsVecT ParetoDist::param_grad(double x) const
+{
+    return {_alpha/_min, 1/_alpha + log(_min/x)};
+}
+
+inline
+ParetoDist::NparamsMatT ParetoDist::param_hess(double x) const
+{
+    NparamsVecT g(arma::fill::zeros);
+    NparamsMatT h(arma::fill::zeros);
+    param_grad_hess_accumulate(x,g,h);
+    return h;
+}
+
+inline
+void ParetoDist::param_grad_hess_accumulate(double x, NparamsVecT &g, NparamsMatT &h) const
+{
+    double min_inv = 1/_min;
+    double alpha_inv = 1/_alpha;
+    g(0) += _alpha*min_inv; // d/dmin
+    g(1) += alpha_inv + log(_min/x); // d/dalpha
+    h(0,0) += -_alpha*square(min_inv);
+    h(0,1) += min_inv;
+    h(1,0) += min_inv;
+    h(1,1) += -square(alpha_inv);
+}
+
 template<class RngT>
 double ParetoDist::sample(RngT &rng) const
 {
@@ -2,77 +2,22 @@
  * @author Mark J. Olah (mjo\@cs.unm DOT edu)
  * @date 2017-2019
  * @brief Poly log computation for negative integer valued parameters.
+ *
+ * For n>=1, polylog<-n>(z) = z*A_n(z)/(1-z)^(n+1), where A_n = eulerian_polynomial<n-1> is the Eulerian polynomial of
+ * degree n-1.
  */
 
 #ifndef PRIOR_HESSIAN_POLYLOG_H
 #define PRIOR_HESSIAN_POLYLOG_H
-namespace prior_hessian {
-namespace polylog {
-
-    
-template<int n> 
-double eulerian_polynomial(double z);
 
-template<>
-double eulerian_polynomial<0>(double)
-{
-    return 1;
-}
-
-template<>
-double eulerian_polynomial<1>(double z)
-{
-    return 1+z;
-}
-
-template<>
-double eulerian_polynomial<2>(double z)
-{
-    return 1+z*(4+z);
-}
-
-template<>
-double eulerian_polynomial<3>(double z)
-{
-    return 1+z*(11+z*(11+z));
-}
-
-template<>
-double eulerian_polynomial<4>(double z)
-{
-    return 1+z*(26+z*(66+z*(26+z)));
-}
-
-template<>
-double eulerian_polynomial<5>(double z)
-{
-    return 1+z*(57+z*(302+z*(302+z*(57+z))));
-}
+#include <cmath>
+#include <type_traits>
 
-template<>
-double eulerian_polynomial<6>(double z)
-{
-    return 1+z*(120+z*(1191+z*(2416+z*(1191+z*(120+z)))));
-}
+#include "PriorHessian/EulerianPolynomial.h"
 
-template<>
-double eulerian_polynomial<7>(double z)
-{
-    return 1+z*(247+z*(4293+z*(15619+z*(15619+z*(4293+z*(247+z))))));
-}
+namespace prior_hessian {
+namespace polylog {
 
-template<>
-double eulerian_polynomial<8>(double z)
-{
-    return 1+z*(502+z*(14608+z*(88234+z*(156190+z*(88234+z*(14608+z*(502+z)))))));
-}
-template<>
-double eulerian_polynomial<9>(double z)
-{
-    return 1+z*(1013+z*(47840+z*(455192+z*(1310354+z*(1310354+z*(455192+z*(47840+z*(1013+z))))))));
-}
-    
-    
 // template<int n>
 // double poly_A171692(double z);
 // 
@@ -113,104 +58,33 @@ double eulerian_polynomial<9>(double z)
 // }
 
     
-template<int n> 
-double polylog(double z);
-
-template<>
-double polylog<1>(double z)
+template<int n>
+typename std::enable_if_t< n==1, double> 
+polylog(double z)
 {
-    return -std::log(1-z);
+    return -std::log1p(-z);
 }
 
 template<int n>
 typename std::enable_if_t< n<=0, double> 
 polylog(double z)
 {
-    return z*eulerian_polynomial<-n>(z)/(1-z);
+    return n==0 ? z/(1-z) : z*eulerian_polynomial<(n<0 ? -n-1 : 0)>(z)/std::pow(1-z,1-n);
+}
+
+/* log(polylog<n>(z)) for n<=0 and 0<z<1.  As z->1 the polylog overflows for large -n, but its log does not.
+ * Near 1, z is best represented by its log, log_z=log(z), as 1-z=-expm1(log_z) is then computed to full relative
+ * precision even when z rounds to 1.
+ */
+template<int n>
+typename std::enable_if_t< n<=0, double> 
+log_polylog_exp(double log_z)
+{
+    double z = std::exp(log_z);
+    double log_A = n==0 ? 0 : std::log(eulerian_polynomial<(n<0 ? -n-1 : 0)>(z));
+    return log_z + log_A - (1-n)*std::log(-std::expm1(log_z));
 }
 
-// template<>
-// double polylog<-1>(double z)
-// {
-//     // z/(1-z)^2
-//     double zr = 1-z;
-//     return z/(zr*zr);
-// }
-// 
-// template<>
-// double polylog<-2>(double z)
-// {
-//     // z*(1+z)/(1-z)^3
-//     double zr = 1-z;
-//     return z*(1+z) / std::pow(zr,3);
-// }
-// 
-// template<>
-// double polylog<-3>(double z)
-// {
-//      // (z+4z^2+z^3) / (1-z)^4
-//     double zr = 1-z;
-//     return eulerian_polynomial<2>(z) / std::pow(zr,4);
-// }
-// 
-// template<>
-// double polylog<-4>(double z)
-// {
-//     // (z+11*z^2+11*z^3+z^4) / (1-z)^5
-//     double zr = 1-z;
-//     return eulerian_polynomial<3>(z) / std::pow(zr,5);
-// }
-// 
-// template<>
-// double polylog<-5>(double z)
-// {
-//     // (z+26*z^2+66*z^3+26*z^4+z^5) / (1-z)^6
-//     double zr = 1-z;
-//     return eulerian_polynomial<4>(z) / std::pow(zr,6);
-// }
-// 
-// template<>
-// double polylog<-6>(double z)
-// {
-//     // (z+57*z^2+302*z^3+302*z^4+57*z^5+z^6) / (1-z)^7
-//     double zr = 1-z;
-//     return eulerian_polynomial<5>(z) / std::pow(zr,7);
-// }
-// 
-// template<>
-// double polylog<-7>(double z)
-// {
-//     // (z+120*z^2+1191*z^3+2416*z^4+1191*z^5+120*z^6+z^7) / (1-z)^8
-//     double zr = 1-z;
-//     return eulerian_polynomial<6>(z) / std::pow(zr,8);
-// }
-// 
-// template<>
-// double polylog<-8>(double z)
-// {
-//     // (z+247*z^2+4293*z^3+15619*z^4+15619*z^5+4293*z^6+247*z^7+z^8) / (1-z)^9
-//     double zr = 1-z;
-//     return eulerian_polynomial<7>(z) / std::pow(zr,9);
-// }
-// 
-// template<>
-// double polylog<-9>(double z)
-// {
-//     // (z+502*z^2+14608*z^3+88234*z^4+156190*z^5+88234*z^6+14608*z^7+502*z^8+z^9) / (1-z)^10
-//     double zr = 1-z;
-//     return eulerian_polynomial<8>(z) / std::pow(zr,10);
-// }
-// 
-// template<>
-// double polylog<-10>(double z)
-// {
-//     // (z+1013*z^2+47840*z^3+455192*z^4+1310345*z^5+1310345*z^6+455192*z^7+47840*z^8+1013*z^9+z^10) / (1-z)^11
-//     double zr = 1-z;
-//     return eulerian_polynomial<9>(z) / std::pow(zr,11);
-// }
-// 
-// 
-// 
 // template<int numer, int denom> 
 // double polylog_ratio(double z);
 // 
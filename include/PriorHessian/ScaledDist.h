@@ -8,6 +8,7 @@
 #define PRIOR_HESSIAN_SCALEDDIST_H
 
 #include <cmath>
+#include <utility>
 
 #include "PriorHessian/Meta.h"
 #include "PriorHessian/PriorHessianError.h"
@@ -19,6 +20,9 @@ template<class Dist>
 class ScaledDist : public Dist
 {
 public:
+    using NparamsVecT = typename Dist::NparamsVecT;
+    using NparamsMatT = typename Dist::NparamsMatT;
+
     ScaledDist() : ScaledDist(Dist{}) { }
     ScaledDist(double lbound, double ubound) : ScaledDist(Dist{}, lbound, ubound) { }
 
@@ -57,6 +61,27 @@ public:
     double pdf(double x) const;
     double icdf(double u) const;
     double llh(double x) const;
+    /* Array form of llh, if Dist has one.  Used by CompositeDist for batched evaluation. */
+    template<class D=Dist>
+    auto llh(IdxT N, const double *x, double *out) const -> decltype(std::declval<const D&>().llh(N,x,out))
+    {
+        D::llh(N,x,out);
+        for(IdxT i=0; i<N; i++) out[i] += llh_scaling_const;
+    }
+    double sf(double x) const { return Dist::sf(convert_to_unitary_coords(x)); }
+    double isf(double u) const { return convert_from_unitary_coords(Dist::isf(u)); }
+    double logcdf(double x) const { return Dist::logcdf(convert_to_unitary_coords(x)); }
+    double logsf(double x) const { return Dist::logsf(convert_to_unitary_coords(x)); }
+    double log_cdf_diff(double a, double b) const 
+    { return Dist::log_cdf_diff(convert_to_unitary_coords(a), convert_to_unitary_coords(b)); }
+
+    /* Scaling does not depend on the parameters, so parameter derivatives are those of Dist in unitary coordinates */
+    NparamsVecT param_grad(double x) const { return Dist::param_grad(convert_to_unitary_coords(x)); }
+    NparamsMatT param_hess(double x) const { return Dist::param_hess(convert_to_unitary_coords(x)); }
+    void param_grad_hess_accumulate(double x, NparamsVecT &g, NparamsMatT &h) const
+    { Dist::param_grad_hess_accumulate(convert_to_unitary_coords(x),g,h); }
+    /* Gradient and hessian of cdf(x) with respect to the parameters.  Used for CopulaDist parameter derivatives. */
+    void cdf_param_grad_hess(double x, NparamsVecT &grad, NparamsMatT &hess) const;
 
     template<class RngT>
     double sample(RngT &rng) const;
@@ -120,6 +145,22 @@ double ScaledDist<Dist>::icdf(double u) const
     return convert_from_unitary_coords(this->Dist::icdf(u));
 }
 
+template<class Dist>
+void ScaledDist<Dist>::cdf_param_grad_hess(double x, NparamsVecT &grad, NparamsMatT &hess) const
+{
+    double u = convert_to_unitary_coords(x);
+    if(!(unscaled_lbound() < u && u < unscaled_ubound())) { //cdf is 0 or 1 for any parameter values
+        grad.zeros();
+        hess.zeros();
+        return;
+    }
+    //Derivatives of the log-cdf, converted as in TruncatedDist::cdf_param_grad_hess
+    this->log_cdf_difference_param_grad_hess(static_cast<const Dist&>(*this), unscaled_lbound(), u, grad, hess);
+    double c = Dist::cdf(u);
+    hess = c*(hess + grad*grad.t());
+    grad *= c;
+}
+
 template<class Dist>
 double ScaledDist<Dist>::pdf(double x) const
 {
@@ -0,0 +1,814 @@
+/** @file StaticCompositeDist.h
+ * @author Mark J. Olah (mjo\@cs.unm DOT edu)
+ * @date 2017-2019
+ * @brief StaticCompositeDist class declaration and inline and templated member function definitions
+ *
+ *
+ */
+#ifndef PRIOR_HESSIAN_STATICCOMPOSITEDIST_H
+#define PRIOR_HESSIAN_STATICCOMPOSITEDIST_H
+
+#include<utility>
+#include<string>
+#include<tuple>
+
+#include<armadillo>
+
+#include "PriorHessian/Meta.h"
+#include "PriorHessian/util.h"
+#include "PriorHessian/PriorHessianError.h"
+#include "PriorHessian/CompositeDist.h"
+
+namespace prior_hessian {
+
+/** @brief A CompositeDist with the component types known at compile time.
+ *
+ * StaticCompositeDist<Ts...> stores the same tuple of bounds-adapted component distributions as CompositeDist, but
+ * without the type-erasing DistTupleHandle.  There is no virtual dispatch or std::unique_ptr indirection, so every
+ * llh/grad/hess call can be fully inlined into the caller.  num_dim() and num_params() are constexpr and single-point
+ * outputs are fixed-size armadillo types, so single-point evaluation does not allocate.
+ *
+ * The numerical API mirrors CompositeDist, including block_hess, hessvec, the parameter derivatives, and the workspace
+ * overloads.  Batched evaluation is always serial.  Threading (set_num_threads), counter-based parallel sampling
+ * (sample(num_samples,seed,nthreads)), and the naming conveniences (component_names, dim_variables, named params) are
+ * only provided by CompositeDist.  A CompositeDist can be constructed from any StaticCompositeDist when type-erasure is required.
+ */
+template<class... Ts>
+class StaticCompositeDist
+{
+    static_assert(sizeof...(Ts)>0, "StaticCompositeDist requires at least one component distribution.");
+    static_assert(PRIOR_HESSIAN_META_HAS_CONSTEXPR, "StaticCompositeDist requires constexpr support.");
+    using IndexT = std::index_sequence_for<Ts...>;
+
+public:
+    template<class DistT> using ComponentDistT = CompositeDist::ComponentDistT<DistT>;
+    using DistTupleT = std::tuple<ComponentDistT<Ts>...>;
+    using AnyRngT = CompositeDist::AnyRngT;
+
+private:
+    constexpr static IdxT _num_dists = sizeof...(Ts);
+    constexpr static IdxT _num_dim = meta::sum_in_order<IdxT>({ComponentDistT<Ts>::num_dim()...});
+    constexpr static IdxT _num_params = meta::sum_in_order<IdxT>({ComponentDistT<Ts>::num_params()...});
+
+public:
+    using NdimVecT = arma::Col<double>::fixed<_num_dim>;
+    using NdimMatT = arma::Mat<double>::fixed<_num_dim,_num_dim>;
+    using NparamsVecT = arma::Col<double>::fixed<_num_params>;
+    using NparamsMatT = arma::Mat<double>::fixed<_num_params,_num_params>;
+    using NcomponentsVecT = arma::Col<double>::fixed<_num_dists>;
+
+    static constexpr IdxT num_components() { return _num_dists; }
+    static constexpr IdxT num_dim() { return _num_dim; }
+    static constexpr IdxT num_params() { return _num_params; }
+    static UVecT num_dim_components() { return {ComponentDistT<Ts>::num_dim()...}; }
+    static UVecT num_params_components() { return {ComponentDistT<Ts>::num_params()...}; }
+    static TypeInfoVecT component_types() { return {std::type_index(typeid(typename ComponentDistT<Ts>::ComponentDistT))...}; }
+
+    StaticCompositeDist() = default;
+
+    /** @brief Construct from a variadic list of subclasses of UnivariateDist's or MulitvariateDist's */
+    template<class... Us, meta::ConstructableIfAllAreNotTupleAndAreNotT<StaticCompositeDist, Us...> = true>
+    explicit StaticCompositeDist(Us&&... component_dists)
+        : dists{CompositeDist::make_component_dist(std::forward<Us>(component_dists))...}
+    { static_assert(sizeof...(Us)==_num_dists, "Incorrect number of component distributions."); }
+
+    /** @brief Construct from a lvalue tuple of subclasses of UnivariateDist's or MulitvariateDist's */
+    explicit StaticCompositeDist(const std::tuple<Ts...> &dist_tuple)
+        : dists{CompositeDist::make_component_dist_tuple(dist_tuple)}
+    { }
+
+    /** @brief Construct from a rvalue tuple of subclasses of UnivariateDist's or MulitvariateDist's */
+    explicit StaticCompositeDist(std::tuple<Ts...> &&dist_tuple)
+        : dists{CompositeDist::make_component_dist_tuple(std::move(dist_tuple))}
+    { }
+
+    const DistTupleT& get_dist_tuple() const { return dists; }
+
+    bool operator==(const StaticCompositeDist &o) const { return is_equal(o,IndexT{}); }
+    bool operator!=(const StaticCompositeDist &o) const { return !is_equal(o,IndexT{}); }
+
+    /* Bounds */
+    NdimVecT lbound() const
+    {
+        NdimVecT lb;
+        append_lbound(lb.begin(),IndexT{});
+        return lb;
+    }
+
+    NdimVecT ubound() const
+    {
+        NdimVecT ub;
+        append_ubound(ub.begin(),IndexT{});
+        return ub;
+    }
+
+    NdimVecT global_lbound() const
+    {
+        NdimVecT lb;
+        append_global_lbound(lb.begin(),IndexT{});
+        return lb;
+    }
+
+    NdimVecT global_ubound() const
+    {
+        NdimVecT ub;
+        append_global_ubound(ub.begin(),IndexT{});
+        return ub;
+    }
+
+    bool in_bounds(const VecT &u) const { return arma::all(lbound()<=u) && arma::all(u<=ubound()); }
+    bool in_bounds_all(const MatT &u) const
+    {
+        return arma::all(arma::min(u,1)>=lbound()) &&arma::all(arma::max(u,1)<=ubound());
+    }
+
+    void set_lbound(const VecT &new_bound) { check_dim(new_bound); set_lbound(new_bound.begin(), IndexT{}); }
+    void set_ubound(const VecT &new_bound) { check_dim(new_bound); set_ubound(new_bound.begin(), IndexT{}); }
+    void set_bounds(const VecT &new_lbound,const VecT &new_ubound)
+    {
+        check_dim(new_lbound);
+        check_dim(new_ubound);
+        set_bounds(new_lbound.begin(), new_ubound.begin(), IndexT{});
+    }
+
+    /* Distribution Parameters */
+    NparamsVecT params() const
+    {
+        NparamsVecT p;
+        append_params(p.begin(),IndexT{});
+        return p;
+    }
+
+    void set_params(const VecT &new_params)
+    {
+        if(new_params.n_elem != _num_params) {
+            std::ostringstream msg;
+            msg<<"Expected: "<<_num_params<<" params. Got: "<<new_params.n_elem;
+            throw ParameterSizeError(msg.str());
+        }
+        set_params(new_params.begin(),IndexT{});
+    }
+
+    bool check_params(const VecT &new_params) const
+    { return new_params.n_elem == _num_params && check_params(new_params.begin(), IndexT{}); }
+
+    NparamsVecT params_lbound() const
+    {
+        NparamsVecT lb;
+        append_params_lbound(lb.begin(),IndexT{});
+        return lb;
+    }
+
+    NparamsVecT params_ubound() const
+    {
+        NparamsVecT ub;
+        append_params_ubound(ub.begin(),IndexT{});
+        return ub;
+    }
+
+    std::vector<VecT> params_components() const { return params_components(IndexT{}); }
+
+    StringVecT param_names() const
+    {
+        StringVecT names(_num_params);
+        append_param_names(names.begin(),IndexT{});
+        return names;
+    }
+
+    //Functions mapped over underlying distributions
+    double cdf(const VecT &u) const { return cdf(u.begin(),IndexT{}); }
+    double pdf(const VecT &u) const { return pdf(u.begin(),IndexT{}); }
+    double llh(const VecT &u) const { return llh(u.begin(),IndexT{}); }
+    double rllh(const VecT &u) const { return rllh(u.begin(),IndexT{}); }
+
+    NdimVecT grad(const VecT &u) const
+    {
+        NdimVecT g(arma::fill::zeros);
+        grad_accumulate(u,g,IndexT{});
+        return g;
+    }
+
+    NdimVecT grad2(const VecT &u) const
+    {
+        NdimVecT g2(arma::fill::zeros);
+        grad2_accumulate(u,g2,IndexT{});
+        return g2;
+    }
+
+    /* Returns hessian as an upper triangular matrix */
+    NdimMatT hess(const VecT &u) const
+    {
+        NdimMatT h(arma::fill::zeros);
+        hess_accumulate(u,h,IndexT{});
+        return h;
+    }
+
+    void grad_accumulate(const VecT &theta, VecT &grad) const { grad_accumulate(theta,grad,IndexT{}); }
+    void grad2_accumulate(const VecT &theta, VecT &grad2) const { grad2_accumulate(theta,grad2,IndexT{}); }
+    void hess_accumulate(const VecT &theta, MatT &hess) const { hess_accumulate(theta,hess,IndexT{}); }
+    void grad_grad2_accumulate(const VecT &theta, VecT &grad, VecT &grad2) const { grad_grad2_accumulate(theta,grad,grad2,IndexT{}); }
+    /* Returns hessian as an upper triangular matrix */
+    void grad_hess_accumulate(const VecT &theta, VecT &grad, MatT &hess) const { grad_hess_accumulate(theta,grad,hess,IndexT{}); }
+    /* Fused rllh, grad, and upper triangular hess */
+    void rllh_grad_hess_accumulate(const VecT &theta, double &rllh, VecT &grad, MatT &hess) const 
+    { rllh_grad_hess_accumulate(theta,rllh,grad,hess,IndexT{}); }
+    /* Workspace methods write into caller-owned buffers, as for CompositeDist */
+    void grad(const VecT &theta, VecT &grad) const
+    {
+        grad.zeros(_num_dim);
+        grad_accumulate(theta,grad,IndexT{});
+    }
+
+    void grad2(const VecT &theta, VecT &grad2) const
+    {
+        grad2.zeros(_num_dim);
+        grad2_accumulate(theta,grad2,IndexT{});
+    }
+
+    /* Computes hessian as an upper triangular matrix */
+    void hess(const VecT &theta, MatT &hess) const
+    {
+        hess.zeros(_num_dim,_num_dim);
+        hess_accumulate(theta,hess,IndexT{});
+    }
+
+    void grad_grad2(const VecT &theta, VecT &grad, VecT &grad2) const
+    {
+        grad.zeros(_num_dim);
+        grad2.zeros(_num_dim);
+        grad_grad2_accumulate(theta,grad,grad2,IndexT{});
+    }
+
+    /* Computes hessian as an upper triangular matrix */
+    void grad_hess(const VecT &theta, VecT &grad, MatT &hess) const
+    {
+        grad.zeros(_num_dim);
+        hess.zeros(_num_dim,_num_dim);
+        grad_hess_accumulate(theta,grad,hess,IndexT{});
+    }
+
+    static NdimVecT make_zero_grad() { return NdimVecT(arma::fill::zeros); }
+    static NdimMatT make_zero_hess() { return NdimMatT(arma::fill::zeros); }
+
+    /* Block-diagonal hessian, with one dense upper-triangular block per component */
+    BlockHessian block_hess(const VecT &theta) const
+    {
+        BlockHessian h = make_zero_block_hess();
+        hess_accumulate(theta,h,IndexT{});
+        return h;
+    }
+    void hess_accumulate(const VecT &theta, BlockHessian &hess) const
+    {
+        check_block_hess(hess);
+        hess_accumulate(theta,hess,IndexT{});
+    }
+    void grad_hess_accumulate(const VecT &theta, VecT &grad, BlockHessian &hess) const
+    {
+        check_block_hess(hess);
+        grad_hess_accumulate(theta,grad,hess,IndexT{});
+    }
+    static BlockHessian make_zero_block_hess() { return BlockHessian{num_dim_components()}; }
+
+    /* Hessian-vector products, accumulating the full symmetric hess(theta)*v into out one component at a time */
+    void hessvec_accumulate(const VecT &theta, const VecT &v, VecT &out) const { hessvec_accumulate(theta,v,out,IndexT{}); }
+    NdimVecT hessvec(const VecT &theta, const VecT &v) const
+    {
+        NdimVecT hv(arma::fill::zeros);
+        hessvec_accumulate(theta,v,hv,IndexT{});
+        return hv;
+    }
+
+    /* Derivatives of llh(theta) with respect to the parameters, in params() order.  The parameter hessian is
+     * block-diagonal and only the upper triangle is filled.
+     */
+    void param_grad_accumulate(const VecT &theta, VecT &pgrad) const { param_grad_accumulate(theta,pgrad,IndexT{}); }
+    void param_grad_hess_accumulate(const VecT &theta, VecT &pgrad, MatT &phess) const
+    { param_grad_hess_accumulate(theta,pgrad,phess,IndexT{}); }
+    NparamsVecT param_grad(const VecT &theta) const
+    {
+        NparamsVecT g(arma::fill::zeros);
+        param_grad_accumulate(theta,g,IndexT{});
+        return g;
+    }
+
+    /* Returns parameter hessian as an upper triangular matrix */
+    NparamsMatT param_hess(const VecT &theta) const
+    {
+        NparamsVecT g(arma::fill::zeros);
+        NparamsMatT h(arma::fill::zeros);
+        param_grad_hess_accumulate(theta,g,h,IndexT{});
+        return h;
+    }
+
+    /* Batched evaluation over the columns of a matrix of points theta (size: num_dim X N). */
+    VecT llh(const MatT &theta) const
+    {
+        check_batch(theta);
+        VecT out(theta.n_cols, arma::fill::zeros);
+        llh_accumulate_batch(theta,out,IndexT{});
+        return out;
+    }
+
+    VecT rllh(const MatT &theta) const
+    {
+        check_batch(theta);
+        VecT out(theta.n_cols, arma::fill::zeros);
+        rllh_accumulate_batch(theta,out,IndexT{});
+        return out;
+    }
+
+    MatT grad(const MatT &theta) const
+    {
+        MatT g(_num_dim, theta.n_cols, arma::fill::zeros);
+        grad_accumulate(theta,g);
+        return g;
+    }
+
+    MatT grad2(const MatT &theta) const
+    {
+        MatT g2(_num_dim, theta.n_cols, arma::fill::zeros);
+        grad2_accumulate(theta,g2);
+        return g2;
+    }
+
+    /* Returns a cube of upper triangular hessians, one slice per column of theta */
+    CubeT hess(const MatT &theta) const
+    {
+        CubeT h(_num_dim, _num_dim, theta.n_cols, arma::fill::zeros);
+        hess_accumulate(theta,h);
+        return h;
+    }
+
+    void grad_accumulate(const MatT &theta, MatT &grad) const
+    {
+        check_batch(theta,grad);
+        grad_accumulate_batch(theta,grad,IndexT{});
+    }
+
+    void grad2_accumulate(const MatT &theta, MatT &grad2) const
+    {
+        check_batch(theta,grad2);
+        grad2_accumulate_batch(theta,grad2,IndexT{});
+    }
+
+    void hess_accumulate(const MatT &theta, CubeT &hess) const
+    {
+        check_batch(theta,hess);
+        for(IdxT n=0; n<theta.n_cols; n++) {
+            const VecT t(const_cast<double*>(theta.colptr(n)), _num_dim, false, true);
+            MatT h(hess.slice_memptr(n), _num_dim, _num_dim, false, true);
+            hess_accumulate(t,h,IndexT{});
+        }
+    }
+
+    void grad_grad2_accumulate(const MatT &theta, MatT &grad, MatT &grad2) const
+    {
+        check_batch(theta,grad);
+        check_batch(theta,grad2);
+        grad_grad2_accumulate_batch(theta,grad,grad2,IndexT{});
+    }
+
+    void grad_hess_accumulate(const MatT &theta, MatT &grad, CubeT &hess) const
+    {
+        check_batch(theta,grad);
+        check_batch(theta,hess);
+        for(IdxT n=0; n<theta.n_cols; n++) {
+            const VecT t(const_cast<double*>(theta.colptr(n)), _num_dim, false, true);
+            VecT g(grad.colptr(n), _num_dim, false, true);
+            MatT h(hess.slice_memptr(n), _num_dim, _num_dim, false, true);
+            grad_hess_accumulate(t,g,h,IndexT{});
+        }
+    }
+
+    /* Batched workspace methods.  As with the single point versions the outputs are zeroed and resized only if necessary. */
+    void grad(const MatT &theta, MatT &grad) const
+    {
+        grad.zeros(_num_dim,theta.n_cols);
+        grad_accumulate(theta,grad);
+    }
+
+    void grad2(const MatT &theta, MatT &grad2) const
+    {
+        grad2.zeros(_num_dim,theta.n_cols);
+        grad2_accumulate(theta,grad2);
+    }
+
+    void hess(const MatT &theta, CubeT &hess) const
+    {
+        hess.zeros(_num_dim,_num_dim,theta.n_cols);
+        hess_accumulate(theta,hess);
+    }
+
+    /* Batched parameter derivatives.  Outputs have a column (or slice) of size num_params for each column of theta. */
+    MatT param_grad(const MatT &theta) const
+    {
+        MatT g(_num_params, theta.n_cols, arma::fill::zeros);
+        param_grad_accumulate(theta,g);
+        return g;
+    }
+
+    /* Returns a cube of upper triangular parameter hessians, one slice per column of theta */
+    CubeT param_hess(const MatT &theta) const
+    {
+        MatT g(_num_params, theta.n_cols, arma::fill::zeros);
+        CubeT h(_num_params, _num_params, theta.n_cols, arma::fill::zeros);
+        param_grad_hess_accumulate(theta,g,h);
+        return h;
+    }
+
+    void param_grad_accumulate(const MatT &theta, MatT &pgrad) const
+    {
+        check_param_batch(theta,pgrad);
+        for(IdxT n=0; n<theta.n_cols; n++) {
+            const VecT t(const_cast<double*>(theta.colptr(n)), _num_dim, false, true);
+            VecT g(pgrad.colptr(n), _num_params, false, true);
+            param_grad_accumulate(t,g,IndexT{});
+        }
+    }
+
+    void param_grad_hess_accumulate(const MatT &theta, MatT &pgrad, CubeT &phess) const
+    {
+        check_param_batch(theta,pgrad);
+        check_param_batch(theta,phess);
+        for(IdxT n=0; n<theta.n_cols; n++) {
+            const VecT t(const_cast<double*>(theta.colptr(n)), _num_dim, false, true);
+            VecT g(pgrad.colptr(n), _num_params, false, true);
+            MatT h(phess.slice_memptr(n), _num_params, _num_params, false, true);
+            param_grad_hess_accumulate(t,g,h,IndexT{});
+        }
+    }
+
+    static MatT make_zero_grad(IdxT N) { return {_num_dim,N,arma::fill::zeros}; }
+    static CubeT make_zero_hess(IdxT N) { return {_num_dim,_num_dim,N,arma::fill::zeros}; }
+
+    /* Sampling works directly with any RNG type.  There is no need to wrap in an AnyRng. */
+    template<class RngT>
+    NdimVecT sample(RngT &rng) const
+    {
+        NdimVecT s;
+        auto it = s.begin();
+        sample(rng, it, IndexT{});
+        return s;
+    }
+
+    template<class RngT>
+    MatT sample(RngT &rng, IdxT num_samples) const
+    {
+        MatT s(_num_dim,num_samples);
+        sample_bulk(rng, s, IndexT{});
+        return s;
+    }
+
+    /* Per-component values for debugging and plotting purposes */
+    NcomponentsVecT llh_components(const VecT &u) const
+    {
+        NcomponentsVecT c;
+        append_llh_components(u.begin(), c.begin(), IndexT{});
+        return c;
+    }
+
+    NcomponentsVecT rllh_components(const VecT &u) const
+    {
+        NcomponentsVecT c;
+        append_rllh_components(u.begin(), c.begin(), IndexT{});
+        return c;
+    }
+
+    MatT llh_components(const MatT &theta) const
+    {
+        check_batch(theta);
+        MatT c(_num_dists,theta.n_cols);
+        for(IdxT n=0; n<theta.n_cols; n++) append_llh_components(theta.colptr(n), c.colptr(n), IndexT{});
+        return c;
+    }
+
+    MatT rllh_components(const MatT &theta) const
+    {
+        check_batch(theta);
+        MatT c(_num_dists,theta.n_cols);
+        for(IdxT n=0; n<theta.n_cols; n++) append_rllh_components(theta.colptr(n), c.colptr(n), IndexT{});
+        return c;
+    }
+
+private:
+    /* Data members */
+    DistTupleT dists;
+
+    static void check_dim(const VecT &v)
+    {
+        if(v.n_elem != _num_dim) {
+            std::ostringstream msg;
+            msg<<"Expected: "<<_num_dim<<" elements. Got: "<<v.n_elem;
+            throw ParameterSizeError(msg.str());
+        }
+    }
+
+    static void check_batch(const MatT &theta)
+    {
+        if(theta.n_rows != _num_dim) {
+            std::ostringstream msg;
+            msg<<"Expected theta with: "<<_num_dim<<" rows. Got: "<<theta.n_rows;
+            throw ParameterSizeError(msg.str());
+        }
+    }
+
+    static void check_batch(const MatT &theta, const MatT &out)
+    {
+        check_batch(theta);
+        if(out.n_rows != _num_dim || out.n_cols != theta.n_cols) {
+            std::ostringstream msg;
+            msg<<"Expected output of size: ["<<_num_dim<<","<<theta.n_cols<<"]. Got: ["<<out.n_rows<<","<<out.n_cols<<"]";
+            throw ParameterSizeError(msg.str());
+        }
+    }
+
+    static void check_block_hess(const BlockHessian &hess)
+    {
+        if(hess.num_blocks() != _num_dists || !arma::all(hess.block_sizes() == num_dim_components())) {
+            std::ostringstream msg;
+            msg<<"Expected BlockHessian with block sizes: "<<num_dim_components().t()<<" Got: "<<hess.block_sizes().t();
+            throw ParameterSizeError(msg.str());
+        }
+    }
+
+    static void check_param_batch(const MatT &theta, const MatT &out)
+    {
+        check_batch(theta);
+        if(out.n_rows != _num_params || out.n_cols != theta.n_cols) {
+            std::ostringstream msg;
+            msg<<"Expected output of size: ["<<_num_params<<","<<theta.n_cols<<"]. Got: ["<<out.n_rows<<","<<out.n_cols<<"]";
+            throw ParameterSizeError(msg.str());
+        }
+    }
+
+    static void check_param_batch(const MatT &theta, const CubeT &out)
+    {
+        check_batch(theta);
+        if(out.n_rows != _num_params || out.n_cols != _num_params || out.n_slices != theta.n_cols) {
+            std::ostringstream msg;
+            msg<<"Expected output of size: ["<<_num_params<<","<<_num_params<<","<<theta.n_cols<<"]. Got: ["
+               <<out.n_rows<<","<<out.n_cols<<","<<out.n_slices<<"]";
+            throw ParameterSizeError(msg.str());
+        }
+    }
+
+    static void check_batch(const MatT &theta, const CubeT &out)
+    {
+        check_batch(theta);
+        if(out.n_rows != _num_dim || out.n_cols != _num_dim || out.n_slices != theta.n_cols) {
+            std::ostringstream msg;
+            msg<<"Expected output of size: ["<<_num_dim<<","<<_num_dim<<","<<theta.n_cols<<"]. Got: ["
+               <<out.n_rows<<","<<out.n_cols<<","<<out.n_slices<<"]";
+            throw ParameterSizeError(msg.str());
+        }
+    }
+
+    template<std::size_t... I>
+    bool is_equal(const StaticCompositeDist &o, std::index_sequence<I...>) const
+    { return meta::logical_and_in_order( {std::get<I>(dists) == std::get<I>(o.dists)...}); }
+
+    template<class IterT, std::size_t... I>
+    void append_lbound(IterT p, std::index_sequence<I...>) const
+    { meta::call_in_order( {(std::get<I>(dists).append_lbound(p),0)...} ); }
+
+    template<class IterT, std::size_t... I>
+    void append_ubound(IterT p, std::index_sequence<I...>) const
+    { meta::call_in_order( {(std::get<I>(dists).append_ubound(p),0)...} ); }
+
+    template<class IterT, std::size_t... I>
+    void append_global_lbound(IterT p, std::index_sequence<I...>) const
+    { meta::call_in_order( {(std::get<I>(dists).append_global_lbound(p),0)...} ); }
+
+    template<class IterT, std::size_t... I>
+    void append_global_ubound(IterT p, std::index_sequence<I...>) const
+    { meta::call_in_order( {(std::get<I>(dists).append_global_ubound(p),0)...} ); }
+
+    template<class IterT, std::size_t... I>
+    void set_lbound(IterT b, std::index_sequence<I...>)
+    { meta::call_in_order( {(std::get<I>(dists).set_lbound_from_iter(b),0)...} ); }
+
+    template<class IterT, std::size_t... I>
+    void set_ubound(IterT b, std::index_sequence<I...>)
+    { meta::call_in_order( {(std::get<I>(dists).set_ubound_from_iter(b),0)...} ); }
+
+    template<class IterT, std::size_t... I>
+    void set_bounds(IterT lb, IterT ub, std::index_sequence<I...>)
+    { meta::call_in_order( {(std::get<I>(dists).set_bounds_from_iter(lb,ub),0)...} ); }
+
+    template<class IterT, std::size_t... I>
+    void append_params(IterT p, std::index_sequence<I...>) const
+    { meta::call_in_order( {(std::get<I>(dists).append_params(p),0)...} ); }
+
+    template<class IterT, std::size_t... I>
+    void set_params(IterT p,std::index_sequence<I...>)
+    { meta::call_in_order( {(std::get<I>(dists).set_params_iter(p),0)...} ); }
+
+    template<class IterT, std::size_t... I>
+    bool check_params(IterT p,std::index_sequence<I...>) const
+    { return meta::logical_and_in_order( {std::get<I>(dists).check_params_iter(p)...} ); }
+
+    template<class IterT, std::size_t... I>
+    void append_params_lbound(IterT p, std::index_sequence<I...>) const
+    { meta::call_in_order( {(std::get<I>(dists).append_params_lbound(p),0)...} ); }
+
+    template<class IterT, std::size_t... I>
+    void append_params_ubound(IterT p, std::index_sequence<I...>) const
+    { meta::call_in_order( {(std::get<I>(dists).append_params_ubound(p),0)...} ); }
+
+    template<std::size_t... I>
+    std::vector<VecT> params_components(std::index_sequence<I...>) const
+    { return {std::get<I>(dists).params()...}; }
+
+    template<class IterT, std::size_t... I>
+    void append_param_names(IterT p, std::index_sequence<I...>) const
+    { meta::call_in_order( {(append_component_param_names(p,I,std::get<I>(dists)),0)...} ); }
+
+    /* Prefixes names with the CompositeDist default component name, "D<n>_", so param_names() match */
+    template<class IterT, class Dist>
+    static void append_component_param_names(IterT &p, IdxT n, const Dist &dist)
+    {
+        auto name = p;
+        dist.append_param_names(p);
+        std::string prefix = "D"+std::to_string(n+1)+"_";
+        for(; name!=p; ++name) name->insert(0,prefix);
+    }
+
+    template<class IterT, std::size_t... I>
+    double cdf(IterT u,std::index_sequence<I...>) const
+    { return meta::prod_in_order<double>( {std::get<I>(dists).cdf_from_iter(u)...} ); }
+
+    template<class IterT, std::size_t... I>
+    double pdf(IterT u,std::index_sequence<I...>) const
+    { return meta::prod_in_order<double>( {std::get<I>(dists).pdf_from_iter(u)...} ); }
+
+    template<class IterT, std::size_t... I>
+    double llh(IterT u,std::index_sequence<I...>) const
+    { return meta::sum_in_order<double>( {std::get<I>(dists).llh_from_iter(u)...} ); }
+
+    template<class IterT, std::size_t... I>
+    double rllh(IterT u,std::index_sequence<I...>) const
+    { return meta::sum_in_order<double>( {std::get<I>(dists).rllh_from_iter(u)...} ); }
+
+    template<std::size_t... I>
+    void grad_accumulate(const VecT &u, VecT &g,std::index_sequence<I...>) const
+    {
+        IdxT k=0;
+        meta::call_in_order( {(std::get<I>(dists).grad_accumulate_idx(u,g,k),0)...} );
+    }
+
+    template<std::size_t... I>
+    void grad2_accumulate(const VecT &u, VecT &g2,std::index_sequence<I...>) const
+    {
+        IdxT k=0;
+        meta::call_in_order( {(std::get<I>(dists).grad2_accumulate_idx(u,g2,k),0)...} );
+    }
+
+    template<std::size_t... I>
+    void hess_accumulate(const VecT &u, MatT &m, std::index_sequence<I...>) const
+    {
+        IdxT k=0;
+        meta::call_in_order( {(std::get<I>(dists).hess_accumulate_idx(u,m,k),0)...} );
+    }
+
+    template<std::size_t... I>
+    void grad_grad2_accumulate(const VecT &u, VecT &g, VecT &g2, std::index_sequence<I...>) const
+    {
+        IdxT k=0;
+        meta::call_in_order( {(std::get<I>(dists).grad_grad2_accumulate_idx(u,g,g2,k),0)...} );
+    }
+
+    template<std::size_t... I>
+    void grad_hess_accumulate(const VecT &u, VecT &g, MatT &h,std::index_sequence<I...>) const
+    {
+        IdxT k=0;
+        meta::call_in_order( {(std::get<I>(dists).grad_hess_accumulate_idx(u,g,h,k),0)...} );
+    }
+
+    template<std::size_t... I> 
+    void rllh_grad_hess_accumulate(const VecT &u, double &rllh, VecT &g, MatT &h,std::index_sequence<I...>) const
+    {
+        IdxT k=0;
+        meta::call_in_order( {(std::get<I>(dists).rllh_grad_hess_accumulate_idx(u,rllh,g,h,k),0)...} );
+    }
+
+    template<std::size_t... I> 
+    void hess_accumulate(const VecT &u, BlockHessian &h, std::index_sequence<I...>) const 
+    {
+        IdxT k=0;
+        meta::call_in_order( {(std::get<I>(dists).hess_accumulate_block(u,h.block(I),k),0)...} );
+    }
+
+    template<std::size_t... I> 
+    void grad_hess_accumulate(const VecT &u, VecT &g, BlockHessian &h,std::index_sequence<I...>) const
+    {
+        IdxT k=0;
+        meta::call_in_order( {(std::get<I>(dists).grad_hess_accumulate_block(u,g,h.block(I),k),0)...} );
+    }
+
+    template<std::size_t... I> 
+    void hessvec_accumulate(const VecT &u, const VecT &v, VecT &out, std::index_sequence<I...>) const
+    {
+        IdxT k=0;
+        meta::call_in_order( {(std::get<I>(dists).hessvec_accumulate_idx(u,v,out,k),0)...} );
+    }
+
+    /* Parameter derivatives track both the dimension index k and the parameter index p */
+    template<std::size_t... I> 
+    void param_grad_accumulate(const VecT &u, VecT &g, std::index_sequence<I...>) const
+    {
+        IdxT k=0;
+        IdxT p=0;
+        meta::call_in_order( {(std::get<I>(dists).param_grad_accumulate_idx(u,g,k,p),0)...} );
+    }
+
+    template<std::size_t... I> 
+    void param_grad_hess_accumulate(const VecT &u, VecT &g, MatT &h, std::index_sequence<I...>) const
+    {
+        IdxT k=0;
+        IdxT p=0;
+        meta::call_in_order( {(std::get<I>(dists).param_grad_hess_accumulate_idx(u,g,h,k,p),0)...} );
+    }
+
+    /* Batched evaluation one component at a time, so univariate components can use their array methods */
+    template<std::size_t... I>
+    void llh_accumulate_batch(const MatT &u, VecT &out, std::index_sequence<I...>) const
+    {
+        IdxT k=0;
+        meta::call_in_order( {(std::get<I>(dists).llh_accumulate_batch(u,out,0,u.n_cols,k),0)...} );
+    }
+
+    template<std::size_t... I>
+    void rllh_accumulate_batch(const MatT &u, VecT &out, std::index_sequence<I...>) const
+    {
+        IdxT k=0;
+        meta::call_in_order( {(std::get<I>(dists).rllh_accumulate_batch(u,out,0,u.n_cols,k),0)...} );
+    }
+
+    template<std::size_t... I>
+    void grad_accumulate_batch(const MatT &u, MatT &g, std::index_sequence<I...>) const
+    {
+        IdxT k=0;
+        meta::call_in_order( {(std::get<I>(dists).grad_accumulate_batch(u,g,0,u.n_cols,k),0)...} );
+    }
+
+    template<std::size_t... I>
+    void grad2_accumulate_batch(const MatT &u, MatT &g2, std::index_sequence<I...>) const
+    {
+        IdxT k=0;
+        meta::call_in_order( {(std::get<I>(dists).grad2_accumulate_batch(u,g2,0,u.n_cols,k),0)...} );
+    }
+
+    template<std::size_t... I>
+    void grad_grad2_accumulate_batch(const MatT &u, MatT &g, MatT &g2, std::index_sequence<I...>) const
+    {
+        IdxT k=0;
+        meta::call_in_order( {(std::get<I>(dists).grad_grad2_accumulate_batch(u,g,g2,0,u.n_cols,k),0)...} );
+    }
+
+    template<class RngT, class IterT, std::size_t... I>
+    void sample(RngT &rng, IterT &s, std::index_sequence<I...>) const
+    { meta::call_in_order( {(std::get<I>(dists).append_sample(rng,s),0)...} ); }
+
+    template<class RngT, std::size_t... I>
+    void sample_bulk(RngT &rng, MatT &s, std::index_sequence<I...>) const
+    { 
+        IdxT k=0;
+        meta::call_in_order( {(std::get<I>(dists).append_samples(rng,s,k),0)...} ); 
+    }
+
+    template<class IterT, class OutIterT, std::size_t... I>
+    void append_llh_components(IterT theta, OutIterT out, std::index_sequence<I...>) const
+    { meta::call_in_order( {(*out++ = std::get<I>(dists).llh_from_iter(theta),0)...} ); }
+
+    template<class IterT, class OutIterT, std::size_t... I>
+    void append_rllh_components(IterT theta, OutIterT out, std::index_sequence<I...>) const
+    { meta::call_in_order( {(*out++ = std::get<I>(dists).rllh_from_iter(theta),0)...} ); }
+};
+
+template<class... Ts>
+constexpr IdxT StaticCompositeDist<Ts...>::_num_dists;
+template<class... Ts>
+constexpr IdxT StaticCompositeDist<Ts...>::_num_dim;
+template<class... Ts>
+constexpr IdxT StaticCompositeDist<Ts...>::_num_params;
+
+/** @brief Make a StaticCompositeDist with component types deduced from the arguments */
+template<class... Ts>
+StaticCompositeDist<std::decay_t<Ts>...> make_static_composite_dist(Ts&&... dists)
+{ return StaticCompositeDist<std::decay_t<Ts>...>(std::forward<Ts>(dists)...); }
+
+/* CompositeDist wrapping of a StaticCompositeDist.  Declared in CompositeDist.h */
+template<class... Ts>
+CompositeDist::CompositeDist(const StaticCompositeDist<Ts...> &static_dist)
+    : handle{ std::make_unique<DistTuple<ComponentDistT<Ts>...>>(static_dist.get_dist_tuple()) }
+{ initialize_from_handle(); }
+
+template<class... Ts>
+void CompositeDist::initialize(const StaticCompositeDist<Ts...> &static_dist)
+{
+    handle = std::make_unique<DistTuple<ComponentDistT<Ts>...>>(static_dist.get_dist_tuple());
+    initialize_from_handle();
+}
+
+} /* namespace prior_hessian */
+#endif /* PRIOR_HESSIAN_STATICCOMPOSITEDIST_H */
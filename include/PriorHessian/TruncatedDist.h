@@ -7,7 +7,10 @@
 #ifndef PRIOR_HESSIAN_TRUNCATEDDIST_H
 #define PRIOR_HESSIAN_TRUNCATEDDIST_H
 
+#include <algorithm>
 #include <cmath>
+#include <random>
+#include <utility>
 
 #include "PriorHessian/Meta.h"
 #include "PriorHessian/PriorHessianError.h"
@@ -22,8 +25,9 @@ template<class Dist>
 class TruncatedDist : public Dist
 {
 public:
+    using NparamsVecT = typename Dist::NparamsVecT;
+    using NparamsMatT = typename Dist::NparamsMatT;
     static constexpr IdxT num_params() { return Dist::num_params(); } 
-    static constexpr const double min_bounds_pdf_integral = 1.0e-8; /** minimum allowable delta in cdf for a valid truncation*/
     static double global_lbound() { return Dist::lbound(); }
     static double global_ubound() { return Dist::ubound(); }
     
@@ -59,12 +63,37 @@ public:
     void set_lbound(double lbound);    
     void set_ubound(double ubound);    
 
+    /* The truncated probability mass depends on the parameters, so setting parameters recomputes the truncation constants */
+    template<class... Args>
+    void set_params(Args&&... args);
+    void set_param(int idx, double val);
+    template<class IterT>
+    void set_params_iter(IterT &params);
+
     double mean() const { throw NotImplementedError("Mean is not implemented for truncated distributions. No general-purpose efficient algorithm."); }
-    double median() const {return Dist::icdf(lbound_cdf+bounds_pdf_integral*.5); }
+    double median() const { return icdf(.5); }
     double cdf(double x) const;
     double pdf(double x) const;
     double icdf(double u) const;
+    double sf(double x) const { return exp(logsf(x)); }
+    double isf(double u) const { return icdf(1-u); }
+    double logcdf(double x) const { return log_cdf_diff(lbound(),x); }
+    double logsf(double x) const { return log_cdf_diff(x,ubound()); }
+    double log_cdf_diff(double a, double b) const;
     double llh(double x) const;
+    /* Array form of llh, if Dist has one.  Used by CompositeDist for batched evaluation. */
+    template<class D=Dist>
+    auto llh(IdxT N, const double *x, double *out) const -> decltype(std::declval<const D&>().llh(N,x,out))
+    {
+        D::llh(N,x,out);
+        for(IdxT i=0; i<N; i++) out[i] += llh_truncation_const;
+    }
+
+    NparamsVecT param_grad(double x) const;
+    NparamsMatT param_hess(double x) const;
+    void param_grad_hess_accumulate(double x, NparamsVecT &g, NparamsMatT &h) const;
+    /* Gradient and hessian of cdf(x) with respect to the parameters.  Used for CopulaDist parameter derivatives. */
+    void cdf_param_grad_hess(double x, NparamsVecT &grad, NparamsMatT &hess) const;
 
     template<class RngT>
     double sample(RngT &rng) const;
@@ -73,9 +102,23 @@ protected:
     double _truncated_ubound;
     bool _truncated = false;
 
-    double lbound_cdf; // cdf(_lbound)
-    double bounds_pdf_integral; // (cdf(_ubound) - cdf(_lbound))
-    double llh_truncation_const;// -log(bounds_pdf_integral)   
+    bool upper_tail = false; // Bounds are above the median, so icdf inverts the survival function
+    double log_lbound_tail; // logsf(_lbound) if upper_tail else logcdf(_lbound)
+    double log_ubound_tail; // logsf(_ubound) if upper_tail else logcdf(_ubound)
+    double llh_truncation_const;// -log(cdf(_ubound) - cdf(_lbound)), computed in log space by Dist::log_cdf_diff
+
+    //Lazy computation of the derivatives of llh_truncation_const with respect to the parameters.
+    mutable NparamsVecT truncation_param_grad;
+    mutable NparamsMatT truncation_param_hess;
+    mutable bool truncation_param_derivs_initialized = false;
+    void initialize_truncation_param_derivs() const;
+
+    /* Use Dist::sample_truncated if Dist provides a dedicated truncated sampler, e.g., NormalDist */
+    template<class RngT, class D=Dist>
+    auto sample_truncated(RngT &rng, int) const -> decltype(std::declval<const D&>().sample_truncated(0.,0.,rng))
+    { return D::sample_truncated(lbound(),ubound(),rng); }
+    template<class RngT>
+    double sample_truncated(RngT &rng, long) const;
 };
 
 template<class Dist>
@@ -98,25 +141,33 @@ void TruncatedDist<Dist>::set_bounds(double lbound, double ubound)
     }
     bool truncated = (lbound>global_lbound() || ubound<global_ubound());
     if(truncated) {
-        lbound_cdf = (lbound==global_lbound()) ? 0 : Dist::cdf(lbound);
-        double ubound_cdf = (ubound==global_ubound()) ? 1 : Dist::cdf(ubound);
-        bounds_pdf_integral = ubound_cdf - lbound_cdf;
-        if(bounds_pdf_integral<min_bounds_pdf_integral) {            
+        double log_bounds_pdf_integral = Dist::log_cdf_diff(lbound, ubound);
+        if(!(log_bounds_pdf_integral > -INFINITY)) {
             std::ostringstream msg;
-            msg<<"TruncatedDist::set_bounds: bounds:["<<lbound<<","<<ubound<<"] with cdf:["<<lbound_cdf<<","<<ubound_cdf
-               <<"] have delta: "<<bounds_pdf_integral<<" < min_delta = "<<min_bounds_pdf_integral
-               <<".  Bounds cover too small a portion of the domain for accuarate truncation.";
+            msg<<"TruncatedDist::set_bounds: bounds:["<<lbound<<","<<ubound<<"] have log pdf integral: "
+               <<log_bounds_pdf_integral<<".  Bounds have no probability mass.";
             throw ParameterValueError(msg.str());
         }
-        llh_truncation_const = -log(bounds_pdf_integral);
+        llh_truncation_const = -log_bounds_pdf_integral;
+        double log_lbound_cdf = (lbound==global_lbound()) ? -INFINITY : Dist::logcdf(lbound);
+        upper_tail = log_lbound_cdf > -constants::ln2;
+        if(upper_tail) {
+            log_lbound_tail = Dist::logsf(lbound);
+            log_ubound_tail = (ubound==global_ubound()) ? -INFINITY : Dist::logsf(ubound);
+        } else {
+            log_lbound_tail = log_lbound_cdf;
+            log_ubound_tail = (ubound==global_ubound()) ? 0 : Dist::logcdf(ubound);
+        }
     } else {
-        lbound_cdf = 0;
-        bounds_pdf_integral = 1;
+        upper_tail = false;
+        log_lbound_tail = -INFINITY;
+        log_ubound_tail = 0;
         llh_truncation_const = 0;
     }
     _truncated = truncated;
     _truncated_lbound = lbound;
     _truncated_ubound = ubound;
+    truncation_param_derivs_initialized = false;
 }
 
 template<class Dist>
@@ -131,42 +182,142 @@ void TruncatedDist<Dist>::set_ubound(double new_ubound)
     set_bounds(lbound(), new_ubound);
 }
 
+template<class Dist>
+template<class... Args>
+void TruncatedDist<Dist>::set_params(Args&&... args)
+{
+    Dist::set_params(std::forward<Args>(args)...);
+    set_bounds(lbound(), ubound());
+}
+
+template<class Dist>
+void TruncatedDist<Dist>::set_param(int idx, double val)
+{
+    Dist::set_param(idx,val);
+    set_bounds(lbound(), ubound());
+}
+
+template<class Dist>
+template<class IterT>
+void TruncatedDist<Dist>::set_params_iter(IterT &params)
+{
+    Dist::set_params_iter(params);
+    set_bounds(lbound(), ubound());
+}
+
 template<class Dist>
 double TruncatedDist<Dist>::cdf(double x) const
 {
-    return (this->Dist::cdf(x) - lbound_cdf) / bounds_pdf_integral;
+    if(!truncated()) return this->Dist::cdf(x);
+    if(x <= lbound()) return 0;
+    if(x >= ubound()) return 1;
+    return exp(this->Dist::log_cdf_diff(lbound(),x) + llh_truncation_const);
 }
 
 template<class Dist>
 double TruncatedDist<Dist>::icdf(double u) const
 {
-    return this->Dist::icdf(lbound_cdf + u*bounds_pdf_integral);
+    if(!truncated()) return this->Dist::icdf(u);
+    //Invert in the tail the bounds are in, where the probabilities have full relative precision.  The tail probability
+    //of the quantile is (1-u)*tail(lbound) + u*tail(ubound), formed in log space so it does not underflow.
+    double log_tail = log_sum_exp(log1p(-u) + log_lbound_tail, log(u) + log_ubound_tail);
+    const Dist &dist = *this;
+    double x = upper_tail ? this->inverse_logsf(dist, log_tail) : this->inverse_logcdf(dist, log_tail);
+    return std::min(std::max(x,lbound()),ubound());
+}
+
+template<class Dist>
+double TruncatedDist<Dist>::log_cdf_diff(double a, double b) const
+{
+    return this->Dist::log_cdf_diff(std::max(a,lbound()), std::min(b,ubound())) + llh_truncation_const;
 }
 
 template<class Dist>
 double TruncatedDist<Dist>::pdf(double x) const
 {
-    return this->Dist::pdf(x) / bounds_pdf_integral;
+    return exp(this->Dist::llh(x) + llh_truncation_const);
 }
 
 template<class Dist>
 double TruncatedDist<Dist>::llh(double x) const
 {
-    if(!std::isfinite(x))        throw ParameterValueError("GOO1");
-    if(!std::isfinite(llh_truncation_const))        throw ParameterValueError("GOO2");
-    if(!std::isfinite(this->Dist::llh(x))){
-        std::cout<<"x: "<<x<<" llh: "<<this->Dist::llh(x)<<" params:"<<this->params().t()<<std::endl;
-//         throw ParameterValueError("GOO3");
-    }
     return this->Dist::llh(x) + llh_truncation_const;
 }
 
+template<class Dist>
+typename TruncatedDist<Dist>::NparamsVecT
+TruncatedDist<Dist>::param_grad(double x) const
+{
+    if(!truncated()) return Dist::param_grad(x);
+    if(!truncation_param_derivs_initialized) initialize_truncation_param_derivs();
+    return Dist::param_grad(x) + truncation_param_grad;
+}
+
+template<class Dist>
+typename TruncatedDist<Dist>::NparamsMatT
+TruncatedDist<Dist>::param_hess(double x) const
+{
+    if(!truncated()) return Dist::param_hess(x);
+    if(!truncation_param_derivs_initialized) initialize_truncation_param_derivs();
+    return Dist::param_hess(x) + truncation_param_hess;
+}
+
+template<class Dist>
+void TruncatedDist<Dist>::param_grad_hess_accumulate(double x, NparamsVecT &g, NparamsMatT &h) const
+{
+    Dist::param_grad_hess_accumulate(x,g,h);
+    if(!truncated()) return;
+    if(!truncation_param_derivs_initialized) initialize_truncation_param_derivs();
+    g += truncation_param_grad;
+    h += truncation_param_hess;
+}
+
+/* With log(cdf(x)) = log_cdf_diff(lbound,x) + llh_truncation_const for x in the bounds, and lg, lh its parameter
+ * gradient and hessian, the cdf derivatives are cdf(x)*lg and cdf(x)*(lh + lg*lg^T).
+ */
+template<class Dist>
+void TruncatedDist<Dist>::cdf_param_grad_hess(double x, NparamsVecT &grad, NparamsMatT &hess) const
+{
+    if(!(lbound() < x && x < ubound())) { //cdf is 0 or 1 for any parameter values
+        grad.zeros();
+        hess.zeros();
+        return;
+    }
+    this->log_cdf_difference_param_grad_hess(static_cast<const Dist&>(*this), lbound(), x, grad, hess);
+    if(truncated()) {
+        if(!truncation_param_derivs_initialized) initialize_truncation_param_derivs();
+        grad += truncation_param_grad;
+        hess += truncation_param_hess;
+    }
+    double u = cdf(x);
+    hess = u*(hess + grad*grad.t());
+    grad *= u;
+}
+
+template<class Dist>
+void TruncatedDist<Dist>::initialize_truncation_param_derivs() const
+{
+    this->log_cdf_difference_param_grad_hess(static_cast<const Dist&>(*this), lbound(), ubound(), 
+                                             truncation_param_grad, truncation_param_hess);
+    //llh_truncation_const = -log(cdf(ubound) - cdf(lbound))
+    truncation_param_grad = -truncation_param_grad;
+    truncation_param_hess = -truncation_param_hess;
+    truncation_param_derivs_initialized = true;
+}
+
 template<class Dist>
 template<class RngT>
 double TruncatedDist<Dist>::sample(RngT &rng) const
 {
     if(!truncated()) return Dist::sample(rng);
-    //If truncated, the iCDF method is the most generally applicable and efficient.
+    return sample_truncated(rng,0);
+}
+
+template<class Dist>
+template<class RngT>
+double TruncatedDist<Dist>::sample_truncated(RngT &rng, long) const
+{
+    //The iCDF method is the most generally applicable.
     //One nice property is we only need to draw a single RNG vs a rejection strategy
     std::uniform_real_distribution<double> uniform;
     return icdf(uniform(rng));
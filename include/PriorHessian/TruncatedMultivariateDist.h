@@ -8,61 +8,136 @@
 #define PRIOR_HESSIAN_TRUNCATEDMULTIVARIATEDIST_H
 
 #include <cmath>
-#include <bitset>
-#include <mutex>
+#include <cstdint>
+#include <atomic>
+#include <unordered_map>
+#include <utility>
 
 #include "PriorHessian/Meta.h"
 #include "PriorHessian/PriorHessianError.h"
 #include "PriorHessian/BoundsAdaptedDist.h"
+#include "PriorHessian/NormalDist.h"
 
 namespace prior_hessian {
 
 namespace mcmc {
-    template<int Ndim>
-   class MCMCData {
+    /** Identifies the target distribution of a chain.
+     * Every instance, copy, and change of bounds or sampling method gets a new key, so chains started for a
+     * different target are never continued.
+     */
+    class ChainKey {
     public:
-        using NdimVecT = arma::Col<double>::fixed<Ndim>;
-        MCMCData() : nsample(0) {}
-        MCMCData(const MCMCData<Ndim> &o) : 
-            mutex()
+        ChainKey() : key(next()) {}
+        ChainKey(const ChainKey &) : key(next()) {}
+        ChainKey& operator=(const ChainKey &) { key = next(); return *this; }
+        void reset() { key = next(); }
+        uint64_t get() const { return key; }
+    private:
+        uint64_t key;
+        static uint64_t next()
         {
-            std::lock(mutex,o.mutex);
-            std::lock_guard<std::mutex> lock(mutex, std::adopt_lock);
-            std::lock_guard<std::mutex> o_lock(o.mutex, std::adopt_lock);
-            sample = o.sample; 
-            rllh = o.rllh;
-            nsample = o.nsample;
+            static std::atomic<uint64_t> counter{1};
+            return counter.fetch_add(1,std::memory_order_relaxed);
         }
-        
-        MCMCData<Ndim>& operator=(const MCMCData<Ndim> &o)
-        {
-            std::lock(mutex,o.mutex);
-            std::lock_guard<std::mutex> lock(mutex, std::adopt_lock);
-            std::lock_guard<std::mutex> o_lock(o.mutex, std::adopt_lock);
-            sample = o.sample; 
-            rllh = o.rllh;
-            nsample = o.nsample;
-            return *this;
-        }
-        
+    };
+
+    /** State of a single MCMC chain.
+     * A chain is owned by a single thread or caller, so no locking is required.  A default constructed chain,
+     * or one last used with a different target, restarts with a new burn-in.
+     */
+    template<int Ndim>
+    class ChainState {
+    public:
+        using NdimVecT = arma::Col<double>::fixed<Ndim>;
         NdimVecT sample;
         double rllh;
-        int nsample=0;
-        mutable std::mutex mutex;
+        int nsample = 0;
+        uint64_t key = 0;
+
+        /* Restart the chain if it was last used with a different target */
+        void attach(const ChainKey &target)
+        {
+            if(key == target.get()) return;
+            key = target.get();
+            nsample = 0;
+        }
     };
+
+    /** Per-thread chain state for a target.
+     * Each thread keeps its own chain for each distribution it samples from, so threads never contend.  Chains
+     * for stale keys are dropped once the per-thread cache fills.
+     */
+    template<int Ndim>
+    ChainState<Ndim>& thread_chain(const ChainKey &target)
+    {
+        static const size_t max_cached_chains = 64;
+        thread_local std::unordered_map<uint64_t,ChainState<Ndim>> chains;
+        auto it = chains.find(target.get());
+        if(it != chains.end()) return it->second;
+        if(chains.size() >= max_cached_chains) chains.clear();
+        return chains[target.get()];
+    }
+
+    /** Diagnostics of a bulk sampling run.
+     * acceptance_rate - Fraction of proposals accepted.  For rejection sampling this is the fraction of draws in
+     *                   bounds, and for Gibbs sampling it is 1.
+     * ess - Effective sample size of each coordinate.  Equal to the number of samples for independent draws.
+     */
+    struct SamplingStats {
+        double acceptance_rate = 1;
+        VecT ess;
+    };
+
+    /** Effective sample size of each row of samples, with columns as the chain steps.
+     * Uses Geyer's (1992) initial monotone sequence estimate of the integrated autocorrelation time.
+     */
+    inline VecT effective_sample_size(const MatT &samples)
+    {
+        IdxT N = samples.n_cols;
+        VecT ess(samples.n_rows);
+        for(IdxT i=0; i<samples.n_rows; i++) {
+            VecT x = samples.row(i).t();
+            x -= arma::mean(x);
+            double c0 = arma::dot(x,x);
+            if(N<4 || !(c0>0)) { ess(i) = N; continue; }
+            auto rho = [&](IdxT k) { return arma::dot(x.head(N-k),x.tail(N-k))/c0; };
+            double tau = -1; //tau = -1 + 2*sum_m (rho(2m) + rho(2m+1))
+            double pair_min = INFINITY;
+            for(IdxT m=0; 2*m+1<N; m++) {
+                double pair = (m==0 ? 1 : rho(2*m)) + rho(2*m+1);
+                if(pair <= 0) break;
+                pair_min = std::min(pair_min,pair); //Enforce a monotone sequence
+                tau += 2*pair_min;
+            }
+            ess(i) = std::min(N/tau, N*std::log10(static_cast<double>(N)));
+        }
+        return ess;
+    }
 } /* namespace prior_hessian::mcmc */
 
+/** Sampling methods for TruncatedMultivariateDist.
+ * Auto - Rejection if the truncated region has probability above 0.05, otherwise Gibbs.  Rejection only if Dist does
+ *        not support Gibbs sampling.
+ * Rejection - Sample from Dist until in bounds.  Throws RuntimeSamplingError after 1000 failures.
+ * Gibbs - Coordinate-wise Gibbs sampling from the univariate truncated conditionals.  Requires a normal Dist, i.e., one
+ *         with mu() and sigma_inv().  See TruncatedMultivariateDist::gibbs_supported().
+ * Metropolis - Metropolis sampling with uniform proposals over the bounds.  The bounds must be finite.
+ */
+enum class TruncatedSamplingMethod { Auto, Rejection, Gibbs, Metropolis };
+
     
-/** @brief 
+/** @brief A multivariate distribution truncated to the rectangle [lbound, ubound].
  * 
+ * Dist must provide rectangle_probability(lbound,ubound) and log_rectangle_probability(lbound,ubound).  The truncation
+ * normalizer is computed in log space in a single integration, so truncations far in the tails remain valid.
  */
 template<class Dist>
 class TruncatedMultivariateDist : public Dist
 {
 public:
     using typename Dist::NdimVecT;
-    static constexpr const double min_bounds_pdf_integral = 1.0e-8; /** minimum allowabale integral of pdf for a valid truncation*/
-    
+    using typename Dist::NparamsVecT;
+    using typename Dist::NparamsMatT;
     TruncatedMultivariateDist(): TruncatedMultivariateDist(Dist{}) { }
     
     template<class Vec>
@@ -110,6 +185,12 @@ public:
     void set_lbound(const Vec &lbound);    
     template<class Vec>
     void set_ubound(const Vec &ubound);    
+
+    /* The truncated probability mass depends on the parameters, so setting parameters recomputes the truncation constants */
+    template<class... Args>
+    void set_params(Args&&... args);
+    template<class IterT>
+    void set_params_iter(IterT &params);
     
     double mean() const { throw NotImplementedError("No universal mean formula for truncated multivariate distributions"); }
     
@@ -120,60 +201,111 @@ public:
     template<class Vec>
     double llh(const Vec& x) const;
 
+    template<class Vec>
+    NparamsVecT param_grad(const Vec &x) const;
+    template<class Vec>
+    NparamsMatT param_hess(const Vec &x) const;
+    template<class Vec, class Vec2, class Mat>
+    void param_grad_hess_accumulate(const Vec &x, Vec2 &g, Mat &h) const;
+
+    TruncatedSamplingMethod sampling_method() const { return _sampling_method; }
+    void set_sampling_method(TruncatedSamplingMethod method);
+    /* True if Dist has the normal conditionals needed for Gibbs sampling */
+    static constexpr bool gibbs_supported() { return has_normal_conditionals<Dist>(0); }
+
+    using ChainStateT = mcmc::ChainState<Dist::num_dim()>;
+    /* Sample using the calling thread's chain state for MCMC methods */
     template<class RngT>
     NdimVecT sample(RngT &rng) const;
+    /* Sample using a caller owned chain state for MCMC methods */
+    template<class RngT>
+    NdimVecT sample(RngT &rng, ChainStateT &chain) const;
+    /* Bulk sampling with a single chain, so burn-in is paid once per call.  Samples are the columns. */
+    template<class RngT>
+    MatT sample(RngT &rng, IdxT num_samples) const;
+    template<class RngT>
+    MatT sample(RngT &rng, IdxT num_samples, mcmc::SamplingStats &stats) const;
 protected:
+    /* Bulk sampling, filling in stats only if non-null, as the effective sample size is not free */
+    template<class RngT>
+    MatT sample_bulk(RngT &rng, IdxT num_samples, mcmc::SamplingStats *stats) const;
     NdimVecT _truncated_lbound;
     NdimVecT _truncated_ubound;
     bool _truncated = false;
+    TruncatedSamplingMethod _sampling_method = TruncatedSamplingMethod::Auto;
 
-    double compute_truncated_pdf_integral(const NdimVecT &lbound, const NdimVecT &ubound, double lbound_cdf) const;
-    double lbound_cdf; // cdf(lbound())
     double bounds_pdf_integral; // integral of pdf over valid bounded polytope
     double llh_truncation_const;// -log(bounds_pdf_integral)
+
+    //Lazy computation of the derivatives of llh_truncation_const with respect to the parameters.  The gradient is
+    //Dist::log_rectangle_probability_param_grad if Dist provides it, and the hessian is its finite differences.
+    //Otherwise both are finite differences of Dist::log_rectangle_probability, which is only accurate if the
+    //rectangle probability is exact, as it is for Ndim<=3.
+    mutable NparamsVecT truncation_param_grad;
+    mutable NparamsMatT truncation_param_hess;
+    mutable bool truncation_param_derivs_initialized = false;
+    void initialize_truncation_param_derivs() const;
     
 private:
+    template<class D>
+    static auto log_rectangle_probability_param_grad_hess(const D &dist, const NdimVecT &lb, const NdimVecT &ub,
+                                                          NparamsVecT &grad, NparamsMatT &hess, int)
+        -> decltype(dist.log_rectangle_probability_param_grad(lb,ub), void())
+    {
+        auto grad_func = [&](const D &d) { return d.log_rectangle_probability_param_grad(lb,ub); };
+        grad = grad_func(dist);
+        Dist::param_hess_finite_difference(dist, grad_func, hess);
+    }
+    template<class D>
+    static void log_rectangle_probability_param_grad_hess(const D &dist, const NdimVecT &lb, const NdimVecT &ub,
+                                                          NparamsVecT &grad, NparamsMatT &hess, long)
+    { 
+        auto func = [&](const D &d) { return d.log_rectangle_probability(lb,ub); };
+        Dist::param_grad_hess_finite_difference(dist, func, grad, hess); 
+    }
+
+    template<class RngT>
+    bool try_rejection_sample(RngT &rng, NdimVecT &s) const;
     template<class RngT>
     NdimVecT rejection_sample(RngT &rng) const;
     
     template<class RngT>
-    NdimVecT mcmc_sample(RngT &rng) const;
+    NdimVecT mcmc_sample(RngT &rng, ChainStateT &chain) const;
+    template<class RngT>
+    bool mcmc_step(RngT &rng, ChainStateT &chain) const;
     static constexpr double mcmc_pdf_integral_threshold=0.05;
+    static constexpr int mcmc_burnin=10;
+    static constexpr int mcmc_keep_every=10;
+
+    template<class D>
+    static constexpr auto has_normal_conditionals(int) 
+        -> decltype(std::declval<const D&>().mu(), std::declval<const D&>().sigma_inv(), bool())
+    { return true; }
+    template<class D>
+    static constexpr bool has_normal_conditionals(long) { return false; }
+
+    template<class RngT>
+    NdimVecT gibbs_sample(RngT &rng, ChainStateT &chain) const;
+    template<class RngT>
+    void gibbs_sweep(NdimVecT &x, RngT &rng) const { gibbs_sweep(x,rng,0); }
+    template<class RngT, class D=Dist>
+    auto gibbs_sweep(NdimVecT &x, RngT &rng, int) const -> decltype(std::declval<const D&>().sigma_inv(), void());
+    template<class RngT>
+    void gibbs_sweep(NdimVecT &, RngT &, long) const
+    { throw NotImplementedError("TruncatedMultivariateDist: Gibbs sampling requires a normal Dist."); }
+    static constexpr int gibbs_burnin=10; //Sweeps
+    static constexpr int gibbs_keep_every=2; //Sweeps between returned samples
+
+    void start_chain(ChainStateT &chain, TruncatedSamplingMethod method) const;
+    /* Start chains at the mean projected into the bounds, if Dist has a mean(), otherwise at the center of the bounds */
+    template<class D=Dist>
+    auto chain_start_point(int) const -> decltype(std::declval<const D&>().mean(), NdimVecT())
+    { return arma::min(arma::max(NdimVecT(this->mean()),lbound()),ubound()); }
+    NdimVecT chain_start_point(long) const { return .5*(lbound()+ubound()); }
     
-    mutable mcmc::MCMCData<Dist::num_dim()> mcmc;
+    mcmc::ChainKey chain_key;
 };
 
-template<class Dist>
-double TruncatedMultivariateDist<Dist>::compute_truncated_pdf_integral(const NdimVecT &lbound, const NdimVecT &ubound, double lbound_cdf) const
-{
-    const IdxT N = Dist::num_dim();
-    if(lbound_cdf==0 && arma::all(lbound==-INFINITY)) return this->Dist::cdf(ubound);
-    double pdf_integral = (N%2==0) ? lbound_cdf : -lbound_cdf; //account for the lbound() vertex here.
-
-    //n iterates through all integers less than 2^N. we use the binary repr of N to choose ubound or lbound
-    // 0 bit = use ubound(k)
-    // 1 bit = use lbound(k)
-    // all 1's is skipped as we account for that in initial pdf_integral value
-    for(IdxT n=0; n<pow(2,N)-1; n++) {
-        IdxT b=n; //b is used as a binary repr.
-        IdxT k=0; //k is index we are considering
-        IdxT flips=0;
-        NdimVecT v = ubound;
-        while(b && k<N) {
-            if(b&0x1) {
-                v(k) = lbound(k);
-                flips++;
-            }
-            k++;
-            b>>=1;
-        }
-        double cdf_val = arma::any(v==-INFINITY) ? 0 : this->Dist::cdf(v);
-        if(flips%2==1) cdf_val = -cdf_val; //odd number of flips
-        pdf_integral += cdf_val;
-    }
-    return pdf_integral;
-}
-        
 template<class Dist>
 template<class Vec, class Vec2>
 void TruncatedMultivariateDist<Dist>::set_bounds(const Vec &lbound, const Vec2 &ubound)
@@ -195,16 +327,15 @@ void TruncatedMultivariateDist<Dist>::set_bounds(const Vec &lbound, const Vec2 &
     }
     bool truncated = arma::any(lbound > global_lbound()) || arma::any(ubound < global_ubound());
     if(truncated) {
-        lbound_cdf = arma::any(lbound==-INFINITY) ? 0 : this->Dist::cdf(lbound);
-        bounds_pdf_integral = compute_truncated_pdf_integral(lbound,ubound,lbound_cdf);
-        if(!(bounds_pdf_integral > min_bounds_pdf_integral)) {            
+        double log_bounds_pdf_integral = this->Dist::log_rectangle_probability(lbound,ubound);
+        if(!(log_bounds_pdf_integral > -INFINITY)) {
             std::ostringstream msg;
-            msg<<"TruncatedMultivariateDist::set_bounds: params: ["<<this->params().t()<<"]\n bounds:[ ["<<lbound.t()<<"], ["<<ubound.t()<<"] ] with cdf:["<<lbound_cdf<<","<<this->Dist::cdf(ubound)
-               <<"] have pdf integral: "<<bounds_pdf_integral<<" < min_delta = "<<min_bounds_pdf_integral
-               <<".  Bounds cover too small a portion of the domain for accuarate truncation.";
+            msg<<"TruncatedMultivariateDist::set_bounds: params: ["<<this->params().t()<<"]\n bounds:[ ["<<lbound.t()<<"], ["<<ubound.t()<<"] ] have log pdf integral: "<<log_bounds_pdf_integral
+               <<".  Bounds have no probability mass.";
             throw ParameterValueError(msg.str());
         }
-        llh_truncation_const = -log(bounds_pdf_integral);
+        bounds_pdf_integral = exp(log_bounds_pdf_integral);
+        llh_truncation_const = -log_bounds_pdf_integral;
     } else {
         bounds_pdf_integral = 1;
         llh_truncation_const = 0;
@@ -212,6 +343,17 @@ void TruncatedMultivariateDist<Dist>::set_bounds(const Vec &lbound, const Vec2 &
     _truncated = truncated;
     _truncated_lbound = lbound;
     _truncated_ubound = ubound;
+    truncation_param_derivs_initialized = false;
+    chain_key.reset();
+}
+
+template<class Dist>
+void TruncatedMultivariateDist<Dist>::set_sampling_method(TruncatedSamplingMethod method)
+{
+    if(method == TruncatedSamplingMethod::Gibbs && !gibbs_supported())
+        throw ParameterValueError("TruncatedMultivariateDist: Gibbs sampling requires a normal Dist.");
+    _sampling_method = method;
+    chain_key.reset();
 }
 
 template<class Dist>
@@ -228,19 +370,36 @@ void TruncatedMultivariateDist<Dist>::set_ubound(const Vec &new_ubound)
     set_bounds(lbound(), new_ubound);
 }
 
+template<class Dist>
+template<class... Args>
+void TruncatedMultivariateDist<Dist>::set_params(Args&&... args)
+{
+    Dist::set_params(std::forward<Args>(args)...);
+    set_bounds(lbound(), ubound());
+}
+
+template<class Dist>
+template<class IterT>
+void TruncatedMultivariateDist<Dist>::set_params_iter(IterT &params)
+{
+    Dist::set_params_iter(params);
+    set_bounds(lbound(), ubound());
+}
+
 template<class Dist>
 template<class Vec>
 double TruncatedMultivariateDist<Dist>::cdf(const Vec &x) const
 {
     if(!truncated()) return this->Dist::cdf(x);
-    return compute_truncated_pdf_integral(lbound(),x,lbound_cdf)/bounds_pdf_integral;
+    NdimVecT ub = arma::min(static_cast<NdimVecT>(x),ubound());
+    return exp(this->Dist::log_rectangle_probability(lbound(),ub) + llh_truncation_const);
 }
 
 template<class Dist>
 template<class Vec>
 double TruncatedMultivariateDist<Dist>::pdf(const Vec &x) const
 {
-    return this->Dist::pdf(x) / bounds_pdf_integral;
+    return exp(this->Dist::llh(x) + llh_truncation_const);
 }
 
 template<class Dist>
@@ -250,16 +409,92 @@ double TruncatedMultivariateDist<Dist>::llh(const Vec &x) const
     return this->Dist::llh(x) + llh_truncation_const;
 }
 
+template<class Dist>
+template<class Vec>
+typename TruncatedMultivariateDist<Dist>::NparamsVecT
+TruncatedMultivariateDist<Dist>::param_grad(const Vec &x) const
+{
+    if(!truncated()) return Dist::param_grad(x);
+    if(!truncation_param_derivs_initialized) initialize_truncation_param_derivs();
+    return Dist::param_grad(x) + truncation_param_grad;
+}
+
+template<class Dist>
+template<class Vec>
+typename TruncatedMultivariateDist<Dist>::NparamsMatT
+TruncatedMultivariateDist<Dist>::param_hess(const Vec &x) const
+{
+    if(!truncated()) return Dist::param_hess(x);
+    if(!truncation_param_derivs_initialized) initialize_truncation_param_derivs();
+    return Dist::param_hess(x) + truncation_param_hess;
+}
+
+template<class Dist>
+template<class Vec, class Vec2, class Mat>
+void TruncatedMultivariateDist<Dist>::param_grad_hess_accumulate(const Vec &x, Vec2 &g, Mat &h) const
+{
+    Dist::param_grad_hess_accumulate(x,g,h);
+    if(!truncated()) return;
+    if(!truncation_param_derivs_initialized) initialize_truncation_param_derivs();
+    g += truncation_param_grad;
+    h += truncation_param_hess;
+}
+
+template<class Dist>
+void TruncatedMultivariateDist<Dist>::initialize_truncation_param_derivs() const
+{
+    log_rectangle_probability_param_grad_hess(static_cast<const Dist&>(*this), lbound(), ubound(), 
+                                              truncation_param_grad, truncation_param_hess, 0);
+    //llh_truncation_const = -log(bounds_pdf_integral)
+    truncation_param_grad = -truncation_param_grad;
+    truncation_param_hess = -truncation_param_hess;
+    truncation_param_derivs_initialized = true;
+}
+
 template<class Dist>
 template<class RngT>
 typename TruncatedMultivariateDist<Dist>::NdimVecT 
 TruncatedMultivariateDist<Dist>::sample(RngT &rng) const
+{
+    if(!truncated() || _sampling_method == TruncatedSamplingMethod::Rejection) return rejection_sample(rng);
+    return sample(rng, mcmc::thread_chain<Dist::num_dim()>(chain_key));
+}
+
+template<class Dist>
+template<class RngT>
+typename TruncatedMultivariateDist<Dist>::NdimVecT 
+TruncatedMultivariateDist<Dist>::sample(RngT &rng, ChainStateT &chain) const
 {
     if(!truncated()) return Dist::sample(rng);
-    if(bounds_pdf_integral  > mcmc_pdf_integral_threshold)  return rejection_sample(rng);
-    else return mcmc_sample(rng);
+    switch(_sampling_method) {
+        case TruncatedSamplingMethod::Rejection:
+            return rejection_sample(rng);
+        case TruncatedSamplingMethod::Gibbs:
+            return gibbs_sample(rng,chain);
+        case TruncatedSamplingMethod::Metropolis:
+            return mcmc_sample(rng,chain);
+        case TruncatedSamplingMethod::Auto:
+        default:
+            if(!gibbs_supported()) return rejection_sample(rng);
+            if(bounds_pdf_integral > mcmc_pdf_integral_threshold) {
+                NdimVecT s;
+                if(try_rejection_sample(rng,s)) return s;
+            }
+            return gibbs_sample(rng,chain);
+    }
 }
 
+template<class Dist>
+template<class RngT>
+bool TruncatedMultivariateDist<Dist>::try_rejection_sample(RngT &rng, NdimVecT &s) const
+{
+    const int MaxIter = 1000;
+    for(int n=0;n<MaxIter; n++){
+        s=Dist::sample(rng);
+        if(this->in_bounds(s)) return true;
+    }
+    return false;
+}
 
 template<class Dist>
 template<class RngT>
@@ -268,57 +503,161 @@ TruncatedMultivariateDist<Dist>::rejection_sample(RngT &rng) const
 {
     if(!truncated()) return Dist::sample(rng);
     //If truncated, rejection sampling is the only universal multi-dimensional distribution.
-    const int MaxIter = 1000;
     NdimVecT s;
-    for(int n=0;n<MaxIter; n++){
-        s=Dist::sample(rng);
-        if(this->in_bounds(s)) {
-            return s;
+    if(try_rejection_sample(rng,s)) return s;
+    throw RuntimeSamplingError("Truncated distribution rejection sampling failure.  A more efficient method is required.");
+}
+
+template<class Dist>
+template<class RngT>
+MatT TruncatedMultivariateDist<Dist>::sample(RngT &rng, IdxT num_samples) const
+{
+    return sample_bulk(rng,num_samples,nullptr);
+}
+
+template<class Dist>
+template<class RngT>
+MatT TruncatedMultivariateDist<Dist>::sample(RngT &rng, IdxT num_samples, mcmc::SamplingStats &stats) const
+{
+    return sample_bulk(rng,num_samples,&stats);
+}
+
+template<class Dist>
+template<class RngT>
+MatT TruncatedMultivariateDist<Dist>::sample_bulk(RngT &rng, IdxT num_samples, mcmc::SamplingStats *stats) const
+{
+    MatT s(this->num_dim(),num_samples);
+    auto method = _sampling_method;
+    if(method == TruncatedSamplingMethod::Auto)
+        method = bounds_pdf_integral > mcmc_pdf_integral_threshold || !gibbs_supported() ? 
+                    TruncatedSamplingMethod::Rejection : TruncatedSamplingMethod::Gibbs;
+    if(!truncated() || method == TruncatedSamplingMethod::Rejection) {
+        //Independent draws.  Auto falls back to Gibbs sampling for any failed rejection draws.
+        const IdxT MaxIter = 1000;
+        IdxT ndraws = 0;
+        ChainStateT chain;
+        for(IdxT n=0; n<num_samples; n++) {
+            IdxT k=0;
+            for(; k<MaxIter; k++) {
+                s.col(n) = Dist::sample(rng);
+                if(!truncated() || this->in_bounds(s.col(n))) break;
+            }
+            ndraws += std::min(k+1,MaxIter);
+            if(k < MaxIter) continue;
+            if(_sampling_method == TruncatedSamplingMethod::Rejection || !gibbs_supported()) 
+                throw RuntimeSamplingError("Truncated distribution rejection sampling failure.  A more efficient method is required.");
+            s.col(n) = gibbs_sample(rng,chain);
+        }
+        if(stats) {
+            stats->acceptance_rate = num_samples ? static_cast<double>(num_samples)/ndraws : 1;
+            stats->ess = mcmc::effective_sample_size(s);
         }
+        return s;
     }
-    throw RuntimeSamplingError("Truncated distribution rejection sampling failure.  A more efficient method is required.");
+    ChainStateT chain;
+    start_chain(chain,method);
+    IdxT naccept = 0;
+    if(method == TruncatedSamplingMethod::Gibbs) {
+        for(int k=0; k<gibbs_burnin; k++) gibbs_sweep(chain.sample,rng);
+        for(IdxT n=0; n<num_samples; n++) {
+            for(int k=0; k<gibbs_keep_every; k++) gibbs_sweep(chain.sample,rng);
+            s.col(n) = chain.sample;
+        }
+    } else {
+        for(int k=0; k<mcmc_burnin; k++) mcmc_step(rng,chain);
+        for(IdxT n=0; n<num_samples; n++) {
+            for(int k=0; k<mcmc_keep_every; k++) naccept += mcmc_step(rng,chain);
+            s.col(n) = chain.sample;
+        }
+    }
+    if(stats) {
+        if(method == TruncatedSamplingMethod::Gibbs) stats->acceptance_rate = 1;
+        else stats->acceptance_rate = num_samples ? static_cast<double>(naccept)/(num_samples*mcmc_keep_every) : 1;
+        stats->ess = mcmc::effective_sample_size(s);
+    }
+    return s;
+}
+
+template<class Dist>
+void TruncatedMultivariateDist<Dist>::start_chain(ChainStateT &chain, TruncatedSamplingMethod method) const
+{
+    chain.key = chain_key.get();
+    chain.nsample = 0;
+    if(method == TruncatedSamplingMethod::Metropolis && !(lbound().is_finite() && ubound().is_finite()))
+        throw ParameterValueError("TruncatedMultivariateDist: Metropolis sampling requires finite bounds.");
+    chain.sample = chain_start_point(0);
+    if(method == TruncatedSamplingMethod::Metropolis) chain.rllh = this->rllh(chain.sample);
 }
 
 template<class Dist>
 template<class RngT>
 typename TruncatedMultivariateDist<Dist>::NdimVecT 
-TruncatedMultivariateDist<Dist>::mcmc_sample(RngT &rng) const
+TruncatedMultivariateDist<Dist>::mcmc_sample(RngT &rng, ChainStateT &chain) const
+{
+    chain.attach(chain_key);
+    if(chain.nsample==0) start_chain(chain,TruncatedSamplingMethod::Metropolis);
+    do {
+        chain.nsample++;
+        mcmc_step(rng,chain);
+    } while(chain.nsample<=mcmc_burnin || chain.nsample%mcmc_keep_every != 0);
+    return chain.sample;
+}
+
+/* One Metropolis step with a uniform proposal over the bounds.  Returns true if accepted. */
+template<class Dist>
+template<class RngT>
+bool TruncatedMultivariateDist<Dist>::mcmc_step(RngT &rng, ChainStateT &chain) const
 {
-    const int burnin=10;
-    const int keep_every =10;
     auto& lb = this->lbound();
     auto& ub = this->ubound();
     std::uniform_real_distribution<double> uniform;
-    
-    this->mcmc.mutex.lock();
-    NdimVecT sample = mcmc.sample;
-    double sample_rllh = mcmc.rllh;
-    int N = mcmc.nsample;
-    this->mcmc.mutex.unlock();
-    if(N==0) {
-        sample = .5*(lb+ub);
-        sample_rllh = this->rllh(sample);
+    NdimVecT can_sample;
+    for(IdxT k=0;k<this->num_dim();k++) can_sample(k) = uniform(rng)*(ub(k)-lb(k)) + lb(k);
+    double can_rllh = this->rllh(can_sample);
+    double alpha = std::min(1., exp(can_rllh - chain.rllh));
+    if(uniform(rng) < alpha) {
+        //Accept
+        chain.sample = can_sample;
+        chain.rllh = can_rllh;
+        return true;
     }
-    do {
-        N++;
-        NdimVecT can_sample;
-        for(IdxT k=0;k<this->num_dim();k++) can_sample(k) = uniform(rng)*(ub(k)-lb(k)) + lb(k);
-        double can_rllh = this->rllh(can_sample);
-        double alpha = std::min(1., exp(can_rllh - sample_rllh));
-        if(uniform(rng) < alpha) {
-            //Accept
-            sample = can_sample;
-            sample_rllh = can_rllh;
-        }
-    } while(N<=burnin || N%keep_every != 0);
+    return false;
+}
 
-    this->mcmc.mutex.lock();
-    mcmc.sample = sample;
-    mcmc.rllh = sample_rllh;
-    mcmc.nsample = N;
-    this->mcmc.mutex.unlock();
+template<class Dist>
+template<class RngT>
+typename TruncatedMultivariateDist<Dist>::NdimVecT 
+TruncatedMultivariateDist<Dist>::gibbs_sample(RngT &rng, ChainStateT &chain) const
+{
+    chain.attach(chain_key);
+    if(chain.nsample==0) start_chain(chain,TruncatedSamplingMethod::Gibbs);
+    do {
+        chain.nsample++;
+        gibbs_sweep(chain.sample,rng);
+    } while(chain.nsample<=gibbs_burnin || chain.nsample%gibbs_keep_every != 0);
+    return chain.sample;
+}
 
-    return sample;
+/* One sweep over the coordinates, each drawn from its normal conditional truncated to the bounds.
+ * With precision P = sigma^-1, x(i) | x(-i) has mean mu(i) - sum_{j!=i} P(j,i)*(x(j)-mu(j))/P(i,i), and
+ * variance 1/P(i,i).  Cost is O(Ndim^2) per sweep with no rejection.
+ */
+template<class Dist>
+template<class RngT, class D>
+auto TruncatedMultivariateDist<Dist>::gibbs_sweep(NdimVecT &x, RngT &rng, int) const 
+    -> decltype(std::declval<const D&>().sigma_inv(), void())
+{
+    const auto &mu = this->mu();
+    const auto &P = this->sigma_inv();
+    const auto &lb = lbound();
+    const auto &ub = ubound();
+    for(IdxT i=0; i<this->num_dim(); i++) {
+        double s = 0;
+        for(IdxT j=0; j<this->num_dim(); j++) if(j!=i) s += P(j,i)*(x(j)-mu(j));
+        double sd = 1/sqrt(P(i,i));
+        double m = mu(i) - s/P(i,i);
+        x(i) = m + sd*sample_truncated_unit_normal((lb(i)-m)/sd, (ub(i)-m)/sd, rng);
+    }
 }
 
 } /* namespace prior_hessian */
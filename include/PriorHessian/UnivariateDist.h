@@ -6,6 +6,10 @@
 #ifndef PRIOR_HESSIAN_UNIVARIATEDIST_H
 #define PRIOR_HESSIAN_UNIVARIATEDIST_H
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #include "PriorHessian/util.h"
 #include "PriorHessian/Meta.h"
 #include "PriorHessian/BaseDist.h"
@@ -28,12 +32,58 @@ public:
 
 protected:
     static void check_bounds(double lbound, double ubound);
+
+    /** log(cdf(b)-cdf(a)) for a < b, from the log-cdf when [a,b] is below the median and from the log-survival
+     * function when it is above.  The difference of two probabilities near 1 is never formed, so narrow intervals
+     * far in the upper tail keep full relative precision.  Dist must provide cdf, sf, logcdf and logsf.
+     */
+    template<class Dist>
+    static double log_cdf_difference(const Dist &dist, double a, double b);
+
+    /** Gradient and hessian of dist.log_cdf_diff(a,b) with respect to the parameters of dist.  Uses the closed form
+     * dist.log_cdf_diff_param_grad_hess if Dist provides it, and central finite differences otherwise.
+     */
+    template<class Dist>
+    static void log_cdf_difference_param_grad_hess(const Dist &dist, double a, double b, 
+                                                   typename Dist::NparamsVecT &grad, typename Dist::NparamsMatT &hess)
+    { log_cdf_difference_param_grad_hess(dist,a,b,grad,hess,0); }
+
+    /** Inverses of dist.logcdf and dist.logsf.  Uses dist.ilogcdf and dist.ilogsf if Dist provides them.  Otherwise
+     * the probability is floored at the smallest normal double before calling dist.icdf or dist.isf, so quantiles
+     * whose probability underflows are limited to the most extreme quantile the double probability can represent.
+     */
+    template<class Dist>
+    static double inverse_logcdf(const Dist &dist, double log_u) { return inverse_logcdf(dist,log_u,0); }
+    template<class Dist>
+    static double inverse_logsf(const Dist &dist, double log_u) { return inverse_logsf(dist,log_u,0); }
     /**
      * Unsafe: internally set _lbound unchecked.  For use by set_lbound functions of sub-classes only. 
      * Only used by ParetoDist. 
      */
 //     void set_lbound_internal(double lbound) { _lbound = lbound; } 
     
+private:
+    template<class Dist>
+    static auto inverse_logcdf(const Dist &dist, double log_u, int) -> decltype(dist.ilogcdf(log_u))
+    { return dist.ilogcdf(log_u); }
+    template<class Dist>
+    static double inverse_logcdf(const Dist &dist, double log_u, long)
+    { return dist.icdf(std::max(std::exp(log_u), std::numeric_limits<double>::min())); }
+    template<class Dist>
+    static auto inverse_logsf(const Dist &dist, double log_u, int) -> decltype(dist.ilogsf(log_u))
+    { return dist.ilogsf(log_u); }
+    template<class Dist>
+    static double inverse_logsf(const Dist &dist, double log_u, long)
+    { return dist.isf(std::max(std::exp(log_u), std::numeric_limits<double>::min())); }
+    template<class Dist>
+    static auto log_cdf_difference_param_grad_hess(const Dist &dist, double a, double b, typename Dist::NparamsVecT &grad, 
+                                                   typename Dist::NparamsMatT &hess, int) 
+        -> decltype(dist.log_cdf_diff_param_grad_hess(a,b,grad,hess))
+    { return dist.log_cdf_diff_param_grad_hess(a,b,grad,hess); }
+    template<class Dist>
+    static void log_cdf_difference_param_grad_hess(const Dist &dist, double a, double b, typename Dist::NparamsVecT &grad, 
+                                                   typename Dist::NparamsMatT &hess, long)
+    { param_grad_hess_finite_difference(dist, [=](const Dist &d) { return d.log_cdf_diff(a,b); }, grad, hess); }
 // private:
 //     double _lbound;
 //     double _ubound;
@@ -63,6 +113,19 @@ protected:
 //     return _lbound<u && u<_ubound;
 // }
 
+template<class Dist>
+double UnivariateDist::log_cdf_difference(const Dist &dist, double a, double b)
+{
+    if(a >= b) return -INFINITY;
+    if(a <= dist.lbound()) return dist.logcdf(b);
+    if(b >= dist.ubound()) return dist.logsf(a);
+    double log_cdf_b = dist.logcdf(b);
+    if(log_cdf_b <= -constants::ln2) return log_diff_exp(log_cdf_b, dist.logcdf(a)); //[a,b] below the median
+    double log_sf_a = dist.logsf(a);
+    if(log_sf_a <= -constants::ln2) return log_diff_exp(log_sf_a, dist.logsf(b)); //[a,b] above the median
+    return std::log1p(-(dist.cdf(a) + dist.sf(b))); //[a,b] contains the median
+}
+
 } /* namespace prior_hessian */
 
 #endif /* PRIOR_HESSIAN_UNIVARIATEDIST_H */
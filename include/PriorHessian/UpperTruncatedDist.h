@@ -7,7 +7,9 @@
 #ifndef PRIOR_HESSIAN_UPPERTRUNCATEDDIST_H
 #define PRIOR_HESSIAN_UPPERTRUNCATEDDIST_H
 
+#include <algorithm>
 #include <cmath>
+#include <utility>
 
 #include "PriorHessian/Meta.h"
 #include "PriorHessian/PriorHessianError.h"
@@ -22,6 +24,9 @@ template<class Dist>
 class UpperTruncatedDist : public Dist
 {
 public:
+    using NparamsVecT = typename Dist::NparamsVecT;
+    using NparamsMatT = typename Dist::NparamsMatT;
+
     UpperTruncatedDist() : UpperTruncatedDist(Dist{}) { }
     explicit UpperTruncatedDist(double ubound) : UpperTruncatedDist(Dist{}, ubound) { }
     
@@ -49,13 +54,38 @@ public:
     void set_lbound(double ubound);    
     void set_ubound(double ubound);    
 
+    /* The truncated probability mass depends on the parameters, so setting parameters recomputes the truncation constants */
+    template<class... Args>
+    void set_params(Args&&... args);
+    void set_param(int idx, double val);
+    template<class IterT>
+    void set_params_iter(IterT &params);
+
     double mean() const { throw NotImplementedError("Mean is not implemented for truncated distributions. No general-purpose efficient algorithm."); }
     double median() const {return Dist::icdf((Dist::cdf(this->lbound())+ubound_cdf)*.5); }
     
     double cdf(double x) const;
     double pdf(double x) const;
     double icdf(double u) const;
+    double sf(double x) const { return exp(logsf(x)); }
+    double isf(double u) const { return icdf(1-u); }
+    double logcdf(double x) const { return log_cdf_diff(this->lbound(),x); }
+    double logsf(double x) const { return log_cdf_diff(x,ubound()); }
+    double log_cdf_diff(double a, double b) const;
     double llh(double x) const;
+    /* Array form of llh, if Dist has one.  Used by CompositeDist for batched evaluation. */
+    template<class D=Dist>
+    auto llh(IdxT N, const double *x, double *out) const -> decltype(std::declval<const D&>().llh(N,x,out))
+    {
+        D::llh(N,x,out);
+        for(IdxT i=0; i<N; i++) out[i] += llh_truncation_const;
+    }
+
+    NparamsVecT param_grad(double x) const;
+    NparamsMatT param_hess(double x) const;
+    void param_grad_hess_accumulate(double x, NparamsVecT &g, NparamsMatT &h) const;
+    /* Gradient and hessian of cdf(x) with respect to the parameters.  Used for CopulaDist parameter derivatives. */
+    void cdf_param_grad_hess(double x, NparamsVecT &grad, NparamsMatT &hess) const;
 
     template<class RngT>
     double sample(RngT &rng) const;
@@ -66,6 +96,12 @@ private:
     double ubound_cdf; // cdf(_truncated_ubound)  [The lbound remains in place and the cdf at the lbound is 0 so this is equivalent to bounds_cdf_delta in TrunctedDist]
     double llh_truncation_const;// -log(ubounds_cdf)   
 
+    //Lazy computation of the derivatives of llh_truncation_const with respect to the parameters.
+    mutable NparamsVecT truncation_param_grad;
+    mutable NparamsMatT truncation_param_hess;
+    mutable bool truncation_param_derivs_initialized = false;
+    void initialize_truncation_param_derivs() const;
+
     void set_ubound_impl(double ubound);
 };
 
@@ -105,6 +141,7 @@ void UpperTruncatedDist<Dist>::set_lbound(double lbound)
         throw ParameterValueError(msg.str());
     }
     static_cast<Dist*>(this)->set_lbound(lbound);
+    set_ubound_impl(ubound()); //Truncated mass depends on lbound
 }
 
 template<class Dist>
@@ -128,13 +165,37 @@ void UpperTruncatedDist<Dist>::set_ubound_impl(double ubound)
 {
     _truncated =  ubound < global_ubound();
     if(_truncated) {
-        ubound_cdf = Dist::cdf(ubound);
-        llh_truncation_const = -log(ubound_cdf);
+        llh_truncation_const = -Dist::logcdf(ubound);
+        ubound_cdf = exp(-llh_truncation_const);
     } else {
         ubound_cdf = 1;
         llh_truncation_const = 0;
     }
     _truncated_ubound = ubound;
+    truncation_param_derivs_initialized = false;
+}
+
+template<class Dist>
+template<class... Args>
+void UpperTruncatedDist<Dist>::set_params(Args&&... args)
+{
+    Dist::set_params(std::forward<Args>(args)...);
+    set_ubound_impl(ubound());
+}
+
+template<class Dist>
+void UpperTruncatedDist<Dist>::set_param(int idx, double val)
+{
+    Dist::set_param(idx,val);
+    set_ubound_impl(ubound());
+}
+
+template<class Dist>
+template<class IterT>
+void UpperTruncatedDist<Dist>::set_params_iter(IterT &params)
+{
+    Dist::set_params_iter(params);
+    set_ubound_impl(ubound());
 }
 
 template<class Dist>
@@ -149,10 +210,16 @@ double UpperTruncatedDist<Dist>::icdf(double u) const
     return this->Dist::icdf(u*ubound_cdf);
 }
 
+template<class Dist>
+double UpperTruncatedDist<Dist>::log_cdf_diff(double a, double b) const
+{
+    return this->Dist::log_cdf_diff(a, std::min(b,ubound())) + llh_truncation_const;
+}
+
 template<class Dist>
 double UpperTruncatedDist<Dist>::pdf(double x) const
 {
-    return this->Dist::pdf(x) / ubound_cdf;
+    return exp(this->Dist::llh(x) + llh_truncation_const);
 }
 
 template<class Dist>
@@ -161,6 +228,67 @@ double UpperTruncatedDist<Dist>::llh(double x) const
     return this->Dist::llh(x) + llh_truncation_const;
 }
 
+template<class Dist>
+typename UpperTruncatedDist<Dist>::NparamsVecT
+UpperTruncatedDist<Dist>::param_grad(double x) const
+{
+    if(!_truncated) return Dist::param_grad(x);
+    if(!truncation_param_derivs_initialized) initialize_truncation_param_derivs();
+    return Dist::param_grad(x) + truncation_param_grad;
+}
+
+template<class Dist>
+typename UpperTruncatedDist<Dist>::NparamsMatT
+UpperTruncatedDist<Dist>::param_hess(double x) const
+{
+    if(!_truncated) return Dist::param_hess(x);
+    if(!truncation_param_derivs_initialized) initialize_truncation_param_derivs();
+    return Dist::param_hess(x) + truncation_param_hess;
+}
+
+template<class Dist>
+void UpperTruncatedDist<Dist>::param_grad_hess_accumulate(double x, NparamsVecT &g, NparamsMatT &h) const
+{
+    Dist::param_grad_hess_accumulate(x,g,h);
+    if(!_truncated) return;
+    if(!truncation_param_derivs_initialized) initialize_truncation_param_derivs();
+    g += truncation_param_grad;
+    h += truncation_param_hess;
+}
+
+/* The lbound of Dist may be a parameter (e.g., ParetoDist min), so the cdfs are taken as log_cdf_diff from -inf,
+ * which is below the lbound for any parameter values.
+ */
+template<class Dist>
+void UpperTruncatedDist<Dist>::cdf_param_grad_hess(double x, NparamsVecT &grad, NparamsMatT &hess) const
+{
+    if(!(this->lbound() < x && x < ubound())) { //cdf is 0 or 1 for any parameter values
+        grad.zeros();
+        hess.zeros();
+        return;
+    }
+    this->log_cdf_difference_param_grad_hess(static_cast<const Dist&>(*this), -INFINITY, x, grad, hess);
+    if(_truncated) {
+        if(!truncation_param_derivs_initialized) initialize_truncation_param_derivs();
+        grad += truncation_param_grad;
+        hess += truncation_param_hess;
+    }
+    double u = cdf(x);
+    hess = u*(hess + grad*grad.t());
+    grad *= u;
+}
+
+template<class Dist>
+void UpperTruncatedDist<Dist>::initialize_truncation_param_derivs() const
+{
+    this->log_cdf_difference_param_grad_hess(static_cast<const Dist&>(*this), -INFINITY, ubound(), 
+                                             truncation_param_grad, truncation_param_hess);
+    //llh_truncation_const = -log(ubound_cdf)
+    truncation_param_grad = -truncation_param_grad;
+    truncation_param_hess = -truncation_param_hess;
+    truncation_param_derivs_initialized = true;
+}
+
 template<class Dist>
 template<class RngT>
 double UpperTruncatedDist<Dist>::sample(RngT &rng) const
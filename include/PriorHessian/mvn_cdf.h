@@ -9,9 +9,13 @@
 #define PRIOR_HESSIAN_MVN_CDF_H
 
 #include<iomanip>
+#include<sstream>
+#include<cstdint>
 
 #include<random>
 #include<cmath>
+#include<vector>
+#include<algorithm>
 
 #include "PriorHessian/util.h"
 
@@ -19,6 +23,15 @@ namespace prior_hessian {
 
 double unit_normal_cdf( double t );
 double unit_normal_icdf( double u );
+/** log of unit_normal_cdf, with full relative precision in both tails and no underflow for any finite t. */
+double unit_normal_logcdf( double t );
+/** Inverse of unit_normal_logcdf.  Valid where exp(log_u) underflows, so far lower tail quantiles keep full precision. */
+double unit_normal_log_icdf( double log_u );
+/** Probability of [a,b] under the unit normal.  Computed from the tail on the side of the interval, so there is no
+ * cancellation between probabilities near 1. */
+double unit_normal_interval_probability( double a, double b );
+/** log of unit_normal_interval_probability, which does not underflow for finite intervals in the far tails. */
+double unit_normal_log_interval_probability( double a, double b );
 
 double owen_t_integral(double h, double a, double gh);
 
@@ -31,6 +44,24 @@ double owen_t_integral(double h, double a)
 double owen_b_integral(double h,double k, double r);
 
 
+/** Batched unit_normal_cdf: out[i] = unit_normal_cdf(t[i]) for i < N.
+ * Vectorized across points.  Absolute error is below 3E-16, but in the far lower tail (t < -7) the relative error
+ * is up to 1E-8, so use unit_normal_cdf where the relative accuracy of tiny probabilities matters.
+ */
+void unit_normal_cdf_batch(IdxT N, const double *t, double *out);
+
+/** Batched owen_t_integral: T[i] = owen_t_integral(h[i], a[i], gh[i]) for i < N.
+ * 
+ * Owen's T is evaluated by fixed-order Gauss-Legendre quadrature, with no data-dependent branches, so the kernel is
+ * vectorized across points.  With GCC on x86-64 Linux the AVX-512, AVX2 or baseline version is chosen at run time.
+ */
+void owen_t_integral_batch(IdxT N, const double *h, const double *a, const double *gh, double *T);
+
+/** Batched unit bivariate normal cdf: out[i] = P(X < h[i], Y < k[i]) for unit normals with correlation r[i].
+ * Equivalent to owen_b_integral(h[i], k[i], r[i]) for i < N.
+ */
+void bvn_cdf_batch(IdxT N, const double *h, const double *k, const double *r, double *out);
+
 /** compute the upper-right tail of the bivariate normal distribution
  * computes the probability for two normal variates X and Y
  *    whose correlation is R, that AH <= X and AK <= Y.
@@ -75,94 +106,450 @@ double owen_bvn_cdf(const Vec &b, const Mat &sigma)
     return owen_b_integral(z0,z1,rho);
 }
 
-/** compute the multivariate normal cdf integral
- */    
+/** Bivariate normal cdf algorithms.  Auto selects the fastest method meeting a requested tolerance. */
+enum class BVNMethod { Auto, Owen, Donnelly, GaussLegendre };
+
+/** Default absolute tolerance for the bivariate normal cdf */
+const double bvn_cdf_default_tol = 1E-14;
+
+/** Fastest bivariate normal cdf method with absolute error below tol at (h,k,r).
+ *
+ * Regions are taken from benchmark/benchmark_bvn.cpp.  Donnelly is accurate to about 5E-16 everywhere and is
+ * the fastest method over most of the domain.  The fixed-order Gauss-Legendre kernel has a constant cost, so it is
+ * faster for max(|h|,|k|) >= 8 with |r| < 0.5, where the Donnelly series is slow to converge.  Owen's T series is
+ * accurate to only about 1E-11 and is no faster than Donnelly in any region, so it is never selected.
+ * If no method meets tol, the most accurate method (Donnelly) is returned.
+ */
+BVNMethod bvn_cdf_select_method(double h, double k, double r, double tol=bvn_cdf_default_tol);
+
+/** Unit bivariate normal cdf: P(X < h, Y < k) for unit normals with correlation r, using the given method.
+ * Infinite h and k are allowed.
+ */
+double bvn_cdf_integral(double h, double k, double r, BVNMethod method);
+
+/** Unit bivariate normal cdf, P(X < h, Y < k), with absolute error below tol */
+inline
+double bvn_cdf_integral(double h, double k, double r, double tol=bvn_cdf_default_tol)
+{
+    return bvn_cdf_integral(h,k,r,bvn_cdf_select_method(h,k,r,tol));
+}
+
+/** Bivariate normal cdf at b with covariance sigma, with absolute error below tol */
 template<class Vec, class Mat>
-double mc_mvn_integral(const Vec &a, const Vec &b, const Mat &U, double &error, int &niter)
+double bvn_cdf(const Vec &b, const Mat &sigma, double tol=bvn_cdf_default_tol)
 {
-    int Ndim = a.n_elem;
-    const int Nmax = 10000*Ndim;
-    const double eps = 1E-4;
-    const double alpha = 2.5;
-    double c = U(0,0);
-    double d1 = unit_normal_cdf(a(0)/c);
-    double e1 = unit_normal_cdf(b(0)/c);
-    double f1 = e1-d1;
-    double int_sum = 0.;
-    double var_sum = 0.;
-    VecT y(Ndim);
-    std::random_device R;
-    std::default_random_engine rng{R()};
-    std::uniform_real_distribution<double> uniform(0, 1);
-    VecT ys(Ndim-1);
-    
-    error = eps;
-    for(niter=0; niter<Nmax; niter++){
+    double s0 = sqrt(sigma(0,0));
+    double s1 = sqrt(sigma(1,1));
+    double rho = sigma(0,1)/(s0*s1);
+    return bvn_cdf_integral(b(0)/s0, b(1)/s1, rho, tol);
+}
+
+/** Unit trivariate normal cdf: P(X1 < h1, X2 < h2, X3 < h3) for unit normals with correlations r12, r13, r23.
+ *
+ * Deterministic.  The largest correlation is handled exactly by the bivariate cdf, and the other two by adaptive
+ * Gauss-Kronrod integration of Plackett's formula, following Genz's TVN algorithm.  Absolute error is below 1E-14
+ * in our tests.  Infinite limits are allowed.
+ *
+ * Reference:
+ *    Alan Genz,
+ *    Numerical computation of rectangular bivariate and trivariate normal and t probabilities,
+ *    Statistics and Computing,
+ *    2004, Volume 14, pages 251-260.
+ */
+double tvn_cdf_integral(double h1, double h2, double h3, double r12, double r13, double r23);
+
+/** Trivariate normal cdf at b with covariance sigma */
+template<class Vec, class Mat>
+double tvn_cdf(const Vec &b, const Mat &sigma)
+{
+    double s0 = sqrt(sigma(0,0));
+    double s1 = sqrt(sigma(1,1));
+    double s2 = sqrt(sigma(2,2));
+    return tvn_cdf_integral(b(0)/s0, b(1)/s1, b(2)/s2,
+                            sigma(0,1)/(s0*s1), sigma(0,2)/(s0*s2), sigma(1,2)/(s1*s2));
+}
+
+/** Trivariate normal probability of the rectangle [a,b] with covariance sigma.  Entries may be infinite.
+ *
+ * Deterministic, by inclusion-exclusion over the corners with tvn_cdf_integral.  The absolute error is below 1E-13,
+ * so the relative error is only small for probabilities well above that.
+ */
+template<class Vec, class Vec2, class Mat>
+double tvn_rectangle_probability(const Vec &a, const Vec2 &b, const Mat &sigma)
+{
+    double s[3] = {sqrt(sigma(0,0)), sqrt(sigma(1,1)), sqrt(sigma(2,2))};
+    double r12 = sigma(0,1)/(s[0]*s[1]);
+    double r13 = sigma(0,2)/(s[0]*s[2]);
+    double r23 = sigma(1,2)/(s[1]*s[2]);
+    double p = 0;
+    for(int corner=0; corner<8; corner++) { //Bit i set for the lower limit of variable i
+        double h[3];
+        int sign = 1;
+        for(int i=0; i<3; i++) {
+            if(corner & (1<<i)) {
+                h[i] = a(i)/s[i];
+                sign = -sign;
+            } else {
+                h[i] = b(i)/s[i];
+            }
+        }
+        if(h[0]==-INFINITY || h[1]==-INFINITY || h[2]==-INFINITY) continue;
+        p += sign*tvn_cdf_integral(h[0], h[1], h[2], r12, r13, r23);
+    }
+    return std::min(std::max(p,0.),1.);
+}
+
+/** Bivariate normal cdf of each column of b [2xN] with covariance sigma */
+template<class Mat, class Mat2>
+VecT owen_bvn_cdf_batch(const Mat &b, const Mat2 &sigma)
+{
+    if(b.n_rows != 2) {
+        std::ostringstream msg;
+        msg<<"owen_bvn_cdf_batch: Got b with "<<b.n_rows<<" rows.  Expected 2.";
+        throw ParameterSizeError(msg.str());
+    }
+    IdxT N = b.n_cols;
+    double s0 = sqrt(sigma(0,0));
+    double s1 = sqrt(sigma(1,1));
+    double rho = sigma(0,1)/(s0*s1);
+    VecT z0 = b.row(0).t()/s0;
+    VecT z1 = b.row(1).t()/s1;
+    VecT r(N);
+    r.fill(rho);
+    VecT out(N);
+    bvn_cdf_batch(N, z0.memptr(), z1.memptr(), r.memptr(), out.memptr());
+    return out;
+}
+
+/** Number of precomputed Korobov rank-1 lattice rules */
+IdxT korobov_lattice_num_rules();
+
+/** Korobov rank-1 lattice rule r, for r < korobov_lattice_num_rules().
+ * The rule has n points (n prime) and generating vector z = (1, gen, gen^2, ...) mod n.
+ * Rules increase in size by a factor of about 1.5 with r.
+ */
+void korobov_lattice_rule(IdxT r, std::uint64_t &n, std::uint64_t &gen);
+
+/** Reusable buffers for lattice_integral and monte_carlo_integral, so repeated integrals do not allocate. */
+struct IntegralWorkspace {
+    std::vector<std::uint64_t> z, kz;
+    std::vector<double> shift, w, shift_values;
+};
+
+/** Randomized quasi-Monte Carlo integral of f over the unit hypercube [0,1]^Ndim.
+ *
+ * Evaluates a sequence of Korobov lattice rules of increasing size, each with several independent random shifts and 
+ * the baker's (tent) transform.  The spread over the shifts gives the error estimate.  The value and error are those
+ * of the last, largest rule, as weighting in the smaller rules lets those that underestimate their variance dominate.
+ * For smooth integrands the error decreases nearly as O(1/n),
+ * compared to O(1/sqrt(n)) for monte_carlo_integral.
+ * 
+ * f - callable as f(const double *w) for w in [0,1]^Ndim
+ * maxpts - maximum number of evaluations of f.  The first rule is always evaluated.
+ * abseps, releps - stop once error <= max(abseps, releps*|value|)
+ * antithetic - also evaluate f(1-w) for each point w
+ * rng - source of the random shifts
+ * error [out] - estimated absolute error, at a 99% confidence level.
+ * nevals [out] - number of evaluations of f
+ * converged [out] - true if the error tolerance was met
+ * ws - workspace
+ */
+template<class Func, class RngT>
+double lattice_integral(IdxT Ndim, Func &&f, IdxT maxpts, double abseps, double releps, bool antithetic, RngT &rng,
+                        double &error, IdxT &nevals, bool &converged, IntegralWorkspace &ws)
+{
+    const IdxT Nshifts = 8; //Random shifts of each lattice for the error estimate
+    const double alpha = 3.5; //99% two-sided t quantile with Nshifts-1 degrees of freedom
+    const IdxT Nrules = korobov_lattice_num_rules();
+    const IdxT evals_per_point = antithetic ? 2 : 1;
+    error = 0;
+    nevals = 0;
+    converged = true;
+    if(Ndim == 0) { //Constant integrand
+        nevals = 1;
+        return f(nullptr);
+    }
+    converged = false;
+    std::uniform_real_distribution<double> uniform(0,1);
+    auto &z = ws.z;
+    auto &kz = ws.kz;
+    auto &shift = ws.shift;
+    auto &w = ws.w;
+    auto &shift_values = ws.shift_values;
+    z.resize(Ndim);
+    kz.resize(Ndim);
+    shift.resize(Ndim);
+    w.resize(Ndim);
+    shift_values.resize(Nshifts);
+    double value = 0;
+    for(IdxT r=0; r<Nrules; r++) {
+        std::uint64_t n, gen;
+        korobov_lattice_rule(r, n, gen);
+        if(r>0 && nevals + evals_per_point*Nshifts*n > maxpts) break;
+        z[0] = 1;
+        for(IdxT j=1; j<Ndim; j++) z[j] = (z[j-1]*gen) % n;
+        for(IdxT m=0; m<Nshifts; m++) {
+            for(IdxT j=0; j<Ndim; j++) {
+                shift[j] = uniform(rng);
+                kz[j] = 0;
+            }
+            double sum = 0;
+            for(std::uint64_t k=0; k<n; k++) {
+                for(IdxT j=0; j<Ndim; j++) {
+                    double t = static_cast<double>(kz[j])/n + shift[j];
+                    if(t >= 1) t -= 1;
+                    w[j] = std::fabs(2*t-1);
+                    kz[j] += z[j];
+                    if(kz[j] >= n) kz[j] -= n;
+                }
+                sum += f(w.data());
+                if(antithetic) {
+                    for(IdxT j=0; j<Ndim; j++) w[j] = 1-w[j];
+                    sum += f(w.data());
+                }
+            }
+            shift_values[m] = sum/(evals_per_point*n);
+        }
+        nevals += evals_per_point*Nshifts*n;
+        double mean = 0;
+        for(auto v: shift_values) mean += v;
+        mean /= Nshifts;
+        double var = 0;
+        for(auto v: shift_values) var += (v-mean)*(v-mean);
+        var /= Nshifts*(Nshifts-1); //Variance of the mean
+        value = mean;
+        error = alpha*std::sqrt(var);
+        if(error <= std::max(abseps, releps*std::fabs(value))) {
+            converged = true;
+            break;
+        }
+    }
+    return value;
+}
+
+template<class Func, class RngT>
+double lattice_integral(IdxT Ndim, Func &&f, IdxT maxpts, double abseps, double releps, bool antithetic, RngT &rng,
+                        double &error, IdxT &nevals, bool &converged)
+{
+    IntegralWorkspace ws;
+    return lattice_integral(Ndim, f, maxpts, abseps, releps, antithetic, rng, error, nevals, converged, ws);
+}
+
+/** Plain Monte Carlo integral of f over the unit hypercube [0,1]^Ndim.
+ * 
+ * Arguments are as for lattice_integral.  With antithetic=true each sample is the average of f(w) and f(1-w).
+ */
+template<class Func, class RngT>
+double monte_carlo_integral(IdxT Ndim, Func &&f, IdxT maxpts, double abseps, double releps, bool antithetic, RngT &rng,
+                            double &error, IdxT &nevals, bool &converged, IntegralWorkspace &ws)
+{
+    const IdxT Nmin = 16; //Minimum samples before the error estimate is trusted
+    const double alpha = 2.576; //99% two-sided normal quantile, as the mean of many samples is nearly normal
+    const IdxT evals_per_sample = antithetic ? 2 : 1;
+    error = 0;
+    nevals = 0;
+    converged = true;
+    if(Ndim == 0) { //Constant integrand
+        nevals = 1;
+        return f(nullptr);
+    }
+    converged = false;
+    error = INFINITY;
+    std::uniform_real_distribution<double> uniform(0,1);
+    auto &w = ws.w;
+    w.resize(Ndim);
+    double mean = 0;
+    double m2 = 0; //Running sum of squared deviations
+    IdxT n = 0;
+    while(n==0 || nevals + evals_per_sample <= maxpts) {
+        for(IdxT j=0; j<Ndim; j++) w[j] = uniform(rng);
+        double val = f(w.data());
+        if(antithetic) {
+            for(IdxT j=0; j<Ndim; j++) w[j] = 1-w[j];
+            val = .5*(val + f(w.data()));
+        }
+        nevals += evals_per_sample;
+        n++;
+        double delta = val-mean;
+        mean += delta/n;
+        m2 += delta*(val-mean);
+        if(n>1) error = alpha*std::sqrt(m2/((n-1)*n));
+        if(n>=Nmin && error <= std::max(abseps, releps*std::fabs(mean))) {
+            converged = true;
+            break;
+        }
+    }
+    return mean;
+}
+
+template<class Func, class RngT>
+double monte_carlo_integral(IdxT Ndim, Func &&f, IdxT maxpts, double abseps, double releps, bool antithetic, RngT &rng,
+                            double &error, IdxT &nevals, bool &converged)
+{
+    IntegralWorkspace ws;
+    return monte_carlo_integral(Ndim, f, maxpts, abseps, releps, antithetic, rng, error, nevals, converged, ws);
+}
+
+/** Sampling methods for the Monte Carlo multivariate normal integrals.
+ * PseudoRandom - independent uniform samples
+ * Lattice - randomly shifted Korobov lattice rules (see lattice_integral)
+ */
+enum class MCSampling { PseudoRandom, Lattice };
+
+/** Controls for mc_mvn_integral and mc_mvn_cdf_core.
+ * The defaults select lattice sampling.  The overloads without options keep their original plain pseudo-random
+ * sampling.
+ * maxpts - maximum number of integrand evaluations
+ * eps - absolute error tolerance
+ */
+struct MCMVNOptions {
+    MCSampling sampling = MCSampling::Lattice;
+    bool antithetic = true;
+    IdxT maxpts = 100000;
+    double eps = 1E-5;
+};
+
+/** Reusable storage for mc_mvn_integral, mc_mvn_cdf_core, and mc_mvn_cdf. */
+struct MCMVNWorkspace {
+    VecT ys;
+    MatT U; //Cholesky factor computed by mc_mvn_cdf
+    IntegralWorkspace integral;
+};
+
+template<class Func, class RngT>
+double mc_mvn_integrate(IdxT Ndim, Func &&f, const MCMVNOptions &opts, RngT &rng, IntegralWorkspace &ws,
+                        double &error, int &niter)
+{
+    IdxT nevals;
+    bool converged;
+    double val;
+    if(opts.sampling == MCSampling::Lattice) {
+        val = lattice_integral(Ndim, f, opts.maxpts, opts.eps, 0, opts.antithetic, rng, error, nevals, converged, ws);
+    } else {
+        val = monte_carlo_integral(Ndim, f, opts.maxpts, opts.eps, 0, opts.antithetic, rng, error, nevals, converged, ws);
+    }
+    niter = static_cast<int>(nevals);
+    return val;
+}
+
+/** compute the multivariate normal integral over the rectangle [a,b] by separation of variables
+ * U - upper Cholesky factor of the covariance
+ * rng - random number generator.  Results are reproducible for a given rng state.
+ * ws - workspace, which may be reused across calls to avoid allocations
+ */    
+template<class Vec, class Mat, class RngT>
+double mc_mvn_integral(const Vec &a, const Vec &b, const Mat &U, double &error, int &niter, const MCMVNOptions &opts,
+                       RngT &rng, MCMVNWorkspace &ws)
+{
+    IdxT Ndim = a.n_elem;
+    double d1 = unit_normal_cdf(a(0)/U(0,0));
+    double e1 = unit_normal_cdf(b(0)/U(0,0));
+    VecT &ys = ws.ys;
+    ys.set_size(Ndim);
+    auto integrand = [&](const double *w) {
         double d = d1;
         double e = e1;
-        double f = f1;
-        for(int i=1; i<Ndim; i++){
-            c = U(i,i);
-            ys(i-1) = unit_normal_icdf(d+uniform(rng)*(e-d));
+        double f = e1-d1;
+        for(IdxT i=1; i<Ndim; i++){
+            double c = U(i,i);
+            ys(i-1) = unit_normal_icdf(d+w[i-1]*(e-d));
             double q = 0;
-            for(int k=0; k<i; k++) q+=ys(k)*U(k,i);
+            for(IdxT k=0; k<i; k++) q+=ys(k)*U(k,i);
             d = unit_normal_cdf((a(i)-q)/c);
             e = unit_normal_cdf((b(i)-q)/c);
             f *= (e-d);
         }
-        double delta = (f-int_sum)/(niter+1);
-        int_sum += delta;
-        var_sum = (niter-1)*var_sum/(niter+1) + delta*delta;
-        error = alpha * sqrt(var_sum);
-        if(error < eps) break;
-    }
-    return int_sum;
+        return f;
+    };
+    return mc_mvn_integrate(Ndim-1, integrand, opts, rng, ws.integral, error, niter);
 }
 
+template<class Vec, class Mat>
+double mc_mvn_integral(const Vec &a, const Vec &b, const Mat &U, double &error, int &niter, const MCMVNOptions &opts)
+{
+    std::random_device R;
+    std::default_random_engine rng{R()};
+    MCMVNWorkspace ws;
+    return mc_mvn_integral(a,b,U,error,niter,opts,rng,ws);
+}
 
+/* Legacy overload: plain pseudo-random sampling, as before MCMVNOptions.  Pass options for lattice sampling. */
+template<class Vec, class Mat>
+double mc_mvn_integral(const Vec &a, const Vec &b, const Mat &U, double &error, int &niter)
+{
+    MCMVNOptions opts;
+    opts.sampling = MCSampling::PseudoRandom;
+    opts.antithetic = false;
+    opts.maxpts = 10000*a.n_elem;
+    opts.eps = 1E-4;
+    return mc_mvn_integral(a,b,U,error,niter,opts);
+}
 
 /**
  * 
  * For the cdf a=-Infinity, so d=0.
  * 
  */
-template<class Vec, class Mat>
-double mc_mvn_cdf_core(const Vec &b, const Mat &U, double &error, int &niter)
+template<class Vec, class Mat, class RngT>
+double mc_mvn_cdf_core(const Vec &b, const Mat &U, double &error, int &niter, const MCMVNOptions &opts,
+                       RngT &rng, MCMVNWorkspace &ws)
 {
-    int Ndim = b.n_elem;
-    const int Nmax = 1000*Ndim;
-    const double eps = 1E-5;
-    const double alpha = 2.5;
-    double c = U(0,0);
-    //double d1 = 0;
-    double e1 = unit_normal_cdf(b(0)/c);
-    double f1 = e1;
-    double int_sum = 0.;
-    double var_sum = 0.;
-    VecT y(Ndim);
-    std::random_device R;
-    std::default_random_engine rng{R()};
-    std::uniform_real_distribution<double> uniform(0, 1);
-    VecT ys(Ndim-1);
-    error = eps;
-    for(niter=0; niter<Nmax; niter++){
+    IdxT Ndim = b.n_elem;
+    double e1 = unit_normal_cdf(b(0)/U(0,0));
+    VecT &ys = ws.ys;
+    ys.set_size(Ndim);
+    auto integrand = [&](const double *w) {
         double e = e1;
-        double f = f1;
-        for(int i=1; i<Ndim; i++){
-            c = U(i,i);
-            ys(i-1) = unit_normal_icdf(uniform(rng)*e);
+        double f = e1;
+        for(IdxT i=1; i<Ndim; i++){
+            double c = U(i,i);
+            ys(i-1) = unit_normal_icdf(w[i-1]*e);
             double q = 0;
-            for(int k=0; k<i; k++) q+=ys(k)*U(k,i);
+            for(IdxT k=0; k<i; k++) q+=ys(k)*U(k,i);
             e = unit_normal_cdf((b(i)-q)/c);
             f *= e;
         }
-        double delta = (f-int_sum)/(niter+1);
-        int_sum += delta;
-        var_sum = (niter-1)*var_sum/(niter+1) + delta*delta;
-        error = alpha * sqrt(var_sum);
-        if(error < eps) break;
-    }
-    return int_sum;
+        return f;
+    };
+    return mc_mvn_integrate(Ndim-1, integrand, opts, rng, ws.integral, error, niter);
+}
+
+template<class Vec, class Mat>
+double mc_mvn_cdf_core(const Vec &b, const Mat &U, double &error, int &niter, const MCMVNOptions &opts)
+{
+    std::random_device R;
+    std::default_random_engine rng{R()};
+    MCMVNWorkspace ws;
+    return mc_mvn_cdf_core(b,U,error,niter,opts,rng,ws);
+}
+
+/* Legacy overload: plain pseudo-random sampling, as before MCMVNOptions.  Pass options for lattice sampling. */
+template<class Vec, class Mat>
+double mc_mvn_cdf_core(const Vec &b, const Mat &U, double &error, int &niter)
+{
+    MCMVNOptions opts;
+    opts.sampling = MCSampling::PseudoRandom;
+    opts.antithetic = false;
+    opts.maxpts = 1000*b.n_elem;
+    return mc_mvn_cdf_core(b,U,error,niter,opts);
+}
+
+/* The Cholesky factor is computed into ws.U, so repeated calls of the same dimension do not allocate */
+template<class Vec, class Mat, class RngT>
+double mc_mvn_cdf(const Vec &b, const Mat &S, double &error, const MCMVNOptions &opts, RngT &rng, MCMVNWorkspace &ws)
+{
+    if(!arma::chol(ws.U,S)) throw ParameterValueError("mc_mvn_cdf: S is not positive definite.");
+    int niter;
+    return mc_mvn_cdf_core(b,ws.U,error,niter,opts,rng,ws);
+}
+
+template<class Vec, class Mat>
+double mc_mvn_cdf(const Vec &b, const Mat &S, double &error, const MCMVNOptions &opts)
+{
+    std::random_device R;
+    std::default_random_engine rng{R()};
+    MCMVNWorkspace ws;
+    return mc_mvn_cdf(b,S,error,opts,rng,ws);
 }
 
 template<class Vec, class Mat>
@@ -175,69 +562,101 @@ double mc_mvn_cdf(const Vec &b, const Mat &S, double &error)
 
 namespace genz
 {
-    namespace fortran {
-        //Genz fortran code interface declaration
-        /*
-        *  Parameters
-        *     N      INTEGER, the number of variables.
-        *     LOWER  REAL, array of lower integration limits.
-        *     UPPER  REAL, array of upper integration limits.
-        *     INFIN  INTEGER, array of integration limits flags:
-        *            if INFIN(I) < 0, Ith limits are (-infinity, infinity);
-        *            if INFIN(I) = 0, Ith limits are (-infinity, UPPER(I)];
-        *            if INFIN(I) = 1, Ith limits are [LOWER(I), infinity);
-        *            if INFIN(I) = 2, Ith limits are [LOWER(I), UPPER(I)].
-        *     CORREL REAL, array of correlation coefficients; the correlation
-        *            coefficient in row I column J of the correlation matrix
-        *            should be stored in CORREL( J + ((I-2)*(I-1))/2 ), for J < I.
-        *            THe correlation matrix must be positive semidefinite.
-        *     MAXPTS INTEGER, maximum number of function values allowed. This 
-        *            parameter can be used to limit the time. A sensible 
-        *            strategy is to start with MAXPTS = 1000*N, and then
-        *            increase MAXPTS if ERROR is too large.
-        *     ABSEPS REAL absolute error tolerance.
-        *     RELEPS REAL relative error tolerance.
-        *     ERROR  REAL estimated absolute error, with 99% confidence level.
-        *     VALUE  REAL estimated value for the integral
-        *     INFORM INTEGER, termination status parameter:
-        *            if INFORM = 0, normal completion with ERROR < EPS;
-        *            if INFORM = 1, completion with ERROR > EPS and MAXPTS 
-        *                           function vaules used; increase MAXPTS to 
-        *                           decrease ERROR;
-        *            if INFORM = 2, N > 500 or N < 1.
-        */
-        extern "C" 
-        int mvndst_(int *n, double lower[], double upper[],
-            int infin[], double correl[], int *maxpts, double *abseps, double *releps, 
-            double *error, double *value, int *inform);
-    }
+    /** Controls for the Genz integrator.
+     * maxpts - maximum number of integrand evaluations.  The first lattice rule is always evaluated.
+     * abseps, releps - absolute and relative error tolerances.
+     * seed - seed for the random lattice shifts.  The same seed gives the same result.
+     */
+    struct MVNIntegralOptions {
+        IdxT maxpts = 10000;
+        double abseps = 1E-5;
+        double releps = 1E-5;
+        std::uint64_t seed = 0;
+    };
+
+    /** Integral of a zero-mean multivariate normal over the rectangle [lower, upper].
+     *
+     * C++ implementation of the separation-of-variables algorithm of Genz's MVNDST, with variable prioritization and
+     * randomized Korobov lattice rules.  All state is local to the call, so it is safe to call concurrently.
+     * Dimensions with (-inf,inf) limits are dropped, and 1D and 2D problems are computed exactly.
+     *
+     * N - number of dimensions
+     * lower - lower limits, which may be -INFINITY.  If nullptr all lower limits are -INFINITY.
+     * upper - upper limits, which may be INFINITY.
+     * sigma - column-major NxN positive-definite covariance matrix.  No normalization to a correlation matrix is needed.
+     * opts - integration controls
+     * error [out] - estimated absolute error, at a 99% confidence level.
+     * inform [out] - termination status, as for MVNDST:
+     *      inform = 0, normal completion with error < max(abseps, releps*value);
+     *      inform = 1, completion with error > max(abseps, releps*value) after maxpts evaluations;
+     *      inform = 2, N < 1.
+     */
+    double mvn_integral(IdxT N, const double *lower, const double *upper, const double *sigma, 
+                        const MVNIntegralOptions &opts, double &error, int &inform);
+
+    /** log of mvn_integral, which does not underflow for rectangles in the far tails.  With a single limited variable
+     * the integral is computed directly in log space.  With more, tiny integrals are recomputed with the integrand
+     * divided by its value at the center of the unit cube, and each conditional probability in log space.
+     * error and inform are as for mvn_integral.
+     */
+    double log_mvn_integral(IdxT N, const double *lower, const double *upper, const double *sigma, 
+                            const MVNIntegralOptions &opts, double &error, int &inform);
 
     // S = sigma covariamce matrix
+    template<class Vec, class Mat>
+    double mvn_cdf_genz(const Vec &b, const Mat &S, double &error, int &inform, const MVNIntegralOptions &opts)
+    {
+        const VecT upper(b);
+        const MatT sigma(S);
+        if(sigma.n_rows != upper.n_elem || sigma.n_cols != upper.n_elem) {
+            std::ostringstream msg;
+            msg<<"mvn_cdf_genz: Got b of size: "<<upper.n_elem<<" and S of size: ["<<sigma.n_rows<<","<<sigma.n_cols<<"]";
+            throw ParameterSizeError(msg.str());
+        }
+        return mvn_integral(upper.n_elem, nullptr, upper.memptr(), sigma.memptr(), opts, error, inform);
+    }
+
     template<class Vec, class Mat>
     double mvn_cdf_genz(const Vec &b, const Mat &S, double &error)
     {
-        int maxpts = 10000;
-        double abseps = 1E-5;
-        double releps = 1E-5;
-        int N = b.n_elem;
-        VecT lower(N);
-        lower.fill(-INFINITY);
-        VecT s = arma::sqrt(S.diag());
-    
-        MatT U = S / (s*s.t());
-        VecT upper = b / s;
-        //Fill correlation matrix while normalizing each column by the sigma on diagonal of U.
-        VecT correl(N*(N-1)/2);
-        int k=0;
-        for(int j=1; j<N; j++) for(int i=0; i<j; i++) correl(k++) = U(i,j);
-        arma::Col<int> infin(N,arma::fill::zeros); // infin(i) = 0 implies (-inf, upper(i)] bounds.
-        double value;
-        int inform=-1;
-        fortran::mvndst_(&N, lower.memptr(), upper.memptr(), infin.memptr(), correl.memptr(), &maxpts, &abseps, &releps, &error, &value, &inform);
-        return std::min(std::max(value,0.),1.);
+        int inform;
+        return mvn_cdf_genz(b, S, error, inform, MVNIntegralOptions{});
     }
 
-} /* namespace prior_hessian::gentz */
+    /* Integral over the rectangle [a,b], where entries of a and b may be infinite. */
+    template<class Vec, class Mat>
+    double mvn_integral_genz(const Vec &a, const Vec &b, const Mat &S, double &error, int &inform, 
+                             const MVNIntegralOptions &opts = MVNIntegralOptions{})
+    {
+        const VecT lower(a);
+        const VecT upper(b);
+        const MatT sigma(S);
+        if(lower.n_elem != upper.n_elem || sigma.n_rows != upper.n_elem || sigma.n_cols != upper.n_elem) {
+            std::ostringstream msg;
+            msg<<"mvn_integral_genz: Got a of size: "<<lower.n_elem<<" b of size: "<<upper.n_elem
+               <<" and S of size: ["<<sigma.n_rows<<","<<sigma.n_cols<<"]";
+            throw ParameterSizeError(msg.str());
+        }
+        return mvn_integral(upper.n_elem, lower.memptr(), upper.memptr(), sigma.memptr(), opts, error, inform);
+    }
+
+    /* log of the integral over the rectangle [a,b], where entries of a and b may be infinite. */
+    template<class Vec, class Mat>
+    double log_mvn_integral_genz(const Vec &a, const Vec &b, const Mat &S, double &error, int &inform, 
+                                 const MVNIntegralOptions &opts = MVNIntegralOptions{})
+    {
+        const VecT lower(a);
+        const VecT upper(b);
+        const MatT sigma(S);
+        if(lower.n_elem != upper.n_elem || sigma.n_rows != upper.n_elem || sigma.n_cols != upper.n_elem) {
+            std::ostringstream msg;
+            msg<<"log_mvn_integral_genz: Got a of size: "<<lower.n_elem<<" b of size: "<<upper.n_elem
+               <<" and S of size: ["<<sigma.n_rows<<","<<sigma.n_cols<<"]";
+            throw ParameterSizeError(msg.str());
+        }
+        return log_mvn_integral(upper.n_elem, lower.memptr(), upper.memptr(), sigma.memptr(), opts, error, inform);
+    }
+} /* namespace prior_hessian::genz */
 
 } /* namespace prior_hessian */
 
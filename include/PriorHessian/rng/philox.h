@@ -0,0 +1,151 @@
+/** @file rng/philox.h
+ * @author Mark J. Olah (mjo\@cs.unm.edu)
+ * @date 2019
+ * @brief A counter-based random number engine (Philox4x64-10)
+ *
+ * Philox4x64-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", SC11) computes each block of four
+ * 64-bit outputs as a keyed bijection of a 256-bit counter.  There is no sequential state, so any position of any stream
+ * can be reached in O(1), and independent streams are just different keys or counters.
+ *
+ * Here the key is (seed, stream) and the counter is (block, substream, 0, 0).  The engine satisfies the
+ * UniformRandomBitGenerator and RandomNumberEngine requirements, and gives the full 64-bit range, so it can be used
+ * with AnyRng and BufferedRng.
+ */
+#ifndef _PRIOR_HESSIAN_RNG_PHILOX_H
+#define _PRIOR_HESSIAN_RNG_PHILOX_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <type_traits>
+
+namespace prior_hessian {
+
+namespace rng {
+
+class philox4x64
+{
+public:
+    using result_type = std::uint64_t;
+    static constexpr std::size_t outputs_per_block = 4;
+    static constexpr result_type default_seed = 0;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    philox4x64() : philox4x64(default_seed) { }
+    explicit philox4x64(result_type seed, result_type stream=0, result_type substream=0)
+        : key{{seed,stream}}, block(0), substream_id(substream), pos(outputs_per_block) { }
+
+    /* Seed from a seed sequence, such as std::seed_seq, which gives the seed and the stream */
+    template<class SeedSeq, class=typename std::enable_if<!std::is_convertible<SeedSeq,result_type>::value &&
+                                                          !std::is_same<SeedSeq,philox4x64>::value>::type>
+    explicit philox4x64(SeedSeq &q) : philox4x64(0) { seed(q); }
+
+    void seed(result_type seed=default_seed) { *this = philox4x64(seed, stream(), substream()); }
+    template<class SeedSeq, class=typename std::enable_if<!std::is_convertible<SeedSeq,result_type>::value>::type>
+    void seed(SeedSeq &q)
+    {
+        std::array<std::uint_least32_t,4> words;
+        q.generate(words.begin(), words.end());
+        *this = philox4x64(static_cast<result_type>(words[0]) | static_cast<result_type>(words[1])<<32,
+                           static_cast<result_type>(words[2]) | static_cast<result_type>(words[3])<<32);
+    }
+
+    result_type stream() const { return key[1]; }
+    result_type substream() const { return substream_id; }
+    /* Number of outputs drawn so far in the current (stream, substream) */
+    result_type position() const { return pos==outputs_per_block ? block*outputs_per_block : (block-1)*outputs_per_block + pos; }
+
+    /* Move to the start of another stream or substream with the same seed */
+    void set_stream(result_type stream, result_type substream=0) { *this = philox4x64(key[0], stream, substream); }
+    void set_substream(result_type substream) { *this = philox4x64(key[0], stream(), substream); }
+
+    result_type operator()()
+    {
+        if(pos==outputs_per_block) {
+            output = generate_block(key, {{block, substream_id, 0, 0}});
+            block++;
+            pos = 0;
+        }
+        return output[pos++];
+    }
+
+    /* O(1) skip-ahead */
+    void discard(unsigned long long z)
+    {
+        result_type p = position() + z;
+        block = p/outputs_per_block;
+        pos = outputs_per_block;
+        if(p%outputs_per_block) {
+            (*this)(); //Generate the partial block
+            pos = p%outputs_per_block;
+        }
+    }
+
+    friend bool operator==(const philox4x64 &a, const philox4x64 &b)
+    { return a.key==b.key && a.substream_id==b.substream_id && a.position()==b.position(); }
+    friend bool operator!=(const philox4x64 &a, const philox4x64 &b) { return !(a==b); }
+
+    friend std::ostream& operator<<(std::ostream &out, const philox4x64 &r)
+    { return out<<r.key[0]<<' '<<r.key[1]<<' '<<r.substream_id<<' '<<r.position(); }
+
+    friend std::istream& operator>>(std::istream &in, philox4x64 &r)
+    {
+        result_type seed, stream, substream, position;
+        if(in>>seed>>stream>>substream>>position) {
+            r = philox4x64(seed,stream,substream);
+            r.discard(position);
+        }
+        return in;
+    }
+
+    using CounterT = std::array<result_type,4>;
+    using KeyT = std::array<result_type,2>;
+    /* The Philox4x64-10 bijection.  Exposed for known-answer testing. */
+    static CounterT generate_block(KeyT k, CounterT c)
+    {
+        for(int round=0; round<10; round++) {
+            if(round>0) {
+                k[0] += 0x9E3779B97F4A7C15ULL;
+                k[1] += 0xBB67AE8584CAA73BULL;
+            }
+            result_type hi0, hi1;
+            result_type lo0 = mulhilo(0xD2E7470EE14C6C93ULL, c[0], hi0);
+            result_type lo1 = mulhilo(0xCA5A826395121157ULL, c[2], hi1);
+            c = {{hi1^c[1]^k[0], lo1, hi0^c[3]^k[1], lo0}};
+        }
+        return c;
+    }
+
+private:
+    KeyT key;
+    result_type block; //Index of the next block to generate
+    result_type substream_id;
+    std::size_t pos; //Position in output.  outputs_per_block if output is not yet generated
+    CounterT output;
+
+    static result_type mulhilo(result_type a, result_type b, result_type &hi)
+    {
+#ifdef __SIZEOF_INT128__
+        unsigned __int128 p = static_cast<unsigned __int128>(a)*b;
+        hi = static_cast<result_type>(p>>64);
+        return static_cast<result_type>(p);
+#else
+        const result_type mask = 0xFFFFFFFFULL;
+        result_type a0 = a&mask, a1 = a>>32, b0 = b&mask, b1 = b>>32;
+        result_type p00 = a0*b0, p01 = a0*b1, p10 = a1*b0, p11 = a1*b1;
+        result_type mid = (p00>>32) + (p01&mask) + (p10&mask);
+        hi = p11 + (p01>>32) + (p10>>32) + (mid>>32);
+        return a*b;
+#endif
+    }
+};
+
+} /* namespace prior_hessian::rng */
+
+} /* namespace prior_hessian */
+
+#endif /* _PRIOR_HESSIAN_RNG_PHILOX_H */
@@ -13,6 +13,7 @@
 #include<random>
 #include<vector>
 #include<typeindex>
+#include<utility>
 
 #include<armadillo>
 
@@ -29,6 +30,7 @@ using IdxT = arma::uword;
 using UVecT = arma::Col<IdxT>;
 using VecT = arma::Col<double>;
 using MatT = arma::Mat<double>;
+using CubeT = arma::Cube<double>;
 using StringVecT = std::vector<std::string>; 
 using TypeInfoVecT = std::vector<std::type_index>;
     
@@ -38,6 +40,7 @@ namespace constants {
     extern const double sqrt2pi;
     extern const double sqrt2pi_inv;
     extern const double log2pi;
+    extern const double ln2;
 } /* namespace prior_hessian::constants */
 
 template<class T>
@@ -46,6 +49,30 @@ T square(T t)
     return t*t;
 }
 
+/** log(1-exp(x)) for x <= 0.  Switches between expm1 and log1p at -log(2) to keep full precision (Maechler, 2012). */
+inline
+double log1mexp(double x)
+{
+    return x > -constants::ln2 ? std::log(-std::expm1(x)) : std::log1p(-std::exp(x));
+}
+
+/** log(exp(a)-exp(b)) for a >= b, without forming exp(a) or exp(b) */
+inline
+double log_diff_exp(double a, double b)
+{
+    if(a == -INFINITY) return -INFINITY;
+    return a + log1mexp(b-a);
+}
+
+/** log(exp(a)+exp(b)), without forming exp(a) or exp(b) */
+inline
+double log_sum_exp(double a, double b)
+{
+    if(a < b) std::swap(a,b);
+    if(a == -INFINITY) return -INFINITY;
+    return a + std::log1p(std::exp(b-a));
+}
+
 
 } /* namespace prior_hessian */
 
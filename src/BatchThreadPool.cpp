@@ -0,0 +1,74 @@
+/** @file BatchThreadPool.cpp
+ * @author Mark J. Olah (mjo\@cs.unm DOT edu)
+ * @date 2019
+ * @brief BatchThreadPool class definitions
+ *
+ */
+
+#include "PriorHessian/BatchThreadPool.h"
+
+namespace prior_hessian {
+
+BatchThreadPool& BatchThreadPool::instance()
+{
+    static BatchThreadPool pool;
+    return pool;
+}
+
+BatchThreadPool::~BatchThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    start_cv.notify_all();
+    for(auto &worker: workers) worker.join();
+}
+
+IdxT BatchThreadPool::num_workers() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<IdxT>(workers.size());
+}
+
+void BatchThreadPool::run(IdxT nthreads, const std::function<void(IdxT)> &f)
+{
+    std::unique_lock<std::mutex> run_lock(run_mutex, std::try_to_lock);
+    if(nthreads <= 1 || !run_lock.owns_lock()) {
+        for(IdxT t=0; t<nthreads; t++) f(t);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        //New workers start at the current generation, so they join the run started below
+        for(IdxT t = static_cast<IdxT>(workers.size())+1; t<nthreads; t++)
+            workers.emplace_back(&BatchThreadPool::worker_loop, this, t, generation);
+        task = &f;
+        task_nthreads = nthreads;
+        num_pending = nthreads-1;
+        generation++;
+    }
+    start_cv.notify_all();
+    f(0);
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [&]{ return num_pending == 0; });
+    task = nullptr;
+}
+
+void BatchThreadPool::worker_loop(IdxT t, std::uint64_t seen_generation)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while(true) {
+        start_cv.wait(lock, [&]{ return stopping || generation != seen_generation; });
+        if(stopping) return;
+        seen_generation = generation;
+        if(t >= task_nthreads) continue; //Not needed for this run
+        const std::function<void(IdxT)> &f = *task;
+        lock.unlock();
+        f(t);
+        lock.lock();
+        if(--num_pending == 0) done_cv.notify_one();
+    }
+}
+
+} /* namespace prior_hessian */
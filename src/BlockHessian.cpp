@@ -0,0 +1,133 @@
+/** @file BlockHessian.cpp
+ * @author Mark J. Olah (mjo\@cs.unm DOT edu)
+ * @date 2019
+ * @brief BlockHessian class definitions
+ *
+ */
+
+#include "PriorHessian/BlockHessian.h"
+
+#include<sstream>
+#include<cmath>
+
+namespace prior_hessian {
+
+BlockHessian::BlockHessian(const UVecT &block_sizes)
+    : _num_dim(arma::accu(block_sizes)),
+      _block_sizes(block_sizes),
+      _block_offsets(block_sizes.n_elem),
+      _blocks(block_sizes.n_elem)
+{
+    IdxT offset = 0;
+    for(IdxT i=0; i<block_sizes.n_elem; i++) {
+        _block_offsets(i) = offset;
+        offset += block_sizes(i);
+        _blocks[i].zeros(block_sizes(i),block_sizes(i));
+    }
+}
+
+void BlockHessian::zeros()
+{
+    for(auto &B: _blocks) B.zeros();
+}
+
+MatT BlockHessian::to_dense() const
+{
+    MatT H(_num_dim,_num_dim,arma::fill::zeros);
+    for(IdxT i=0; i<num_blocks(); i++) {
+        IdxT k = _block_offsets(i);
+        IdxT n = _block_sizes(i);
+        H.submat(k,k,k+n-1,k+n-1) = arma::symmatu(_blocks[i]);
+    }
+    return H;
+}
+
+arma::sp_mat BlockHessian::to_sp_mat() const
+{
+    IdxT nnz = arma::accu(arma::square(_block_sizes));
+    arma::umat locations(2,nnz);
+    VecT values(nnz);
+    IdxT n=0;
+    for(IdxT b=0; b<num_blocks(); b++) {
+        IdxT k = _block_offsets(b);
+        MatT B = arma::symmatu(_blocks[b]);
+        for(IdxT j=0; j<B.n_cols; j++) for(IdxT i=0; i<B.n_rows; i++) {
+            locations(0,n) = k+i;
+            locations(1,n) = k+j;
+            values(n) = B(i,j);
+            n++;
+        }
+    }
+    return arma::sp_mat(locations,values,_num_dim,_num_dim);
+}
+
+VecT BlockHessian::solve(const VecT &b) const
+{
+    check_size(b);
+    VecT x(_num_dim);
+    for(IdxT i=0; i<num_blocks(); i++) {
+        IdxT k = _block_offsets(i);
+        IdxT n = _block_sizes(i);
+        VecT xi;
+        if(!arma::solve(xi, arma::symmatu(_blocks[i]), b.subvec(k,k+n-1))) {
+            std::ostringstream msg;
+            msg<<"Unable to solve hessian block: "<<i<<".  Block is singular.";
+            throw ParameterValueError(msg.str());
+        }
+        x.subvec(k,k+n-1) = xi;
+    }
+    return x;
+}
+
+double BlockHessian::logdet(double &sign) const
+{
+    double val = 0;
+    sign = 1;
+    for(auto &B: _blocks) {
+        double block_val, block_sign;
+        arma::log_det(block_val, block_sign, arma::symmatu(B).eval());
+        val += block_val;
+        sign *= block_sign;
+    }
+    return val;
+}
+
+BlockHessian BlockHessian::inverse() const
+{
+    BlockHessian inv(*this);
+    for(IdxT i=0; i<num_blocks(); i++) {
+        if(!arma::inv(inv._blocks[i], arma::symmatu(_blocks[i]))) {
+            std::ostringstream msg;
+            msg<<"Unable to invert hessian block: "<<i<<".  Block is singular.";
+            throw ParameterValueError(msg.str());
+        }
+    }
+    return inv;
+}
+
+bool BlockHessian::operator==(const BlockHessian &o) const
+{
+    if(_num_dim != o._num_dim || num_blocks() != o.num_blocks()) return false;
+    if(!arma::all(_block_sizes == o._block_sizes)) return false;
+    for(IdxT i=0; i<num_blocks(); i++) if(!arma::approx_equal(_blocks[i],o._blocks[i],"absdiff",0)) return false;
+    return true;
+}
+
+void BlockHessian::check_size(const VecT &b) const
+{
+    if(b.n_elem != _num_dim) {
+        std::ostringstream msg;
+        msg<<"Expected vector of size: "<<_num_dim<<". Got: "<<b.n_elem;
+        throw ParameterSizeError(msg.str());
+    }
+}
+
+std::ostream& operator<<(std::ostream &out, const BlockHessian &hess)
+{
+    out<<"[BlockHessian: num_dim:"<<hess.num_dim()<<" num_blocks:"<<hess.num_blocks()<<"]\n";
+    for(IdxT i=0; i<hess.num_blocks(); i++)
+        out<<"  Block "<<i<<" offset:"<<hess.block_offset(i)<<"\n"<<hess.block(i);
+    return out;
+}
+
+} /* namespace prior_hessian */
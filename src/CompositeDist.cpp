@@ -10,6 +10,8 @@
 
 namespace prior_hessian {
 
+constexpr IdxT CompositeDist::batch_chunk_size;
+
 CompositeDist::CompositeDist() 
     : handle{new EmptyDistTuple{}}
 { initialize_from_handle(); }
@@ -18,7 +20,8 @@ CompositeDist::CompositeDist(const CompositeDist &o)
     : handle{o.handle->clone()},
       component_names_initialized(o.component_names_initialized),
       dim_variables_initialized(o.dim_variables_initialized),
-      param_names_initialized(o.param_names_initialized)
+      param_names_initialized(o.param_names_initialized),
+      _num_threads(o._num_threads)
 {
     if(component_names_initialized) _component_names = o._component_names;
     if(dim_variables_initialized) _dim_variables = o._dim_variables;
@@ -29,7 +32,8 @@ CompositeDist::CompositeDist(CompositeDist &&o)
     : handle{std::move(o.handle)},
       component_names_initialized(o.component_names_initialized),
       dim_variables_initialized(o.dim_variables_initialized),
-      param_names_initialized(o.param_names_initialized)
+      param_names_initialized(o.param_names_initialized),
+      _num_threads(o._num_threads)
 {
     if(component_names_initialized) _component_names = std::move(o._component_names);
     if(dim_variables_initialized) _dim_variables = std::move(o._dim_variables);
@@ -48,6 +52,7 @@ CompositeDist& CompositeDist::operator=(const CompositeDist &o)
     component_names_initialized = o.component_names_initialized;
     dim_variables_initialized = o.dim_variables_initialized;
     param_names_initialized = o.param_names_initialized;
+    _num_threads = o._num_threads;
     if(component_names_initialized) _component_names = o._component_names;
     if(dim_variables_initialized) _dim_variables = o._dim_variables;
     if(param_names_initialized) _param_names = o._param_names;
@@ -61,6 +66,7 @@ CompositeDist& CompositeDist::operator=(CompositeDist &&o)
     component_names_initialized = o.component_names_initialized;
     dim_variables_initialized = o.dim_variables_initialized;
     param_names_initialized = o.param_names_initialized;
+    _num_threads = o._num_threads;
     if(component_names_initialized) _component_names = std::move(o._component_names);
     if(dim_variables_initialized) _dim_variables = std::move(o._dim_variables);
     if(param_names_initialized) _param_names = std::move(o._param_names);
@@ -284,5 +290,95 @@ CompositeDist::initialize_name_idx(const StringVecT &names)
     return name_idx;
 }
 
+MatT CompositeDist::sample(IdxT num_samples, std::uint64_t seed, IdxT nthreads) const
+{
+    if(nthreads == 0) nthreads = std::max(IdxT{1}, static_cast<IdxT>(std::thread::hardware_concurrency()));
+    MatT s(num_dim(), num_samples);
+    for_each_batch_chunk(num_samples, nthreads, [&](IdxT begin, IdxT end) {
+        //With one thread the whole range is passed at once, so split it into the same chunks used in parallel
+        for(IdxT b=begin; b<end; b+=batch_chunk_size) {
+            IdxT e = std::min(b+batch_chunk_size, end);
+            rng::philox4x64 chunk_rng(seed, 0, b/batch_chunk_size);
+            AnyRngT any_rng(chunk_rng);
+            s.cols(b,e-1) = handle->sample(any_rng, e-b);
+        }
+    });
+    return s;
+}
+
+void CompositeDist::initialize_llh_constants(const MatT &theta) const
+{
+    if(batch_is_parallel(theta.n_cols)) handle->llh(VecT(theta.col(0)));
+}
+
+void CompositeDist::initialize_param_constants(const MatT &theta) const
+{
+    if(!batch_is_parallel(theta.n_cols)) return;
+    VecT u = theta.col(0);
+    VecT pgrad(num_params(), arma::fill::zeros);
+    MatT phess(num_params(), num_params(), arma::fill::zeros);
+    handle->llh(u);
+    handle->param_grad_hess_accumulate(u,pgrad,phess);
+}
+
+void CompositeDist::check_batch(const MatT &theta) const
+{
+    if(theta.n_rows != num_dim()) {
+        std::ostringstream msg;
+        msg<<"Expected theta with: "<<num_dim()<<" rows. Got: "<<theta.n_rows;
+        throw ParameterSizeError(msg.str());
+    }
+}
+
+void CompositeDist::check_batch(const MatT &theta, const MatT &out) const
+{
+    check_batch(theta);
+    if(out.n_rows != num_dim() || out.n_cols != theta.n_cols) {
+        std::ostringstream msg;
+        msg<<"Expected output of size: ["<<num_dim()<<","<<theta.n_cols<<"]. Got: ["<<out.n_rows<<","<<out.n_cols<<"]";
+        throw ParameterSizeError(msg.str());
+    }
+}
+
+void CompositeDist::check_batch(const MatT &theta, const CubeT &out) const
+{
+    check_batch(theta);
+    if(out.n_rows != num_dim() || out.n_cols != num_dim() || out.n_slices != theta.n_cols) {
+        std::ostringstream msg;
+        msg<<"Expected output of size: ["<<num_dim()<<","<<num_dim()<<","<<theta.n_cols<<"]. Got: ["
+           <<out.n_rows<<","<<out.n_cols<<","<<out.n_slices<<"]";
+        throw ParameterSizeError(msg.str());
+    }
+}
+
+void CompositeDist::check_block_hess(const BlockHessian &hess) const
+{
+    if(hess.num_blocks() != num_components() || !arma::all(hess.block_sizes() == num_dim_components())) {
+        std::ostringstream msg;
+        msg<<"Expected BlockHessian with block sizes: "<<num_dim_components().t()<<" Got: "<<hess.block_sizes().t();
+        throw ParameterSizeError(msg.str());
+    }
+}
+
+void CompositeDist::check_param_batch(const MatT &theta, const MatT &out) const
+{
+    check_batch(theta);
+    if(out.n_rows != num_params() || out.n_cols != theta.n_cols) {
+        std::ostringstream msg;
+        msg<<"Expected output of size: ["<<num_params()<<","<<theta.n_cols<<"]. Got: ["<<out.n_rows<<","<<out.n_cols<<"]";
+        throw ParameterSizeError(msg.str());
+    }
+}
+
+void CompositeDist::check_param_batch(const MatT &theta, const CubeT &out) const
+{
+    check_batch(theta);
+    if(out.n_rows != num_params() || out.n_cols != num_params() || out.n_slices != theta.n_cols) {
+        std::ostringstream msg;
+        msg<<"Expected output of size: ["<<num_params()<<","<<num_params()<<","<<theta.n_cols<<"]. Got: ["
+           <<out.n_rows<<","<<out.n_cols<<","<<out.n_slices<<"]";
+        throw ParameterSizeError(msg.str());
+    }
+}
 
 } /* namespace prior_hessian */
@@ -13,6 +13,8 @@
 #include <limits>
 
 #include <boost/math/special_functions/gamma.hpp>
+#include <boost/math/special_functions/digamma.hpp>
+#include <boost/math/special_functions/trigamma.hpp>
 
 namespace prior_hessian {
 
@@ -62,6 +64,97 @@ double GammaDist::icdf(double u) const
     return boost::math::gamma_p_inv(_shape, u) * _scale;
 }
 
+double GammaDist::sf(double x) const
+{
+   return boost::math::gamma_q(_shape, x / _scale);
+}
+
+double GammaDist::isf(double u) const
+{
+    if(u == 1) return 0;
+    if(u == 0) return INFINITY;
+    return boost::math::gamma_q_inv(_shape, u) * _scale;
+}
+
+double GammaDist::logcdf(double x) const
+{
+    double z = x / _scale;
+    double p = boost::math::gamma_p(_shape, z);
+    if(p > .5) return log1p(-boost::math::gamma_q(_shape, z));
+    if(p >= std::numeric_limits<double>::min() || !(z > 0)) return log(p);
+    //P(k,z) underflows, so z << k.  Series P(k,z) = z^k e^-z / Gamma(k+1) * sum_n z^n/((k+1)...(k+n))
+    double term = 1, sum = 1;
+    for(int n=1; n<1000 && term > sum*std::numeric_limits<double>::epsilon(); n++) {
+        term *= z/(_shape+n);
+        sum += term;
+    }
+    return _shape*log(z) - z - std::lgamma(_shape+1) + log(sum);
+}
+
+double GammaDist::logsf(double x) const
+{
+    double z = x / _scale;
+    double q = boost::math::gamma_q(_shape, z);
+    if(q > .5) return log1p(-boost::math::gamma_p(_shape, z));
+    if(q >= std::numeric_limits<double>::min() || !std::isfinite(z)) return log(q);
+    //Q(k,z) underflows, so z >> k.  Legendre continued fraction for Q(k,z) e^z z^-k Gamma(k), by the modified Lentz method.
+    const double tiny = 1e-300;
+    double b = z + 1 - _shape;
+    double c = 1/tiny;
+    double d = 1/b;
+    double h = d;
+    for(int i=1; i<1000; i++) {
+        double an = -i*(i - _shape);
+        b += 2;
+        d = an*d + b;
+        if(fabs(d) < tiny) d = tiny;
+        c = b + an/c;
+        if(fabs(c) < tiny) c = tiny;
+        d = 1/d;
+        double delta = d*c;
+        h *= delta;
+        if(fabs(delta-1) < std::numeric_limits<double>::epsilon()) break;
+    }
+    return _shape*log(z) - z - std::lgamma(_shape) + log(h);
+}
+
+/* With u=x/scale and w(u) = u^shape e^-u/Gamma(shape), d/dscale (F(b)-F(a)) = -[w(u)]_a^b/scale and
+ * d2/dscale2 (F(b)-F(a)) = [(1+shape-u) w(u)]_a^b/scale^2, so the scale derivatives are closed form.  The derivative
+ * of the regularized incomplete gamma function in the shape has no closed form, so the shape derivatives are central
+ * differences in the shape only: of log_cdf_diff for the shape gradient and second derivative, and of the closed-form
+ * scale gradient for the cross term.
+ */
+void GammaDist::log_cdf_diff_param_grad_hess(double a, double b, NparamsVecT &grad, NparamsMatT &hess) const
+{
+    //Scale gradient g and second derivative h of L=log_cdf_diff(a,b) at the given shape
+    auto scale_derivs = [=](double shape, double L, double &g, double &h) {
+        double w1 = 0, w2 = 0; //[w(u)]_a^b and [(1+shape-u) w(u)]_a^b, divided by exp(L)
+        for(double s: {-1., 1.}) {
+            double u = (s > 0 ? b : a)/_scale;
+            if(!(u > 0 && std::isfinite(u))) continue; //w(u) vanishes at the bounds of the distribution
+            double w = exp(shape*log(u) - u - std::lgamma(shape) - L);
+            w1 += s*w;
+            w2 += s*(1 + shape - u)*w;
+        }
+        g = -w1/_scale;
+        h = w2/square(_scale) - g*g;
+    };
+    double step = param_finite_difference_step*std::max(1.0,_shape);
+    if(!(_shape - step > 0)) step = param_finite_difference_step*_shape;
+    double L0 = log_cdf_diff(a,b);
+    double Lp = GammaDist(_scale,_shape+step).log_cdf_diff(a,b);
+    double Lm = GammaDist(_scale,_shape-step).log_cdf_diff(a,b);
+    double g0, h0, gp, hp, gm, hm;
+    scale_derivs(_shape, L0, g0, h0);
+    scale_derivs(_shape+step, Lp, gp, hp);
+    scale_derivs(_shape-step, Lm, gm, hm);
+    grad(0) = g0;
+    grad(1) = (Lp-Lm)/(2*step);
+    hess(0,0) = h0;
+    hess(0,1) = hess(1,0) = (gp-gm)/(2*step);
+    hess(1,1) = (Lp-2*L0+Lm)/square(step);
+}
+
 double GammaDist::pdf(double x) const
 {
     if(x==0) return 0;
@@ -75,6 +168,32 @@ double GammaDist::llh(double x) const
     return rllh(x) + llh_const; 
 }
 
+GammaDist::NparamsVecT GammaDist::param_grad(double x) const
+{
+    double scale_inv = 1/_scale;
+    return {(x*scale_inv - _shape)*scale_inv, log(x*scale_inv) - boost::math::digamma(_shape)};
+}
+
+GammaDist::NparamsMatT GammaDist::param_hess(double x) const
+{
+    NparamsVecT g(arma::fill::zeros);
+    NparamsMatT h(arma::fill::zeros);
+    param_grad_hess_accumulate(x,g,h);
+    return h;
+}
+
+void GammaDist::param_grad_hess_accumulate(double x, NparamsVecT &g, NparamsMatT &h) const
+{
+    double scale_inv = 1/_scale;
+    double x_scaled = x*scale_inv;
+    g(0) += (x_scaled - _shape)*scale_inv; // d/dscale
+    g(1) += log(x_scaled) - boost::math::digamma(_shape); // d/dshape
+    h(0,0) += (_shape - 2*x_scaled)*square(scale_inv);
+    h(0,1) += -scale_inv;
+    h(1,0) += -scale_inv;
+    h(1,1) += -boost::math::trigamma(_shape);
+}
+
 void GammaDist::initialize_llh_const() const
 {
     llh_const = compute_llh_const(shape(),scale());
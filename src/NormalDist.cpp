@@ -6,6 +6,7 @@
  */
 #include "PriorHessian/NormalDist.h"
 #include "PriorHessian/PriorHessianError.h"
+#include "PriorHessian/mvn_cdf.h"
 
 #include <sstream>
 #include <cmath>
@@ -41,12 +42,75 @@ void NormalDist::set_sigma(double val)
 
 double NormalDist::cdf(double x) const
 {
-    return .5*(1 + boost::math::erf((x - _mu)*_sigma_inv*constants::sqrt2_inv));
+    return unit_normal_cdf((x - _mu)*_sigma_inv);
 }
 
 double NormalDist::icdf(double u) const
 {
-    return mu() + sigma()*constants::sqrt2*boost::math::erf_inv(2*u-1);
+    return mu() + sigma()*unit_normal_icdf(u);
+}
+
+double NormalDist::sf(double x) const
+{
+    return unit_normal_cdf((_mu - x)*_sigma_inv);
+}
+
+double NormalDist::isf(double u) const
+{
+    return mu() - sigma()*unit_normal_icdf(u);
+}
+
+double NormalDist::logcdf(double x) const
+{
+    return unit_normal_logcdf((x - _mu)*_sigma_inv);
+}
+
+double NormalDist::logsf(double x) const
+{
+    return unit_normal_logcdf((_mu - x)*_sigma_inv);
+}
+
+double NormalDist::log_cdf_diff(double a, double b) const
+{
+    return unit_normal_log_interval_probability((a - _mu)*_sigma_inv, (b - _mu)*_sigma_inv);
+}
+
+/* With alpha=(a-mu)/sigma, beta=(b-mu)/sigma, L=log(Phi(beta)-Phi(alpha)), and r(x)=phi(x)/exp(L),
+ *      dL/dmu = (r(alpha)-r(beta))/sigma
+ *      dL/dsigma = (alpha*r(alpha)-beta*r(beta))/sigma
+ * and using dr(x)/dmu = r(x)*(x/sigma - dL/dmu), dr(x)/dsigma = r(x)*(x^2/sigma - dL/dsigma),
+ *      d2L/dmu2 = dL/dsigma/sigma - (dL/dmu)^2
+ *      d2L/dmu dsigma = -dL/dmu/sigma + (alpha^2*r(alpha)-beta^2*r(beta))/sigma^2 - dL/dmu*dL/dsigma
+ *      d2L/dsigma2 = -2*dL/dsigma/sigma + (alpha^3*r(alpha)-beta^3*r(beta))/sigma^2 - (dL/dsigma)^2.
+ * Infinite bounds contribute r(x)*x^k = 0.
+ */
+void NormalDist::log_cdf_diff_param_grad_hess(double a, double b, NparamsVecT &grad, NparamsMatT &hess) const
+{
+    double alpha = (a - _mu)*_sigma_inv;
+    double beta = (b - _mu)*_sigma_inv;
+    double L = unit_normal_log_interval_probability(alpha, beta);
+    auto r = [=](double x) { return std::isfinite(x) ? exp(-.5*x*x - .5*constants::log2pi - L) : 0; };
+    double ra = r(alpha), rb = r(beta);
+    double xa = std::isfinite(alpha) ? alpha : 0; //x*r(x) terms vanish at infinite bounds
+    double xb = std::isfinite(beta) ? beta : 0;
+    double g_mu = (ra - rb)*_sigma_inv;
+    double g_sigma = (xa*ra - xb*rb)*_sigma_inv;
+    double sigma_inv2 = square(_sigma_inv);
+    grad(0) = g_mu;
+    grad(1) = g_sigma;
+    hess(0,0) = g_sigma*_sigma_inv - g_mu*g_mu;
+    hess(0,1) = hess(1,0) = -g_mu*_sigma_inv + (xa*xa*ra - xb*xb*rb)*sigma_inv2 - g_mu*g_sigma;
+    hess(1,1) = -2*g_sigma*_sigma_inv + (xa*xa*xa*ra - xb*xb*xb*rb)*sigma_inv2 - g_sigma*g_sigma;
+}
+
+double NormalDist::ilogcdf(double log_u) const
+{
+    return mu() + sigma()*unit_normal_log_icdf(log_u);
+}
+
+double NormalDist::ilogsf(double log_u) const
+{
+    return mu() - sigma()*unit_normal_log_icdf(log_u);
 }
 
 double NormalDist::checked_mu(double val)
@@ -61,6 +61,41 @@ double ParetoDist::median() const
     return lbound() * std::pow(2,1/alpha()); 
 }
 
+/* With f(y) = log(1-exp(-y)), so f'(y) = 1/expm1(y) and f''(y) = -exp(y)/expm1(y)^2,
+ *      log_cdf_diff(a,b) = alpha*log(min/a) + f(alpha*log(b/a))   for a > min
+ *      log_cdf_diff(a,b) = f(alpha*log(b/min))                    for a <= min.
+ * For b = inf, f and its derivatives are 0.
+ */
+void ParetoDist::log_cdf_diff_param_grad_hess(double a, double b, NparamsVecT &grad, NparamsMatT &hess) const
+{
+    bool lower = a > _min; //a is above the lbound of the distribution
+    double l = lower ? log(b/a) : log(b/_min);
+    double y = _alpha*l;
+    double f1 = 0, f2 = 0; //f'(y) and f''(y)
+    if(std::isfinite(y)) {
+        double em1 = expm1(y);
+        f1 = 1/em1;
+        f2 = -exp(y)/square(em1);
+    }
+    double l_f1 = f1 ? l*f1 : 0; //d/dalpha f(y)
+    double l_f2 = f2 ? l*f2 : 0;
+    double l2_f2 = f2 ? l*l_f2 : 0; //d2/dalpha2 f(y)
+    if(lower) {
+        grad(0) = _alpha/_min;
+        grad(1) = log(_min/a) + l_f1;
+        hess(0,0) = -_alpha/square(_min);
+        hess(0,1) = hess(1,0) = 1/_min;
+        hess(1,1) = l2_f2;
+    } else {
+        //dy/dmin = -alpha/min
+        grad(0) = -_alpha*f1/_min;
+        grad(1) = l_f1;
+        hess(0,0) = _alpha*(_alpha*f2 + f1)/square(_min);
+        hess(0,1) = hess(1,0) = -(f1 + _alpha*l_f2)/_min;
+        hess(1,1) = l2_f2;
+    }
+}
+
 double ParetoDist::llh(double x) const 
 { 
     if(!llh_const_initialized) initialize_llh_const();
@@ -12,6 +12,8 @@
 #include <limits>
 
 #include <boost/math/special_functions/beta.hpp>
+#include <boost/math/special_functions/digamma.hpp>
+#include <boost/math/special_functions/trigamma.hpp>
 
 namespace prior_hessian {
 
@@ -47,6 +49,27 @@ double SymmetricBetaDist::icdf(double u) const
     return boost::math::ibeta_inv(_beta, _beta, u);
 }
 
+double SymmetricBetaDist::logcdf(double x) const
+{
+    if(x > .5) return log1p(-sf(x));
+    double p = cdf(x);
+    if(p >= std::numeric_limits<double>::min() || !(x > 0)) return log(p);
+    //I_x(b,b) underflows, so x is small.  Series I_x(b,b) = x^b (1-x)^b / (b Beta(b,b)) * sum_n t_n,
+    //with t_0 = 1 and t_n = t_{n-1} x (2b+n-1)/(b+n).
+    double term = 1, sum = 1;
+    for(int n=1; n<1000 && term > sum*std::numeric_limits<double>::epsilon(); n++) {
+        term *= x*(2*_beta+n-1)/(_beta+n);
+        sum += term;
+    }
+    if(!llh_const_initialized) initialize_llh_const(); //llh_const = -log(Beta(b,b))
+    return _beta*(log(x) + log1p(-x)) - log(_beta) + llh_const + log(sum);
+}
+
+double SymmetricBetaDist::logsf(double x) const
+{
+    return x < .5 ? log1p(-cdf(x)) : logcdf(1-x);
+}
+
 double SymmetricBetaDist::pdf(double x) const
 {
    return boost::math::ibeta_derivative(_beta, _beta, x);
@@ -66,7 +89,25 @@ void SymmetricBetaDist::initialize_llh_const() const
 
 double SymmetricBetaDist::compute_llh_const(double beta)
 {
-    return -2*lgamma(beta) - lgamma(2*beta);//log(1/Beta(beta,beta))
+    return lgamma(2*beta) - 2*lgamma(beta);//log(1/Beta(beta,beta))
+}
+
+SymmetricBetaDist::NparamsVecT SymmetricBetaDist::param_grad(double x) const
+{
+    return {log(x*(1-x)) + 2*(boost::math::digamma(2*_beta) - boost::math::digamma(_beta))};
+}
+
+SymmetricBetaDist::NparamsMatT SymmetricBetaDist::param_hess(double ) const
+{
+    NparamsMatT h;
+    h(0,0) = 4*boost::math::trigamma(2*_beta) - 2*boost::math::trigamma(_beta);
+    return h;
+}
+
+void SymmetricBetaDist::param_grad_hess_accumulate(double x, NparamsVecT &g, NparamsMatT &h) const
+{
+    g(0) += log(x*(1-x)) + 2*(boost::math::digamma(2*_beta) - boost::math::digamma(_beta));
+    h(0,0) += 4*boost::math::trigamma(2*_beta) - 2*boost::math::trigamma(_beta);
 }
 
 double SymmetricBetaDist::checked_beta(double val)
@@ -8,17 +8,24 @@
 
 #include <cmath>
 #include <limits>
+#include <vector>
+#include <random>
+#include <sstream>
+#include <cstdint>
 
 #include <armadillo>
 
 #include <boost/math/special_functions/erf.hpp>
 #include <boost/math/constants/constants.hpp>
+#include <boost/math/quadrature/gauss_kronrod.hpp>
 
 
 namespace {
     const double sqrt2 = sqrt(2.);
     const double inv_sqrt2 = 1./sqrt2;
     const double inv_2pi = 1./(2.*arma::datum::pi);
+    //log_mvn_integral integrates in log-scaled form below this value, where the integrand can underflow
+    const double log_scaled_min_value = 1E-280;
 }
 
 namespace prior_hessian {
@@ -39,6 +46,52 @@ double unit_normal_icdf( double u )
     return -::sqrt2*boost::math::erfc_inv(2*u);
 }
 
+double unit_normal_logcdf( double t )
+{
+    if(t > 5) return std::log1p(-.5*std::erfc(t*::inv_sqrt2));
+    if(t > -30) return std::log(.5*std::erfc(-t*::inv_sqrt2));
+    if(t == -INFINITY) return -INFINITY;
+    //Asymptotic series Phi(t) = phi(t)/(-t) * (1 - 1/t^2 + 3/t^4 - 15/t^6 + ...).  Truncation error < 3E-16 for t <= -30.
+    double r = 1/(t*t);
+    double s = 1 + r*(-1 + r*(3 + r*(-15 + r*(105 + r*(-945 + r*10395)))));
+    return -.5*t*t - std::log(-t) - .5*constants::log2pi + std::log(s);
+}
+
+double unit_normal_log_icdf( double log_u )
+{
+    if(log_u >= 0) return INFINITY;
+    if(log_u > -constants::ln2) return -unit_normal_icdf(-std::expm1(log_u)); //Upper half, from the complement
+    if(log_u > -700) return unit_normal_icdf(std::exp(log_u));
+    if(log_u == -INFINITY) return -INFINITY;
+    //exp(log_u) would underflow.  Newton's method on the concave unit_normal_logcdf, from the leading
+    //asymptotic term Phi(t) ~ phi(t)/(-t).
+    double y = -2*log_u;
+    double t = -std::sqrt(y - std::log(y) - constants::log2pi);
+    for(int n=0; n<20; n++) {
+        double log_cdf = unit_normal_logcdf(t);
+        double dt = (log_cdf - log_u) * std::exp(log_cdf + .5*t*t + .5*constants::log2pi); //f/f' with f' = phi(t)/Phi(t)
+        t -= dt;
+        if(std::fabs(dt) <= 4*std::numeric_limits<double>::epsilon()*std::fabs(t)) break;
+    }
+    return t;
+}
+
+double unit_normal_interval_probability( double a, double b )
+{
+    if(!(a < b)) return 0;
+    if(a+b > 0) return unit_normal_interval_probability(-b,-a); //Mirror so that the midpoint is <= 0
+    if(b <= 0) return unit_normal_cdf(b) - unit_normal_cdf(a); //Lower tail probabilities have full relative precision
+    return 1 - unit_normal_cdf(a) - unit_normal_cdf(-b);
+}
+
+double unit_normal_log_interval_probability( double a, double b )
+{
+    if(!(a < b)) return -INFINITY;
+    if(a+b > 0) return unit_normal_log_interval_probability(-b,-a);
+    if(b <= 0) return log_diff_exp(unit_normal_logcdf(b), unit_normal_logcdf(a));
+    return std::log1p(-(unit_normal_cdf(a) + unit_normal_cdf(-b)));
+}
+
 double bounded(double x)
 {
     return std::min(std::max(x,0.),1.);
@@ -115,7 +168,7 @@ double owen_b_integral(double h,double k, double r)
     if(h==INFINITY && k==INFINITY) return 1;
     if(fabs(r)==1) { //Degenerate case.
         if(r>0) return unit_normal_cdf(std::min(h,k));
-        else return unit_normal_cdf(h) - unit_normal_cdf(-k);
+        else return std::max(unit_normal_cdf(h) - unit_normal_cdf(-k), 0.0); //P(-k < X < h)
     }
     assert(fabs(r)<1);
     double sigma = sqrt(1-r*r);
@@ -490,6 +543,410 @@ double donnelly_bvn_integral_orig( double ah, double ak, double r )
   return b;
 }
 
+BVNMethod bvn_cdf_select_method(double h, double k, double r, double tol)
+{
+    //Region boundaries and error bounds measured with benchmark/benchmark_bvn.cpp
+    const double gauss_legendre_max_error = 1E-15;
+    if(tol >= gauss_legendre_max_error && fabs(r) < 0.5 && std::max(fabs(h),fabs(k)) >= 8) return BVNMethod::GaussLegendre;
+    return BVNMethod::Donnelly;
+}
+
+double bvn_cdf_integral(double h, double k, double r, BVNMethod method)
+{
+    if(std::isnan(h)) throw ParameterValueError("h is NaN");
+    if(std::isnan(k)) throw ParameterValueError("k is NaN");
+    if(fabs(r)>1 || !std::isfinite(r)) throw ParameterValueError("r is not in interval [-1,1]");
+    if(h==-INFINITY || k==-INFINITY) return 0;
+    if(h==INFINITY) return unit_normal_cdf(k);
+    if(k==INFINITY) return unit_normal_cdf(h);
+    switch(method) {
+        case BVNMethod::Auto:
+            return bvn_cdf_integral(h,k,r,bvn_cdf_select_method(h,k,r));
+        case BVNMethod::Owen:
+            return owen_b_integral(h,k,r);
+        case BVNMethod::Donnelly:
+            return donnelly_bvn_integral(-h,-k,r); //Integration of x,y coordinates in bvn_integral is inverted from normal CDF
+        case BVNMethod::GaussLegendre: {
+            double out;
+            bvn_cdf_batch(1,&h,&k,&r,&out);
+            return out;
+        }
+    }
+    throw ParameterValueError("bvn_cdf_integral: Unknown BVNMethod");
+}
+
+namespace {
+    /* sx = sin(x), cs = 1-sin(x)^2, accurate when |x| is near pi/2 */
+    void tvn_sincs(double x, double &sx, double &cs)
+    {
+        double ee = arma::datum::pi/2 - fabs(x);
+        ee *= ee;
+        if(ee < 5E-5) {
+            sx = std::copysign(1 - ee*(1 - ee/12)/2, x);
+            cs = ee*(1 - ee*(1 - 2*ee/15)/3);
+        } else {
+            sx = sin(x);
+            cs = 1 - sx*sx;
+        }
+    }
+
+    /* Plackett formula integrand: exp(-ft/2)*Phi(bt), the derivative of the trivariate cdf with respect to r,
+     * the correlation of (ba,bb), with ra, rb the correlations of (ba,bc) and (bb,bc), and rr = 1-r^2.
+     */
+    double tvn_plackett_integrand(double ba, double bb, double bc, double ra, double rb, double r, double rr)
+    {
+        double dt = rr*(rr - (ra-rb)*(ra-rb) - 2*ra*rb*(1-r));
+        if(!(dt > 0)) return 0;
+        double bt = (bc*rr + ba*(r*rb-ra) + bb*(r*ra-rb))/sqrt(dt);
+        double ft = (ba-r*bb)*(ba-r*bb)/rr + bb*bb;
+        if(bt <= -10 || ft >= 100) return 0;
+        double v = exp(-ft/2);
+        if(bt < 10) v *= unit_normal_cdf(bt);
+        return v;
+    }
+} /* namespace */
+
+double tvn_cdf_integral(double h1, double h2, double h3, double r12, double r13, double r23)
+{
+    using std::swap;
+    if(std::isnan(h1) || std::isnan(h2) || std::isnan(h3)) throw ParameterValueError("tvn_cdf_integral: h is NaN");
+    for(double r: {r12,r13,r23})
+        if(!(fabs(r)<=1)) throw ParameterValueError("tvn_cdf_integral: r is not in interval [-1,1]");
+    if(h1==-INFINITY || h2==-INFINITY || h3==-INFINITY) return 0;
+    if(h1==INFINITY) return bvn_cdf_integral(h2,h3,r23);
+    if(h2==INFINITY) return bvn_cdf_integral(h1,h3,r13);
+    if(h3==INFINITY) return bvn_cdf_integral(h1,h2,r12);
+
+    //Order so that |r23| is the largest correlation.  It is handled exactly, and r12, r13 by integration.
+    if(fabs(r12) > fabs(r13)) { swap(h2,h3); swap(r12,r13); }
+    if(fabs(r13) > fabs(r23)) { swap(h1,h2); swap(r13,r23); }
+    const double eps = 1E-14;
+    double p;
+    if(fabs(h1)+fabs(h2)+fabs(h3) < eps) {
+        p = (1 + (asin(r12)+asin(r13)+asin(r23))/(arma::datum::pi/2))/8;
+    } else if(fabs(r12)+fabs(r13) < eps) {
+        p = unit_normal_cdf(h1)*bvn_cdf_integral(h2,h3,r23);
+    } else if(fabs(r13)+fabs(r23) < eps) {
+        p = unit_normal_cdf(h3)*bvn_cdf_integral(h1,h2,r12);
+    } else if(fabs(r12)+fabs(r23) < eps) {
+        p = unit_normal_cdf(h2)*bvn_cdf_integral(h1,h3,r13);
+    } else if(1-r23 < eps) {
+        p = bvn_cdf_integral(h1,std::min(h2,h3),r12);
+    } else if(r23+1 < eps) {
+        p = (h2 > -h3) ? bvn_cdf_integral(h1,h2,r12) - bvn_cdf_integral(h1,-h3,r12) : 0;
+    } else {
+        //Plackett's formula: integrate the derivative along r12(t) = sin(t*asin(r12)), r13(t) = sin(t*asin(r13))
+        //from the independent case at t=0, where the cdf is Phi(h1)*BVN(h2,h3,r23).
+        double rua = asin(r12);
+        double rub = asin(r13);
+        auto f = [=](double t) {
+            double r12t, rr12t, r13t, rr13t;
+            tvn_sincs(rua*t, r12t, rr12t);
+            tvn_sincs(rub*t, r13t, rr13t);
+            double v = 0;
+            if(rua != 0) v += rua*tvn_plackett_integrand(h1,h2,h3,r13t,r23,r12t,rr12t);
+            if(rub != 0) v += rub*tvn_plackett_integrand(h1,h3,h2,r12t,r23,r13t,rr13t);
+            return v;
+        };
+        double integral = boost::math::quadrature::gauss_kronrod<double,15>::integrate(f, 0, 1, 10, 1E-11);
+        p = unit_normal_cdf(h1)*bvn_cdf_integral(h2,h3,r23) + integral/(2*arma::datum::pi);
+    }
+    return bounded(p);
+}
+
+namespace {
+    /* Prime lattice sizes and Korobov generators, a, for the rank-1 lattice rules z = (1, a, a^2, ...) mod n.
+     * Each a minimizes the P_2 criterion with product weights 0.6^j in 12 dimensions, over all 1 < a < n/2 (n < 4000)
+     * or 2000 random candidates (larger n).
+     */
+    const IdxT korobov_num_rules = 27;
+    const IdxT korobov_rules[korobov_num_rules][2] = {
+        {31, 7}, {47, 17}, {71, 21}, {107, 52}, {163, 57}, {251, 71}, {379, 73}, {569, 56}, {853, 318},
+        {1279, 615}, {1931, 270}, {2897, 695}, {4349, 158}, {6529, 351}, {9803, 1834}, {14713, 5495},
+        {22073, 4260}, {33113, 3324}, {49669, 19580}, {74507, 1964}, {111767, 19996}, {167663, 43382},
+        {251501, 46618}, {377257, 76616}, {565889, 162501}, {848839, 358934}, {1273267, 377810}
+    };
+
+    /* P(X>h, Y>k) for unit normals X,Y with correlation r, allowing for infinite limits */
+    double bvn_upper_tail_integral(double h, double k, double r)
+    {
+        if(h==INFINITY || k==INFINITY) return 0;
+        if(h==-INFINITY) return unit_normal_cdf(-k);
+        if(k==-INFINITY) return unit_normal_cdf(-h);
+        return donnelly_bvn_integral(h,k,r);
+    }
+
+    /* Exact integral over the rectangle [a,b] of a zero-mean bivariate normal with column-major covariance S */
+    double bvn_rectangle_integral(const double *a, const double *b, const double *S)
+    {
+        double s0 = std::sqrt(S[0]);
+        double s1 = std::sqrt(S[3]);
+        double r = S[2]/(s0*s1);
+        double a0 = a[0]/s0, a1 = a[1]/s1;
+        double b0 = b[0]/s0, b1 = b[1]/s1;
+        double p = bvn_upper_tail_integral(a0,a1,r) - bvn_upper_tail_integral(a0,b1,r)
+                 - bvn_upper_tail_integral(b0,a1,r) + bvn_upper_tail_integral(b0,b1,r);
+        return std::min(std::max(p,0.),1.);
+    }
+
+    /* Integrand of the Genz separation-of-variables transform.  All state is in the object, so each call
+     * to genz::mvn_integral has its own, and concurrent calls are safe.
+     * L is the lower triangular cholesky factor of the re-ordered covariance, with each row scaled by its diagonal.
+     */
+    class GenzIntegrand
+    {
+    public:
+        GenzIntegrand(IdxT N, const double *lower, const double *upper, const double *sigma);
+        /* Evaluate at w in [0,1]^(N-1) */
+        double operator()(const double *w);
+        /* log of operator()(w), with each conditional probability kept in log space so it does not underflow */
+        double log_eval(const double *w);
+    private:
+        IdxT N;
+        std::vector<double> a, b, L, y;
+        double d0, e0;
+        double log_d0, log_e0;
+        double& l(IdxT i, IdxT j) { return L[i*N+j]; }
+    };
+
+    GenzIntegrand::GenzIntegrand(IdxT N_, const double *lower, const double *upper, const double *sigma)
+        : N(N_), a(lower,lower+N_), b(upper,upper+N_), L(N_*N_,0), y(N_,0)
+    {
+        std::vector<double> C(sigma,sigma+N*N); //Column-major covariance, permuted in place
+        std::vector<double> ys(N,0); //Conditional expected values for variable prioritization
+        auto c = [&](IdxT i, IdxT j) -> double& { return C[i+j*N]; };
+        for(IdxT i=0; i<N; i++) {
+            //Choose the remaining variable with the smallest conditional probability (Genz's variable prioritization)
+            IdxT jmin = i;
+            double demin = 2;
+            double amin=0, bmin=0;
+            for(IdxT j=i; j<N; j++) {
+                double sum = 0, sumsq = 0;
+                for(IdxT k=0; k<i; k++) {
+                    sum += l(j,k)*ys[k];
+                    sumsq += l(j,k)*l(j,k);
+                }
+                double v = c(j,j) - sumsq;
+                if(!(v > 0)) throw ParameterValueError("genz::mvn_integral: sigma is not positive definite.");
+                double s = std::sqrt(v);
+                double aj = (a[j]-sum)/s;
+                double bj = (b[j]-sum)/s;
+                double de = unit_normal_interval_probability(aj,bj);
+                if(de <= demin) {
+                    jmin = j;
+                    demin = de;
+                    amin = aj;
+                    bmin = bj;
+                }
+            }
+            if(jmin != i) {
+                std::swap(a[i],a[jmin]);
+                std::swap(b[i],b[jmin]);
+                for(IdxT k=0; k<N; k++) std::swap(c(i,k),c(jmin,k));
+                for(IdxT k=0; k<N; k++) std::swap(c(k,i),c(k,jmin));
+                for(IdxT k=0; k<i; k++) std::swap(l(i,k),l(jmin,k));
+            }
+            double sumsq = 0;
+            for(IdxT k=0; k<i; k++) sumsq += l(i,k)*l(i,k);
+            double lii = std::sqrt(c(i,i) - sumsq);
+            l(i,i) = lii;
+            for(IdxT j=i+1; j<N; j++) {
+                double sum = 0;
+                for(IdxT k=0; k<i; k++) sum += l(j,k)*l(i,k);
+                l(j,i) = (c(j,i)-sum)/lii;
+            }
+            //Expected value of a unit normal truncated to [amin,bmin]
+            if(demin>0) {
+                double pa = std::isfinite(amin) ? std::exp(-.5*amin*amin) : 0;
+                double pb = std::isfinite(bmin) ? std::exp(-.5*bmin*bmin) : 0;
+                ys[i] = (pa-pb)/(constants::sqrt2pi*demin);
+            } else { //Limits are far in a tail
+                ys[i] = std::isfinite(amin) ? amin : bmin;
+            }
+        }
+        //Scale rows by the diagonal, so the integrand needs no divisions
+        for(IdxT i=0; i<N; i++) {
+            double lii = l(i,i);
+            a[i] /= lii;
+            b[i] /= lii;
+            for(IdxT k=0; k<i; k++) l(i,k) /= lii;
+        }
+        d0 = unit_normal_cdf(a[0]);
+        e0 = unit_normal_cdf(b[0]);
+        log_d0 = unit_normal_logcdf(a[0]);
+        log_e0 = unit_normal_logcdf(b[0]);
+    }
+
+    double GenzIntegrand::operator()(const double *w)
+    {
+        double d = d0;
+        double e = e0;
+        double f = e-d;
+        for(IdxT i=1; i<N && f>0; i++) {
+            y[i-1] = unit_normal_icdf(d + w[i-1]*(e-d));
+            double sum = 0;
+            for(IdxT k=0; k<i; k++) sum += l(i,k)*y[k];
+            d = unit_normal_cdf(a[i]-sum);
+            e = unit_normal_cdf(b[i]-sum);
+            f *= e-d;
+        }
+        return f;
+    }
+
+    double GenzIntegrand::log_eval(const double *w)
+    {
+        double log_d = log_d0;
+        double log_e = log_e0;
+        double log_f = log_diff_exp(log_e,log_d);
+        for(IdxT i=1; i<N && log_f>-INFINITY; i++) {
+            //log(d + w*(e-d)) = log(e) + log(1 - (1-w)*(1-d/e))
+            y[i-1] = unit_normal_log_icdf(log_e + std::log1p((1-w[i-1])*std::expm1(log_d-log_e)));
+            double sum = 0;
+            for(IdxT k=0; k<i; k++) sum += l(i,k)*y[k];
+            log_d = unit_normal_logcdf(a[i]-sum);
+            log_e = unit_normal_logcdf(b[i]-sum);
+            log_f += log_diff_exp(log_e,log_d);
+        }
+        return log_f;
+    }
+
+    /* Drops variables with (-inf,inf) limits, which integrate to 1, and copies the limits and covariance of the rest
+     * into a, b, and S.  Returns false if any limits are empty, so the integral is 0.
+     */
+    bool reduce_limits(IdxT N, const double *lower, const double *upper, const double *sigma,
+                       std::vector<double> &a, std::vector<double> &b, std::vector<double> &S)
+    {
+        std::vector<IdxT> idx;
+        for(IdxT i=0; i<N; i++) {
+            double lb = lower ? lower[i] : -INFINITY;
+            if(!(lb < upper[i])) return false; //Empty or NaN limits
+            if(!(sigma[i+i*N] > 0)) {
+                std::ostringstream msg;
+                msg<<"genz::mvn_integral: sigma("<<i<<","<<i<<")="<<sigma[i+i*N]<<" is not positive.";
+                throw ParameterValueError(msg.str());
+            }
+            if(lb > -INFINITY || upper[i] < INFINITY) idx.push_back(i);
+        }
+        IdxT Nd = idx.size();
+        a.resize(Nd);
+        b.resize(Nd);
+        S.resize(Nd*Nd);
+        for(IdxT i=0; i<Nd; i++) {
+            a[i] = lower ? lower[idx[i]] : -INFINITY;
+            b[i] = upper[idx[i]];
+            for(IdxT j=0; j<Nd; j++) S[i+j*Nd] = sigma[idx[i]+idx[j]*N];
+        }
+        return true;
+    }
+
+    /* Reflect variables so their limits are centered at or below 0.  S -> D*S*D for D=diag(+-1) leaves the integral
+     * unchanged, and the integrand then takes differences of lower tail probabilities, which have full relative precision.
+     */
+    void reflect_limits(std::vector<double> &a, std::vector<double> &b, std::vector<double> &S)
+    {
+        IdxT Nd = a.size();
+        for(IdxT i=0; i<Nd; i++) {
+            if(!(a[i]+b[i] > 0)) continue;
+            double ai = a[i];
+            a[i] = -b[i];
+            b[i] = -ai;
+            for(IdxT j=0; j<Nd; j++) if(j != i) {
+                S[i+j*Nd] = -S[i+j*Nd];
+                S[j+i*Nd] = -S[j+i*Nd];
+            }
+        }
+    }
+} /* namespace */
+
+IdxT korobov_lattice_num_rules()
+{
+    return korobov_num_rules;
+}
+
+void korobov_lattice_rule(IdxT r, std::uint64_t &n, std::uint64_t &gen)
+{
+    if(r >= korobov_num_rules) {
+        std::ostringstream msg;
+        msg<<"korobov_lattice_rule: Got rule index: "<<r<<" but there are only "<<korobov_num_rules<<" rules.";
+        throw ParameterValueError(msg.str());
+    }
+    n = korobov_rules[r][0];
+    gen = korobov_rules[r][1];
+}
+
+namespace genz {
+
+double mvn_integral(IdxT N, const double *lower, const double *upper, const double *sigma, 
+                    const MVNIntegralOptions &opts, double &error, int &inform)
+{
+    error = 0;
+    if(N<1) {
+        inform = 2;
+        return 0;
+    }
+    inform = 0;
+    std::vector<double> a, b, S;
+    if(!reduce_limits(N, lower, upper, sigma, a, b, S)) return 0;
+    IdxT Nd = a.size();
+    if(Nd == 0) return 1;
+    if(Nd == 1) return unit_normal_interval_probability(a[0]/std::sqrt(S[0]), b[0]/std::sqrt(S[0]));
+    if(Nd == 2) return bvn_rectangle_integral(a.data(), b.data(), S.data());
+    if(Nd == 3 && a[0]==-INFINITY && a[1]==-INFINITY && a[2]==-INFINITY) {
+        double s0 = std::sqrt(S[0]), s1 = std::sqrt(S[4]), s2 = std::sqrt(S[8]);
+        return tvn_cdf_integral(b[0]/s0, b[1]/s1, b[2]/s2, S[3]/(s0*s1), S[6]/(s0*s2), S[7]/(s1*s2));
+    }
+    reflect_limits(a, b, S);
+    GenzIntegrand f(Nd, a.data(), b.data(), S.data());
+
+    std::mt19937_64 rng(opts.seed);
+    IdxT nevals;
+    bool converged;
+    double value = lattice_integral(Nd-1, f, opts.maxpts, opts.abseps, opts.releps, true, rng, error, nevals, converged);
+    inform = converged ? 0 : 1;
+    return std::min(std::max(value,0.),1.);
+}
+
+double log_mvn_integral(IdxT N, const double *lower, const double *upper, const double *sigma, 
+                        const MVNIntegralOptions &opts, double &error, int &inform)
+{
+    double value = mvn_integral(N, lower, upper, sigma, opts, error, inform); //Also validates the arguments
+    if(inform == 2) return std::log(value);
+    //With a single limited variable the integral is a univariate normal interval, which is computed in log space
+    IdxT Nlimited = 0, k = 0;
+    for(IdxT i=0; i<N; i++) {
+        if((lower && lower[i] > -INFINITY) || upper[i] < INFINITY) {
+            Nlimited++;
+            k = i;
+        }
+    }
+    if(Nlimited == 1) {
+        double s = std::sqrt(sigma[k+k*N]);
+        return unit_normal_log_interval_probability((lower ? lower[k] : -INFINITY)/s, upper[k]/s);
+    }
+    if(value >= log_scaled_min_value) return std::log(value);
+    //The integrand may underflow, so integrate it divided by its value at the center of the unit cube, exp(log_scale),
+    //which keeps the samples near 1.  abseps is scaled to match, but the scaled value is order 1 and abseps on a
+    //value this small would be met by any estimate, so it is capped at releps and the result has relative accuracy.
+    std::vector<double> a, b, S;
+    if(!reduce_limits(N, lower, upper, sigma, a, b, S)) return -INFINITY;
+    reflect_limits(a, b, S);
+    IdxT Nd = a.size();
+    GenzIntegrand f(Nd, a.data(), b.data(), S.data());
+    std::vector<double> w_center(Nd-1, .5);
+    double log_scale = f.log_eval(w_center.data());
+    if(!std::isfinite(log_scale)) return std::log(value);
+    auto f_scaled = [&](const double *w) { return std::exp(f.log_eval(w) - log_scale); };
+    double abseps = std::min(std::exp(std::log(opts.abseps) - log_scale), opts.releps);
+    std::mt19937_64 rng(opts.seed);
+    IdxT nevals;
+    bool converged;
+    double scaled_value = lattice_integral(Nd-1, f_scaled, opts.maxpts, abseps, opts.releps, true, rng, error, nevals,
+                                           converged);
+    error *= std::exp(log_scale);
+    inform = converged ? 0 : 1;
+    return log_scale + std::log(scaled_value);
+}
 
+} /* namespace prior_hessian::genz */
 
 } /* namespace prior_hessian */
@@ -0,0 +1,271 @@
+/** @file mvn_cdf_batch.cpp
+ * @author Mark J. Olah (mjo\@cs.unm DOT edu)
+ * @date 2017-2019
+ * @brief Batched Owen's T and bivariate normal cdf kernels.
+ *
+ * Each batch is split into a scalar pass, which handles the special cases and the Owen's T symmetry reductions, and a
+ * branch-free quadrature pass over all points.  The quadrature pass is vectorized across points.
+ */
+#include "PriorHessian/mvn_cdf.h"
+
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+/* Run-time dispatch to AVX-512 and AVX2 versions of the vectorized kernels, with a scalar fallback */
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define PRIOR_HESSIAN_SIMD_CLONES __attribute__((target_clones("avx512f","avx2","default")))
+#else
+#define PRIOR_HESSIAN_SIMD_CLONES
+#endif
+
+namespace prior_hessian {
+
+namespace {
+    const double inv_2pi = 0.15915494309189533577;
+
+    /* 12-point Gauss-Legendre nodes and weights on [0,1]. */
+    const int gauss_legendre_num_nodes = 12;
+    const double gauss_legendre_nodes[gauss_legendre_num_nodes][2] = {
+        {0.0092196828766403782, 0.023587668193255917}, {0.047941371814762601, 0.053469662997659283},
+        {0.11504866290284765, 0.080039164271673166}, {0.20634102285669126, 0.10158371336153292},
+        {0.31608425050090994, 0.11674626826917739}, {0.43738329574426554, 0.12457352290670144},
+        {0.56261670425573440, 0.12457352290670144}, {0.68391574949909006, 0.11674626826917739},
+        {0.79365897714330869, 0.10158371336153292}, {0.88495133709715235, 0.080039164271673166},
+        {0.95205862818523745, 0.053469662997659283}, {0.99078031712335957, 0.023587668193255917}
+    };
+
+    /* Largest h for which the quadrature is evaluated.  Beyond this T(h,a) < exp(-h^2/2) underflows. */
+    const double owen_t_max_h = 26;
+
+    /* exp(x) for -708 <= x <= 0, with no branches so that it vectorizes.  Relative error < 4E-16. */
+    inline double exp_kernel(double x)
+    {
+        const double log2e = 1.4426950408889634074;
+        const double ln2_hi = 0.693147180369123816490;
+        const double ln2_lo = 1.90821492927058770002e-10;
+        const double shifter = 6755399441055744.0; // 1.5*2^52.  Adding rounds to an integer in the low mantissa bits.
+        double t = x*log2e + shifter;
+        double n = t - shifter;
+        double r = (x - n*ln2_hi) - n*ln2_lo;
+        double p = 1 + r*(1 + r*(1./2 + r*(1./6 + r*(1./24 + r*(1./120 + r*(1./720 + r*(1./5040 + r*(1./40320
+                   + r*(1./362880 + r*(1./3628800 + r*(1./39916800 + r*(1./479001600))))))))))));
+        std::uint64_t bits;
+        std::memcpy(&bits,&t,sizeof(bits));
+        bits = (bits + 1023) << 52; //2^n
+        double scale;
+        std::memcpy(&scale,&bits,sizeof(scale));
+        return p*scale;
+    }
+
+    /* Unit normal cdf for batches, with no branches so that it vectorizes.
+     * Algorithm 5666 of Hart (1968) for |t| < 7.07 and a continued fraction otherwise, as given by West (2005),
+     * "Better approximations to cumulative normal functions".  Absolute error < 3E-16.  In the far lower tail the
+     * relative error is up to 1E-8, so use unit_normal_cdf where relative accuracy of tiny values matters.
+     */
+    inline double unit_normal_cdf_kernel(double t)
+    {
+        const double sqrt2pi = 2.5066282746310005024;
+        const double tail_cutoff = 37; //exp(-tail_cutoff^2/2) is near the smallest normal double
+        double x = std::fabs(t);
+        x = x < tail_cutoff ? x : tail_cutoff;
+        double e = exp_kernel(-.5*x*x);
+        double p = ((((((3.52624965998911e-02*x + 0.700383064443688)*x + 6.37396220353165)*x + 33.912866078383)*x
+                   + 112.079291497871)*x + 221.213596169931)*x + 220.206867912376);
+        double q = (((((((8.83883476483184e-02*x + 1.75566716318264)*x + 16.064177579207)*x + 86.7807322029461)*x
+                   + 296.564248779674)*x + 637.333633378831)*x + 793.826512519948)*x + 440.413735824752);
+        double cf = x + 1/(x + 2/(x + 3/(x + 4/(x + 0.65))));
+        double lower_tail = x < 7.07106781186547 ? e*p/q : e/(sqrt2pi*cf);
+        lower_tail = std::fabs(t) < tail_cutoff ? lower_tail : 0;
+        return t > 0 ? 1-lower_tail : lower_tail;
+    }
+
+    PRIOR_HESSIAN_SIMD_CLONES
+    void unit_normal_cdf_vectorized(IdxT N, const double *t, double *out)
+    {
+        for(IdxT i=0; i<N; i++) out[i] = unit_normal_cdf_kernel(t[i]);
+    }
+
+    /* T(h,a) for 0 <= h <= owen_t_max_h and 0 <= a <= 1, by Gauss-Legendre quadrature of
+     *   T(h,a) = 1/(2pi) * int_0^a exp(-h^2(1+x^2)/2)/(1+x^2) dx.
+     * Over this domain the absolute error is < 2E-16 (checked against boost::math::owens_t in test_mvn_cdf).  The exp
+     * factor narrows to a peak of width 1/h at x=0 as h grows, so the relative error grows with h: < 1E-12 for h <= 4,
+     * but near 1E-6 at h=10 and 5E-3 at h=26, where T(h,a) < 1E-148.
+     */
+    PRIOR_HESSIAN_SIMD_CLONES
+    void owen_t_gauss_legendre(IdxT N, const double *h, const double *a, double *T)
+    {
+        for(IdxT i=0; i<N; i++) T[i] = 0;
+        for(int j=0; j<gauss_legendre_num_nodes; j++) {
+            const double u = gauss_legendre_nodes[j][0];
+            const double w = gauss_legendre_nodes[j][1];
+            for(IdxT i=0; i<N; i++) {
+                double x = a[i]*u;
+                double q = 1 + x*x;
+                T[i] += w*exp_kernel(-.5*h[i]*h[i]*q)/q;
+            }
+        }
+        for(IdxT i=0; i<N; i++) T[i] *= a[i]*inv_2pi;
+    }
+
+    /* Points per chunk for the batched kernels, which keeps the work arrays in cache */
+    const IdxT batch_chunk_size = 256;
+
+    /* Reduction of T(h,a) to  val + coef*T(hr,ar) with 0 <= hr <= owen_t_max_h and 0 <= ar <= 1.
+     * Follows the special cases and symmetries of owen_t_integral.  For |a| > 1 Owens 2.3 needs the cdf at |a*h|, so
+     * the reduction is split in two parts around a batched cdf evaluation.
+     * Part 1 returns true if T(h,a) is not yet known, and sets ah to the argument of the needed cdf, or 0 if not needed.
+     */
+    bool owen_t_reduce_begin(double h, double a, double gh, double &val, double &ah)
+    {
+        if(std::isnan(h)) throw ParameterValueError("a is NaN");
+        if(!(gh >=0 && gh<=1)) throw ParameterValueError("gh is not in [0,1]");
+        val = 0;
+        ah = 0;
+        if(std::fabs(h) == INFINITY) return false;
+        if(std::isnan(a)) throw ParameterValueError("a is NaN");
+        if(a == 0) return false;
+        if(h == 0) {
+            val = std::atan(a)*inv_2pi;
+            return false;
+        }
+        //Owens 2.4 and 2.5: T(h,-a) = -T(h,a) and T(-h,a) = T(h,a)
+        double sign = a<0 ? -1 : 1;
+        a = std::fabs(a);
+        if(h<0) gh = 1-gh; //gh is now the cdf at |h|
+        h = std::fabs(h);
+        if(a == INFINITY) {
+            val = sign*.5*(1-gh);
+            return false;
+        }
+        if(a == 1) {
+            val = sign*.5*gh*(1-gh);
+            return false;
+        }
+        if(a>1) ah = a*h;
+        return true;
+    }
+
+    void owen_t_reduce_end(double h, double a, double gh, double gah, double &val, double &coef, double &hr, double &ar)
+    {
+        double sign = a<0 ? -1 : 1;
+        a = std::fabs(a);
+        if(h<0) gh = 1-gh;
+        h = std::fabs(h);
+        if(a>1) { //Owens 2.3
+            val = sign*(.5*(gh+gah) - gh*gah);
+            coef = -sign;
+            hr = a*h;
+            ar = 1/a;
+        } else {
+            val = 0;
+            coef = sign;
+            hr = h;
+            ar = a;
+        }
+        if(!(hr <= owen_t_max_h)) { //Negligible
+            coef = 0;
+            hr = 0;
+            ar = 0;
+        }
+    }
+
+    void owen_t_integral_chunk(IdxT N, const double *h, const double *a, const double *gh, double *T)
+    {
+        double val[batch_chunk_size], coef[batch_chunk_size], hr[batch_chunk_size], ar[batch_chunk_size];
+        double ah[batch_chunk_size] = {};
+        double gah[batch_chunk_size];
+        bool todo[batch_chunk_size];
+        for(IdxT i=0; i<N; i++) todo[i] = owen_t_reduce_begin(h[i], a[i], gh[i], val[i], ah[i]);
+        unit_normal_cdf_vectorized(N, ah, gah);
+        for(IdxT i=0; i<N; i++) {
+            if(todo[i]) {
+                owen_t_reduce_end(h[i], a[i], gh[i], gah[i], val[i], coef[i], hr[i], ar[i]);
+            } else {
+                coef[i] = hr[i] = ar[i] = 0;
+            }
+        }
+        owen_t_gauss_legendre(N, hr, ar, T);
+        for(IdxT i=0; i<N; i++) T[i] = val[i] + coef[i]*T[i];
+    }
+
+    void bvn_cdf_chunk(IdxT N, const double *h, const double *k, const double *r, double *out)
+    {
+        //Each point needs up to two T evaluations:  T(h,ah) and T(k,ak).  Unused slots are set to T(0,0)=0.
+        double gh[batch_chunk_size], gk[batch_chunk_size], base[batch_chunk_size];
+        double Th[2*batch_chunk_size], Ta[2*batch_chunk_size], Tgh[2*batch_chunk_size], T[2*batch_chunk_size];
+        bool done[batch_chunk_size];
+        unit_normal_cdf_vectorized(N, h, gh);
+        unit_normal_cdf_vectorized(N, k, gk);
+        for(IdxT i=0; i<N; i++) {
+            double hi = h[i];
+            double ki = k[i];
+            double ri = r[i];
+            if(std::isnan(hi)) throw ParameterValueError("h is NaN");
+            if(std::isnan(ki)) throw ParameterValueError("k is NaN");
+            if(fabs(ri)>1 || !std::isfinite(ri)) throw ParameterValueError("r is not in interval [-1,1]");
+            Th[2*i] = Ta[2*i] = Th[2*i+1] = Ta[2*i+1] = 0;
+            Tgh[2*i] = Tgh[2*i+1] = .5;
+            done[i] = true;
+            if(hi==-INFINITY || ki==-INFINITY) {
+                out[i] = 0;
+            } else if(hi==INFINITY && ki==INFINITY) {
+                out[i] = 1;
+            } else if(fabs(ri)==1) { //Degenerate case.
+                if(ri>0) out[i] = std::min(gh[i],gk[i]);
+                else out[i] = std::max(gh[i] - (1-gk[i]), 0.);
+            } else if(hi==0 && ki==0) {
+                out[i] = .25+asin(ri)*inv_2pi;
+            } else {
+                done[i] = false;
+                double sigma = sqrt(1-ri*ri);
+                Th[2*i] = hi;
+                Ta[2*i] = (ki-ri*hi)/(hi*sigma);
+                Tgh[2*i] = gh[i];
+                if(hi==ki) {
+                    base[i] = gh[i];
+                    Th[2*i+1] = hi; //Second term equals the first
+                    Ta[2*i+1] = Ta[2*i];
+                    Tgh[2*i+1] = gh[i];
+                } else if(hi==-ki) {
+                    base[i] = .5;
+                    Th[2*i+1] = hi;
+                    Ta[2*i+1] = Ta[2*i];
+                    Tgh[2*i+1] = gh[i];
+                } else {
+                    base[i] = .5*(gh[i]+gk[i]);
+                    Th[2*i+1] = ki;
+                    Ta[2*i+1] = (hi-ri*ki)/(ki*sigma);
+                    Tgh[2*i+1] = gk[i];
+                }
+                if( hi*ki < 0 || (hi*ki == 0 && (hi<0 || ki<0))) base[i] -= .5;
+            }
+        }
+        owen_t_integral_batch(2*N, Th, Ta, Tgh, T);
+        for(IdxT i=0; i<N; i++) {
+            if(done[i]) continue;
+            double bint = base[i] - T[2*i] - T[2*i+1];
+            out[i] = std::min(std::max(bint,0.0),1.0);
+        }
+    }
+} /* namespace */
+
+void unit_normal_cdf_batch(IdxT N, const double *t, double *out)
+{
+    unit_normal_cdf_vectorized(N, t, out);
+}
+
+void owen_t_integral_batch(IdxT N, const double *h, const double *a, const double *gh, double *T)
+{
+    for(IdxT i=0; i<N; i+=batch_chunk_size) 
+        owen_t_integral_chunk(std::min(batch_chunk_size, N-i), h+i, a+i, gh+i, T+i);
+}
+
+void bvn_cdf_batch(IdxT N, const double *h, const double *k, const double *r, double *out)
+{
+    for(IdxT i=0; i<N; i+=batch_chunk_size) 
+        bvn_cdf_chunk(std::min(batch_chunk_size, N-i), h+i, k+i, r+i, out+i);
+}
+
+} /* namespace prior_hessian */
@@ -0,0 +1,253 @@
+/** @file univariate_batch.cpp
+ * @author Mark J. Olah (mjo\@cs.unm DOT edu)
+ * @date 2017-2019
+ * @brief Array forms of llh, rllh, grad, grad2, and grad_grad2_accumulate for the univariate distributions.
+ *
+ * Each method evaluates N points with a branch-free kernel, so the loops are vectorized.  The logarithm is computed by
+ * log_kernel, which vectorizes where std::log does not.  Results agree with the scalar methods to a few ulp.
+ */
+#include "PriorHessian/NormalDist.h"
+#include "PriorHessian/GammaDist.h"
+#include "PriorHessian/ParetoDist.h"
+#include "PriorHessian/SymmetricBetaDist.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+
+/* Run-time dispatch to AVX-512 and AVX2 versions of the vectorized kernels, with a scalar fallback */
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define PRIOR_HESSIAN_SIMD_CLONES __attribute__((target_clones("avx512f","avx2","default")))
+#else
+#define PRIOR_HESSIAN_SIMD_CLONES
+#endif
+
+namespace prior_hessian {
+
+namespace {
+    /* log(x) with no branches so that it vectorizes.  Error < 1 ulp.  Special values follow std::log:
+     * log(0)=-inf, log(inf)=inf, and NaN for x<0 or NaN.  Subnormals are scaled by 2^52 into the normal range.
+     * The reduction and the polynomial for log(1+f) with f in [sqrt(2)/2-1, sqrt(2)-1] are those of fdlibm's e_log.c.
+     */
+    inline double log_kernel(double x)
+    {
+        const double ln2_hi = 6.93147180369123816490e-01;
+        const double ln2_lo = 1.90821492927058770002e-10;
+        const double two52 = 4503599627370496.0;
+        const double sqrt2 = 1.41421356237309504880;
+        const double Lg1 = 6.666666666666735130e-01, Lg2 = 3.999999999940941908e-01, Lg3 = 2.857142874366239149e-01,
+                     Lg4 = 2.222219843214978396e-01, Lg5 = 1.818357216161805012e-01, Lg6 = 1.531383769920937332e-01,
+                     Lg7 = 1.479819860511658591e-01;
+        bool subnormal = x < 2.2250738585072014e-308;
+        double xn = subnormal ? x*two52 : x;
+        std::uint64_t bits;
+        std::memcpy(&bits,&xn,sizeof(bits));
+        //Exponent as a double, by placing the biased exponent in the low mantissa bits of 2^52
+        std::uint64_t ebits = (bits >> 52) | 0x4330000000000000ULL;
+        double e;
+        std::memcpy(&e,&ebits,sizeof(e));
+        e = e - (two52 + 1023) - (subnormal ? 52 : 0);
+        //Mantissa m in [1,2), then m in (sqrt(2)/2, sqrt(2)]
+        bits = (bits & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL;
+        double m;
+        std::memcpy(&m,&bits,sizeof(m));
+        bool big = m > sqrt2;
+        m = big ? .5*m : m;
+        e = big ? e+1 : e;
+        double f = m - 1;
+        double s = f/(2+f);
+        double z = s*s;
+        double w = z*z;
+        double R = z*(Lg1 + w*(Lg3 + w*(Lg5 + w*Lg7))) + w*(Lg2 + w*(Lg4 + w*Lg6));
+        double hfsq = .5*f*f;
+        double r = e*ln2_hi - ((hfsq - (s*(hfsq + R) + e*ln2_lo)) - f);
+        r = x > 0 ? r : (x == 0 ? -INFINITY : NAN);
+        return x < INFINITY ? r : x;
+    }
+
+    /* Kernels take the distribution parameters by value, and the llh kernels add the constant c, which is 0 for rllh */
+    PRIOR_HESSIAN_SIMD_CLONES
+    void normal_rllh_kernel(IdxT N, const double *x, double mu, double sigma_inv, double c, double *out)
+    {
+        for(IdxT i=0; i<N; i++) out[i] = -.5*square((x[i] - mu)*sigma_inv) + c;
+    }
+
+    PRIOR_HESSIAN_SIMD_CLONES
+    void normal_grad_kernel(IdxT N, const double *x, double mu, double sigma_inv2, double *g)
+    {
+        for(IdxT i=0; i<N; i++) g[i] = -(x[i] - mu)*sigma_inv2;
+    }
+
+    PRIOR_HESSIAN_SIMD_CLONES
+    void normal_grad_grad2_kernel(IdxT N, const double *x, double mu, double sigma_inv2, double *g, double *g2)
+    {
+        for(IdxT i=0; i<N; i++) {
+            g[i]  += -(x[i] - mu)*sigma_inv2;
+            g2[i] += -sigma_inv2;
+        }
+    }
+
+    PRIOR_HESSIAN_SIMD_CLONES
+    void gamma_rllh_kernel(IdxT N, const double *x, double km1, double scale, double c, double *out)
+    {
+        for(IdxT i=0; i<N; i++) out[i] = (km1*log_kernel(x[i]) - x[i]/scale) + c;
+    }
+
+    PRIOR_HESSIAN_SIMD_CLONES
+    void gamma_grad_kernel(IdxT N, const double *x, double km1, double scale, double *g)
+    {
+        for(IdxT i=0; i<N; i++) g[i] = km1/x[i] - 1/scale;
+    }
+
+    PRIOR_HESSIAN_SIMD_CLONES
+    void gamma_grad2_kernel(IdxT N, const double *x, double km1, double *g2)
+    {
+        for(IdxT i=0; i<N; i++) g2[i] = -km1/(x[i]*x[i]);
+    }
+
+    PRIOR_HESSIAN_SIMD_CLONES
+    void gamma_grad_grad2_kernel(IdxT N, const double *x, double km1, double scale, double *g, double *g2)
+    {
+        for(IdxT i=0; i<N; i++) {
+            g[i]  += km1/x[i] - 1/scale;
+            g2[i] += -km1/(x[i]*x[i]);
+        }
+    }
+
+    PRIOR_HESSIAN_SIMD_CLONES
+    void pareto_rllh_kernel(IdxT N, const double *x, double ap1, double c, double *out)
+    {
+        for(IdxT i=0; i<N; i++) out[i] = -ap1*log_kernel(x[i]) + c;
+    }
+
+    PRIOR_HESSIAN_SIMD_CLONES
+    void pareto_grad_kernel(IdxT N, const double *x, double ap1, double *g)
+    {
+        for(IdxT i=0; i<N; i++) g[i] = -ap1/x[i];
+    }
+
+    PRIOR_HESSIAN_SIMD_CLONES
+    void pareto_grad2_kernel(IdxT N, const double *x, double ap1, double *g2)
+    {
+        for(IdxT i=0; i<N; i++) g2[i] = ap1/(x[i]*x[i]);
+    }
+
+    PRIOR_HESSIAN_SIMD_CLONES
+    void pareto_grad_grad2_kernel(IdxT N, const double *x, double ap1, double *g, double *g2)
+    {
+        for(IdxT i=0; i<N; i++) {
+            double x_inv = 1/x[i];
+            double ap1ox = ap1*x_inv;
+            g[i]  -= ap1ox;
+            g2[i] += ap1ox*x_inv;
+        }
+    }
+
+    PRIOR_HESSIAN_SIMD_CLONES
+    void symmetric_beta_rllh_kernel(IdxT N, const double *x, double bm1, double c, double *out)
+    {
+        for(IdxT i=0; i<N; i++) out[i] = bm1*log_kernel(x[i]*(1-x[i])) + c;
+    }
+
+    PRIOR_HESSIAN_SIMD_CLONES
+    void symmetric_beta_grad_kernel(IdxT N, const double *x, double bm1, double *g)
+    {
+        for(IdxT i=0; i<N; i++) g[i] = bm1*(1/x[i] - 1/(1-x[i]));
+    }
+
+    PRIOR_HESSIAN_SIMD_CLONES
+    void symmetric_beta_grad2_kernel(IdxT N, const double *x, double bm1, double *g2)
+    {
+        for(IdxT i=0; i<N; i++) g2[i] = bm1*(square(1/(1-x[i])) - square(1/x[i]));
+    }
+
+    PRIOR_HESSIAN_SIMD_CLONES
+    void symmetric_beta_grad_grad2_kernel(IdxT N, const double *x, double bm1, double *g, double *g2)
+    {
+        for(IdxT i=0; i<N; i++) {
+            double v = 1/(1-x[i]);
+            double x_inv = 1/x[i];
+            g[i]  += bm1*(x_inv-v);
+            g2[i] += bm1*(v*v-x_inv*x_inv);
+        }
+    }
+} /* namespace */
+
+/* NormalDist */
+void NormalDist::llh(IdxT N, const double *x, double *out) const
+{
+    if(!llh_const_initialized) initialize_llh_const();
+    normal_rllh_kernel(N, x, _mu, _sigma_inv, llh_const, out);
+}
+
+void NormalDist::rllh(IdxT N, const double *x, double *out) const
+{ normal_rllh_kernel(N, x, _mu, _sigma_inv, 0, out); }
+
+void NormalDist::grad(IdxT N, const double *x, double *out) const
+{ normal_grad_kernel(N, x, _mu, square(_sigma_inv), out); }
+
+void NormalDist::grad2(IdxT N, const double *, double *out) const
+{ std::fill_n(out, N, -square(_sigma_inv)); }
+
+void NormalDist::grad_grad2_accumulate(IdxT N, const double *x, double *g, double *g2) const
+{ normal_grad_grad2_kernel(N, x, _mu, square(_sigma_inv), g, g2); }
+
+/* GammaDist */
+void GammaDist::llh(IdxT N, const double *x, double *out) const
+{
+    if(!llh_const_initialized) initialize_llh_const();
+    gamma_rllh_kernel(N, x, _shape-1, _scale, llh_const, out);
+}
+
+void GammaDist::rllh(IdxT N, const double *x, double *out) const
+{ gamma_rllh_kernel(N, x, _shape-1, _scale, 0, out); }
+
+void GammaDist::grad(IdxT N, const double *x, double *out) const
+{ gamma_grad_kernel(N, x, _shape-1, _scale, out); }
+
+void GammaDist::grad2(IdxT N, const double *x, double *out) const
+{ gamma_grad2_kernel(N, x, _shape-1, out); }
+
+void GammaDist::grad_grad2_accumulate(IdxT N, const double *x, double *g, double *g2) const
+{ gamma_grad_grad2_kernel(N, x, _shape-1, _scale, g, g2); }
+
+/* ParetoDist */
+void ParetoDist::llh(IdxT N, const double *x, double *out) const
+{
+    if(!llh_const_initialized) initialize_llh_const();
+    pareto_rllh_kernel(N, x, alpha()+1, llh_const, out);
+}
+
+void ParetoDist::rllh(IdxT N, const double *x, double *out) const
+{ pareto_rllh_kernel(N, x, alpha()+1, 0, out); }
+
+void ParetoDist::grad(IdxT N, const double *x, double *out) const
+{ pareto_grad_kernel(N, x, alpha()+1, out); }
+
+void ParetoDist::grad2(IdxT N, const double *x, double *out) const
+{ pareto_grad2_kernel(N, x, alpha()+1, out); }
+
+void ParetoDist::grad_grad2_accumulate(IdxT N, const double *x, double *g, double *g2) const
+{ pareto_grad_grad2_kernel(N, x, alpha()+1, g, g2); }
+
+/* SymmetricBetaDist */
+void SymmetricBetaDist::llh(IdxT N, const double *x, double *out) const
+{
+    if(!llh_const_initialized) initialize_llh_const();
+    symmetric_beta_rllh_kernel(N, x, _beta-1, llh_const, out);
+}
+
+void SymmetricBetaDist::rllh(IdxT N, const double *x, double *out) const
+{ symmetric_beta_rllh_kernel(N, x, _beta-1, 0, out); }
+
+void SymmetricBetaDist::grad(IdxT N, const double *x, double *out) const
+{ symmetric_beta_grad_kernel(N, x, _beta-1, out); }
+
+void SymmetricBetaDist::grad2(IdxT N, const double *x, double *out) const
+{ symmetric_beta_grad2_kernel(N, x, _beta-1, out); }
+
+void SymmetricBetaDist::grad_grad2_accumulate(IdxT N, const double *x, double *g, double *g2) const
+{ symmetric_beta_grad_grad2_kernel(N, x, _beta-1, g, g2); }
+
+} /* namespace prior_hessian */
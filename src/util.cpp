@@ -14,6 +14,7 @@ namespace constants {
     const double sqrt2pi = std::sqrt(2.*arma::datum::pi);
     const double sqrt2pi_inv = 1./std::sqrt(2.*arma::datum::pi);
     const double log2pi = std::log(2.*arma::datum::pi);    
+    const double ln2 = std::log(2.);
 } /* namespace prior_hessian::constants */
 
 } /* namespace prior_hessian */
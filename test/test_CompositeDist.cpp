@@ -3,6 +3,11 @@
  * @date 2018
  */
 #include <cmath>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 #include "gtest/gtest.h"
 
 #include "test_prior_hessian.h"
@@ -1066,6 +1071,23 @@ TYPED_TEST(CompositeDistTest,grad_hess_accumulate) {
     }
 }
 
+TYPED_TEST(CompositeDistTest,rllh_grad_hess_accumulate) {
+    CompositeDist &composite = this->composite;
+    if(!composite) return; //Ignore empty dists.
+    for(IdxT n=0; n<this->Ntest; n++) {
+        auto v = composite.sample(env->get_rng());
+        ASSERT_TRUE(composite.in_bounds(v));
+        double rllh_acc = 0;
+        auto grad_acc = composite.make_zero_grad();
+        auto hess_acc = composite.make_zero_hess();
+        
+        composite.rllh_grad_hess_accumulate(v,rllh_acc,grad_acc,hess_acc);
+        ASSERT_DOUBLE_EQ(composite.rllh(v),rllh_acc);
+        ASSERT_TRUE(arma::approx_equal(composite.grad(v),grad_acc,"reldiff",1e-8))<<"Grad should matach rllh_grad_hess_accumulate";        
+        ASSERT_TRUE(arma::approx_equal(composite.hess(v),hess_acc,"reldiff",1e-8))<<"Hess should matach rllh_grad_hess_accumulate:"<<hess_acc;
+    }
+}
+
 TYPED_TEST(CompositeDistTest, rllh_components) {
     CompositeDist &composite = this->composite;
     if(!composite) return; //Ignore empty dists.
@@ -1128,3 +1150,375 @@ TYPED_TEST(CompositeDistTest, bulk_sample_repeatablity) {
     EXPECT_TRUE(arma::approx_equal(v11,v21,"absdiff",0))<<"Random number generation not repeatable."<<v11<<" "<<v21;
     EXPECT_TRUE(arma::approx_equal(v12,v22,"absdiff",0))<<"Random number generation not repeatable."<<v12<<" "<<v22;
 }
+
+TYPED_TEST(CompositeDistTest, parallel_sample) {
+    CompositeDist &composite = this->composite;
+    if(!composite) return; //Ignore empty dists.
+    IdxT N = 3*CompositeDist::batch_chunk_size + 17;
+    auto s1 = composite.sample(N,2019,1);
+    ASSERT_EQ(s1.n_rows, composite.num_dim());
+    ASSERT_EQ(s1.n_cols, N);
+    ASSERT_TRUE(composite.in_bounds_all(s1));
+    for(IdxT nthreads: {2,3,8,0}) {
+        auto s = composite.sample(N,2019,nthreads);
+        EXPECT_TRUE(arma::approx_equal(s1,s,"absdiff",0))<<"Parallel sampling should not depend on nthreads:"<<nthreads;
+    }
+    //Prefixes are reproducible too, since each chunk has its own substream
+    auto prefix = composite.sample(CompositeDist::batch_chunk_size+1,2019,2);
+    EXPECT_TRUE(arma::approx_equal(prefix.cols(0,CompositeDist::batch_chunk_size-1),s1.cols(0,CompositeDist::batch_chunk_size-1),"absdiff",0));
+    auto s2 = composite.sample(N,2020,2);
+    EXPECT_FALSE(arma::approx_equal(s1,s2,"absdiff",0))<<"Different seeds should give different samples.";
+}
+
+TYPED_TEST(CompositeDistTest, batch_llh) {
+    CompositeDist &composite = this->composite;
+    auto Ntest = this->Ntest;
+    if(!composite) return; //Ignore empty dists.
+    auto theta = composite.sample(env->get_rng(),Ntest);
+    auto llh = composite.llh(theta);
+    auto rllh = composite.rllh(theta);
+    auto llh_components = composite.llh_components(theta);
+    auto rllh_components = composite.rllh_components(theta);
+    ASSERT_EQ(llh.n_elem, Ntest);
+    ASSERT_EQ(rllh.n_elem, Ntest);
+    ASSERT_EQ(llh_components.n_rows, composite.num_components());
+    ASSERT_EQ(llh_components.n_cols, Ntest);
+    ASSERT_EQ(rllh_components.n_rows, composite.num_components());
+    ASSERT_EQ(rllh_components.n_cols, Ntest);
+    for(IdxT n=0; n<Ntest; n++) {
+        VecT v = theta.col(n);
+        //Batches use vectorized logarithms, which can differ from std::log by an ulp
+        double tol = 1E-13*(1 + arma::accu(arma::abs(composite.llh_components(v)))
+                              + arma::accu(arma::abs(composite.rllh_components(v))));
+        EXPECT_NEAR(llh(n), composite.llh(v), tol);
+        EXPECT_NEAR(rllh(n), composite.rllh(v), tol);
+        EXPECT_TRUE(arma::all(llh_components.col(n) == composite.llh_components(v)));
+        EXPECT_TRUE(arma::all(rllh_components.col(n) == composite.rllh_components(v)));
+    }
+}
+
+TYPED_TEST(CompositeDistTest, batch_grad_grad2) {
+    CompositeDist &composite = this->composite;
+    auto Ntest = this->Ntest;
+    if(!composite) return; //Ignore empty dists.
+    auto theta = composite.sample(env->get_rng(),Ntest);
+    auto grad = composite.grad(theta);
+    auto grad2 = composite.grad2(theta);
+    ASSERT_EQ(grad.n_rows, composite.num_dim());
+    ASSERT_EQ(grad.n_cols, Ntest);
+    ASSERT_EQ(grad2.n_rows, composite.num_dim());
+    ASSERT_EQ(grad2.n_cols, Ntest);
+    auto grad_acc = composite.make_zero_grad(Ntest);
+    auto grad2_acc = composite.make_zero_grad(Ntest);
+    composite.grad_grad2_accumulate(theta,grad_acc,grad2_acc);
+    for(IdxT n=0; n<Ntest; n++) {
+        VecT v = theta.col(n);
+        VecT g = composite.grad(v);
+        VecT g2 = composite.grad2(v);
+        EXPECT_TRUE(arma::approx_equal(g,VecT(grad.col(n)),"reldiff",1e-8));
+        EXPECT_TRUE(arma::approx_equal(g2,VecT(grad2.col(n)),"reldiff",1e-8));
+        EXPECT_TRUE(arma::approx_equal(g,VecT(grad_acc.col(n)),"reldiff",1e-8));
+        EXPECT_TRUE(arma::approx_equal(g2,VecT(grad2_acc.col(n)),"reldiff",1e-8));
+    }
+    MatT bad_grad(composite.num_dim(),Ntest+1,arma::fill::zeros);
+    EXPECT_THROW(composite.grad_accumulate(theta,bad_grad),ParameterSizeError);
+}
+
+TYPED_TEST(CompositeDistTest, batch_hess) {
+    CompositeDist &composite = this->composite;
+    auto Ntest = this->Ntest;
+    if(!composite) return; //Ignore empty dists.
+    auto theta = composite.sample(env->get_rng(),Ntest);
+    auto hess = composite.hess(theta);
+    ASSERT_EQ(hess.n_rows, composite.num_dim());
+    ASSERT_EQ(hess.n_cols, composite.num_dim());
+    ASSERT_EQ(hess.n_slices, Ntest);
+    auto grad_acc = composite.make_zero_grad(Ntest);
+    auto hess_acc = composite.make_zero_hess(Ntest);
+    composite.grad_hess_accumulate(theta,grad_acc,hess_acc);
+    for(IdxT n=0; n<Ntest; n++) {
+        VecT v = theta.col(n);
+        MatT h = composite.hess(v);
+        EXPECT_TRUE(arma::approx_equal(h,hess.slice(n),"reldiff",1e-8));
+        EXPECT_TRUE(arma::approx_equal(composite.grad(v),VecT(grad_acc.col(n)),"reldiff",1e-8));
+        EXPECT_TRUE(arma::approx_equal(h,hess_acc.slice(n),"reldiff",1e-8));
+    }
+    CubeT bad_hess(composite.num_dim(),composite.num_dim(),Ntest-1,arma::fill::zeros);
+    EXPECT_THROW(composite.hess_accumulate(theta,bad_hess),ParameterSizeError);
+}
+
+TYPED_TEST(CompositeDistTest, batch_parallel_repeatability) {
+    CompositeDist &composite = this->composite;
+    if(!composite) return; //Ignore empty dists.
+    IdxT N = 5*CompositeDist::batch_chunk_size+7;
+    auto theta = composite.sample(env->get_rng(),N);
+    composite.set_num_threads(1);
+    auto llh1 = composite.llh(theta);
+    auto rllh_comp1 = composite.rllh_components(theta);
+    auto grad1 = composite.grad(theta);
+    auto hess1 = composite.hess(theta);
+    for(IdxT nthreads : {2,3,8}) {
+        composite.set_num_threads(nthreads);
+        ASSERT_EQ(composite.num_threads(),nthreads);
+        CompositeDist copy(composite);
+        ASSERT_EQ(copy.num_threads(),nthreads);
+        EXPECT_TRUE(arma::approx_equal(llh1,composite.llh(theta),"absdiff",0))<<"Parallel llh not repeatable.";
+        EXPECT_TRUE(arma::approx_equal(rllh_comp1,composite.rllh_components(theta),"absdiff",0))<<"Parallel rllh_components not repeatable.";
+        EXPECT_TRUE(arma::approx_equal(grad1,composite.grad(theta),"absdiff",0))<<"Parallel grad not repeatable.";
+        EXPECT_TRUE(arma::approx_equal(hess1,composite.hess(theta),"absdiff",0))<<"Parallel hess not repeatable.";
+    }
+    composite.set_num_threads(1);
+}
+
+/* Lazily computed constants are initialized before the workers start, and batches requested concurrently from
+ * several threads, which share the thread pool, are still correct.
+ */
+TYPED_TEST(CompositeDistTest, batch_parallel_lazy_constants_and_concurrent_callers) {
+    CompositeDist &composite = this->composite;
+    if(!composite) return; //Ignore empty dists.
+    IdxT N = 5*CompositeDist::batch_chunk_size+7;
+    auto theta = composite.sample(env->get_rng(),N);
+    composite.set_num_threads(1);
+    auto llh1 = composite.llh(theta);
+    auto pgrad1 = composite.param_grad(theta);
+    for(IdxT rep=0; rep<3; rep++) {
+        CompositeDist par(composite);
+        par.set_num_threads(4);
+        par.set_params(composite.params()); //Reset lazy constants
+        EXPECT_TRUE(arma::approx_equal(llh1,par.llh(theta),"absdiff",0))<<"Parallel llh not repeatable.";
+        par.set_params(composite.params());
+        EXPECT_TRUE(arma::approx_equal(pgrad1,par.param_grad(theta),"absdiff",0))<<"Parallel param_grad not repeatable.";
+    }
+    std::vector<VecT> llhs(3);
+    std::vector<std::thread> callers;
+    for(IdxT t=0; t<llhs.size(); t++)
+        callers.emplace_back([&,t]{
+            CompositeDist par(composite);
+            par.set_num_threads(3);
+            for(IdxT rep=0; rep<5; rep++) llhs[t] = par.llh(theta);
+        });
+    for(auto &caller: callers) caller.join();
+    for(auto &llh: llhs) EXPECT_TRUE(arma::approx_equal(llh1,llh,"absdiff",0))<<"Concurrent parallel llh not repeatable.";
+}
+
+TYPED_TEST(CompositeDistTest, block_hess) {
+    CompositeDist &composite = this->composite;
+    if(!composite) return; //Ignore empty dists.
+    for(IdxT n=0; n<this->Ntest; n++) {
+        auto v = composite.sample(env->get_rng());
+        MatT hess = arma::symmatu(composite.hess(v));
+        auto block_hess = composite.block_hess(v);
+        ASSERT_EQ(block_hess.num_dim(),composite.num_dim());
+        ASSERT_EQ(block_hess.num_blocks(),composite.num_components());
+        EXPECT_TRUE(arma::approx_equal(hess,block_hess.to_dense(),"reldiff",1e-8));
+        EXPECT_TRUE(arma::approx_equal(hess,MatT(block_hess.to_sp_mat()),"reldiff",1e-8));
+
+        auto grad_acc = composite.make_zero_grad();
+        auto block_hess_acc = composite.make_zero_block_hess();
+        composite.grad_hess_accumulate(v,grad_acc,block_hess_acc);
+        EXPECT_TRUE(arma::approx_equal(composite.grad(v),grad_acc,"reldiff",1e-8));
+        EXPECT_TRUE(arma::approx_equal(hess,block_hess_acc.to_dense(),"reldiff",1e-8));
+    }
+}
+
+TYPED_TEST(CompositeDistTest, block_hess_solve_logdet_inverse) {
+    CompositeDist &composite = this->composite;
+    if(!composite) return; //Ignore empty dists.
+    for(IdxT n=0; n<this->Ntest; n++) {
+        auto v = composite.sample(env->get_rng());
+        auto block_hess = composite.block_hess(v);
+        MatT hess = block_hess.to_dense();
+        VecT b = composite.sample(env->get_rng());
+        EXPECT_TRUE(arma::approx_equal(VecT(arma::solve(hess,b)),block_hess.solve(b),"reldiff",1e-6));
+        double val, sign, block_sign;
+        arma::log_det(val,sign,hess);
+        EXPECT_NEAR(val,block_hess.logdet(block_sign),1e-6*std::max(1.0,std::fabs(val)));
+        EXPECT_EQ(sign,block_sign);
+        EXPECT_TRUE(arma::approx_equal(MatT(arma::inv(hess)),block_hess.inverse().to_dense(),"reldiff",1e-6));
+    }
+}
+
+TYPED_TEST(CompositeDistTest, hessvec) {
+    CompositeDist &composite = this->composite;
+    if(!composite) return; //Ignore empty dists.
+    for(IdxT n=0; n<this->Ntest; n++) {
+        auto theta = composite.sample(env->get_rng());
+        VecT v = composite.sample(env->get_rng());
+        VecT hv = arma::symmatu(composite.hess(theta))*v;
+        EXPECT_TRUE(arma::approx_equal(hv,composite.hessvec(theta,v),"both",1e-8,1e-8));
+        VecT hv_acc = composite.grad(theta);
+        composite.hessvec_accumulate(theta,v,hv_acc);
+        EXPECT_TRUE(arma::approx_equal(VecT(hv+composite.grad(theta)),hv_acc,"both",1e-8,1e-8));
+    }
+}
+
+TYPED_TEST(CompositeDistTest, param_grad_hess) {
+    CompositeDist &composite = this->composite;
+    if(!composite) return; //Ignore empty dists.
+    auto Nparams = composite.num_params();
+    auto Ntest = this->Ntest;
+    auto theta = composite.sample(env->get_rng(),Ntest);
+    auto pgrad = composite.param_grad(theta);
+    auto phess = composite.param_hess(theta);
+    ASSERT_EQ(pgrad.n_rows, Nparams);
+    ASSERT_EQ(pgrad.n_cols, Ntest);
+    ASSERT_EQ(phess.n_rows, Nparams);
+    ASSERT_EQ(phess.n_cols, Nparams);
+    ASSERT_EQ(phess.n_slices, Ntest);
+    VecT params = composite.params();
+    for(IdxT n=0; n<Ntest; n++) {
+        VecT v = theta.col(n);
+        VecT g = composite.param_grad(v);
+        MatT h = composite.param_hess(v);
+        EXPECT_TRUE(g.is_finite());
+        EXPECT_TRUE(h.is_finite());
+        EXPECT_TRUE(arma::approx_equal(g,VecT(pgrad.col(n)),"reldiff",1e-8));
+        EXPECT_TRUE(arma::approx_equal(h,phess.slice(n),"reldiff",1e-8));
+        EXPECT_TRUE(arma::all(arma::vectorise(arma::trimatl(h,-1))==0))<<"param_hess should be upper triangular.";
+        VecT g_acc(Nparams,arma::fill::zeros);
+        MatT h_acc(Nparams,Nparams,arma::fill::zeros);
+        composite.param_grad_hess_accumulate(v,g_acc,h_acc);
+        EXPECT_TRUE(arma::approx_equal(g,g_acc,"reldiff",1e-8));
+        EXPECT_TRUE(arma::approx_equal(h,h_acc,"reldiff",1e-8));
+    }
+    //The composite parameter gradient is the gradient of llh over the params() vector
+    VecT v = theta.col(0);
+    VecT g = composite.param_grad(v);
+    for(IdxT i=0; i<Nparams; i++) {
+        double step = 1e-6*std::max(1.0,std::fabs(params(i)));
+        CompositeDist dp(composite), dm(composite);
+        VecT pp = params, pm = params;
+        pp(i) += step;
+        pm(i) -= step;
+        dp.set_params(pp);
+        dm.set_params(pm);
+        double fd = (dp.llh(v)-dm.llh(v))/(2*step);
+        EXPECT_NEAR(g(i),fd,1e-4*std::max(1.0,std::fabs(fd)))<<"param:"<<i;
+    }
+    MatT bad_pgrad(Nparams+1,Ntest,arma::fill::zeros);
+    EXPECT_THROW(composite.param_grad_accumulate(theta,bad_pgrad),ParameterSizeError);
+}
+
+TEST(AnyRngTest, generate_block) {
+    std::mt19937_64 rng1(1), rng2(1);
+    CompositeDist::AnyRngT any_rng(rng1);
+    std::vector<std::size_t> block(1000);
+    any_rng.generate_block(block.data(), block.size());
+    for(auto v: block) ASSERT_EQ(v, rng2());
+    //Buffered draws are the same sequence, and cross block boundaries seamlessly
+    ASSERT_TRUE(CompositeDist::BufferedRngT::is_full_range(any_rng));
+    {
+        CompositeDist::BufferedRngT buffered_rng(any_rng);
+        for(int n=0; n<1000; n++) ASSERT_EQ(buffered_rng(), rng2());
+    }
+    //Unused buffered numbers are returned, so the generator is where direct draws would have left it
+    EXPECT_EQ(rng1(), rng2());
+    //std::mt19937 only has the full range of its result_type if uint_fast32_t is 32 bits
+    using Result32T = std::mt19937::result_type;
+    std::mt19937 rng32;
+    any_rng::AnyRng<Result32T> any_rng32(rng32);
+    bool full_range = any_rng::BufferedRng<Result32T>::is_full_range(any_rng32);
+    EXPECT_EQ(full_range, sizeof(Result32T)==4);
+    if(!full_range) EXPECT_THROW(any_rng::BufferedRng<Result32T>{any_rng32}, std::invalid_argument);
+}
+
+/* A full-range generator that cannot be copied, so AnyRng cannot rewind it */
+class NoCopyRng : public std::mt19937_64 {
+public:
+    NoCopyRng() = default;
+    NoCopyRng(const NoCopyRng&) = delete;
+    NoCopyRng& operator=(const NoCopyRng&) = delete;
+};
+
+TEST(AnyRngTest, buffered_without_rewind) {
+    //Generators that cannot be rewound still work with BufferedRng, which then leaves them at the end of the block
+    NoCopyRng rng1;
+    std::mt19937_64 rng2;
+    CompositeDist::AnyRngT any_rng(rng1);
+    EXPECT_FALSE(any_rng.can_rewind());
+    EXPECT_THROW(any_rng.rewind_to_mark(0), std::logic_error);
+    {
+        CompositeDist::BufferedRngT buffered_rng(any_rng);
+        EXPECT_FALSE(buffered_rng.returns_unused());
+        for(int n=0; n<10; n++) ASSERT_EQ(buffered_rng(), rng2());
+    }
+    rng2.discard(256-10);
+    EXPECT_EQ(rng1(), rng2());
+    //Callers that do not need the exact end position can skip saving the state of rewindable generators
+    std::mt19937_64 rng3;
+    CompositeDist::AnyRngT any_rng3(rng3);
+    EXPECT_TRUE(any_rng3.can_rewind());
+    {
+        CompositeDist::BufferedRngT buffered_rng(any_rng3,false);
+        EXPECT_FALSE(buffered_rng.returns_unused());
+        for(int n=0; n<10; n++) buffered_rng();
+    }
+    std::mt19937_64 rng4;
+    rng4.discard(256);
+    EXPECT_EQ(rng3(), rng4());
+}
+
+/* Known answer tests from the Random123 distribution (kat_vectors, philox4x64_10) */
+TEST(PhiloxTest, known_answers) {
+    using rng::philox4x64;
+    using CounterT = philox4x64::CounterT;
+    CounterT c0 = philox4x64::generate_block({{0,0}}, {{0,0,0,0}});
+    EXPECT_EQ(c0, (CounterT{{0x16554d9eca36314cULL, 0xdb20fe9d672d0fdcULL, 0xd7e772cee186176bULL, 0x7e68b68aec7ba23bULL}}));
+    const std::uint64_t ones = ~std::uint64_t{0};
+    CounterT c1 = philox4x64::generate_block({{ones,ones}}, {{ones,ones,ones,ones}});
+    EXPECT_EQ(c1, (CounterT{{0x87b092c3013fe90bULL, 0x438c3c67be8d0224ULL, 0x9cc7d7c69cd777b6ULL, 0xa09caebf594f0ba0ULL}}));
+    CounterT c2 = philox4x64::generate_block({{0x452821e638d01377ULL, 0xbe5466cf34e90c6cULL}}, 
+                    {{0x243f6a8885a308d3ULL, 0x13198a2e03707344ULL, 0xa4093822299f31d0ULL, 0x082efa98ec4e6c89ULL}});
+    EXPECT_EQ(c2, (CounterT{{0xa528f45403e61d95ULL, 0x38c72dbd566e9788ULL, 0xa5a1610e72fd18b5ULL, 0x57bd43b5e52b7fe6ULL}}));
+}
+
+TEST(PhiloxTest, discard) {
+    rng::philox4x64 rng(42,3,7);
+    std::vector<std::uint64_t> v(1000);
+    for(auto &x: v) x = rng();
+    EXPECT_EQ(rng.position(), 1000u);
+    for(IdxT k: {0,1,3,4,5,17,998}) {
+        rng::philox4x64 r(42,3,7);
+        r.discard(k/2);
+        r.discard(k-k/2);
+        EXPECT_EQ(r.position(), k);
+        EXPECT_EQ(r(), v[k])<<"k:"<<k;
+    }
+    rng::philox4x64 r(42,3,7);
+    r.discard(5);
+    std::stringstream state;
+    state<<r;
+    rng::philox4x64 r2;
+    state>>r2;
+    EXPECT_EQ(r,r2);
+    EXPECT_EQ(r(),r2());
+    //Streams and substreams differ
+    rng::philox4x64 a(42,3,7), b(42,3,8), c(42,4,7);
+    auto x = a();
+    EXPECT_NE(x, b());
+    EXPECT_NE(x, c());
+}
+
+/* RandomNumberEngine seeding from a seed sequence */
+TEST(PhiloxTest, seed_seq) {
+    std::seed_seq seq{1,2,3};
+    rng::philox4x64 a(seq), b(seq);
+    EXPECT_EQ(a,b);
+    rng::philox4x64 c;
+    c.seed(seq);
+    EXPECT_EQ(a,c);
+    auto x = a();
+    EXPECT_EQ(x, b());
+    EXPECT_EQ(x, c());
+    std::seed_seq other{1,2,4};
+    rng::philox4x64 d(other);
+    EXPECT_NE(x, d());
+    //Integer seeds and copies still select the non-template constructors
+    std::uint64_t s = 42;
+    rng::philox4x64 e(s), f(42);
+    EXPECT_EQ(e,f);
+    rng::philox4x64 g(e);
+    EXPECT_EQ(g,e);
+    g.seed(s);
+    EXPECT_EQ(g(), rng::philox4x64(42)());
+}
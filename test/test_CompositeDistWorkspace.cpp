@@ -0,0 +1,206 @@
+/** @file test_CompositeDistWorkspace.cpp
+ * @author Mark J. Olah (mjo\@cs.unm DOT edu)
+ * @date 2019
+ * @brief Checks the CompositeDist workspace methods do no heap allocation after warm-up.
+ *
+ * Allocations are counted by interposing the glibc malloc family, so this file is built as its own test executable
+ * (see CMakeLists.txt) rather than globbed into the main one.  Armadillo
+ * allocates with posix_memalign (or malloc), and operator new is implemented with malloc, so all heap allocations
+ * are seen.  On other platforms, or under a sanitizer, counting is disabled and the allocation checks are skipped.
+ */
+#include <cmath>
+#include <atomic>
+#include <cstdlib>
+#include <cerrno>
+#include "gtest/gtest.h"
+
+#include "test_prior_hessian.h"
+#include "test_multivariate.h"
+#include "test_univariate.h"
+#include "PriorHessian/CompositeDist.h"
+#include "PriorHessian/AMHCopula.h"
+#include "PriorHessian/CopulaDist.h"
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+#define TEST_PRIOR_HESSIAN_COUNT_ALLOCATIONS 1
+#else
+#define TEST_PRIOR_HESSIAN_COUNT_ALLOCATIONS 0
+#endif
+
+namespace allocation_counter {
+    std::atomic<std::size_t> num_allocations{0};
+}
+
+#if TEST_PRIOR_HESSIAN_COUNT_ALLOCATIONS
+extern "C" {
+    void* __libc_malloc(std::size_t size);
+    void* __libc_calloc(std::size_t n, std::size_t size);
+    void* __libc_realloc(void *p, std::size_t size);
+    void* __libc_memalign(std::size_t alignment, std::size_t size);
+    void __libc_free(void *p);
+
+    void* malloc(std::size_t size) __THROW
+    {
+        allocation_counter::num_allocations++;
+        return __libc_malloc(size);
+    }
+
+    void* calloc(std::size_t n, std::size_t size) __THROW
+    {
+        allocation_counter::num_allocations++;
+        return __libc_calloc(n,size);
+    }
+
+    void* realloc(void *p, std::size_t size) __THROW
+    {
+        allocation_counter::num_allocations++;
+        return __libc_realloc(p,size);
+    }
+
+    int posix_memalign(void **p, std::size_t alignment, std::size_t size) __THROW
+    {
+        allocation_counter::num_allocations++;
+        *p = __libc_memalign(alignment,size);
+        return *p ? 0 : ENOMEM;
+    }
+
+    void free(void *p) __THROW
+    {
+        __libc_free(p);
+    }
+}
+#endif
+
+using namespace prior_hessian;
+
+/* Counts heap allocations made from construction until allocations() is called */
+class AllocationCounter {
+public:
+    AllocationCounter() : start{allocation_counter::num_allocations.load()} { }
+    std::size_t allocations() const { return allocation_counter::num_allocations.load() - start; }
+    static constexpr bool enabled() { return TEST_PRIOR_HESSIAN_COUNT_ALLOCATIONS; }
+private:
+    std::size_t start;
+};
+
+using AMHCopulaDistT = CopulaDist<AMHCopula, TruncatedNormalDist, TruncatedGammaDist>;
+using CopulaCompositeTupleT = std::tuple<AMHCopulaDistT, NormalDist, MultivariateNormalDist<2>>;
+
+/* Randomly initializes the component distributions of a composite */
+template<class TupleT>
+void initialize_workspace_dists(TupleT &dists)
+{
+    initialize_distribution_tuple(dists);
+}
+
+template<>
+void initialize_workspace_dists(CopulaCompositeTupleT &dists)
+{
+    AMHCopulaDistT::MarginalDistTupleT marginals;
+    initialize_distribution_tuple(marginals);
+    AMHCopulaDistT::CopulaT copula;
+    copula.set_theta(env->sample_real(copula.param_lbound(), copula.param_ubound()));
+    std::get<0>(dists).initialize_copula(copula);
+    std::get<0>(dists).initialize_marginals(marginals);
+    initialize_dist<NormalDist>(std::get<1>(dists));
+    initialize_dist<MultivariateNormalDist<2>>(std::get<2>(dists));
+}
+
+template<class TupleT>
+class CompositeDistWorkspaceTest : public ::testing::Test {
+public:
+    TupleT dists;
+    CompositeDist composite;
+    static constexpr IdxT Ntest = 100;
+    virtual void SetUp() override {
+        env->reset_rng();
+        initialize_workspace_dists(dists);
+        composite.initialize(dists);
+    }
+};
+
+/* Includes composites with num_dim > 4, where outputs are too large for armadillo's preallocated local storage */
+using CompositeDistWorkspaceTestTs = ::testing::Types<
+    std::tuple<NormalDist, GammaDist, ParetoDist, SymmetricBetaDist>,
+    std::tuple<TruncatedDist<NormalDist>, NormalDist, TruncatedDist<GammaDist>, ScaledSymmetricBetaDist, TruncatedParetoDist>,
+    std::tuple<MultivariateNormalDist<4>, NormalDist, GammaDist>,
+    std::tuple<NormalDist,MultivariateNormalDist<2>,TruncatedGammaDist,MultivariateNormalDist<2>>,
+    CopulaCompositeTupleT
+    >;
+
+TYPED_TEST_SUITE_COMPAT(CompositeDistWorkspaceTest, CompositeDistWorkspaceTestTs);
+
+TYPED_TEST(CompositeDistWorkspaceTest, workspace_matches_allocating) {
+    CompositeDist &composite = this->composite;
+    VecT grad, grad2, grad_b, grad2_b;
+    MatT hess, hess_b;
+    for(IdxT n=0; n<this->Ntest; n++) {
+        VecT v = composite.sample(env->get_rng());
+        composite.grad(v,grad);
+        composite.grad2(v,grad2);
+        composite.hess(v,hess);
+        EXPECT_TRUE(arma::all(grad == composite.grad(v)));
+        EXPECT_TRUE(arma::all(grad2 == composite.grad2(v)));
+        EXPECT_TRUE(arma::approx_equal(hess,composite.hess(v),"absdiff",0));
+        //Fused methods may round differently, e.g., ParetoDist computes (alpha+1)/x^2 as ((alpha+1)/x)/x
+        composite.grad_grad2(v,grad_b,grad2_b);
+        EXPECT_TRUE(arma::approx_equal(grad,grad_b,"reldiff",1e-14));
+        EXPECT_TRUE(arma::approx_equal(grad2,grad2_b,"reldiff",1e-14));
+        composite.grad_hess(v,grad_b,hess_b);
+        EXPECT_TRUE(arma::approx_equal(grad,grad_b,"reldiff",1e-14));
+        EXPECT_TRUE(arma::approx_equal(hess,hess_b,"reldiff",1e-14));
+    }
+}
+
+TYPED_TEST(CompositeDistWorkspaceTest, single_point_zero_allocation) {
+    if(!AllocationCounter::enabled()) return; //Allocation counting not supported
+    CompositeDist &composite = this->composite;
+    MatT theta = composite.sample(env->get_rng(),this->Ntest);
+    VecT v(composite.num_dim());
+    VecT grad, grad2;
+    MatT hess;
+    //Warm-up: sizes buffers and initializes lazily computed constants
+    v = theta.col(0);
+    composite.grad(v,grad);
+    composite.grad2(v,grad2);
+    composite.hess(v,hess);
+    composite.llh(v);
+
+    double llh = 0;
+    AllocationCounter counter;
+    for(IdxT n=0; n<this->Ntest; n++) {
+        std::copy_n(theta.colptr(n), composite.num_dim(), v.memptr());
+        llh += composite.llh(v);
+        llh += composite.rllh(v);
+        composite.grad(v,grad);
+        composite.grad2(v,grad2);
+        composite.hess(v,hess);
+        composite.grad_grad2(v,grad,grad2);
+        composite.grad_hess(v,grad,hess);
+    }
+    auto num_allocations = counter.allocations();
+    EXPECT_EQ(num_allocations,0u)<<"Workspace methods should not allocate after warm-up.";
+    EXPECT_TRUE(std::isfinite(llh));
+}
+
+TYPED_TEST(CompositeDistWorkspaceTest, batch_zero_allocation) {
+    if(!AllocationCounter::enabled()) return; //Allocation counting not supported
+    CompositeDist &composite = this->composite;
+    MatT theta = composite.sample(env->get_rng(),this->Ntest);
+    MatT grad, grad2;
+    CubeT hess;
+    //Warm-up
+    composite.grad(theta,grad);
+    composite.grad2(theta,grad2);
+    composite.hess(theta,hess);
+
+    AllocationCounter counter;
+    for(IdxT n=0; n<10; n++) {
+        composite.grad(theta,grad);
+        composite.grad2(theta,grad2);
+        composite.hess(theta,hess);
+        composite.grad_hess_accumulate(theta,grad,hess);
+    }
+    auto num_allocations = counter.allocations();
+    EXPECT_EQ(num_allocations,0u)<<"Batched workspace methods should not allocate after warm-up.";
+}
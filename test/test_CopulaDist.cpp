@@ -44,8 +44,8 @@ public:
 };
 
 using CopulaDistTestTs = ::testing::Types<
-    CopulaDist<AMHCopula, TruncatedNormalDist, TruncatedNormalDist>>;
-//     CopulaDist<AMHCopula, TruncatedGammaDist, TruncatedGammaDist>>;
+    CopulaDist<AMHCopula, TruncatedNormalDist, TruncatedNormalDist>,
+    CopulaDist<AMHCopula, TruncatedGammaDist, TruncatedParetoDist>>;
     
 TYPED_TEST_SUITE_COMPAT(CopulaDistTest, CopulaDistTestTs);
 
@@ -83,3 +83,321 @@ TYPED_TEST(CopulaDistTest, num_params)
 //     TypeParam dist_copy(dist);
 //     check_equal(dist, dist_copy);
 // }
+
+TYPED_TEST(CopulaDistTest, sample) 
+{
+    auto &dist = this->dist;
+    auto Ntest = this->Ntest;
+    for(IdxT n=0; n<Ntest; n++) {
+        auto x = dist.sample(env->get_rng());
+        EXPECT_TRUE(arma::all(dist.lbound() <= x) && arma::all(x <= dist.ubound()))<<"x:"<<x.t();
+    }
+    MatT X = dist.sample(env->get_rng(),Ntest);
+    ASSERT_EQ(X.n_rows, dist.num_dim());
+    ASSERT_EQ(X.n_cols, Ntest);
+    for(IdxT n=0; n<Ntest; n++) 
+        EXPECT_TRUE(arma::all(dist.lbound() <= X.col(n)) && arma::all(X.col(n) <= dist.ubound()))<<"x:"<<X.col(n).t();
+}
+
+TYPED_TEST(CopulaDistTest, rllh_grad_hess_accumulate) 
+{
+    auto &dist = this->dist;
+    auto Ntest = this->Ntest;
+    IdxT N = dist.num_dim();
+    const double eps = 1e-6;
+    for(IdxT n=0; n<Ntest; n++) {
+        VecT x = dist.sample(env->get_rng());
+        double rllh = 0;
+        VecT g(N,arma::fill::zeros);
+        MatT H(N,N,arma::fill::zeros);
+        dist.rllh_grad_hess_accumulate(x,rllh,g,H);
+        ASSERT_TRUE(std::isfinite(rllh));
+        EXPECT_NEAR(rllh, dist.rllh(x), 1e-10*(1+std::fabs(rllh)));
+        ASSERT_TRUE(arma::approx_equal(g, VecT(dist.grad(x)), "absdiff", 1e-10*(1+arma::abs(g).max())));
+        MatT hess = dist.hess(x);
+        ASSERT_TRUE(arma::approx_equal(MatT(arma::symmatu(H)), hess, "absdiff", 1e-10*(1+arma::abs(hess).max())));
+        ASSERT_TRUE(arma::approx_equal(VecT(dist.grad2(x)), VecT(hess.diag()), "absdiff", 1e-10*(1+arma::abs(hess).max())));
+        //Central differences, staying inside the bounds
+        for(IdxT i=0; i<N; i++) {
+            double h = std::min({eps*(1+std::fabs(x(i))), (x(i)-dist.lbound()(i))/2, (dist.ubound()(i)-x(i))/2});
+            VecT xp = x, xm = x;
+            xp(i) += h;
+            xm(i) -= h;
+            double fd_grad = (dist.rllh(xp)-dist.rllh(xm))/(2*h);
+            EXPECT_NEAR(fd_grad, g(i), 1e-4*(1+std::fabs(g(i))))<<"i:"<<i<<" x:"<<x.t();
+            VecT fd_hess = (VecT(dist.grad(xp))-VecT(dist.grad(xm)))/(2*h);
+            for(IdxT j=0; j<N; j++) 
+                EXPECT_NEAR(fd_hess(j), hess(i,j), 1e-4*(1+std::fabs(hess(i,j))))<<"i:"<<i<<" j:"<<j<<" x:"<<x.t();
+        }
+    }
+}
+
+TYPED_TEST(CopulaDistTest, hessvec) 
+{
+    auto &dist = this->dist;
+    auto Ntest = this->Ntest;
+    IdxT N = dist.num_dim();
+    for(IdxT n=0; n<Ntest; n++) {
+        VecT x = dist.sample(env->get_rng());
+        VecT v(N);
+        for(IdxT i=0; i<N; i++) v(i) = env->sample_real(-1,1);
+        MatT hess = dist.hess(x);
+        VecT hv = hess*v;
+        VecT hessvec = dist.hessvec(x,v);
+        ASSERT_EQ(hessvec.n_elem, N);
+        EXPECT_TRUE(arma::approx_equal(hessvec, hv, "absdiff", 1e-10*(1+arma::abs(hess).max())))
+            <<"hessvec:"<<hessvec.t()<<" hess*v:"<<hv.t();
+    }
+}
+
+TYPED_TEST(CopulaDistTest, params) 
+{
+    auto &dist = this->dist;
+    auto p = dist.params();
+    ASSERT_EQ(p.n_elem, dist.num_params());
+    EXPECT_EQ(p(0), this->copula.theta());
+    EXPECT_TRUE(arma::all(p.subvec(1,p.n_elem-1) == this->composite.params()));
+    EXPECT_EQ(dist.param_names().size(), dist.num_params());
+    EXPECT_TRUE(arma::all(dist.param_lbound() <= p) && arma::all(p <= dist.param_ubound()));
+    auto p2 = p;
+    p2(0) = this->copula.theta()/2;
+    dist.set_params(p2);
+    EXPECT_TRUE(arma::all(dist.params() == p2));
+}
+
+/* Parameter derivatives are checked against central finite differences of llh and param_grad */
+TYPED_TEST(CopulaDistTest, param_grad_hess) 
+{
+    auto &dist = this->dist;
+    auto Ntest = this->Ntest;
+    IdxT Np = dist.num_params();
+    const auto p0 = dist.params();
+    for(IdxT n=0; n<Ntest; n++) {
+        VecT x = dist.sample(env->get_rng());
+        VecT g = dist.param_grad(x);
+        MatT h = dist.param_hess(x);
+        ASSERT_TRUE(g.is_finite());
+        ASSERT_TRUE(h.is_finite());
+        ASSERT_TRUE(arma::approx_equal(h, MatT(h.t()), "absdiff", 1e-12*(1+arma::abs(h).max())));
+        for(IdxT i=0; i<Np; i++) {
+            double step = 1e-6*std::max(1.0,std::fabs(p0(i)));
+            TypeParam dp(dist), dm(dist);
+            auto pp = p0, pm = p0;
+            pp(i) += step;
+            pm(i) -= step;
+            dp.set_params(pp);
+            dm.set_params(pm);
+            double fd_grad = (dp.llh(x)-dm.llh(x))/(2*step);
+            EXPECT_NEAR(g(i), fd_grad, 1e-4*std::max(1.0,std::fabs(fd_grad)))<<"param:"<<i<<" x:"<<x.t();
+            VecT fd_hess = (VecT(dp.param_grad(x))-VecT(dm.param_grad(x)))/(2*step);
+            for(IdxT j=0; j<Np; j++)
+                EXPECT_NEAR(h(j,i), fd_hess(j), 1e-4*std::max(1.0,std::fabs(fd_hess(j))))<<"param:"<<j<<","<<i<<" x:"<<x.t();
+        }
+    }
+}
+
+/* A CopulaDist is a component of a CompositeDist like any other MultivariateDist */
+TYPED_TEST(CopulaDistTest, composite_param_grad_hess) 
+{
+    auto &dist = this->dist;
+    NormalDist normal(1,2);
+    CompositeDist composite(std::make_tuple(dist,normal));
+    IdxT N = dist.num_dim();
+    IdxT Np = dist.num_params();
+    ASSERT_EQ(composite.num_dim(), N+1);
+    ASSERT_EQ(composite.num_params(), Np+2);
+    for(IdxT n=0; n<this->Ntest; n++) {
+        VecT x = composite.sample(env->get_rng());
+        VecT xc = x.subvec(0,N-1);
+        EXPECT_NEAR(composite.llh(x), dist.llh(xc)+normal.llh(x(N)), 1e-10);
+        VecT g = composite.param_grad(x);
+        MatT h = composite.param_hess(x);
+        VecT gc = dist.param_grad(xc);
+        MatT hc = dist.param_hess(xc);
+        EXPECT_TRUE(arma::approx_equal(VecT(g.subvec(0,Np-1)), gc, "absdiff", 1e-10*(1+arma::abs(gc).max())));
+        EXPECT_TRUE(arma::approx_equal(MatT(h.submat(0,0,Np-1,Np-1)), MatT(arma::trimatu(hc)), "absdiff", 1e-10*(1+arma::abs(hc).max())));
+        EXPECT_TRUE(arma::approx_equal(VecT(g.subvec(Np,Np+1)), VecT(normal.param_grad(x(N))), "absdiff", 1e-10));
+    }
+}
+
+/* Sample Kendall's tau of rows i and j */
+double kendall_tau(const MatT &u, IdxT i, IdxT j)
+{
+    double s = 0;
+    IdxT N = u.n_cols;
+    for(IdxT a=0; a<N; a++) for(IdxT b=a+1; b<N; b++) {
+        double d = (u(i,a)-u(i,b))*(u(j,a)-u(j,b));
+        s += (d>0) - (d<0);
+    }
+    return 2*s/(N*(N-1));
+}
+
+/* Each bivariate margin of an AMH copula is AMH with the same theta, and has
+ * tau = 1 - 2*((1-theta)^2*log(1-theta) + theta)/(3*theta^2).
+ */
+template<int Ndim>
+void check_amh_copula_sample(double theta)
+{
+    const IdxT N = 3000;
+    AMHCopula<Ndim> copula(theta);
+    MatT u = copula.sample(env->get_rng(),N);
+    ASSERT_EQ(u.n_rows, static_cast<IdxT>(Ndim));
+    ASSERT_TRUE(arma::all(arma::vectorise(u) > 0) && arma::all(arma::vectorise(u) < 1));
+    for(IdxT i=0; i<Ndim; i++) EXPECT_NEAR(arma::mean(u.row(i)), 0.5, 0.03);
+    double tau = theta==0 ? 0 : 1 - 2*(square(1-theta)*std::log1p(-theta) + theta)/(3*square(theta));
+    for(IdxT i=0; i<Ndim; i++) for(IdxT j=i+1; j<Ndim; j++)
+        EXPECT_NEAR(kendall_tau(u,i,j), tau, 0.05)<<"Ndim:"<<Ndim<<" theta:"<<theta<<" i:"<<i<<" j:"<<j;
+    auto v = copula.sample(env->get_rng());
+    EXPECT_TRUE(arma::all(v > 0) && arma::all(v < 1));
+}
+
+TEST(AMHCopulaTest, sample) 
+{
+    env->reset_rng();
+    for(double theta: {-1., -0.5, 0., 0.5, 0.95}) check_amh_copula_sample<2>(theta);
+    //For Ndim>2 negative theta is restricted to near 0 for a valid copula
+    for(double theta: {-0.2, 0., 0.5, 0.95}) {
+        check_amh_copula_sample<3>(theta);
+        check_amh_copula_sample<4>(theta);
+    }
+}
+
+/* The bivariate AMH copula density is
+ * c(u,v) = (1 + theta*((1+u)*(1+v)-3) + theta^2*(1-u)*(1-v)) / (1-theta*(1-u)*(1-v))^3
+ */
+TEST(AMHCopulaTest, bivariate_density) 
+{
+    env->reset_rng();
+    for(double theta: {-1., -0.5, 0., 0.5, 0.95}) {
+        AMHCopula<2> copula(theta);
+        for(IdxT n=0; n<100; n++) {
+            VecT u = {env->sample_real(0,1), env->sample_real(0,1)};
+            double a = (1-u(0))*(1-u(1));
+            double c = (1 + theta*((1+u(0))*(1+u(1))-3) + square(theta)*a)/std::pow(1-theta*a,3);
+            EXPECT_NEAR(copula.pdf(u), c, 1e-12*c)<<"theta:"<<theta<<" u:"<<u.t();
+            EXPECT_NEAR(copula.rllh(u), std::log(c), 1e-12)<<"theta:"<<theta<<" u:"<<u.t();
+            EXPECT_NEAR(copula.cdf(u), u(0)*u(1)/(1-theta*a), 1e-14)<<"theta:"<<theta<<" u:"<<u.t();
+        }
+    }
+}
+
+template<int Ndim>
+void check_amh_copula_theta_derivatives(double theta)
+{
+    using CopulaT = AMHCopula<Ndim>;
+    using NdimVecT = typename CopulaT::NdimVecT;
+    using NdimMatT = typename CopulaT::NdimMatT;
+    const double h = 1e-6;
+    CopulaT copula(theta);
+    for(IdxT n=0; n<20; n++) {
+        NdimVecT u;
+        for(IdxT i=0; i<Ndim; i++) u(i) = env->sample_real(0.05,0.95);
+        double rllh = 0, dtheta = 0, d2theta = 0;
+        CopulaT::rllh_d2theta_accumulate(theta,u,rllh,dtheta,d2theta);
+        EXPECT_NEAR(rllh, copula.rllh(u), 1e-12*(1+std::fabs(rllh)));
+        double rllh1 = 0, dtheta1 = 0;
+        CopulaT::rllh_dtheta_accumulate(theta,u,rllh1,dtheta1);
+        EXPECT_DOUBLE_EQ(dtheta1, dtheta);
+        auto rllh_theta = [&](double t) { return CopulaT(t).rllh(u); };
+        auto dtheta_theta = [&](double t) { double r=0, d=0; CopulaT::rllh_dtheta_accumulate(t,u,r,d); return d; };
+        EXPECT_NEAR((rllh_theta(theta+h)-rllh_theta(theta-h))/(2*h), dtheta, 1e-6*(1+std::fabs(dtheta)))
+            <<"theta:"<<theta<<" u:"<<u.t();
+        EXPECT_NEAR((dtheta_theta(theta+h)-dtheta_theta(theta-h))/(2*h), d2theta, 1e-5*(1+std::fabs(d2theta)))
+            <<"theta:"<<theta<<" u:"<<u.t();
+        //Fused form, with mixed derivatives d2/dtheta du(i)
+        double r = 0, dt = 0, d2t = 0;
+        NdimVecT g(arma::fill::zeros), g_theta(arma::fill::zeros);
+        NdimMatT H(arma::fill::zeros);
+        copula.rllh_grad_hess_dtheta_accumulate(u,r,g,H,dt,d2t,g_theta);
+        EXPECT_DOUBLE_EQ(r, rllh);
+        EXPECT_DOUBLE_EQ(dt, dtheta);
+        EXPECT_DOUBLE_EQ(d2t, d2theta);
+        EXPECT_TRUE(arma::approx_equal(g, copula.grad(u), "absdiff", 1e-12*(1+arma::abs(g).max())));
+        EXPECT_TRUE(arma::approx_equal(arma::symmatu(H), copula.hess(u), "absdiff", 1e-12*(1+arma::abs(H).max())));
+        NdimVecT fd_g_theta = (CopulaT(theta+h).grad(u) - CopulaT(theta-h).grad(u))/(2*h);
+        EXPECT_TRUE(arma::approx_equal(g_theta, fd_g_theta, "absdiff", 1e-5*(1+arma::abs(g_theta).max())))
+            <<"theta:"<<theta<<" u:"<<u.t()<<" g_theta:"<<g_theta.t()<<" fd:"<<fd_g_theta.t();
+    }
+}
+
+TEST(AMHCopulaTest, theta_derivatives)
+{
+    env->reset_rng();
+    for(double theta: {-0.9, -0.3, 0., 0.4, 0.9}) check_amh_copula_theta_derivatives<2>(theta);
+    //For Ndim>2 negative theta is restricted to near 0 for a valid copula, more so as Ndim grows
+    for(double theta: {-0.2, 0., 0.4, 0.9}) check_amh_copula_theta_derivatives<3>(theta);
+    for(double theta: {-0.05, 0., 0.4, 0.9}) check_amh_copula_theta_derivatives<5>(theta);
+}
+
+TEST(PolyLogTest, eulerian_polynomial) 
+{
+    using namespace polylog;
+    EXPECT_EQ(eulerian_polynomial<0>(0.3), 1);
+    EXPECT_DOUBLE_EQ(eulerian_polynomial<3>(0.3), 1+0.3*(11+0.3*(11+0.3)));
+    const auto &A9 = EulerianPolynomial<9>::coefficients;
+    const double A9_expected[] = {1,1013,47840,455192,1310354,1310354,455192,47840,1013,1};
+    for(IdxT k=0; k<A9.size(); k++) EXPECT_EQ(A9[k], A9_expected[k]);
+    //Coefficients are symmetric and sum to (n+1)!
+    const auto &A20 = EulerianPolynomial<20>::coefficients;
+    for(IdxT k=0; k<A20.size(); k++) EXPECT_EQ(A20[k], A20[20-k]);
+    EXPECT_NEAR(eulerian_polynomial<20>(1), std::tgamma(22), 1e-14*std::tgamma(22));
+    for(double z: {-0.9, -0.2, 0.4, 0.95}) {
+        EXPECT_NEAR((eulerian_polynomial<20>(20,z)), eulerian_polynomial<20>(z), 1e-11*std::fabs(eulerian_polynomial<20>(z)));
+        EXPECT_NEAR((eulerian_polynomial<20>(3,z)), eulerian_polynomial<3>(z), 1e-13*std::fabs(eulerian_polynomial<3>(z)));
+        double p, d1, d2, h = 1e-5;
+        eulerian_polynomial_derivatives<7>(z,p,d1,d2);
+        EXPECT_DOUBLE_EQ(p, eulerian_polynomial<7>(z));
+        EXPECT_NEAR(d1, (eulerian_polynomial<7>(z+h)-eulerian_polynomial<7>(z-h))/(2*h), 1e-6*(1+std::fabs(d1)));
+        EXPECT_NEAR(d2, (eulerian_polynomial<7>(z+h)-2*p+eulerian_polynomial<7>(z-h))/(h*h), 1e-3*(1+std::fabs(d2)));
+    }
+}
+
+TEST(PolyLogTest, polylog) 
+{
+    using namespace polylog;
+    for(double z: {-0.7, 0.3, 0.9}) {
+        //Direct series sum_k k^n z^k
+        double s0=0, s1=0, s4=0;
+        for(int k=1; k<2000; k++) {
+            double zk = std::pow(z,k);
+            s0 += zk;
+            s1 += k*zk;
+            s4 += std::pow(k,4)*zk;
+        }
+        EXPECT_NEAR(polylog::polylog<0>(z), s0, 1e-12*std::fabs(s0));
+        EXPECT_NEAR(polylog::polylog<-1>(z), s1, 1e-12*std::fabs(s1));
+        EXPECT_NEAR(polylog::polylog<-4>(z), s4, 1e-11*std::fabs(s4));
+        EXPECT_NEAR(polylog::polylog<1>(z), -std::log(1-z), 1e-15);
+    }
+    EXPECT_NEAR(log_polylog_exp<-5>(std::log(0.9)), std::log(polylog::polylog<-5>(0.9)), 1e-13);
+    //Near z=1, log(Li_{-n}(exp(-e))) -> log(n!) - (n+1)*log(e), which overflows if not computed in log space
+    double e = 1e-20;
+    EXPECT_NEAR(log_polylog_exp<-30>(-e), std::lgamma(31) - 31*std::log(e), 1e-12);
+}
+
+/* Eulerian coefficients are generated for any dimension, and rllh stays accurate as z->1 */
+TEST(AMHCopulaTest, high_dimension) 
+{
+    env->reset_rng();
+    check_amh_copula_sample<12>(0.6);
+    AMHCopula<12> copula(0.6);
+    AMHCopula<12>::NdimVecT u;
+    for(IdxT n=0; n<20; n++) {
+        for(IdxT i=0; i<12; i++) u(i) = env->sample_real(0.05,0.95);
+        double rllh = 0;
+        AMHCopula<12>::NdimVecT g(arma::fill::zeros);
+        copula.rllh_grad_accumulate(u,rllh,g);
+        ASSERT_TRUE(std::isfinite(rllh));
+        for(IdxT i=0; i<12; i++) {
+            double h = 1e-6;
+            auto up = u, um = u;
+            up(i) += h;
+            um(i) -= h;
+            EXPECT_NEAR((copula.rllh(up)-copula.rllh(um))/(2*h), g(i), 1e-5*(1+std::fabs(g(i))));
+        }
+    }
+    //For theta=1-e and u(i)=1-k*e, 1-z is O(e).  Computing 1-z directly from z would lose about 7 digits for e=1e-9.
+    AMHCopula<3> c3(1-1e-9);
+    AMHCopula<3>::NdimVecT v = {1-3e-9, 1-2e-9, 1-1e-9};
+    EXPECT_NEAR(c3.rllh(v), 1.79175945622805, 1e-12);
+}
@@ -2,6 +2,8 @@
  * @author Mark J. Olah (mjo\@cs.unm DOT edu)
  * @date 2018
  */
+#include <thread>
+
 #include "test_multivariate.h"
 
 // using MultivariateDistTs = ::testing::Types<
@@ -189,6 +191,15 @@ TYPED_TEST(MultivariateDistTest, llh) {
     }
 }
 
+TEST(MultivariateNormalDistTest, llh_value) {
+    MultivariateNormalDist<2> unit;
+    EXPECT_NEAR(unit.llh(VecT{0,0}), -std::log(2*arma::datum::pi), 1e-14);
+    //mu=[1,-1], sigma=[2 .5; .5 1], x=[.5,.25]
+    MultivariateNormalDist<2> dist(VecT{1,-1}, MatT{{2,.5},{.5,1}});
+    EXPECT_NEAR(dist.llh(VecT{.5,.25}), -3.2605421032341995, 1e-13);
+    EXPECT_NEAR(dist.pdf(VecT{.5,.25}), std::exp(-3.2605421032341995), 1e-14);
+}
+
 TYPED_TEST(MultivariateDistTest, rllh_constant) {
     auto &dist = this->dist;
     for(int n=0; n < this->Ntest; n++){
@@ -292,3 +303,429 @@ TYPED_TEST(MultivariateDistTest, sample_in_bounds) {
         EXPECT_TRUE(dist.in_bounds(v));
     }
 }
+
+TYPED_TEST(MultivariateDistTest, param_grad_hess) {
+    using NparamsVecT = typename TypeParam::NparamsVecT;
+    using NparamsMatT = typename TypeParam::NparamsMatT;
+    auto &dist = this->dist;
+    const NparamsVecT p0 = dist.params();
+    for(int n=0; n < this->Ntest; n++){
+        auto v = dist.sample(env->get_rng());
+        NparamsVecT grad = dist.param_grad(v);
+        NparamsMatT hess = dist.param_hess(v);
+        ASSERT_TRUE(grad.is_finite());
+        ASSERT_TRUE(hess.is_finite());
+        check_symmetric(hess);
+        NparamsVecT grad_acc(arma::fill::zeros);
+        NparamsMatT hess_acc(arma::fill::zeros);
+        dist.param_grad_hess_accumulate(v,grad_acc,hess_acc);
+        EXPECT_TRUE(arma::approx_equal(grad,grad_acc,"reldiff",1E-9));
+        EXPECT_TRUE(arma::approx_equal(hess,hess_acc,"reldiff",1E-9));
+        //Compare to finite differences of llh and param_grad.  Off-diagonal sigma params move both symmetric entries.
+        for(IdxT i=0; i<dist.num_params(); i++) {
+            double step = 1E-6;
+            NparamsVecT pp = p0, pm = p0;
+            pp(i) += step;
+            pm(i) -= step;
+            TypeParam dp(dist), dm(dist);
+            dp.set_params(pp);
+            dm.set_params(pm);
+            double fd_grad = (dp.llh(v)-dm.llh(v))/(2*step);
+            EXPECT_NEAR(grad(i),fd_grad,1E-4*std::max(1.0,std::fabs(fd_grad)))<<"param:"<<i;
+            NparamsVecT fd_hess = (dp.param_grad(v)-dm.param_grad(v))/(2*step);
+            for(IdxT j=0; j<dist.num_params(); j++)
+                EXPECT_NEAR(hess(j,i),fd_hess(j),1E-4*std::max(1.0,std::fabs(fd_hess(j))))<<"param:"<<j<<","<<i;
+        }
+    }
+}
+
+TEST(MultivariateNormalDistTest, cdf_batch) {
+    env->reset_rng();
+    auto dist2 = make_dist<MultivariateNormalDist<2>>();
+    auto dist3 = make_dist<MultivariateNormalDist<3>>();
+    IdxT N = 50;
+    MatT x2(2,N), x3(3,N);
+    for(IdxT n=0; n<N; n++) {
+        x2.col(n) = dist2.sample(env->get_rng());
+        x3.col(n) = dist3.sample(env->get_rng());
+    }
+    VecT cdf2 = dist2.cdf(x2);
+    VecT cdf3 = dist3.cdf(x3);
+    ASSERT_EQ(cdf2.n_elem, N);
+    ASSERT_EQ(cdf3.n_elem, N);
+    for(IdxT n=0; n<N; n++) {
+        EXPECT_NEAR(cdf2(n), dist2.cdf(x2.col(n)), 1E-10);
+        EXPECT_LE(0,cdf3(n));
+        EXPECT_LE(cdf3(n),1);
+    }
+    EXPECT_THROW(dist2.cdf(x3), ParameterSizeError);
+}
+
+TEST(MultivariateNormalDistTest, rectangle_probability) {
+    env->reset_rng();
+    auto dist2 = make_dist<MultivariateNormalDist<2>>();
+    auto dist3 = make_dist<MultivariateNormalDist<3>>();
+    for(int n=0; n<20; n++) {
+        arma::vec::fixed<2> a2 = dist2.sample(env->get_rng());
+        arma::vec::fixed<2> b2 = a2 + env->sample_gamma_vec(2,1,1);
+        //Inclusion-exclusion over the vertices of the rectangle
+        double p2 = dist2.cdf(b2) - dist2.cdf(arma::vec({a2(0),b2(1)})) - dist2.cdf(arma::vec({b2(0),a2(1)})) + dist2.cdf(a2);
+        EXPECT_NEAR(dist2.rectangle_probability(a2,b2), p2, 1E-12);
+        
+        arma::vec::fixed<3> a3 = dist3.sample(env->get_rng());
+        arma::vec::fixed<3> b3 = a3 + env->sample_gamma_vec(3,1,1);
+        double p3 = 0;
+        for(IdxT v=0; v<8; v++) {
+            arma::vec::fixed<3> x = b3;
+            int flips = 0;
+            for(IdxT k=0; k<3; k++) if(v & (1<<k)) { x(k) = a3(k); flips++; }
+            p3 += (flips%2 ? -1 : 1) * dist3.cdf(x);
+        }
+        //tvn_rectangle_probability is accurate to 1E-13 absolute.  Probabilities below 1E-6 use the genz integrator,
+        //with its default absolute tolerance of 1E-5.
+        EXPECT_NEAR(dist3.rectangle_probability(a3,b3), p3, p3>1E-6 ? 1E-13 : 1E-5);
+        
+        //Infinite lower limits give the cdf
+        arma::vec::fixed<3> ninf;
+        ninf.fill(-INFINITY);
+        EXPECT_NEAR(dist3.rectangle_probability(ninf,b3), dist3.cdf(b3), 1E-12);
+    }
+}
+
+TEST(TruncatedMultivariateNormalDistTest, cdf) {
+    env->reset_rng();
+    auto dist = make_dist<MultivariateNormalDist<3>>();
+    arma::vec::fixed<3> lb = dist.mu() - 2*arma::sqrt(dist.sigma().diag());
+    arma::vec::fixed<3> ub = dist.mu() + arma::sqrt(dist.sigma().diag());
+    TruncatedMultivariateNormalDist<3> tdist(dist, lb, ub);
+    ASSERT_TRUE(tdist.truncated());
+    EXPECT_NEAR(tdist.cdf(ub), 1, 1E-12);
+    arma::vec::fixed<3> x = ub + 1; //cdf is constant beyond ubound
+    EXPECT_NEAR(tdist.cdf(x), 1, 1E-12);
+    arma::vec::fixed<3> mid = (lb+ub)/2;
+    EXPECT_NEAR(tdist.cdf(mid), dist.rectangle_probability(lb,mid)/dist.rectangle_probability(lb,ub), 1E-12);
+    EXPECT_EQ(tdist.cdf(lb-1), 0);
+    EXPECT_NEAR(tdist.pdf(mid), dist.pdf(mid)/dist.rectangle_probability(lb,ub), 1E-12);
+}
+
+/* Truncation constants follow the parameters, and contribute to the parameter derivatives */
+TEST(TruncatedMultivariateNormalDistTest, param_grad_hess) {
+    env->reset_rng();
+    using DistT = TruncatedMultivariateNormalDist<2>;
+    using NparamsVecT = DistT::NparamsVecT;
+    using NparamsMatT = DistT::NparamsMatT;
+    auto dist = make_dist<MultivariateNormalDist<2>>();
+    arma::vec::fixed<2> lb = dist.mu() - arma::sqrt(dist.sigma().diag());
+    arma::vec::fixed<2> ub = dist.mu() + 2*arma::sqrt(dist.sigma().diag());
+    DistT tdist(dist, lb, ub);
+    ASSERT_TRUE(tdist.truncated());
+    NparamsVecT p0 = tdist.params();
+    NparamsVecT p1 = p0;
+    p1.head(2) += 0.1;
+    tdist.set_params(p1);
+    auto v = tdist.sample(env->get_rng());
+    MultivariateNormalDist<2> dist1(dist);
+    dist1.set_params(p1);
+    EXPECT_NEAR(tdist.llh(v), dist1.llh(v) - dist1.log_rectangle_probability(lb,ub), 1E-10);
+    tdist.set_params(p0);
+    for(int n=0; n < 20; n++){
+        v = tdist.sample(env->get_rng());
+        NparamsVecT grad = tdist.param_grad(v);
+        NparamsMatT hess = tdist.param_hess(v);
+        ASSERT_TRUE(grad.is_finite());
+        ASSERT_TRUE(hess.is_finite());
+        check_symmetric(hess);
+        NparamsVecT grad_acc(arma::fill::zeros);
+        NparamsMatT hess_acc(arma::fill::zeros);
+        tdist.param_grad_hess_accumulate(v,grad_acc,hess_acc);
+        EXPECT_TRUE(arma::approx_equal(grad,grad_acc,"reldiff",1E-9));
+        EXPECT_TRUE(arma::approx_equal(hess,hess_acc,"reldiff",1E-9));
+        for(IdxT i=0; i<tdist.num_params(); i++) {
+            double step = 1E-5*std::max(1.0,std::fabs(p0(i)));
+            NparamsVecT pp = p0, pm = p0;
+            pp(i) += step;
+            pm(i) -= step;
+            DistT dp(tdist), dm(tdist);
+            dp.set_params(pp);
+            dm.set_params(pm);
+            double fd_grad = (dp.llh(v)-dm.llh(v))/(2*step);
+            EXPECT_NEAR(grad(i),fd_grad,1E-4*std::max(1.0,std::fabs(fd_grad)))<<"param:"<<i;
+            NparamsVecT fd_hess = (dp.param_grad(v)-dm.param_grad(v))/(2*step);
+            for(IdxT j=0; j<tdist.num_params(); j++)
+                EXPECT_NEAR(hess(j,i),fd_hess(j),1E-3*std::max(1.0,std::fabs(fd_hess(j))))<<"param:"<<j<<","<<i;
+        }
+    }
+}
+
+/* For Ndim=3 the truncation constant derivatives are checked against finite differences of a reference log rectangle
+ * probability, from inclusion-exclusion over the corners with the deterministic trivariate cdf.
+ */
+TEST(TruncatedMultivariateNormalDistTest, param_grad_hess_3d) {
+    env->reset_rng();
+    using DistT = TruncatedMultivariateNormalDist<3>;
+    using NparamsVecT = DistT::NparamsVecT;
+    using NparamsMatT = DistT::NparamsMatT;
+    using NdimVecT = DistT::NdimVecT;
+    auto dist = make_dist<MultivariateNormalDist<3>>();
+    NdimVecT sd = arma::sqrt(dist.sigma().diag());
+    std::vector<std::pair<NdimVecT,NdimVecT>> bounds = {
+        {dist.mu() - sd, dist.mu() + 2*sd},
+        {dist.mu() - 2*sd, NdimVecT{dist.mu()(0)+sd(0), INFINITY, dist.mu()(2)-.5*sd(2)}}
+    };
+    for(auto &b: bounds) {
+        const NdimVecT &lb = b.first;
+        const NdimVecT &ub = b.second;
+        auto ref_log_Z = [&](const NparamsVecT &p) {
+            MultivariateNormalDist<3> d(dist);
+            d.set_params(p);
+            double Z = 0;
+            for(int corner=0; corner<8; corner++) {
+                NdimVecT x;
+                int sign = 1;
+                for(IdxT i=0; i<3; i++) {
+                    x(i) = (corner & (1<<i)) ? lb(i) : ub(i);
+                    if(corner & (1<<i)) sign = -sign;
+                }
+                Z += sign*d.cdf(x);
+            }
+            return std::log(Z);
+        };
+        const NparamsVecT p0 = dist.params();
+        const IdxT Np = dist.num_params();
+        NparamsVecT ref_grad;
+        NparamsMatT ref_hess;
+        for(IdxT i=0; i<Np; i++) {
+            double step = 1E-5*std::max(1.0,std::fabs(p0(i)));
+            NparamsVecT pp = p0, pm = p0;
+            pp(i) += step;
+            pm(i) -= step;
+            ref_grad(i) = (ref_log_Z(pp)-ref_log_Z(pm))/(2*step);
+            double hi = 1E-3*std::max(1.0,std::fabs(p0(i)));
+            for(IdxT j=0; j<=i; j++) {
+                double hj = 1E-3*std::max(1.0,std::fabs(p0(j)));
+                NparamsVecT ppp = p0, ppm = p0, pmp = p0, pmm = p0;
+                ppp(i) += hi; ppp(j) += hj;
+                ppm(i) += hi; ppm(j) -= hj;
+                pmp(i) -= hi; pmp(j) += hj;
+                pmm(i) -= hi; pmm(j) -= hj;
+                ref_hess(i,j) = ref_hess(j,i) = (ref_log_Z(ppp)-ref_log_Z(ppm)-ref_log_Z(pmp)+ref_log_Z(pmm))/(4*hi*hj);
+            }
+        }
+        EXPECT_TRUE(arma::approx_equal(dist.log_rectangle_probability_param_grad(lb,ub), ref_grad, "absdiff", 1E-7))
+            <<"lb:"<<lb.t()<<" ub:"<<ub.t();
+        DistT tdist(dist, lb, ub);
+        EXPECT_NEAR(tdist.llh(dist.mu()), dist.llh(dist.mu()) - ref_log_Z(p0), 1E-12);
+        for(int n=0; n < 10; n++){
+            NdimVecT v = tdist.sample(env->get_rng());
+            NparamsVecT grad = tdist.param_grad(v);
+            NparamsMatT hess = tdist.param_hess(v);
+            check_symmetric(hess);
+            NparamsVecT grad_ref = dist.param_grad(v) - ref_grad;
+            NparamsMatT hess_ref = dist.param_hess(v) - ref_hess;
+            for(IdxT i=0; i<Np; i++) {
+                EXPECT_NEAR(grad(i),grad_ref(i),1E-7*std::max(1.0,std::fabs(grad_ref(i))))<<"param:"<<i;
+                for(IdxT j=0; j<Np; j++)
+                    EXPECT_NEAR(hess(i,j),hess_ref(i,j),1E-5*std::max(1.0,std::fabs(hess_ref(i,j))))<<"param:"<<i<<","<<j;
+            }
+        }
+    }
+}
+
+TEST(TruncatedMultivariateNormalDistTest, gibbs_sample) {
+    env->reset_rng();
+    auto dist = make_dist<MultivariateNormalDist<3>>();
+    arma::vec::fixed<3> sd = arma::sqrt(dist.sigma().diag());
+    arma::vec::fixed<3> lb = dist.mu() - sd;
+    arma::vec::fixed<3> ub = dist.mu() + 2*sd;
+    TruncatedMultivariateNormalDist<3> tdist(dist, lb, ub);
+    ASSERT_TRUE(tdist.truncated());
+    const IdxT N = 20000;
+    arma::mat rej_samples(3,N), gibbs_samples(3,N);
+    tdist.set_sampling_method(TruncatedSamplingMethod::Rejection);
+    for(IdxT n=0; n<N; n++) rej_samples.col(n) = tdist.sample(env->get_rng());
+    tdist.set_sampling_method(TruncatedSamplingMethod::Gibbs);
+    EXPECT_EQ(tdist.sampling_method(), TruncatedSamplingMethod::Gibbs);
+    for(IdxT n=0; n<N; n++) {
+        gibbs_samples.col(n) = tdist.sample(env->get_rng());
+        ASSERT_TRUE(tdist.in_bounds(gibbs_samples.col(n)));
+    }
+    arma::vec rej_mean = arma::mean(rej_samples,1);
+    arma::vec gibbs_mean = arma::mean(gibbs_samples,1);
+    arma::mat rej_cov = arma::cov(rej_samples.t());
+    arma::mat gibbs_cov = arma::cov(gibbs_samples.t());
+    for(IdxT i=0; i<3; i++) {
+        EXPECT_NEAR(gibbs_mean(i), rej_mean(i), 0.05*sd(i));
+        for(IdxT j=0; j<3; j++) EXPECT_NEAR(gibbs_cov(i,j), rej_cov(i,j), 0.05*sd(i)*sd(j));
+    }
+}
+
+TEST(TruncatedMultivariateNormalDistTest, gibbs_sample_tail) {
+    env->reset_rng();
+    MultivariateNormalDist<3> dist;
+    arma::mat::fixed<3,3> sigma = {{1,.5,.5},{.5,1,.5},{.5,.5,1}};
+    dist.set_sigma(sigma);
+    //Truncation in the tail with probability near 1E-4, where rejection sampling fails
+    arma::vec::fixed<3> lb = {2,2,2};
+    arma::vec::fixed<3> ub = {3,3,3};
+    TruncatedMultivariateNormalDist<3> tdist(dist, lb, ub);
+    ASSERT_TRUE(tdist.truncated());
+    ASSERT_EQ(tdist.sampling_method(), TruncatedSamplingMethod::Auto);
+    for(IdxT n=0; n<1000; n++) ASSERT_TRUE(tdist.in_bounds(tdist.sample(env->get_rng())));
+    tdist.set_sampling_method(TruncatedSamplingMethod::Rejection);
+    EXPECT_THROW(for(IdxT n=0; n<1000; n++) tdist.sample(env->get_rng()), RuntimeSamplingError);
+}
+
+/* Metropolis proposals are uniform over the bounds, so they must be finite.  Gibbs chains start at mu in the bounds. */
+TEST(TruncatedMultivariateNormalDistTest, mcmc_infinite_bounds) {
+    static_assert(TruncatedMultivariateNormalDist<2>::gibbs_supported(), "MVN has normal conditionals");
+    env->reset_rng();
+    MultivariateNormalDist<2> dist;
+    arma::vec::fixed<2> lb = {1,-INFINITY};
+    arma::vec::fixed<2> ub = {INFINITY,0};
+    TruncatedMultivariateNormalDist<2> tdist(dist, lb, ub);
+    tdist.set_sampling_method(TruncatedSamplingMethod::Metropolis);
+    EXPECT_THROW(tdist.sample(env->get_rng()), ParameterValueError);
+    EXPECT_THROW(tdist.sample(env->get_rng(),10), ParameterValueError);
+    tdist.set_sampling_method(TruncatedSamplingMethod::Gibbs);
+    MatT samples = tdist.sample(env->get_rng(),100);
+    for(IdxT n=0; n<100; n++) ASSERT_TRUE(tdist.in_bounds(samples.col(n)));
+}
+
+/* A truncation limited in a single dimension has its normalizer computed exactly in log space, even far in the tail */
+TEST(TruncatedMultivariateNormalDistTest, far_tail_truncation) {
+    env->reset_rng();
+    MultivariateNormalDist<2> dist;
+    arma::mat::fixed<2,2> sigma = {{1,.5},{.5,1}};
+    dist.set_sigma(sigma);
+    arma::vec::fixed<2> lb = {40,-INFINITY};
+    arma::vec::fixed<2> ub = {41,INFINITY};
+    const double log_Z = -804.6084420137538; //log(Phi(-40)-Phi(-41)), which underflows as a double
+    EXPECT_NEAR(dist.log_rectangle_probability(lb,ub), log_Z, 1E-12*fabs(log_Z));
+    TruncatedMultivariateNormalDist<2> tdist(dist, lb, ub);
+    ASSERT_TRUE(tdist.truncated());
+    arma::vec::fixed<2> x = {40.5, 20};
+    EXPECT_NEAR(tdist.llh(x), dist.llh(x) - log_Z, 1E-12*fabs(log_Z));
+    double pdf = exp(dist.llh(x) - log_Z);
+    ASSERT_TRUE(std::isfinite(pdf));
+    EXPECT_GT(pdf, 0);
+    EXPECT_NEAR(tdist.pdf(x), pdf, 1E-10*pdf);
+    //The cdf at [x0,inf] is 1 - P([x0,41] x R)/Z, with both probabilities underflowing as doubles
+    EXPECT_NEAR(tdist.cdf(ub), 1, 1E-10);
+    for(double x0: {40.01, 40.5}) {
+        arma::vec::fixed<2> upper_lb = {x0, -INFINITY};
+        arma::vec::fixed<2> x_cdf = {x0, INFINITY};
+        double cdf = -expm1(dist.log_rectangle_probability(upper_lb,ub) - log_Z);
+        EXPECT_NEAR(cdf, -expm1(-40*(x0-40)), 1E-3); //Leading term of the tail asymptotic expansion
+        EXPECT_NEAR(tdist.cdf(x_cdf), cdf, 1E-10);
+    }
+    for(IdxT n=0; n<100; n++) ASSERT_TRUE(tdist.in_bounds(tdist.sample(env->get_rng())));
+}
+
+/* Truncations limited in several dimensions far in the tail have a finite log normalizer, though it underflows */
+TEST(TruncatedMultivariateNormalDistTest, far_tail_truncation_3d) {
+    MultivariateNormalDist<3> dist;
+    arma::mat::fixed<3,3> sigma = {{1,.5,.5},{.5,1,.5},{.5,.5,1}};
+    dist.set_sigma(sigma);
+    //log P for X(i) = sqrt(.5)*(Z + E(i)), from 1D quadrature over Z of the product of the conditional probabilities
+    const double log_Z3 = -1211.40487894; //[40,41]^3
+    const double log_Z2 = -1074.93033213; //[40,41]^2 x R
+    arma::vec::fixed<3> lb = {40,40,40};
+    arma::vec::fixed<3> ub = {41,41,41};
+    EXPECT_NEAR(dist.log_rectangle_probability(lb,ub), log_Z3, 1E-2);
+    arma::vec::fixed<3> lb2 = {40,40,-INFINITY};
+    arma::vec::fixed<3> ub2 = {41,41,INFINITY};
+    EXPECT_NEAR(dist.log_rectangle_probability(lb2,ub2), log_Z2, 1E-2);
+    TruncatedMultivariateNormalDist<3> tdist(dist, lb, ub);
+    ASSERT_TRUE(tdist.truncated());
+    arma::vec::fixed<3> x = {40.1, 40.1, 40.1};
+    EXPECT_NEAR(tdist.llh(x), dist.llh(x) - log_Z3, 1E-2);
+}
+
+TEST(TruncatedMultivariateNormalDistTest, chain_state) {
+    env->reset_rng();
+    auto dist = make_dist<MultivariateNormalDist<3>>();
+    arma::vec::fixed<3> sd = arma::sqrt(dist.sigma().diag());
+    arma::vec::fixed<3> lb = dist.mu() - sd;
+    arma::vec::fixed<3> ub = dist.mu() + sd;
+    TruncatedMultivariateNormalDist<3> tdist(dist, lb, ub);
+    const IdxT N = 1000;
+    const IdxT Nthreads = 4;
+    for(auto method: {TruncatedSamplingMethod::Gibbs, TruncatedSamplingMethod::Metropolis}) {
+        tdist.set_sampling_method(method);
+        //Caller owned chains with the same seed give the same sequence, regardless of other threads sampling
+        auto run_chain = [&](arma::mat &out) {
+            std::mt19937_64 rng(17);
+            TruncatedMultivariateNormalDist<3>::ChainStateT chain;
+            for(IdxT n=0; n<N; n++) out.col(n) = tdist.sample(rng,chain);
+        };
+        arma::mat expected(3,N);
+        run_chain(expected);
+        std::vector<arma::mat> outs(Nthreads, arma::mat(3,N));
+        std::vector<arma::mat> thread_outs(Nthreads, arma::mat(3,N));
+        std::vector<std::thread> threads;
+        for(IdxT t=0; t<Nthreads; t++) threads.emplace_back([&,t]() {
+            run_chain(outs[t]);
+            //Per-thread chains
+            std::mt19937_64 rng(t);
+            for(IdxT n=0; n<N; n++) thread_outs[t].col(n) = tdist.sample(rng);
+        });
+        for(auto &thread: threads) thread.join();
+        for(IdxT t=0; t<Nthreads; t++) {
+            EXPECT_TRUE(arma::all(arma::vectorise(outs[t] == expected)));
+            for(IdxT n=0; n<N; n++) ASSERT_TRUE(tdist.in_bounds(thread_outs[t].col(n)));
+        }
+    }
+    //Chains restart when the bounds change
+    tdist.set_sampling_method(TruncatedSamplingMethod::Gibbs);
+    TruncatedMultivariateNormalDist<3>::ChainStateT chain;
+    tdist.sample(env->get_rng(),chain);
+    arma::vec::fixed<3> new_ub = dist.mu();
+    tdist.set_ubound(new_ub);
+    for(IdxT n=0; n<100; n++) ASSERT_TRUE(tdist.in_bounds(tdist.sample(env->get_rng(),chain)));
+}
+
+TEST(TruncatedMultivariateNormalDistTest, bulk_sample) {
+    env->reset_rng();
+    auto dist = make_dist<MultivariateNormalDist<3>>();
+    arma::vec::fixed<3> sd = arma::sqrt(dist.sigma().diag());
+    arma::vec::fixed<3> lb = dist.mu() - sd;
+    arma::vec::fixed<3> ub = dist.mu() + 2*sd;
+    TruncatedMultivariateNormalDist<3> tdist(dist, lb, ub);
+    const IdxT N = 20000;
+    mcmc::SamplingStats stats;
+    tdist.set_sampling_method(TruncatedSamplingMethod::Rejection);
+    MatT rej_samples = tdist.sample(env->get_rng(),N,stats);
+    EXPECT_NEAR(stats.acceptance_rate, dist.rectangle_probability(lb,ub), 0.02);
+    arma::vec rej_mean = arma::mean(rej_samples,1);
+    for(auto method: {TruncatedSamplingMethod::Gibbs, TruncatedSamplingMethod::Metropolis}) {
+        tdist.set_sampling_method(method);
+        std::mt19937_64 rng(3);
+        MatT samples = tdist.sample(rng,N,stats);
+        ASSERT_EQ(samples.n_rows, 3u);
+        ASSERT_EQ(samples.n_cols, N);
+        for(IdxT n=0; n<N; n++) ASSERT_TRUE(tdist.in_bounds(samples.col(n)));
+        EXPECT_GT(stats.acceptance_rate, 0);
+        EXPECT_LE(stats.acceptance_rate, 1);
+        if(method == TruncatedSamplingMethod::Gibbs) EXPECT_EQ(stats.acceptance_rate, 1);
+        ASSERT_EQ(stats.ess.n_elem, 3u);
+        EXPECT_TRUE(arma::all(stats.ess > N/100.));
+        arma::vec mean = arma::mean(samples,1);
+        for(IdxT i=0; i<3; i++) EXPECT_NEAR(mean(i), rej_mean(i), 0.05*sd(i));
+        //Bulk runs use a fresh chain so are repeatable
+        std::mt19937_64 rng2(3);
+        EXPECT_TRUE(arma::all(arma::vectorise(samples == tdist.sample(rng2,N))));
+    }
+}
+
+TEST(TruncatedMultivariateNormalDistTest, effective_sample_size) {
+    env->reset_rng();
+    const IdxT N = 20000;
+    MatT x(2,N);
+    x.row(0) = env->sample_normal_vec(N,0,1).t();
+    //AR(1) chain with phi=0.5 has ESS = N*(1-phi)/(1+phi)
+    double v = 0;
+    for(IdxT n=0; n<N; n++) x(1,n) = v = .5*v + x(0,n);
+    VecT ess = mcmc::effective_sample_size(x);
+    EXPECT_NEAR(ess(0), N, 0.1*N);
+    EXPECT_NEAR(ess(1), N/3., 0.1*N/3.);
+}
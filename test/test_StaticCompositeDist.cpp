@@ -0,0 +1,180 @@
+/** @file test_StaticCompositeDist.cpp
+ * @author Mark J. Olah (mjo\@cs.unm DOT edu)
+ * @date 2019
+ */
+#include <cmath>
+#include "gtest/gtest.h"
+
+#include "test_prior_hessian.h"
+#include "test_multivariate.h"
+#include "test_univariate.h"
+#include "PriorHessian/StaticCompositeDist.h"
+
+using namespace prior_hessian;
+
+template<class TupleT> struct StaticCompositeOf;
+template<class... Ts> struct StaticCompositeOf<std::tuple<Ts...>> { using type = StaticCompositeDist<Ts...>; };
+
+template<class TupleT>
+class StaticCompositeDistTest : public ::testing::Test {
+public:
+    using StaticDistT = typename StaticCompositeOf<TupleT>::type;
+    TupleT dists;
+    StaticDistT static_dist;
+    CompositeDist composite;
+    static constexpr IdxT Ntest = 100;
+    virtual void SetUp() override {
+        env->reset_rng();
+        initialize_distribution_tuple(dists);
+        static_dist = StaticDistT{dists};
+        composite = CompositeDist{static_dist};
+    }
+};
+
+using StaticCompositeDistTestTs = ::testing::Types<
+    std::tuple<NormalDist, GammaDist, ParetoDist, SymmetricBetaDist>,
+    std::tuple<UpperTruncatedDist<ParetoDist>, TruncatedParetoDist, GammaDist, ScaledSymmetricBetaDist>,
+    std::tuple<ParetoDist>,
+    std::tuple<MultivariateNormalDist<2>>,
+    std::tuple<MultivariateNormalDist<4>>,
+    std::tuple<NormalDist,MultivariateNormalDist<2>,TruncatedGammaDist,TruncatedMultivariateNormalDist<2>>
+    >;
+
+TYPED_TEST_SUITE_COMPAT(StaticCompositeDistTest, StaticCompositeDistTestTs);
+
+TYPED_TEST(StaticCompositeDistTest, constexpr_sizes) {
+    using StaticDistT = typename TestFixture::StaticDistT;
+    constexpr IdxT Ndim = StaticDistT::num_dim();
+    constexpr IdxT Nparams = StaticDistT::num_params();
+    constexpr IdxT Ncomponents = StaticDistT::num_components();
+    auto &composite = this->composite;
+    EXPECT_EQ(Ndim, composite.num_dim());
+    EXPECT_EQ(Nparams, composite.num_params());
+    EXPECT_EQ(Ncomponents, composite.num_components());
+    EXPECT_TRUE(arma::all(StaticDistT::num_dim_components() == composite.num_dim_components()));
+    EXPECT_TRUE(arma::all(StaticDistT::num_params_components() == composite.num_params_components()));
+    EXPECT_EQ(StaticDistT::component_types(), composite.component_types());
+}
+
+TYPED_TEST(StaticCompositeDistTest, params_and_bounds) {
+    auto &static_dist = this->static_dist;
+    auto &composite = this->composite;
+    EXPECT_TRUE(arma::all(static_dist.params() == composite.params()));
+    EXPECT_TRUE(arma::all(static_dist.params_lbound() == composite.params_lbound()));
+    EXPECT_TRUE(arma::all(static_dist.params_ubound() == composite.params_ubound()));
+    EXPECT_TRUE(arma::all(static_dist.lbound() == composite.lbound()));
+    EXPECT_TRUE(arma::all(static_dist.ubound() == composite.ubound()));
+    EXPECT_EQ(static_dist.param_names(), composite.param_names());
+    VecT new_params = composite.params();
+    static_dist.set_params(new_params);
+    EXPECT_TRUE(arma::all(static_dist.params() == new_params));
+    EXPECT_THROW(static_dist.set_params(VecT(new_params.n_elem+1,arma::fill::ones)),ParameterSizeError);
+}
+
+TYPED_TEST(StaticCompositeDistTest, sample_repeatability) {
+    auto &static_dist = this->static_dist;
+    auto &composite = this->composite;
+    auto &rng = env->get_rng();
+    env->reset_rng();
+    auto v1 = static_dist.sample(rng);
+    env->reset_rng();
+    auto v2 = composite.sample(rng);
+    ASSERT_TRUE(static_dist.in_bounds(v1));
+    EXPECT_TRUE(arma::all(v1 == v2))<<"Static and type-erased sampling should match.";
+    //Type-erased bulk sampling draws through a BufferedRng, which must not change the sequence of numbers drawn
+    env->reset_rng();
+    MatT s1 = static_dist.sample(rng,this->Ntest);
+    env->reset_rng();
+    MatT s2 = composite.sample(rng,this->Ntest);
+    EXPECT_TRUE(arma::approx_equal(s1,s2,"absdiff",0))<<"Static and type-erased bulk sampling should match.";
+    //The BufferedRng also leaves rng at the same position
+    auto next2 = rng();
+    env->reset_rng();
+    static_dist.sample(rng,this->Ntest);
+    EXPECT_EQ(rng(), next2)<<"Type-erased bulk sampling should consume exactly the numbers it uses.";
+}
+
+TYPED_TEST(StaticCompositeDistTest, evaluation_matches_composite) {
+    auto &static_dist = this->static_dist;
+    auto &composite = this->composite;
+    for(IdxT n=0; n<this->Ntest; n++) {
+        VecT v = composite.sample(env->get_rng());
+        EXPECT_EQ(static_dist.llh(v), composite.llh(v));
+        EXPECT_EQ(static_dist.rllh(v), composite.rllh(v));
+        EXPECT_TRUE(arma::all(static_dist.llh_components(v) == composite.llh_components(v)));
+        EXPECT_TRUE(arma::approx_equal(static_dist.grad(v),composite.grad(v),"reldiff",1e-8));
+        EXPECT_TRUE(arma::approx_equal(static_dist.grad2(v),composite.grad2(v),"reldiff",1e-8));
+        EXPECT_TRUE(arma::approx_equal(static_dist.hess(v),composite.hess(v),"reldiff",1e-8));
+        auto grad = static_dist.make_zero_grad();
+        auto hess = static_dist.make_zero_hess();
+        static_dist.grad_hess_accumulate(v,grad,hess);
+        EXPECT_TRUE(arma::approx_equal(grad,composite.grad(v),"reldiff",1e-8));
+        EXPECT_TRUE(arma::approx_equal(hess,composite.hess(v),"reldiff",1e-8));
+    }
+}
+
+TYPED_TEST(StaticCompositeDistTest, batch_matches_composite) {
+    auto &static_dist = this->static_dist;
+    auto &composite = this->composite;
+    MatT theta = composite.sample(env->get_rng(),this->Ntest);
+    EXPECT_TRUE(arma::approx_equal(static_dist.llh(theta),composite.llh(theta),"absdiff",0));
+    EXPECT_TRUE(arma::approx_equal(static_dist.rllh_components(theta),composite.rllh_components(theta),"absdiff",0));
+    EXPECT_TRUE(arma::approx_equal(static_dist.grad(theta),composite.grad(theta),"reldiff",1e-8));
+    EXPECT_TRUE(arma::approx_equal(static_dist.hess(theta),composite.hess(theta),"reldiff",1e-8));
+}
+
+TYPED_TEST(StaticCompositeDistTest, block_hess_hessvec_matches_composite) {
+    auto &static_dist = this->static_dist;
+    auto &composite = this->composite;
+    for(IdxT n=0; n<this->Ntest; n++) {
+        VecT v = composite.sample(env->get_rng());
+        VecT x = composite.sample(env->get_rng());
+        EXPECT_TRUE(arma::approx_equal(static_dist.block_hess(v).to_dense(),composite.block_hess(v).to_dense(),"reldiff",1e-8));
+        auto grad = static_dist.make_zero_grad();
+        auto block_hess = static_dist.make_zero_block_hess();
+        static_dist.grad_hess_accumulate(v,grad,block_hess);
+        EXPECT_TRUE(arma::approx_equal(grad,composite.grad(v),"reldiff",1e-8));
+        EXPECT_TRUE(arma::approx_equal(block_hess.to_dense(),composite.block_hess(v).to_dense(),"reldiff",1e-8));
+        EXPECT_TRUE(arma::approx_equal(static_dist.hessvec(v,x),composite.hessvec(v,x),"reldiff",1e-8));
+    }
+    BlockHessian bad_hess(UVecT{static_dist.num_dim()+1});
+    EXPECT_THROW(static_dist.hess_accumulate(composite.sample(env->get_rng()),bad_hess),ParameterSizeError);
+}
+
+TYPED_TEST(StaticCompositeDistTest, param_grad_hess_matches_composite) {
+    auto &static_dist = this->static_dist;
+    auto &composite = this->composite;
+    for(IdxT n=0; n<this->Ntest; n++) {
+        VecT v = composite.sample(env->get_rng());
+        EXPECT_TRUE(arma::approx_equal(static_dist.param_grad(v),composite.param_grad(v),"reldiff",1e-8));
+        EXPECT_TRUE(arma::approx_equal(static_dist.param_hess(v),composite.param_hess(v),"reldiff",1e-8));
+    }
+    MatT theta = composite.sample(env->get_rng(),this->Ntest);
+    EXPECT_TRUE(arma::approx_equal(static_dist.param_grad(theta),composite.param_grad(theta),"reldiff",1e-8));
+    EXPECT_TRUE(arma::approx_equal(static_dist.param_hess(theta),composite.param_hess(theta),"reldiff",1e-8));
+    MatT bad_pgrad(static_dist.num_params()+1,theta.n_cols,arma::fill::zeros);
+    EXPECT_THROW(static_dist.param_grad_accumulate(theta,bad_pgrad),ParameterSizeError);
+}
+
+TYPED_TEST(StaticCompositeDistTest, workspace_matches_composite) {
+    auto &static_dist = this->static_dist;
+    auto &composite = this->composite;
+    VecT grad, grad2;
+    MatT hess;
+    for(IdxT n=0; n<this->Ntest; n++) {
+        VecT v = composite.sample(env->get_rng());
+        static_dist.grad_hess(v,grad,hess);
+        EXPECT_TRUE(arma::approx_equal(grad,composite.grad(v),"reldiff",1e-8));
+        EXPECT_TRUE(arma::approx_equal(hess,composite.hess(v),"reldiff",1e-8));
+        static_dist.grad_grad2(v,grad,grad2);
+        EXPECT_TRUE(arma::approx_equal(grad,composite.grad(v),"reldiff",1e-8));
+        EXPECT_TRUE(arma::approx_equal(grad2,composite.grad2(v),"reldiff",1e-8));
+    }
+    MatT theta = composite.sample(env->get_rng(),this->Ntest);
+    MatT batch_grad;
+    CubeT batch_hess;
+    static_dist.grad(theta,batch_grad);
+    static_dist.hess(theta,batch_hess);
+    EXPECT_TRUE(arma::approx_equal(batch_grad,composite.grad(theta),"reldiff",1e-8));
+    EXPECT_TRUE(arma::approx_equal(batch_hess,composite.hess(theta),"reldiff",1e-8));
+}
@@ -149,6 +149,22 @@ TYPED_TEST(UnivariateDistTest, cdf) {
     }
 }
 
+TYPED_TEST(UnivariateDistTest, logcdf_logsf) {
+    auto &dist = this->dist;
+    for(IdxT n=0; n < this->Ntest; n++){
+        double v1 = dist.sample(env->get_rng());
+        double v2 = dist.sample(env->get_rng());
+        if(v1 > v2) std::swap(v1,v2);
+        double cdf = dist.cdf(v1);
+        double sf = dist.sf(v1);
+        EXPECT_NEAR(cdf+sf, 1, 1E-12);
+        EXPECT_NEAR(exp(dist.logcdf(v1)), cdf, 1E-12);
+        EXPECT_NEAR(exp(dist.logsf(v1)), sf, 1E-12);
+        EXPECT_NEAR(exp(dist.log_cdf_diff(v1,v2)), dist.cdf(v2)-cdf, 1E-12);
+        EXPECT_NEAR(dist.isf(sf), v1, 1E-6*std::max(1.,fabs(v1)));
+    }
+}
+
 TYPED_TEST(UnivariateDistTest, pdf) {
     auto &dist = this->dist;
     for(IdxT n=0; n < this->Ntest; n++){
@@ -177,6 +193,16 @@ TYPED_TEST(UnivariateDistTest, llh) {
     }
 }
 
+/* Beta(2,2) has density 6x(1-x) and Beta(3,3) has density 30x^2(1-x)^2 */
+TEST(SymmetricBetaDistTest, llh_value) {
+    for(double x: {0.05, 0.3, 0.5, 0.9}) {
+        EXPECT_NEAR(SymmetricBetaDist(1).llh(x), 0, 1e-14);
+        EXPECT_NEAR(SymmetricBetaDist(2).llh(x), std::log(6*x*(1-x)), 1e-13)<<"x:"<<x;
+        EXPECT_NEAR(SymmetricBetaDist(3).llh(x), std::log(30*square(x*(1-x))), 1e-13)<<"x:"<<x;
+    }
+    EXPECT_NEAR(SymmetricBetaDist(2).llh(0.3), 0.23111172096338645, 1e-13);
+}
+
 TYPED_TEST(UnivariateDistTest, rllh_constant) {
     auto &dist = this->dist;
     for(IdxT n=0; n < this->Ntest; n++){
@@ -238,3 +264,329 @@ TYPED_TEST(UnivariateDistTest, sample_in_bounds) {
         EXPECT_TRUE(dist.in_bounds(v));
     }
 }
+
+/* Parameter derivatives are checked against central finite differences of llh and param_grad */
+template<class Dist>
+void check_param_grad_hess(const Dist &dist, double v)
+{
+    using NparamsVecT = typename Dist::NparamsVecT;
+    using NparamsMatT = typename Dist::NparamsMatT;
+    const NparamsVecT p0 = dist.params();
+    NparamsVecT grad = dist.param_grad(v);
+    NparamsMatT hess = dist.param_hess(v);
+    ASSERT_TRUE(grad.is_finite());
+    ASSERT_TRUE(hess.is_finite());
+    check_symmetric(hess);
+    NparamsVecT grad_acc(arma::fill::zeros);
+    NparamsMatT hess_acc(arma::fill::zeros);
+    dist.param_grad_hess_accumulate(v,grad_acc,hess_acc);
+    EXPECT_TRUE(arma::approx_equal(grad,grad_acc,"reldiff",1E-9));
+    EXPECT_TRUE(arma::approx_equal(hess,hess_acc,"reldiff",1E-9));
+    for(IdxT i=0; i<dist.num_params(); i++) {
+        double step = 1E-5*std::max(1.0,std::fabs(p0(i)));
+        NparamsVecT pp = p0, pm = p0;
+        pp(i) += step;
+        pm(i) -= step;
+        Dist dp(dist), dm(dist);
+        dp.set_params(pp);
+        dm.set_params(pm);
+        double fd_grad = (dp.llh(v)-dm.llh(v))/(2*step);
+        EXPECT_NEAR(grad(i),fd_grad,1E-4*std::max(1.0,std::fabs(fd_grad)))<<"param:"<<i<<" v:"<<v;
+        NparamsVecT fd_hess = (dp.param_grad(v)-dm.param_grad(v))/(2*step);
+        for(IdxT j=0; j<dist.num_params(); j++)
+            EXPECT_NEAR(hess(j,i),fd_hess(j),1E-4*std::max(1.0,std::fabs(fd_hess(j))))<<"param:"<<j<<","<<i<<" v:"<<v;
+    }
+}
+
+TYPED_TEST(UnivariateDistTest, param_grad_hess) {
+    auto &dist = this->dist;
+    for(IdxT n=0; n < this->Ntest; n++){
+        double v = dist.sample(env->get_rng());
+        check_param_grad_hess(dist,v);
+    }
+}
+
+TEST(TruncatedDistTest, param_grad_hess) {
+    env->reset_rng();
+    auto dist = make_dist<TruncatedNormalDist>();
+    dist.set_bounds(dist.mu()-dist.sigma(), dist.mu()+2*dist.sigma());
+    ASSERT_TRUE(dist.truncated());
+    for(IdxT n=0; n < 100; n++){
+        double v = dist.sample(env->get_rng());
+        check_param_grad_hess(dist,v);
+    }
+    //Truncation constants follow the parameters
+    auto p = dist.params();
+    p(1) *= 2;
+    dist.set_params(p);
+    double v = dist.sample(env->get_rng());
+    EXPECT_NEAR(dist.llh(v),dist.NormalDist::llh(v)-log(dist.NormalDist::cdf(dist.ubound())-dist.NormalDist::cdf(dist.lbound())),1E-10);
+    check_param_grad_hess(dist,v);
+}
+
+/* Parameter derivatives of the cdf, used by CopulaDist, are checked against central finite differences of cdf */
+template<class Dist>
+void check_cdf_param_grad_hess(const Dist &dist, double v)
+{
+    using NparamsVecT = typename Dist::NparamsVecT;
+    using NparamsMatT = typename Dist::NparamsMatT;
+    const NparamsVecT p0 = dist.params();
+    NparamsVecT grad;
+    NparamsMatT hess;
+    dist.cdf_param_grad_hess(v,grad,hess);
+    ASSERT_TRUE(grad.is_finite());
+    ASSERT_TRUE(hess.is_finite());
+    check_symmetric(hess);
+    for(IdxT i=0; i<dist.num_params(); i++) {
+        double step = 1E-5*std::max(1.0,std::fabs(p0(i)));
+        NparamsVecT pp = p0, pm = p0;
+        pp(i) += step;
+        pm(i) -= step;
+        Dist dp(dist), dm(dist);
+        dp.set_params(pp);
+        dm.set_params(pm);
+        double fd_grad = (dp.cdf(v)-dm.cdf(v))/(2*step);
+        EXPECT_NEAR(grad(i),fd_grad,1E-5*std::max(1.0,std::fabs(fd_grad)))<<"param:"<<i<<" v:"<<v;
+        NparamsVecT gp, gm;
+        NparamsMatT hp, hm;
+        dp.cdf_param_grad_hess(v,gp,hp);
+        dm.cdf_param_grad_hess(v,gm,hm);
+        NparamsVecT fd_hess = (gp-gm)/(2*step);
+        for(IdxT j=0; j<dist.num_params(); j++)
+            EXPECT_NEAR(hess(j,i),fd_hess(j),1E-4*std::max(1.0,std::fabs(fd_hess(j))))<<"param:"<<j<<","<<i<<" v:"<<v;
+    }
+}
+
+template<class Dist>
+void check_cdf_param_grad_hess(const Dist &dist)
+{
+    for(IdxT n=0; n < 50; n++) check_cdf_param_grad_hess(dist,dist.sample(env->get_rng()));
+}
+
+TEST(TruncatedDistTest, cdf_param_grad_hess) {
+    env->reset_rng();
+    auto normal = make_dist<TruncatedNormalDist>();
+    check_cdf_param_grad_hess(normal);
+    normal.set_bounds(normal.mu()-normal.sigma(), normal.mu()+2*normal.sigma());
+    check_cdf_param_grad_hess(normal);
+    auto gamma = make_dist<TruncatedGammaDist>();
+    check_cdf_param_grad_hess(gamma);
+    gamma.set_bounds(gamma.icdf(.1), gamma.icdf(.8));
+    check_cdf_param_grad_hess(gamma);
+    auto pareto = make_dist<TruncatedParetoDist>();
+    check_cdf_param_grad_hess(pareto);
+    pareto.set_ubound(pareto.ParetoDist::icdf(.7));
+    check_cdf_param_grad_hess(pareto);
+    auto beta = make_dist<ScaledSymmetricBetaDist>();
+    beta.set_bounds(-2,3);
+    check_cdf_param_grad_hess(beta);
+}
+
+/* Truncation constant derivatives are closed form for NormalDist and ParetoDist, and for the GammaDist scale */
+TEST(TruncatedDistTest, truncation_param_grad_hess) {
+    env->reset_rng();
+    auto normal = make_dist<TruncatedNormalDist>();
+    for(double a: {-8., -3., 0.5, 4.}) {
+        normal.set_bounds(normal.mu()+a*normal.sigma(), normal.mu()+(a+1.5)*normal.sigma());
+        for(IdxT n=0; n < 20; n++) check_param_grad_hess(normal,normal.sample(env->get_rng()));
+    }
+    auto pareto = make_dist<TruncatedParetoDist>();
+    pareto.set_ubound(pareto.ParetoDist::icdf(.7));
+    for(IdxT n=0; n < 20; n++) check_param_grad_hess(pareto,pareto.sample(env->get_rng()));
+    auto gamma = make_dist<TruncatedGammaDist>();
+    for(double q: {1E-6, .1, .6}) {
+        gamma.set_bounds(gamma.GammaDist::icdf(q), gamma.GammaDist::isf(.2*(1-q)));
+        for(IdxT n=0; n < 20; n++) check_param_grad_hess(gamma,gamma.sample(env->get_rng()));
+    }
+}
+
+/* TruncatedDist<NormalDist> samples with the rejection samplers, which stay accurate in the upper tail where
+ * inversion of the cdf has few significant digits.
+ */
+TEST(TruncatedDistTest, normal_tail_sample) {
+    env->reset_rng();
+    const IdxT N = 20000;
+    TruncatedNormalDist dist(NormalDist(1,2), 11, INFINITY); //5 sigma above the mean
+    double s = 0, s2 = 0;
+    for(IdxT n=0; n<N; n++) {
+        double x = dist.sample(env->get_rng());
+        ASSERT_LE(dist.lbound(), x);
+        s += x;
+        s2 += x*x;
+    }
+    double mean = s/N;
+    double se = sqrt(std::max(s2/N - mean*mean, 0.)/N);
+    double a = 5;
+    double expected = 1 + 2*exp(-.5*a*a)/constants::sqrt2pi/(.5*erfc(a/constants::sqrt2));
+    EXPECT_NEAR(mean, expected, 5*se);
+}
+
+/* The truncation normalizer is computed in log space, so bounds far in the upper tail are valid */
+TEST(TruncatedDistTest, far_tail_truncation) {
+    env->reset_rng();
+    const double log_Z = -454.32124395634327; //log(Phi(-30)-Phi(-31))
+    TruncatedNormalDist dist(NormalDist(0,1), 30, 31);
+    EXPECT_NEAR(dist.llh(30.5), dist.NormalDist::llh(30.5) - log_Z, 1E-12*fabs(log_Z));
+    for(double u: {0.1, 0.5, 0.9}) EXPECT_NEAR(dist.cdf(dist.icdf(u)), u, 1E-8);
+    EXPECT_NEAR(dist.logcdf(31), 0, 1E-12);
+    for(IdxT n=0; n<100; n++) {
+        double x = dist.sample(env->get_rng());
+        ASSERT_LE(dist.lbound(), x);
+        ASSERT_LE(x, dist.ubound());
+    }
+    EXPECT_NEAR(dist.pdf(30.5), exp(dist.NormalDist::llh(30.5) - log_Z), 1E-12*dist.pdf(30.5));
+
+    //The normalizer underflows as a double, so pdf, cdf, and icdf must all work in log space
+    const double log_Z40 = -804.6084420137538; //log(1-Phi(40))
+    TruncatedNormalDist dist40(NormalDist(0,1), 40, INFINITY);
+    TruncatedNormalDist dist40_lower(NormalDist(0,1), -INFINITY, -40);
+    for(double x: {40., 40.01, 40.5}) {
+        EXPECT_NEAR(dist40.llh(x), dist40.NormalDist::llh(x) - log_Z40, 1E-12*fabs(log_Z40));
+        double pdf = exp(dist40.NormalDist::llh(x) - log_Z40);
+        EXPECT_NEAR(dist40.pdf(x), pdf, 1E-10*pdf);
+        EXPECT_NEAR(dist40_lower.pdf(-x), pdf, 1E-10*pdf);
+    }
+    //Density of the tail is close to 40*exp(-40*(x-40)), the leading term of its asymptotic expansion
+    EXPECT_NEAR(dist40.cdf(40.01), -expm1(-40*.01), 1E-3);
+    EXPECT_EQ(dist40.cdf(40), 0);
+    EXPECT_NEAR(dist40_lower.cdf(-40.01), exp(-40*.01), 1E-3);
+    double last = dist40.lbound();
+    for(double u: {0.1, 0.5, 0.9}) {
+        double x = dist40.icdf(u);
+        ASSERT_TRUE(std::isfinite(x));
+        EXPECT_LT(last, x);
+        EXPECT_NEAR(dist40.cdf(x), u, 1E-8);
+        EXPECT_NEAR(dist40_lower.icdf(1-u), -x, 1E-12*x);
+        EXPECT_NEAR(dist40_lower.cdf(-x), 1-u, 1E-8);
+        last = x;
+    }
+
+    const double gamma_log_Z = -27.523942032998743; //log(Q(2,30)-Q(2,30.5))
+    TruncatedGammaDist gamma_dist(GammaDist(2,2), 60, 61);
+    EXPECT_NEAR(gamma_dist.llh(60.5), gamma_dist.GammaDist::llh(60.5) - gamma_log_Z, 1E-12*fabs(gamma_log_Z));
+    EXPECT_NEAR(gamma_dist.pdf(60.5), exp(gamma_dist.GammaDist::llh(60.5) - gamma_log_Z), 1E-12*gamma_dist.pdf(60.5));
+    for(double u: {0.1, 0.5, 0.9}) EXPECT_NEAR(gamma_dist.cdf(gamma_dist.icdf(u)), u, 1E-8);
+    //GammaDist has no log-space inverse, so with an underflowing normalizer icdf stays finite and in bounds
+    TruncatedGammaDist gamma_far(GammaDist(2,2), 2000, INFINITY);
+    EXPECT_TRUE(std::isfinite(gamma_far.pdf(2000.5)));
+    EXPECT_GT(gamma_far.pdf(2000.5), 0);
+    for(double u: {0.1, 0.5, 0.9}) {
+        double x = gamma_far.icdf(u);
+        ASSERT_TRUE(std::isfinite(x));
+        EXPECT_LE(gamma_far.lbound(), x);
+    }
+}
+
+TEST(NormalDistTest, log_tails) {
+    NormalDist dist(1,2);
+    const double log_cdf_m40 = -804.6084420137538; //log(Phi(-40)), which underflows as a double
+    EXPECT_NEAR(dist.logcdf(1-2*40), log_cdf_m40, 1E-12*fabs(log_cdf_m40));
+    EXPECT_NEAR(dist.logsf(1+2*40), log_cdf_m40, 1E-12*fabs(log_cdf_m40));
+    EXPECT_NEAR(dist.log_cdf_diff(1+2*40, 1+2*41), log_cdf_m40, 1E-12*fabs(log_cdf_m40));
+    EXPECT_NEAR(dist.log_cdf_diff(1-2*41, 1-2*40), log_cdf_m40, 1E-12*fabs(log_cdf_m40));
+    EXPECT_NEAR(dist.logsf(1-2*40), 0, 1E-300);
+    EXPECT_NEAR(dist.ilogcdf(log_cdf_m40), 1-2*40, 1E-12*80);
+    EXPECT_NEAR(dist.ilogsf(log_cdf_m40), 1+2*40, 1E-12*80);
+    for(double u: {1E-300, 0.1, 0.5, 0.9, 1-1E-12}) {
+        EXPECT_NEAR(dist.ilogcdf(log(u)), dist.icdf(u), 1E-10*(1+fabs(dist.icdf(u))));
+        EXPECT_NEAR(dist.ilogsf(log(u)), dist.isf(u), 1E-10*(1+fabs(dist.isf(u))));
+    }
+    EXPECT_EQ(dist.log_cdf_diff(2,2), -INFINITY);
+    //Interval containing the median, and the full line
+    EXPECT_NEAR(dist.log_cdf_diff(-1,3), log(dist.cdf(3)-dist.cdf(-1)), 1E-15);
+    EXPECT_EQ(dist.log_cdf_diff(-INFINITY,INFINITY), 0);
+}
+
+TEST(NormalDistTest, sample_truncated_unit_normal) {
+    env->reset_rng();
+    auto phi = [](double x) { return std::isinf(x) ? 0 : exp(-.5*x*x)/constants::sqrt2pi; };
+    auto Z = [](double a, double b) { //Probability of [a,b], computed in the tail that avoids cancellation
+        return a >= 0 ? .5*(erfc(a/constants::sqrt2) - erfc(b/constants::sqrt2)) : 
+                        .5*(erfc(-b/constants::sqrt2) - erfc(-a/constants::sqrt2));
+    };
+    const IdxT N = 20000;
+    //Central, one-sided, far lower tail, far upper tail, and narrow tail intervals, covering each proposal:
+    //normal, uniform, half-normal, tail uniform, and exponential
+    std::vector<std::pair<double,double>> intervals = {{-1,2},{0.5,INFINITY},{-INFINITY,-50},{8,9},{40,41},{20,20.001},
+                                                       {-INFINITY,INFINITY},{-0.1,0.2},{0.1,INFINITY},{-0.5,-0.1},{-2,5}};
+    for(auto &ab: intervals) {
+        double a = ab.first, b = ab.second;
+        double s = 0, s2 = 0;
+        for(IdxT n=0; n<N; n++) {
+            double x = sample_truncated_unit_normal(a,b,env->get_rng());
+            ASSERT_LE(a,x);
+            ASSERT_LE(x,b);
+            s += x;
+            s2 += x*x;
+        }
+        double mean = s/N;
+        double se = sqrt(std::max(s2/N - mean*mean, 0.)/N);
+        double z = Z(a,b);
+        //Where phi underflows the mean comes from the asymptotic expansion t + 1/t - 2/t^3 at the finite bound t
+        double t = std::isinf(a) ? b : a;
+        double expected = z > 0 ? (phi(a)-phi(b))/z : t + 1/t - 2/(t*t*t);
+        EXPECT_NEAR(mean, expected, 5*se + 1E-4) << "a:"<<a<<" b:"<<b;
+    }
+}
+
+/* Array methods against the scalar methods, for samples and for the extra points x */
+template<class Dist>
+void check_array_methods(const Dist &dist, std::vector<double> x)
+{
+    env->reset_rng();
+    for(IdxT n=0; n<1001; n++) x.push_back(dist.sample(env->get_rng())); //Not a multiple of the vector width
+    IdxT N = x.size();
+    std::vector<double> llh(N), rllh(N), grad(N), grad2(N), grad_acc(N,1), grad2_acc(N,1);
+    dist.llh(N, x.data(), llh.data());
+    dist.rllh(N, x.data(), rllh.data());
+    dist.grad(N, x.data(), grad.data());
+    dist.grad2(N, x.data(), grad2.data());
+    dist.grad_grad2_accumulate(N, x.data(), grad_acc.data(), grad2_acc.data());
+    auto expect_close = [](double val, double expected, double x) {
+        if(std::isfinite(expected)) EXPECT_NEAR(val, expected, 1E-13*(1+fabs(expected)))<<"x:"<<x;
+        else EXPECT_EQ(val, expected)<<"x:"<<x;
+    };
+    for(IdxT n=0; n<N; n++) {
+        expect_close(llh[n], dist.llh(x[n]), x[n]);
+        expect_close(rllh[n], dist.rllh(x[n]), x[n]);
+        expect_close(grad[n], dist.grad(x[n]), x[n]);
+        expect_close(grad2[n], dist.grad2(x[n]), x[n]);
+        double g = 1, g2 = 1;
+        dist.grad_grad2_accumulate(x[n], g, g2);
+        expect_close(grad_acc[n], g, x[n]);
+        expect_close(grad2_acc[n], g2, x[n]);
+    }
+}
+
+TEST(UnivariateDistArrayTest, normal) {
+    check_array_methods(NormalDist(1.5,2.5), {0, -1E300, 1E300});
+}
+
+TEST(UnivariateDistArrayTest, gamma) {
+    //Includes the log of 0 and of subnormals
+    check_array_methods(GammaDist(2,3.5), {0, 4.9E-324, 1E-310, 2.2250738585072014E-308, 1E300});
+}
+
+TEST(UnivariateDistArrayTest, pareto) {
+    check_array_methods(ParetoDist(0.5,1.7), {0.5, 1E-310, 1E300});
+}
+
+TEST(UnivariateDistArrayTest, symmetric_beta) {
+    check_array_methods(SymmetricBetaDist(2.5), {1E-310, 0.5, 1-1E-16, 1E-8});
+}
+
+/* The bounds adaptors used by CompositeDist forward the array llh to Dist and add their constants */
+TEST(UnivariateDistArrayTest, bounds_adapted_llh) {
+    auto check = [](const auto &dist) {
+        env->reset_rng();
+        const IdxT N = 1001;
+        std::vector<double> x(N), llh(N);
+        for(auto &v: x) v = dist.sample(env->get_rng());
+        dist.llh(N, x.data(), llh.data());
+        for(IdxT n=0; n<N; n++) EXPECT_NEAR(llh[n], dist.llh(x[n]), 1E-13*(1+fabs(llh[n])))<<"x:"<<x[n];
+    };
+    check(TruncatedNormalDist(NormalDist(1.5,2.5), 0, 4));
+    check(TruncatedGammaDist(GammaDist(2,3.5), 1, 10));
+    check(TruncatedParetoDist(ParetoDist(0.5,1.7), 20));
+    check(ScaledSymmetricBetaDist(SymmetricBetaDist(2.5), -3, 5));
+}
@@ -4,6 +4,8 @@
  */
 #include<iostream>
 #include <limits>
+#include <vector>
+#include <boost/math/special_functions/owens_t.hpp>
 #include "test_prior_hessian.h"
 #include "PriorHessian/mvn_cdf.h"
 #include "PriorHessian/util.h"
@@ -341,6 +343,140 @@ TEST_F(MVNCDFTest, owen_vs_donnelly_bvn_cdf)
 }
 
 
+TEST_F(MVNCDFTest, unit_normal_cdf_batch)
+{
+    VecT t = arma::linspace(-40,10,5001);
+    VecT v(t.n_elem);
+    unit_normal_cdf_batch(t.n_elem, t.memptr(), v.memptr());
+    for(IdxT n=0; n<t.n_elem; n++) EXPECT_NEAR(v(n), unit_normal_cdf(t(n)), 1e-15)<<"t:"<<t(n);
+    VecT tinf = {-INFINITY, INFINITY, 0};
+    VecT vinf(3);
+    unit_normal_cdf_batch(3, tinf.memptr(), vinf.memptr());
+    EXPECT_EQ(vinf(0),0);
+    EXPECT_EQ(vinf(1),1);
+    EXPECT_EQ(vinf(2),.5);
+}
+
+TEST_F(MVNCDFTest, owen_t_integral_batch)
+{
+    IdxT N = 1000;
+    VecT h = env->sample_normal_vec(N,0,2);
+    VecT a = env->sample_normal_vec(N,0,2);
+    h(0) = 0;
+    a(1) = 0;
+    a(2) = 1;
+    a(3) = -INFINITY;
+    h(4) = INFINITY;
+    VecT gh(N), T(N);
+    for(IdxT n=0; n<N; n++) gh(n) = unit_normal_cdf(h(n));
+    owen_t_integral_batch(N, h.memptr(), a.memptr(), gh.memptr(), T.memptr());
+    for(IdxT n=0; n<N; n++) 
+        EXPECT_NEAR(T(n), owen_t_integral(h(n),a(n),gh(n)), 1e-10)<<"h:"<<h(n)<<" a:"<<a(n);
+}
+
+/* Accuracy of the batched quadrature over its whole domain, 0 <= h <= 26 and 0 < a < 1.  a=1 has a closed form. */
+TEST_F(MVNCDFTest, owen_t_integral_batch_accuracy)
+{
+    std::vector<double> h, a, gh;
+    for(int i=0; i<=208; i++) for(int j=1; j<100; j++) {
+        h.push_back(i/8.);
+        a.push_back(j/100.);
+        gh.push_back(unit_normal_cdf(h.back()));
+    }
+    IdxT N = h.size();
+    std::vector<double> T(N);
+    owen_t_integral_batch(N, h.data(), a.data(), gh.data(), T.data());
+    for(IdxT n=0; n<N; n++) {
+        double expected = boost::math::owens_t(h[n],a[n]);
+        EXPECT_NEAR(T[n], expected, 2E-16)<<"h:"<<h[n]<<" a:"<<a[n];
+        if(h[n] <= 4) EXPECT_NEAR(T[n], expected, 1E-12*expected)<<"h:"<<h[n]<<" a:"<<a[n];
+    }
+}
+
+TEST_F(MVNCDFTest, bvn_cdf_batch)
+{
+    IdxT N = 1000;
+    VecT h = env->sample_normal_vec(N,0,3);
+    VecT k = env->sample_normal_vec(N,0,3);
+    VecT r(N);
+    for(IdxT n=0; n<N; n++) r(n) = env->sample_real(-1,1);
+    for(IdxT n=0; n<N; n+=10) k(n) = h(n);
+    for(IdxT n=1; n<N; n+=10) k(n) = -h(n);
+    h(2) = 0;
+    h(3) = k(3) = 0;
+    r(4) = 1;
+    r(5) = -1;
+    h(6) = INFINITY;
+    k(7) = -INFINITY;
+    VecT v(N);
+    bvn_cdf_batch(N, h.memptr(), k.memptr(), r.memptr(), v.memptr());
+    for(IdxT n=0; n<N; n++) {
+        EXPECT_LE(0,v(n));
+        EXPECT_LE(v(n),1);
+        EXPECT_NEAR(v(n), owen_b_integral(h(n),k(n),r(n)), 1e-10)<<"h:"<<h(n)<<" k:"<<k(n)<<" r:"<<r(n);
+    }
+    VecT r_bad = r;
+    r_bad(0) = 1.5;
+    EXPECT_THROW(bvn_cdf_batch(N, h.memptr(), k.memptr(), r_bad.memptr(), v.memptr()), ParameterValueError);
+}
+
+TEST_F(MVNCDFTest, owen_bvn_cdf_batch)
+{
+    IdxT N = 300;
+    MatT S = env->sample_sigma_mat(env->sample_gamma_vec(2,1,1));
+    MatT b(2,N);
+    for(IdxT n=0; n<N; n++) b.col(n) = env->sample_normal_vec(2,0,4);
+    VecT v = owen_bvn_cdf_batch(b,S);
+    ASSERT_EQ(v.n_elem, N);
+    for(IdxT n=0; n<N; n++) EXPECT_NEAR(v(n), owen_bvn_cdf(b.col(n).eval(),S), 1e-10);
+    EXPECT_THROW(owen_bvn_cdf_batch(MatT(3,N),S), ParameterSizeError);
+}
+
+TEST_F(MVNCDFTest, bvn_cdf_integral_methods)
+{
+    IdxT N = 1000;
+    BVNMethod methods[] = {BVNMethod::Auto, BVNMethod::Owen, BVNMethod::Donnelly, BVNMethod::GaussLegendre};
+    for(IdxT n=0; n<N; n++) {
+        double h = env->sample_normal_vec(1,0,5)(0);
+        double k = env->sample_normal_vec(1,0,5)(0);
+        double r = env->sample_real(-1,1);
+        double ref = donnelly_bvn_integral(-h,-k,r);
+        for(auto m: methods) EXPECT_NEAR(bvn_cdf_integral(h,k,r,m), ref, 1e-10)<<"h:"<<h<<" k:"<<k<<" r:"<<r;
+        EXPECT_NEAR(bvn_cdf_integral(h,k,r), ref, bvn_cdf_default_tol)<<"h:"<<h<<" k:"<<k<<" r:"<<r;
+        EXPECT_NEAR(bvn_cdf_integral(h,k,r,1E-8), ref, 1E-8)<<"h:"<<h<<" k:"<<k<<" r:"<<r;
+    }
+    double h = 0.3, r = 0.5;
+    for(auto m: methods) {
+        EXPECT_EQ(bvn_cdf_integral(-INFINITY,h,r,m), 0);
+        EXPECT_EQ(bvn_cdf_integral(h,-INFINITY,r,m), 0);
+        EXPECT_DOUBLE_EQ(bvn_cdf_integral(INFINITY,h,r,m), unit_normal_cdf(h));
+        EXPECT_DOUBLE_EQ(bvn_cdf_integral(h,INFINITY,r,m), unit_normal_cdf(h));
+        EXPECT_EQ(bvn_cdf_integral(INFINITY,INFINITY,r,m), 1);
+        EXPECT_THROW(bvn_cdf_integral(h,h,1.5,m), ParameterValueError);
+        EXPECT_THROW(bvn_cdf_integral(NAN,h,r,m), ParameterValueError);
+    }
+}
+
+TEST_F(MVNCDFTest, bvn_cdf_select_method)
+{
+    EXPECT_EQ(bvn_cdf_select_method(1,2,0.3), BVNMethod::Donnelly);
+    EXPECT_EQ(bvn_cdf_select_method(1,2,0.99,1E-8), BVNMethod::Donnelly);
+    EXPECT_EQ(bvn_cdf_select_method(10,2,0.3), BVNMethod::GaussLegendre);
+    EXPECT_EQ(bvn_cdf_select_method(2,-10,-0.3,1E-8), BVNMethod::GaussLegendre);
+    EXPECT_EQ(bvn_cdf_select_method(10,2,0.9), BVNMethod::Donnelly);
+    //No method meets tol=0, so the most accurate is used
+    EXPECT_EQ(bvn_cdf_select_method(10,2,0.3,0), BVNMethod::Donnelly);
+}
+
+TEST_F(MVNCDFTest, bvn_cdf)
+{
+    MatT S = env->sample_sigma_mat(env->sample_gamma_vec(2,1,1));
+    for(IdxT n=0; n<100; n++) {
+        VecT b = env->sample_normal_vec(2,0,4);
+        EXPECT_NEAR(bvn_cdf(b,S), donnelly_bvn_cdf(b,S), 1e-14);
+    }
+}
+
 // TEST_F(MVNCDFTest, mc_mvn_cdf)
 // {
 //     for(int n=0;n<this->Ntest;n++) {
@@ -359,7 +495,76 @@ TEST_F(MVNCDFTest, owen_vs_donnelly_bvn_cdf)
 //     }
 // }
 
-TEST_F(MVNCDFTest, genz_fortran_2d_mvn_cdf)
+TEST_F(MVNCDFTest, mc_mvn_cdf_lattice)
+{
+    MatT bs = { {0, 0, 0, 0}, {-1,0,1,-1}, {1,1,1,1}, {-1,-1,1,-1}, {0,0,0,1},  {3,1,1,9}};
+    MatT S = {{1.2, .4, -.3, -1.}, {.4, 1.9, .9, .7}, {-.3, .9, 2.1, -.7}, {-1, .7, -.7, 3.8}} ;
+    VecT fs = {0.0499313051448704, 0.00689478049922999, 0.340738068871701, 0.00649338105539796, 0.0906183246427675, 0.626098152194645 };
+    MatT U = arma::chol(S);
+    //eps=1e-5 is reached by every b within maxpts=3e6.  The slowest, b=(1,1,1,1), needs about 2.4e6 evaluations, and
+    //eps=1e-6 would need about 1.8e7, more than a unit test should spend.
+    MCMVNOptions opts;
+    opts.eps = 1e-5;
+    opts.maxpts = 3000000;
+    for(IdxT n=0; n<bs.n_rows; n++){
+        VecT b = bs.row(n).t();
+        double verror;
+        int niter;
+        double v = mc_mvn_cdf_core(b,U,verror,niter,opts);
+        EXPECT_LE(verror,opts.eps)<<"b:"<<b<<" niter:"<<niter;
+        EXPECT_LE(fabs(v-fs(n)),std::max(2e-6,3*verror))<<"b:"<<b<<" v:"<<v<<" v2:"<<fs(n)<<" verror:"<<verror;
+    }
+}
+
+TEST_F(MVNCDFTest, mc_mvn_integral_sampling)
+{
+    MatT S = {{1.2, .4, -.3}, {.4, 1.9, .9}, {-.3, .9, 2.1}};
+    MatT U = arma::chol(S);
+    VecT a = {-1, -INFINITY, -INFINITY};
+    VecT b = {1, 1, 1};
+    VecT b_lower = {-1, 1, 1};
+    genz::MVNIntegralOptions genz_opts;
+    genz_opts.abseps = 1e-8;
+    genz_opts.maxpts = 1000000;
+    double genz_err;
+    int genz_inform;
+    double expected = 0.521853874350785 - genz::mvn_cdf_genz(b_lower,S,genz_err,genz_inform,genz_opts);
+    MCMVNOptions opts;
+    opts.eps = 1e-4;
+    opts.maxpts = 1000000;
+    int lattice_niter, mc_niter;
+    double lattice_err, mc_err;
+    double v_lattice = mc_mvn_integral(a,b,U,lattice_err,lattice_niter,opts);
+    opts.sampling = MCSampling::PseudoRandom;
+    double v_mc = mc_mvn_integral(a,b,U,mc_err,mc_niter,opts);
+    EXPECT_LE(fabs(v_lattice-expected),std::max(1e-5,3*lattice_err));
+    EXPECT_LE(fabs(v_mc-expected),std::max(1e-5,3*mc_err));
+    EXPECT_LT(lattice_niter,mc_niter);
+}
+
+TEST_F(MVNCDFTest, mc_mvn_cdf_seeded)
+{
+    MatT S = {{1.2, .4, -.3, -1.}, {.4, 1.9, .9, .7}, {-.3, .9, 2.1, -.7}, {-1, .7, -.7, 3.8}} ;
+    VecT b = {-1,0,1,-1};
+    MCMVNWorkspace ws;
+    for(auto sampling: {MCSampling::Lattice, MCSampling::PseudoRandom}) {
+        MCMVNOptions opts;
+        opts.sampling = sampling;
+        std::mt19937_64 rng1(7);
+        std::mt19937_64 rng2(7);
+        double err1, err2;
+        double v1 = mc_mvn_cdf(b,S,err1,opts,rng1,ws);
+        const double *U_mem = ws.U.memptr();
+        double v2 = mc_mvn_cdf(b,S,err2,opts,rng2,ws); //Workspace reuse must not change the result
+        EXPECT_EQ(ws.U.memptr(), U_mem); //The Cholesky factor is computed in place
+        EXPECT_TRUE(arma::approx_equal(ws.U, MatT(arma::chol(S)), "absdiff", 1e-15));
+        EXPECT_EQ(v1,v2);
+        EXPECT_EQ(err1,err2);
+        EXPECT_LE(fabs(v1-0.00689478049922999),std::max(1e-5,3*err1));
+    }
+}
+
+TEST_F(MVNCDFTest, genz_2d_mvn_cdf)
 {
     for(int n=0;n<this->Ntest;n++) {
         VecT b = env->sample_normal_vec(2,0,4);
@@ -380,7 +585,7 @@ TEST_F(MVNCDFTest, genz_fortran_2d_mvn_cdf)
 
 
 
-TEST_F(MVNCDFTest, genz_fortran_3d_mvn_cdf)
+TEST_F(MVNCDFTest, genz_3d_mvn_cdf)
 {
         MatT bs = { {0, 0, 0}, {-1,0,1}, {1,1,1}, {-1,-1,1}};
         MatT S = {{1.2, .4, -.3}, {.4, 1.9, .9}, {-.3, .9, 2.1}};
@@ -398,7 +603,64 @@ TEST_F(MVNCDFTest, genz_fortran_3d_mvn_cdf)
     }
 }
 
-TEST_F(MVNCDFTest, genz_fortran_4d_mvn_cdf)
+TEST_F(MVNCDFTest, tvn_cdf)
+{
+    MatT bs = { {0, 0, 0}, {-1,0,1}, {1,1,1}, {-1,-1,1}};
+    MatT S = {{1.2, .4, -.3}, {.4, 1.9, .9}, {-.3, .9, 2.1}};
+    VecT fs = {0.168399788424521, 0.0918727337962062, 0.521853874350785, 0.0559846899485406};
+    for(IdxT n=0; n<bs.n_rows; n++) {
+        VecT b = bs.row(n).t();
+        EXPECT_NEAR(tvn_cdf(b,S), fs(n), 1e-14)<<"b:"<<b;
+    }
+    genz::MVNIntegralOptions opts;
+    opts.maxpts = 1000000;
+    opts.abseps = 1e-9;
+    opts.releps = 0;
+    for(int n=0; n<this->Ntest; n++) {
+        VecT b = env->sample_normal_vec(3,0,3);
+        MatT S = env->sample_sigma_mat(env->sample_gamma_vec(3,1,1));
+        double v = tvn_cdf(b,S);
+        double error;
+        int inform;
+        VecT a(3);
+        a.fill(-1e3); //Finite lower limits, so the lattice integrator is used
+        double v2 = genz::mvn_integral_genz(a,b,S,error,inform,opts);
+        EXPECT_GE(v,0);
+        EXPECT_LE(v,1);
+        EXPECT_LE(fabs(v-v2),std::max(1e-6,3*error))<<"b:"<<b<<" S:"<<S<<" v:"<<v<<" v2:"<<v2<<" error:"<<error;
+    }
+}
+
+TEST_F(MVNCDFTest, tvn_cdf_integral)
+{
+    for(int n=0; n<this->Ntest; n++) {
+        VecT h = env->sample_normal_vec(3,0,2);
+        MatT S = env->sample_sigma_mat(env->sample_gamma_vec(3,1,1));
+        VecT s = arma::sqrt(S.diag());
+        MatT R = S / (s*s.t());
+        double v = tvn_cdf_integral(h(0),h(1),h(2),R(0,1),R(0,2),R(1,2));
+        //Symmetric under permutations of the variables
+        EXPECT_NEAR(v, tvn_cdf_integral(h(1),h(0),h(2),R(0,1),R(1,2),R(0,2)), 1e-14);
+        EXPECT_NEAR(v, tvn_cdf_integral(h(2),h(1),h(0),R(1,2),R(0,2),R(0,1)), 1e-14);
+        //Independent and degenerate cases
+        double g0 = unit_normal_cdf(h(0)), g1 = unit_normal_cdf(h(1)), g2 = unit_normal_cdf(h(2));
+        EXPECT_NEAR(tvn_cdf_integral(h(0),h(1),h(2),0,0,0), g0*g1*g2, 1e-15);
+        EXPECT_NEAR(tvn_cdf_integral(h(0),h(1),h(2),0,0,R(1,2)), g0*bvn_cdf_integral(h(1),h(2),R(1,2)), 1e-15);
+        EXPECT_NEAR(tvn_cdf_integral(h(0),h(1),h(2),R(0,1),R(0,1),1),
+                    bvn_cdf_integral(h(0),std::min(h(1),h(2)),R(0,1)), 1e-15);
+        //Infinite limits
+        EXPECT_EQ(tvn_cdf_integral(h(0),-INFINITY,h(2),R(0,1),R(0,2),R(1,2)), 0);
+        EXPECT_NEAR(tvn_cdf_integral(h(0),h(1),INFINITY,R(0,1),R(0,2),R(1,2)), bvn_cdf_integral(h(0),h(1),R(0,1)), 1e-15);
+        EXPECT_NEAR(tvn_cdf_integral(INFINITY,h(1),h(2),R(0,1),R(0,2),R(1,2)), bvn_cdf_integral(h(1),h(2),R(1,2)), 1e-15);
+    }
+    //Orthant probability
+    double r12 = .3, r13 = -.4, r23 = .5;
+    EXPECT_NEAR(tvn_cdf_integral(0,0,0,r12,r13,r23), .125+(asin(r12)+asin(r13)+asin(r23))/(4*arma::datum::pi), 1e-15);
+    EXPECT_THROW(tvn_cdf_integral(NAN,0,0,r12,r13,r23), ParameterValueError);
+    EXPECT_THROW(tvn_cdf_integral(0,0,0,r12,1.5,r23), ParameterValueError);
+}
+
+TEST_F(MVNCDFTest, genz_4d_mvn_cdf)
 {
         MatT bs = { {0, 0, 0, 0}, {-1,0,1,-1}, {1,1,1,1}, {-1,-1,1,-1}, {0,0,0,1},  {10,10,10,10}, {3,1,1,9}};
         MatT S = {{1.2, .4, -.3, -1.}, {.4, 1.9, .9, .7}, {-.3, .9, 2.1, -.7}, {-1, .7, -.7, 3.8}} ;
@@ -416,6 +678,87 @@ TEST_F(MVNCDFTest, genz_fortran_4d_mvn_cdf)
     }
 }
 
+TEST_F(MVNCDFTest, genz_rectangle_integral)
+{
+    MatT S = {{1.2, .4, -.3, -1.}, {.4, 1.9, .9, .7}, {-.3, .9, 2.1, -.7}, {-1, .7, -.7, 3.8}} ;
+    VecT b = {1, 0.5, 2, 1};
+    VecT a = {-0.5, -INFINITY, -INFINITY, -INFINITY};
+    VecT b_lower = b;
+    b_lower(0) = a(0);
+    genz::MVNIntegralOptions opts;
+    opts.abseps = 1e-5;
+    opts.releps = 0;
+    opts.maxpts = 1000000;
+    double err, err_b, err_a;
+    int inform, inform_b, inform_a;
+    double v = genz::mvn_integral_genz(a,b,S,err,inform,opts);
+    double v_b = genz::mvn_cdf_genz(b,S,err_b,inform_b,opts);
+    double v_a = genz::mvn_cdf_genz(b_lower,S,err_a,inform_a,opts);
+    EXPECT_EQ(inform,0);
+    EXPECT_LE(fabs(v-(v_b-v_a)), std::max(1e-6,3*(err+err_a+err_b)))<<"v:"<<v<<" v_b:"<<v_b<<" v_a:"<<v_a;
+    //Empty rectangles
+    VecT a_empty = a;
+    a_empty(0) = b(0);
+    EXPECT_EQ(genz::mvn_integral_genz(a_empty,b,S,err,inform),0);
+}
+
+TEST_F(MVNCDFTest, genz_inform)
+{
+    MatT S = {{1.2, .4, -.3, -1.}, {.4, 1.9, .9, .7}, {-.3, .9, 2.1, -.7}, {-1, .7, -.7, 3.8}} ;
+    VecT b = {0, 0, 0, 1};
+    genz::MVNIntegralOptions opts;
+    opts.abseps = 1e-14;
+    opts.releps = 0;
+    opts.maxpts = 2000;
+    double err;
+    int inform;
+    double v = genz::mvn_cdf_genz(b,S,err,inform,opts);
+    EXPECT_EQ(inform,1);
+    EXPECT_LE(fabs(v-0.0906183246427675),std::max(1e-5,3*err));
+    genz::mvn_integral(0,nullptr,nullptr,nullptr,opts,err,inform);
+    EXPECT_EQ(inform,2);
+}
+
+/* Far tail integrals are computed in log-scaled form.  The absolute tolerance is met by any estimate of a value this
+ * small, so the default options must still give relative accuracy.
+ */
+TEST_F(MVNCDFTest, genz_log_integral_far_tail)
+{
+    MatT S = {{1, .5, .5}, {.5, 1, .5}, {.5, .5, 1}};
+    VecT a = {40,40,40};
+    VecT b = {41,41,41};
+    const double log_p = -1211.40487894; //1D quadrature of the equicorrelated form
+    double error;
+    int inform;
+    double v = genz::log_mvn_integral_genz(a,b,S,error,inform);
+    EXPECT_NEAR(v, log_p, 5E-3);
+    genz::MVNIntegralOptions opts;
+    opts.abseps = 0;
+    EXPECT_NEAR(genz::log_mvn_integral_genz(a,b,S,error,inform,opts), v, 1E-3);
+}
+
+TEST_F(MVNCDFTest, genz_seed_reproducible)
+{
+    //4D, so the integral is computed by the randomized lattice rules, not by tvn_cdf_integral
+    MatT S = {{1.2, .4, -.3, -1.}, {.4, 1.9, .9, .7}, {-.3, .9, 2.1, -.7}, {-1, .7, -.7, 3.8}};
+    VecT b = {-1,0,1,-1};
+    genz::MVNIntegralOptions opts;
+    opts.seed = 1234;
+    double err1, err2, err3;
+    int inform1, inform2, inform3;
+    double v1 = genz::mvn_cdf_genz(b,S,err1,inform1,opts);
+    double v2 = genz::mvn_cdf_genz(b,S,err2,inform2,opts);
+    EXPECT_EQ(v1,v2);
+    EXPECT_EQ(err1,err2);
+    EXPECT_EQ(inform1,inform2);
+    EXPECT_GT(err1,0);
+    //Another seed gives other random shifts
+    opts.seed = 4321;
+    double v3 = genz::mvn_cdf_genz(b,S,err3,inform3,opts);
+    EXPECT_TRUE(v3 != v1 || err3 != err1);
+    EXPECT_NEAR(v3, v1, err1+err3);
+}
+
 
 
 